@@ -0,0 +1,167 @@
+import logging
+import os
+import time
+import vtk, qt, ctk, slicer
+from slicer.ScriptedLoadableModule import *
+from DICOMLib import DICOMUtils
+
+#
+# DICOMHeaderScannerPerformance
+#
+
+class DICOMHeaderScannerPerformance(ScriptedLoadableModule):
+  def __init__(self, parent):
+    ScriptedLoadableModule.__init__(self, parent)
+    parent.title = "DICOMHeaderScannerPerformance"
+    parent.categories = ["Testing.TestCases"]
+    parent.dependencies = []
+    parent.contributors = ["Slicer Community"]
+    parent.helpText = """
+    This module was developed to measure how long it takes to read the DICOM tags used by the DICOM plugins
+    from a synthetic DICOM tree, with the header scanner and by querying the DICOM database file by file.
+    """
+    self.parent = parent
+
+    # Add this test to the SelfTest module's list for discovery when the module
+    # is created.  Since this module may be discovered before SelfTests itself,
+    # create the list if it doesn't already exist.
+    try:
+      slicer.selfTests
+    except AttributeError:
+      slicer.selfTests = {}
+    slicer.selfTests['DICOMHeaderScannerPerformance'] = self.runTest
+
+  def runTest(self):
+    tester = DICOMHeaderScannerPerformanceTest()
+    tester.runTest()
+
+#
+# DICOMHeaderScannerPerformanceWidget
+#
+
+class DICOMHeaderScannerPerformanceWidget(ScriptedLoadableModuleWidget):
+
+  def setup(self):
+    ScriptedLoadableModuleWidget.setup(self)
+    self.layout.addStretch(1)
+
+#
+# DICOMHeaderScannerPerformanceLogic
+#
+
+class DICOMHeaderScannerPerformanceLogic(ScriptedLoadableModuleLogic):
+
+  def createSyntheticTree(self, treeDirectory, numberOfSeries, numberOfSlices):
+    """Write numberOfSeries series of numberOfSlices files each into
+    treeDirectory, one sub-directory per series. Return the list of files.
+    """
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(32, 32, numberOfSlices)
+    imageData.AllocateScalars(vtk.VTK_SHORT, 1)
+    imageData.GetPointData().GetScalars().Fill(100)
+    volumeNode = slicer.vtkMRMLScalarVolumeNode()
+    volumeNode.SetAndObserveImageData(imageData)
+    slicer.mrmlScene.AddNode(volumeNode)
+
+    for seriesIndex in range(numberOfSeries):
+      parameters = {}
+      parameters['patientName'] = 'Synthetic^Patient%d' % (seriesIndex % 5)
+      parameters['patientID'] = 'SYNTHETIC%d' % (seriesIndex % 5)
+      parameters['seriesDescription'] = 'Synthetic series %d' % seriesIndex
+      parameters['seriesNumber'] = str(seriesIndex + 1)
+      parameters['inputVolume'] = volumeNode.GetID()
+      parameters['dicomDirectory'] = os.path.join(treeDirectory, 'Series%03d' % seriesIndex)
+      qt.QDir().mkpath(parameters['dicomDirectory'])
+      cliNode = slicer.cli.run(slicer.modules.createdicomseries, None, parameters, wait_for_completion=True)
+      if cliNode.GetStatusString() != 'Completed':
+        raise Exception('Failed to create synthetic DICOM series %d' % seriesIndex)
+      slicer.mrmlScene.RemoveNode(cliNode)
+
+    slicer.mrmlScene.RemoveNode(volumeNode)
+
+    files = []
+    for root, dirs, fileNames in os.walk(treeDirectory):
+      for fileName in fileNames:
+        files.append(os.path.join(root, fileName))
+    return files
+
+
+class DICOMHeaderScannerPerformanceTest(ScriptedLoadableModuleTest):
+  """
+  This is the test case
+  """
+
+  def setUp(self):
+    slicer.mrmlScene.Clear(0)
+
+  def runTest(self):
+    self.setUp()
+    self.test_ScanSyntheticTree()
+
+  def test_ScanSyntheticTree(self, numberOfSeries=20, numberOfSlices=50):
+    self.delayDisplay("Creating synthetic DICOM tree", 100)
+    treeDirectory = os.path.join(slicer.app.temporaryPath, 'DICOMHeaderScannerPerformance')
+    import shutil
+    if os.path.exists(treeDirectory):
+      shutil.rmtree(treeDirectory)
+    logic = DICOMHeaderScannerPerformanceLogic()
+    files = logic.createSyntheticTree(treeDirectory, numberOfSeries, numberOfSlices)
+    self.assertEqual(len(files), numberOfSeries * numberOfSlices)
+
+    with DICOMUtils.TemporaryDICOMDatabase() as database:
+      DICOMUtils.importDicom(treeDirectory)
+      tags = list(database.tagsToPrecache)
+      self.assertTrue(len(tags) > 0)
+
+      # Query the database file by file, as plugins did before
+      startTime = time.time()
+      for filePath in files:
+        for tag in tags:
+          database.fileValue(filePath, tag)
+      databaseTime = time.time() - startTime
+
+      # Series description and number are not used by the plugins, scan them to check
+      # the values against the ones the synthetic series were created with
+      seriesDescriptionTag = '0008,103e'
+      seriesNumberTag = '0020,0011'
+      seriesInstanceUIDTag = '0020,000e'
+      scannedTags = tags + [tag for tag in [seriesDescriptionTag, seriesNumberTag, seriesInstanceUIDTag] if tag not in tags]
+
+      scanTimes = {}
+      for numberOfThreads in [1, qt.QThread.idealThreadCount()]:
+        scanner = slicer.qSlicerDICOMHeaderScanner()
+        scanner.tags = scannedTags
+        scanner.numberOfThreads = numberOfThreads
+        scanner.setDatabase(database)
+        startTime = time.time()
+        self.assertEqual(scanner.scanFiles(files), len(files))
+        scanTimes[numberOfThreads] = time.time() - startTime
+
+      # Scanned values must match the ones the series were created with and the ones
+      # read by pydicom, which does not share any code with the scanner or the database
+      import dicom
+      for filePath in files:
+        self.assertTrue(scanner.isFileScanned(filePath))
+        seriesIndex = int(os.path.basename(os.path.dirname(filePath))[len('Series'):])
+        self.assertEqual(scanner.fileValue(filePath, seriesDescriptionTag).strip(), 'Synthetic series %d' % seriesIndex)
+        self.assertEqual(int(scanner.fileValue(filePath, seriesNumberTag)), seriesIndex + 1)
+        dataset = dicom.read_file(filePath, stop_before_pixels=True)
+        self.assertEqual(scanner.fileValue(filePath, seriesInstanceUIDTag).strip('\x00 '), dataset.SeriesInstanceUID)
+        self.assertEqual(scanner.fileValue(filePath, seriesDescriptionTag).strip(), dataset.SeriesDescription.strip())
+        self.assertTrue(scanner.fileHasTag(filePath, '7fe0,0010'))
+
+      # Clearing releases the scanned values
+      scanner.clear()
+      self.assertFalse(scanner.isFileScanned(files[0]))
+      self.assertEqual(scanner.scanFiles(files), len(files))
+
+      # Scanning again is free
+      self.assertEqual(scanner.scanFiles(files), 0)
+
+    logging.info('DICOMHeaderScannerPerformance: %d files, %d tags' % (len(files), len(tags)))
+    logging.info('  database queries: %.3f s' % databaseTime)
+    for numberOfThreads in sorted(scanTimes.keys()):
+      logging.info('  header scanner with %d threads: %.3f s' % (numberOfThreads, scanTimes[numberOfThreads]))
+
+    shutil.rmtree(treeDirectory)
+    self.delayDisplay('Test passed!')
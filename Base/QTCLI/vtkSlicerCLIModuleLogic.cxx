@@ -40,6 +40,9 @@
 #include <vtkStringArray.h>
 #include <vtksys/SystemTools.hxx>
 
+// vtkAddon includes
+#include <vtkTracingMacros.h>
+
 // ITKSYS includes
 #include <itksys/Process.h>
 #include <itksys/SystemTools.hxx>
@@ -821,6 +824,8 @@ void vtkSlicerCLIModuleLogic
 //
 void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
 {
+  vtkTraceScopeMacro("CLI", "vtkSlicerCLIModuleLogic::ApplyTask");
+
   // check if MRML node is present
   if (clientdata == NULL)
     {
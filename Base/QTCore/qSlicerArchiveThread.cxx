@@ -0,0 +1,185 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QAtomicInt>
+#include <QDebug>
+#include <QEventLoop>
+
+// QtCore includes
+#include "qSlicerArchiveThread.h"
+
+// MRML Logic includes
+#include <vtkArchive.h>
+
+//-----------------------------------------------------------------------------
+class qSlicerArchiveThreadPrivate
+{
+public:
+  qSlicerArchiveThreadPrivate();
+
+  static bool progressCallback(double progress, void* clientData);
+
+  qSlicerArchiveThread::Operation Operation;
+  QString ArchiveFileName;
+  QString Directory;
+  bool Success;
+  QAtomicInt Canceled;
+  int LastProgress;
+};
+
+//-----------------------------------------------------------------------------
+qSlicerArchiveThreadPrivate::qSlicerArchiveThreadPrivate()
+  : Operation(qSlicerArchiveThread::Unzip)
+  , Success(false)
+  , Canceled(0)
+  , LastProgress(-1)
+{
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerArchiveThreadPrivate::progressCallback(double progress, void* clientData)
+{
+  qSlicerArchiveThread* self = reinterpret_cast<qSlicerArchiveThread*>(clientData);
+  qSlicerArchiveThreadPrivate* d = self->d_ptr.data();
+  int percent = qBound(0, static_cast<int>(progress * 100.), 100);
+  if (percent != d->LastProgress)
+    {
+    d->LastProgress = percent;
+    emit self->progressChanged(percent);
+    }
+  return d->Canceled.fetchAndAddOrdered(0) == 0;
+}
+
+//-----------------------------------------------------------------------------
+qSlicerArchiveThread::qSlicerArchiveThread(QObject* parentObject)
+  : Superclass(parentObject)
+  , d_ptr(new qSlicerArchiveThreadPrivate)
+{
+}
+
+//-----------------------------------------------------------------------------
+qSlicerArchiveThread::~qSlicerArchiveThread()
+{
+  this->cancel();
+  this->wait();
+}
+
+//-----------------------------------------------------------------------------
+qSlicerArchiveThread::Operation qSlicerArchiveThread::operation()const
+{
+  Q_D(const qSlicerArchiveThread);
+  return d->Operation;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerArchiveThread::setOperation(Operation operation)
+{
+  Q_D(qSlicerArchiveThread);
+  d->Operation = operation;
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerArchiveThread::archiveFileName()const
+{
+  Q_D(const qSlicerArchiveThread);
+  return d->ArchiveFileName;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerArchiveThread::setArchiveFileName(const QString& fileName)
+{
+  Q_D(qSlicerArchiveThread);
+  d->ArchiveFileName = fileName;
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerArchiveThread::directory()const
+{
+  Q_D(const qSlicerArchiveThread);
+  return d->Directory;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerArchiveThread::setDirectory(const QString& directory)
+{
+  Q_D(qSlicerArchiveThread);
+  d->Directory = directory;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerArchiveThread::success()const
+{
+  Q_D(const qSlicerArchiveThread);
+  return d->Success;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerArchiveThread::wasCanceled()const
+{
+  Q_D(const qSlicerArchiveThread);
+  return d->Canceled.fetchAndAddOrdered(0) != 0;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerArchiveThread::cancel()
+{
+  Q_D(qSlicerArchiveThread);
+  d->Canceled.fetchAndStoreOrdered(1);
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerArchiveThread::runAndWait(QEventLoop::ProcessEventsFlags flags)
+{
+  Q_D(qSlicerArchiveThread);
+  if (this->isRunning())
+    {
+    qWarning() << Q_FUNC_INFO << "failed: operation on" << d->ArchiveFileName << "is already running";
+    return false;
+    }
+  d->Canceled.fetchAndStoreOrdered(0);
+  QEventLoop eventLoop;
+  QObject::connect(this, SIGNAL(finished()), &eventLoop, SLOT(quit()));
+  this->start();
+  // the thread may have finished before the event loop is started
+  if (!this->isFinished())
+    {
+    eventLoop.exec(flags);
+    }
+  this->wait();
+  return this->success();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerArchiveThread::run()
+{
+  Q_D(qSlicerArchiveThread);
+  d->Success = false;
+  d->LastProgress = -1;
+
+  // paths are converted in the thread, the strings are not modified while running
+  QByteArray archiveFileName = d->ArchiveFileName.toLatin1();
+  QByteArray directory = d->Directory.toLatin1();
+  if (d->Operation == qSlicerArchiveThread::Zip)
+    {
+    d->Success = zip(archiveFileName.constData(), directory.constData(),
+                     &qSlicerArchiveThreadPrivate::progressCallback, this);
+    }
+  else
+    {
+    d->Success = unzip(archiveFileName.constData(), directory.constData(),
+                       &qSlicerArchiveThreadPrivate::progressCallback, this);
+    }
+}
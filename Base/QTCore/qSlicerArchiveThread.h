@@ -0,0 +1,99 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qSlicerArchiveThread_h
+#define __qSlicerArchiveThread_h
+
+// Qt includes
+#include <QEventLoop>
+#include <QThread>
+
+// QtCore includes
+#include "qSlicerBaseQTCoreExport.h"
+
+class qSlicerArchiveThreadPrivate;
+
+/// Zip a directory or unzip an archive (e.g. a MRB scene bundle) in a
+/// background thread.
+///
+/// Progress is reported by the progressChanged() signal, emitted from the
+/// archiving thread, and the operation can be canceled at any time from any
+/// thread by calling cancel(). A canceled zip does not leave a partial
+/// archive behind.
+/// \sa zip(), unzip() in vtkArchive.h
+class Q_SLICER_BASE_QTCORE_EXPORT qSlicerArchiveThread : public QThread
+{
+  Q_OBJECT
+public:
+  typedef QThread Superclass;
+
+  enum Operation
+  {
+    Zip,
+    Unzip
+  };
+
+  qSlicerArchiveThread(QObject* parent = 0);
+  virtual ~qSlicerArchiveThread();
+
+  /// Operation run by the thread. Default is Unzip.
+  Operation operation()const;
+  void setOperation(Operation operation);
+
+  /// Zip file to write (Zip) or to read (Unzip)
+  QString archiveFileName()const;
+  void setArchiveFileName(const QString& fileName);
+
+  /// Directory to compress (Zip) or to extract the archive into (Unzip)
+  QString directory()const;
+  void setDirectory(const QString& directory);
+
+  /// Return true if the last run of the thread succeeded
+  bool success()const;
+
+  /// Return true if the last run of the thread was canceled
+  bool wasCanceled()const;
+
+  /// Run the operation in the thread and wait for it to finish while
+  /// processing the events of the calling thread, so that the user interface
+  /// is repainted and the operation can be canceled.
+  /// By default user input events are not processed while waiting, so that
+  /// the user cannot trigger actions that re-enter the caller (e.g. load or
+  /// save another scene). Callers that show an application modal dialog to
+  /// let the user cancel the operation can pass QEventLoop::AllEvents.
+  /// Return false without running if the thread is already running.
+  /// \return success()
+  bool runAndWait(QEventLoop::ProcessEventsFlags flags = QEventLoop::ExcludeUserInputEvents);
+
+public slots:
+  /// Request the operation to stop as soon as possible.
+  /// The request is reset by runAndWait()
+  void cancel();
+
+signals:
+  /// Progress of the operation, between 0 and 100
+  void progressChanged(int progress);
+
+protected:
+  virtual void run();
+
+  QScopedPointer<qSlicerArchiveThreadPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qSlicerArchiveThread);
+  Q_DISABLE_COPY(qSlicerArchiveThread);
+};
+
+#endif
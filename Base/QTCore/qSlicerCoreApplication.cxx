@@ -105,6 +105,9 @@
 #include <vtkNew.h>
 #include <vtksys/SystemTools.hxx>
 
+// vtkAddon includes
+#include <vtkTraceLog.h>
+
 // Slicer includes
 #include "vtkSlicerVersionConfigure.h" // For Slicer_VERSION_{MINOR, MAJOR}, Slicer_VERSION_FULL
 
@@ -817,6 +820,11 @@ void qSlicerCoreApplication::handlePreApplicationCommandLineArguments()
     this->setAttribute(AA_EnableTesting);
     }
 
+  if (!options->traceFile().isEmpty())
+    {
+    vtkTraceLog::Start(options->traceFile().toLocal8Bit().constData());
+    }
+
 #ifdef Slicer_USE_PYTHONQT
   if (options->isPythonDisabled())
     {
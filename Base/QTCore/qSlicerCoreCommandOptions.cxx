@@ -351,6 +351,13 @@ bool qSlicerCoreCommandOptions::isTestingEnabled() const
   return d->ParsedArgs.value("testing").toBool();
 }
 
+//-----------------------------------------------------------------------------
+QString qSlicerCoreCommandOptions::traceFile() const
+{
+  Q_D(const qSlicerCoreCommandOptions);
+  return d->ParsedArgs.value("trace-file").toString();
+}
+
 #ifdef Slicer_USE_PYTHONQT
 //-----------------------------------------------------------------------------
 bool qSlicerCoreCommandOptions::isPythonDisabled() const
@@ -463,6 +470,10 @@ void qSlicerCoreCommandOptions::addArguments()
   this->addArgument("disable-message-handlers", "", QVariant::Bool,
                     "Start application disabling the 'terminal' message handlers.");
 
+  this->addArgument("trace-file", "", QVariant::String,
+                    "Record timing of instrumented code paths and write them "
+                    "in Chrome trace-event format into the given file when the application exits.");
+
 #if defined (Q_OS_WIN32) && !defined (Slicer_BUILD_WIN32_CONSOLE)
 #else
   this->addArgument("disable-terminal-outputs", "", QVariant::Bool,
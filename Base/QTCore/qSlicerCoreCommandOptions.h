@@ -55,6 +55,7 @@ class Q_SLICER_BASE_QTCORE_EXPORT qSlicerCoreCommandOptions : public ctkCommandL
   Q_PROPERTY(bool verboseModuleDiscovery READ verboseModuleDiscovery CONSTANT)
   Q_PROPERTY(bool disableMessageHandlers READ disableMessageHandlers CONSTANT)
   Q_PROPERTY(bool testingEnabled READ isTestingEnabled CONSTANT)
+  Q_PROPERTY(QString traceFile READ traceFile CONSTANT)
 #ifdef Slicer_USE_PYTHONQT
   Q_PROPERTY(bool pythonDisabled READ isPythonDisabled CONSTANT)
 #endif
@@ -191,6 +192,12 @@ public:
   /// \sa settingsDisabled()
   bool isTestingEnabled()const;
 
+  /// Return the file where spans of instrumented code paths are written
+  /// in Chrome trace-event format when the application exits.
+  /// Empty if tracing has not been requested using '--trace-file'.
+  /// \sa vtkTraceLog
+  QString traceFile()const;
+
 #ifdef Slicer_USE_PYTHONQT
   /// Return True if slicer has no python infrastructure initialized.
   /// Python is still compiled with the app, but not enabled at run-time.
@@ -24,6 +24,7 @@
 #include <QDateTime>
 
 // QtCore includes
+#include "qSlicerArchiveThread.h"
 #include "qSlicerSceneBundleReader.h"
 
 // CTK includes
@@ -99,10 +100,28 @@ bool qSlicerSceneBundleReader::load(const qSlicerIO::IOProperties& properties)
     return false;
     }
 
+  // unpack in a background thread so that the application is repainted.
+  // User input is not processed while waiting, so that loading or saving
+  // a scene cannot be started again before this one is loaded.
+  qSlicerArchiveThread unzipThread;
+  unzipThread.setOperation(qSlicerArchiveThread::Unzip);
+  unzipThread.setArchiveFileName(file);
+  unzipThread.setDirectory(unpackPath);
+  if (!unzipThread.runAndWait())
+    {
+    qWarning() << "Failed to unpack bundle" << file;
+    ctk::removeDirRecursively(unpackPath);
+    return false;
+    }
+
   vtkNew<vtkMRMLApplicationLogic> appLogic;
   appLogic->SetMRMLScene( this->mrmlScene() );
-  std::string mrmlFile = appLogic->UnpackSlicerDataBundle(
-                                          file.toLatin1(), unpackPath.toLatin1() );
+  std::string mrmlFile = appLogic->FindSlicerDataBundleSceneFile(unpackPath.toLatin1());
+  if (mrmlFile.empty())
+    {
+    ctk::removeDirRecursively(unpackPath);
+    return false;
+    }
 
   this->mrmlScene()->SetURL(mrmlFile.c_str());
 
@@ -0,0 +1,152 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageMapToWindowLevelThresholdColors.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageAppendComponents.h>
+#include <vtkImageData.h>
+#include <vtkImageExtractComponents.h>
+#include <vtkImageLogic.h>
+#include <vtkImageMapToColors.h>
+#include <vtkImageMapToWindowLevelColors.h>
+#include <vtkImageThreshold.h>
+#include <vtkLookupTable.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Compare the output of the filter with the multi-filter pipeline of
+// vtkMRMLScalarVolumeDisplayNode
+bool CompareWithPipeline(vtkImageData* image, vtkLookupTable* lookupTable,
+                         double window, double level,
+                         bool applyThreshold, double lowerThreshold, double upperThreshold)
+{
+  vtkNew<vtkImageMapToWindowLevelColors> mapToWindowLevelColors;
+  mapToWindowLevelColors->SetInputData(image);
+  mapToWindowLevelColors->SetOutputFormatToLuminance();
+  mapToWindowLevelColors->SetWindow(window);
+  mapToWindowLevelColors->SetLevel(level);
+
+  vtkNew<vtkImageMapToColors> mapToColors;
+  mapToColors->SetInputConnection(mapToWindowLevelColors->GetOutputPort());
+  mapToColors->SetOutputFormatToRGBA();
+  mapToColors->SetLookupTable(lookupTable);
+
+  vtkNew<vtkImageExtractComponents> extractRGB;
+  extractRGB->SetInputConnection(mapToColors->GetOutputPort());
+  extractRGB->SetComponents(0, 1, 2);
+  vtkNew<vtkImageExtractComponents> extractAlpha;
+  extractAlpha->SetInputConnection(mapToColors->GetOutputPort());
+  extractAlpha->SetComponents(3);
+
+  vtkNew<vtkImageThreshold> threshold;
+  threshold->SetInputData(image);
+  threshold->ReplaceInOn();
+  threshold->SetInValue(255);
+  threshold->ReplaceOutOn();
+  threshold->SetOutValue(applyThreshold ? 0 : 255);
+  threshold->SetOutputScalarTypeToUnsignedChar();
+  threshold->ThresholdBetween(lowerThreshold, upperThreshold);
+
+  vtkNew<vtkImageLogic> alphaLogic;
+  alphaLogic->SetOperationToAnd();
+  alphaLogic->SetOutputTrueValue(255);
+  alphaLogic->SetInputConnection(0, threshold->GetOutputPort());
+  alphaLogic->SetInputConnection(1, extractAlpha->GetOutputPort());
+
+  vtkNew<vtkImageAppendComponents> appendComponents;
+  appendComponents->AddInputConnection(0, extractRGB->GetOutputPort());
+  appendComponents->AddInputConnection(0, alphaLogic->GetOutputPort());
+  appendComponents->Update();
+
+  vtkNew<vtkImageMapToWindowLevelThresholdColors> filter;
+  filter->SetInputData(image);
+  filter->SetLookupTable(lookupTable);
+  filter->SetWindow(window);
+  filter->SetLevel(level);
+  filter->SetApplyThreshold(applyThreshold);
+  filter->SetLowerThreshold(lowerThreshold);
+  filter->SetUpperThreshold(upperThreshold);
+  filter->Update();
+
+  vtkImageData* expected = appendComponents->GetOutput();
+  vtkImageData* actual = filter->GetOutput();
+  if (actual->GetScalarType() != VTK_UNSIGNED_CHAR
+    || actual->GetNumberOfScalarComponents() != 4
+    || actual->GetNumberOfPoints() != expected->GetNumberOfPoints())
+    {
+    std::cerr << "Output has wrong type or size" << std::endl;
+    return false;
+    }
+  unsigned char* expectedPtr = static_cast<unsigned char*>(expected->GetScalarPointer());
+  unsigned char* actualPtr = static_cast<unsigned char*>(actual->GetScalarPointer());
+  for (vtkIdType i = 0; i < 4 * expected->GetNumberOfPoints(); ++i)
+    {
+    if (expectedPtr[i] != actualPtr[i])
+      {
+      std::cerr << "Mismatch at voxel " << i / 4 << " component " << i % 4
+                << " (value " << image->GetPointData()->GetScalars()->GetTuple1(i / 4) << ")"
+                << " with window=" << window << " level=" << level
+                << " threshold=" << applyThreshold << " [" << lowerThreshold << ", " << upperThreshold << "]"
+                << ": expected " << int(expectedPtr[i]) << ", got " << int(actualPtr[i]) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColorsTest1(int , char * [] )
+{
+  vtkNew<vtkLookupTable> lookupTable;
+  lookupTable->SetNumberOfTableValues(256);
+  lookupTable->SetTableRange(0, 255);
+  for (int i = 0; i < 256; ++i)
+    {
+    // a few transparent colors to check the alpha logic
+    lookupTable->SetTableValue(i, i / 255., 1. - i / 255., (i % 7) / 6., i < 10 ? 0. : 1.);
+    }
+
+  int scalarTypes[] = { VTK_UNSIGNED_CHAR, VTK_SHORT, VTK_UNSIGNED_SHORT, VTK_INT, VTK_FLOAT };
+  for (unsigned int typeIndex = 0; typeIndex < sizeof(scalarTypes) / sizeof(int); ++typeIndex)
+    {
+    vtkNew<vtkImageData> image;
+    image->SetDimensions(64, 64, 2);
+    image->AllocateScalars(scalarTypes[typeIndex], 1);
+    vtkDataArray* scalars = image->GetPointData()->GetScalars();
+    double range[2] = { scalars->GetDataTypeMin(), scalars->GetDataTypeMax() };
+    range[0] = std::max(range[0], -5000.);
+    range[1] = std::min(range[1], 5000.);
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+      {
+      scalars->SetTuple1(i, range[0] + (range[1] - range[0]) * i / (image->GetNumberOfPoints() - 1));
+      }
+
+    CHECK_BOOL(CompareWithPipeline(image.GetPointer(), lookupTable.GetPointer(), 256., 128., false, VTK_SHORT_MIN, VTK_SHORT_MAX), true);
+    CHECK_BOOL(CompareWithPipeline(image.GetPointer(), lookupTable.GetPointer(), 1000., -200., false, VTK_SHORT_MIN, VTK_SHORT_MAX), true);
+    CHECK_BOOL(CompareWithPipeline(image.GetPointer(), lookupTable.GetPointer(), 37.5, 100.25, true, 20.5, 3000.), true);
+    CHECK_BOOL(CompareWithPipeline(image.GetPointer(), lookupTable.GetPointer(), 8000., 3000., true, -100000., 100.), true);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -31,6 +31,9 @@
 #include <vtkSmartPointer.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <set>
+
 namespace
 {
 
@@ -42,6 +45,8 @@ int storeTwice();
 int storeAndRestoreTwice();
 int storeTwiceAndRemoveVolume();
 int references();
+int storeAndRestoreModifiedNodesOnly();
+int storeSharedNodes();
 int storePerformance();
 
 } // end of anonymous namespace
@@ -57,6 +62,8 @@ int vtkMRMLSceneViewNodeStoreSceneTest(int vtkNotUsed(argc),
   CHECK_EXIT_SUCCESS(storeAndRestoreTwice());
   CHECK_EXIT_SUCCESS(storeTwiceAndRemoveVolume());
   CHECK_EXIT_SUCCESS(references());
+  CHECK_EXIT_SUCCESS(storeAndRestoreModifiedNodesOnly());
+  CHECK_EXIT_SUCCESS(storeSharedNodes());
   CHECK_EXIT_SUCCESS(storePerformance());
   return EXIT_SUCCESS;
 }
@@ -275,6 +282,137 @@ int references()
   return EXIT_SUCCESS;
 }
 
+//---------------------------------------------------------------------------
+int storeAndRestoreModifiedNodesOnly()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer());
+  populateScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode;
+  scene->AddNode(sceneViewNode.GetPointer());
+
+  vtkMRMLScalarVolumeDisplayNode* modifiedDisplayNode = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  vtkMRMLScalarVolumeDisplayNode* unmodifiedDisplayNode = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode2"));
+  CHECK_NOT_NULL(modifiedDisplayNode);
+  CHECK_NOT_NULL(unmodifiedDisplayNode);
+  modifiedDisplayNode->SetAutoWindowLevel(0);
+  modifiedDisplayNode->SetWindowLevel(100., 50.);
+
+  sceneViewNode->StoreScene();
+  vtkMRMLNode* storedDisplayNode =
+    sceneViewNode->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1");
+  CHECK_NOT_NULL(storedDisplayNode);
+
+  // Only the modified node is restored
+  modifiedDisplayNode->SetWindowLevel(200., 100.);
+  vtkMTimeType unmodifiedDisplayNodeMTime = unmodifiedDisplayNode->GetMTime();
+  sceneViewNode->RestoreScene();
+  CHECK_DOUBLE(modifiedDisplayNode->GetWindow(), 100.);
+  CHECK_DOUBLE(modifiedDisplayNode->GetLevel(), 50.);
+  CHECK_BOOL(unmodifiedDisplayNode->GetMTime() == unmodifiedDisplayNodeMTime, true);
+
+  // Storing again reuses the stored nodes
+  modifiedDisplayNode->SetWindowLevel(300., 150.);
+  sceneViewNode->StoreScene();
+  CHECK_INT(sceneViewNode->GetStoredScene()->GetNumberOfNodes(), 6);
+  CHECK_POINTER(sceneViewNode->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"),
+                storedDisplayNode);
+  CHECK_DOUBLE(vtkMRMLScalarVolumeDisplayNode::SafeDownCast(storedDisplayNode)->GetWindow(), 300.);
+
+  // Restoring right after storing does not modify the scene nodes
+  vtkMTimeType modifiedDisplayNodeMTime = modifiedDisplayNode->GetMTime();
+  sceneViewNode->RestoreScene();
+  CHECK_BOOL(modifiedDisplayNode->GetMTime() == modifiedDisplayNodeMTime, true);
+  CHECK_DOUBLE(modifiedDisplayNode->GetWindow(), 300.);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+// Number of distinct node instances retained by all the scene views of the scene
+int retainedStoredNodeCount(vtkMRMLScene* scene)
+{
+  std::set<vtkMRMLNode*> storedNodes;
+  std::vector<vtkMRMLNode*> sceneViewNodes;
+  scene->GetNodesByClass("vtkMRMLSceneViewNode", sceneViewNodes);
+  for (size_t i = 0; i < sceneViewNodes.size(); ++i)
+    {
+    vtkMRMLScene* storedScene = vtkMRMLSceneViewNode::SafeDownCast(sceneViewNodes[i])->GetStoredScene();
+    for (int n = 0; storedScene && n < storedScene->GetNumberOfNodes(); ++n)
+      {
+      storedNodes.insert(storedScene->GetNthNode(n));
+      }
+    }
+  return static_cast<int>(storedNodes.size());
+}
+
+//---------------------------------------------------------------------------
+int storeSharedNodes()
+{
+  vtkNew<vtkMRMLScene> scene;
+  populateScene(scene.GetPointer());
+  populateScene(scene.GetPointer());
+
+  vtkSmartPointer<vtkMRMLSceneViewNode> sceneViewNode1 = vtkSmartPointer<vtkMRMLSceneViewNode>::New();
+  scene->AddNode(sceneViewNode1);
+  sceneViewNode1->StoreScene();
+  // 2 volume, 2 display and 2 storage nodes
+  CHECK_INT(sceneViewNode1->GetStoredScene()->GetNumberOfNodes(), 6);
+  CHECK_INT(retainedStoredNodeCount(scene.GetPointer()), 6);
+
+  // The second scene view shares the unmodified display and storage nodes,
+  // only the volume nodes (storable) are copied.
+  vtkNew<vtkMRMLSceneViewNode> sceneViewNode2;
+  scene->AddNode(sceneViewNode2.GetPointer());
+  sceneViewNode2->StoreScene();
+  CHECK_INT(sceneViewNode2->GetStoredScene()->GetNumberOfNodes(), 6);
+  CHECK_INT(retainedStoredNodeCount(scene.GetPointer()), 8);
+  CHECK_POINTER(sceneViewNode2->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"),
+                sceneViewNode1->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+
+  // A shared node is copied when it is modified, the first scene view keeps
+  // its own version
+  vtkMRMLScalarVolumeDisplayNode* displayNode = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(
+    scene->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  CHECK_NOT_NULL(displayNode);
+  double window = displayNode->GetWindow();
+  displayNode->SetAutoWindowLevel(0);
+  displayNode->SetWindowLevel(window + 100., 50.);
+  sceneViewNode2->StoreScene();
+  CHECK_INT(retainedStoredNodeCount(scene.GetPointer()), 9);
+  vtkMRMLScalarVolumeDisplayNode* storedDisplayNode1 = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(
+    sceneViewNode1->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  vtkMRMLScalarVolumeDisplayNode* storedDisplayNode2 = vtkMRMLScalarVolumeDisplayNode::SafeDownCast(
+    sceneViewNode2->GetStoredScene()->GetNodeByID("vtkMRMLScalarVolumeDisplayNode1"));
+  CHECK_NOT_NULL(storedDisplayNode1);
+  CHECK_NOT_NULL(storedDisplayNode2);
+  CHECK_POINTER_DIFFERENT(storedDisplayNode1, storedDisplayNode2);
+  CHECK_DOUBLE(storedDisplayNode1->GetWindow(), window);
+  CHECK_DOUBLE(storedDisplayNode2->GetWindow(), window + 100.);
+  CHECK_POINTER(storedDisplayNode2->GetScene(), sceneViewNode2->GetStoredScene());
+
+  // Restoring the first scene view restores its own version
+  sceneViewNode1->RestoreScene();
+  CHECK_DOUBLE(displayNode->GetWindow(), window);
+
+  // Shared nodes remain valid when the scene view they belong to is deleted
+  scene->RemoveNode(sceneViewNode1);
+  sceneViewNode1 = NULL;
+  CHECK_INT(retainedStoredNodeCount(scene.GetPointer()), 6);
+  sceneViewNode2->RestoreScene();
+  CHECK_DOUBLE(displayNode->GetWindow(), window + 100.);
+  vtkMRMLScene* storedScene = sceneViewNode2->GetStoredScene();
+  for (int n = 0; n < storedScene->GetNumberOfNodes(); ++n)
+    {
+    CHECK_POINTER(storedScene->GetNthNode(n)->GetScene(), storedScene);
+    }
+
+  return EXIT_SUCCESS;
+}
+
 //---------------------------------------------------------------------------
 int storePerformance()
 {
@@ -0,0 +1,187 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSubjectHierarchyNode.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+const char UID_NAME[] = "DICOM";
+
+//---------------------------------------------------------------------------
+// Reference lookups: linear scan of all the items in tree order
+vtkIdType findItemByUIDLinear(vtkMRMLSubjectHierarchyNode* shNode, const std::string& uidValue)
+{
+  std::vector<vtkIdType> itemIDs;
+  shNode->GetItemChildren(shNode->GetSceneItemID(), itemIDs, true);
+  for (std::vector<vtkIdType>::iterator itemIt = itemIDs.begin(); itemIt != itemIDs.end(); ++itemIt)
+    {
+    if (shNode->GetItemUID(*itemIt, UID_NAME) == uidValue)
+      {
+      return *itemIt;
+      }
+    }
+  return vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType findItemByDataNodeLinear(vtkMRMLSubjectHierarchyNode* shNode, vtkMRMLNode* dataNode)
+{
+  std::vector<vtkIdType> itemIDs;
+  shNode->GetItemChildren(shNode->GetSceneItemID(), itemIDs, true);
+  for (std::vector<vtkIdType>::iterator itemIt = itemIDs.begin(); itemIt != itemIDs.end(); ++itemIt)
+    {
+    if (shNode->GetItemDataNode(*itemIt) == dataNode)
+      {
+      return *itemIt;
+      }
+    }
+  return vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID;
+}
+
+//---------------------------------------------------------------------------
+std::string uidValue(int index)
+{
+  std::stringstream ss;
+  ss << "1.2.840." << index;
+  return ss.str();
+}
+
+//---------------------------------------------------------------------------
+// Check lookup of all the data nodes and of all the UID values used by the test (including
+// removed and replaced ones) against the linear scan
+int checkLookups(vtkMRMLSubjectHierarchyNode* shNode, std::vector<vtkSmartPointer<vtkMRMLNode> >& dataNodes)
+{
+  for (std::vector<vtkSmartPointer<vtkMRMLNode> >::iterator nodeIt = dataNodes.begin(); nodeIt != dataNodes.end(); ++nodeIt)
+    {
+    CHECK_INT(shNode->GetItemByDataNode(*nodeIt), findItemByDataNodeLinear(shNode, *nodeIt));
+    }
+  for (int index = 0; index < 40; ++index)
+    {
+    std::string uid = uidValue(index);
+    CHECK_INT(shNode->GetItemByUID(UID_NAME, uid.c_str()), findItemByUIDLinear(shNode, uid));
+    }
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, "9.9.9"), findItemByUIDLinear(shNode, "9.9.9"));
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+// Patients / studies / series with data nodes. Series UIDs are shared between patients
+// so that several items match a UID.
+void populate(vtkMRMLScene* scene, vtkMRMLSubjectHierarchyNode* shNode,
+              std::vector<vtkSmartPointer<vtkMRMLNode> >& dataNodes,
+              std::vector<vtkIdType>& studyItemIDs, std::vector<vtkIdType>& seriesItemIDs)
+{
+  int uidIndex = 0;
+  for (int patient = 0; patient < 3; ++patient)
+    {
+    vtkIdType patientItemID = shNode->CreateSubjectItem(shNode->GetSceneItemID(), "Patient");
+    shNode->SetItemUID(patientItemID, UID_NAME, uidValue(uidIndex++));
+    for (int study = 0; study < 2; ++study)
+      {
+      vtkIdType studyItemID = shNode->CreateStudyItem(patientItemID, "Study");
+      shNode->SetItemUID(studyItemID, UID_NAME, uidValue(uidIndex++));
+      studyItemIDs.push_back(studyItemID);
+      for (int series = 0; series < 3; ++series)
+        {
+        vtkSmartPointer<vtkMRMLNode> dataNode = vtkSmartPointer<vtkMRMLModelNode>::New();
+        scene->AddNode(dataNode);
+        dataNodes.push_back(dataNode);
+        vtkIdType seriesItemID = shNode->CreateItem(studyItemID, dataNode);
+        shNode->SetItemUID(seriesItemID, UID_NAME, uidValue(30 + study * 3 + series));
+        seriesItemIDs.push_back(seriesItemID);
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSubjectHierarchyNodeLookupTest(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+
+  std::vector<vtkSmartPointer<vtkMRMLNode> > dataNodes;
+  std::vector<vtkIdType> studyItemIDs;
+  std::vector<vtkIdType> seriesItemIDs;
+  populate(scene.GetPointer(), shNode, dataNodes, studyItemIDs, seriesItemIDs);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+  // Shared UID is found in the first patient
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(30).c_str()), seriesItemIDs[0]);
+
+  // Replacing a UID removes the old value from the index
+  shNode->SetItemUID(seriesItemIDs[0], UID_NAME, "9.9.9");
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, "9.9.9"), seriesItemIDs[0]);
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(30).c_str()), seriesItemIDs[6]);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+  shNode->SetItemUID(seriesItemIDs[0], UID_NAME, uidValue(30));
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, "9.9.9"), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+
+  // Reparenting a series before its duplicate in tree order changes the found item
+  shNode->SetItemParent(seriesItemIDs[7], studyItemIDs[0]);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+  shNode->SetItemParent(seriesItemIDs[1], studyItemIDs[4]);
+  CHECK_INT(shNode->GetItemByDataNode(dataNodes[1]), seriesItemIDs[1]);
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(31).c_str()), seriesItemIDs[7]);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+
+  // Removing an item removes it from the indices, its duplicate is found instead
+  CHECK_BOOL(shNode->RemoveItem(seriesItemIDs[2], false, false), true);
+  CHECK_INT(shNode->GetItemByDataNode(dataNodes[2]), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(32).c_str()), seriesItemIDs[8]);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+
+  // Removing a branch removes all its items from the indices
+  CHECK_BOOL(shNode->RemoveItem(studyItemIDs[1], false, true), true);
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(2).c_str()), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByDataNode(dataNodes[3]), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+
+  // Removing the children of an item keeps the children in the tree
+  CHECK_BOOL(shNode->RemoveItem(studyItemIDs[2], false, false), true);
+  CHECK_INT(shNode->GetItemByDataNode(dataNodes[6]), seriesItemIDs[6]);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+
+  // Clearing the scene deletes the subject hierarchy, no item is found in the new one
+  scene->Clear(1);
+  shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(0).c_str()), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+  CHECK_INT(shNode->GetItemByDataNode(dataNodes[0]), vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID);
+
+  // Items created again with the same UIDs are found in the new subject hierarchy
+  std::vector<vtkSmartPointer<vtkMRMLNode> > newDataNodes;
+  studyItemIDs.clear();
+  seriesItemIDs.clear();
+  populate(scene.GetPointer(), shNode, newDataNodes, studyItemIDs, seriesItemIDs);
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, newDataNodes));
+  CHECK_EXIT_SUCCESS(checkLookups(shNode, dataNodes));
+  CHECK_INT(shNode->GetItemByUID(UID_NAME, uidValue(30).c_str()), seriesItemIDs[0]);
+
+  return EXIT_SUCCESS;
+}
@@ -24,15 +24,25 @@
 #include "vtkMRMLTableNode.h"
 #include "vtkMRMLTableSQLiteStorageNode.h"
 
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
+#include "vtkSQLiteDatabase.h"
+#include "vtkSQLiteQuery.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
 #include "vtkTable.h"
 #include "vtkTestErrorObserver.h"
+#include "vtkTypeInt64Array.h"
+#include "vtkVariantArray.h"
 
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
 
 #include "vtkMRMLCoreTestingMacros.h"
 
+// STD includes
+#include <sstream>
+
 static int removeFile(char *fileName)
 {
   int removed = 1;
@@ -81,7 +91,8 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
   tableNode->SetAndObserveTable(table.GetPointer());
 
   storageNode->SetFileName("testSQLite.db");
-  storageNode->SetTableName("SinCos");
+  // table names are quoted in the queries
+  storageNode->SetTableName("Sin 'Cos'");
   removeFile(storageNode->GetFileName());
 
   storageNode->WriteData(tableNode.GetPointer());
@@ -111,6 +122,89 @@ int vtkMRMLTableSQLiteStorageNodeTest(int , char * [] )
     return EXIT_FAILURE;
     }
 
+  // float columns are read as double
+  vtkDoubleArray* readArrC = vtkDoubleArray::SafeDownCast(tableNode->GetTable()->GetColumnByName("Cosine"));
+  if (!readArrC || fabs(readArrC->GetValue(5) - cos(5 * inc)) > 1e-5)
+    {
+    std::cerr << "Unexpected values read from the database " << storageNode->GetFileName() << std::endl;
+    removeFile(storageNode->GetFileName());
+    return EXIT_FAILURE;
+    }
+
+  // Write integer and string columns, appending rows to the database table
+  // in two chunks
+  vtkNew<vtkTable> typedTable;
+  vtkNew<vtkTypeInt64Array> arrIndex;
+  arrIndex->SetName("Index");
+  typedTable->AddColumn(arrIndex.GetPointer());
+  vtkNew<vtkStringArray> arrLabel;
+  arrLabel->SetName("Label");
+  typedTable->AddColumn(arrLabel.GetPointer());
+  const int numberOfRowsPerChunk = 10;
+  // does not fit in 32 bits
+  const vtkTypeInt64 largeIndex = static_cast<vtkTypeInt64>(5) * 1000000000;
+  typedTable->SetNumberOfRows(numberOfRowsPerChunk);
+  tableNode->SetAndObserveTable(typedTable.GetPointer());
+  storageNode->SetTableName("Labels");
+  for (int chunk = 0; chunk < 2; ++chunk)
+    {
+    for (int i = 0; i < numberOfRowsPerChunk; ++i)
+      {
+      int index = chunk * numberOfRowsPerChunk + i;
+      arrIndex->SetValue(i, index);
+      if (index == 19)
+        {
+        arrIndex->SetValue(i, largeIndex);
+        }
+      std::stringstream label;
+      label << "label '" << index << "'";
+      arrLabel->SetValue(i, label.str());
+      }
+    storageNode->SetAppendRows(chunk > 0);
+    CHECK_INT(storageNode->WriteData(tableNode.GetPointer()), 1);
+    }
+
+  // Read the second half of the rows
+  storageNode->SetFirstRowToRead(15);
+  storageNode->SetMaximumNumberOfRowsToRead(10);
+  CHECK_INT(storageNode->ReadData(tableNode.GetPointer()), 1);
+  CHECK_INT(tableNode->GetNumberOfRows(), 5);
+  vtkTypeInt64Array* readArrIndex = vtkTypeInt64Array::SafeDownCast(tableNode->GetTable()->GetColumnByName("Index"));
+  vtkStringArray* readArrLabel = vtkStringArray::SafeDownCast(tableNode->GetTable()->GetColumnByName("Label"));
+  CHECK_NOT_NULL(readArrIndex);
+  CHECK_NOT_NULL(readArrLabel);
+  CHECK_INT(readArrIndex->GetValue(0), 15);
+  CHECK_BOOL(readArrIndex->GetValue(4) == largeIndex, true);
+  CHECK_STD_STRING(readArrLabel->GetValue(4), "label '19'");
+
+  // NULL values of an integer column are read as invalid variants
+  {
+  std::string dbname = std::string("sqlite://") + storageNode->GetFileName();
+  vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(
+    vtkSQLiteDatabase::SafeDownCast(vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
+  CHECK_BOOL(database->Open(NULL, vtkSQLiteDatabase::USE_EXISTING), true);
+  vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
+    vtkSQLiteQuery::SafeDownCast(database->GetQueryInstance()));
+  query->SetQuery("INSERT INTO \"Labels\" VALUES (NULL, 'no index')");
+  CHECK_BOOL(query->Execute(), true);
+  database->Close();
+  }
+  storageNode->SetMaximumNumberOfRowsToRead(0);
+  CHECK_INT(storageNode->ReadData(tableNode.GetPointer()), 1);
+  CHECK_INT(tableNode->GetNumberOfRows(), 6);
+  vtkVariantArray* readVariantIndex = vtkVariantArray::SafeDownCast(tableNode->GetTable()->GetColumnByName("Index"));
+  CHECK_NOT_NULL(readVariantIndex);
+  CHECK_INT(readVariantIndex->GetValue(0).ToInt(), 15);
+  CHECK_BOOL(readVariantIndex->GetValue(4).ToTypeInt64() == largeIndex, true);
+  CHECK_BOOL(readVariantIndex->GetValue(5).IsValid(), false);
+
+  // Previous table is still in the database
+  storageNode->SetTableName("Sin 'Cos'");
+  storageNode->SetFirstRowToRead(0);
+  storageNode->SetMaximumNumberOfRowsToRead(0);
+  CHECK_INT(storageNode->ReadData(tableNode.GetPointer()), 1);
+  CHECK_INT(tableNode->GetNumberOfRows(), numPoints);
+
   // clean up
   removeFile(storageNode->GetFileName());
 
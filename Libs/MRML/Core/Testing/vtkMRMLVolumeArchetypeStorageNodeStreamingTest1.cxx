@@ -0,0 +1,133 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+//---------------------------------------------------------------------------
+int TestStreamingRead(vtkMRMLScene* scene, const char* extension);
+
+//---------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNodeStreamingTest1(int argc, char * argv[] )
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetRootDirectory(argv[1]);
+
+  CHECK_EXIT_SUCCESS(TestStreamingRead(scene.GetPointer(), ".nrrd"));
+  CHECK_EXIT_SUCCESS(TestStreamingRead(scene.GetPointer(), ".mha"));
+  CHECK_EXIT_SUCCESS(TestStreamingRead(scene.GetPointer(), ".nii"));
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestStreamingRead(vtkMRMLScene* scene, const char* extension)
+{
+  std::string fileName = std::string(scene->GetRootDirectory()) +
+                         std::string("/vtkMRMLVolumeArchetypeStorageNodeStreamingTest1") +
+                         std::string(extension);
+  std::cout << "Testing " << extension << std::endl;
+
+  // Write a volume with a distinct value in each voxel
+  const int dimensions[3] = {20, 30, 40};
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  vtkIdType numberOfVoxels = imageData->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    voxels[i] = static_cast<short>(i % 30000);
+    }
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  CHECK_NOT_NULL(scene->AddNode(volumeNode.GetPointer()));
+
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  CHECK_NOT_NULL(scene->AddNode(storageNode.GetPointer()));
+  volumeNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetUseCompression(0);
+  CHECK_BOOL(storageNode->WriteData(volumeNode.GetPointer()), true);
+
+  // Read only the header
+  vtkNew<vtkMRMLScalarVolumeNode> streamedVolumeNode;
+  CHECK_NOT_NULL(scene->AddNode(streamedVolumeNode.GetPointer()));
+  storageNode->StreamingReadOn();
+  CHECK_BOOL(storageNode->ReadData(streamedVolumeNode.GetPointer()), true);
+  vtkAlgorithmOutput* connection = streamedVolumeNode->GetImageDataConnection();
+  CHECK_NOT_NULL(connection);
+  vtkAlgorithm* producer = connection->GetProducer();
+  vtkImageData* streamedImageData = streamedVolumeNode->GetImageData();
+  CHECK_NOT_NULL(streamedImageData);
+
+  // Request a single slice and a brick
+  int requestedExtents[2][6] = { {0, 19, 0, 29, 17, 17}, {3, 8, 10, 25, 5, 12} };
+  for (int request = 0; request < 2; ++request)
+    {
+    const int* requestedExtent = requestedExtents[request];
+    producer->UpdateExtent(requestedExtent);
+    // Only part of the volume is read
+    if (streamedImageData->GetNumberOfPoints() >= numberOfVoxels)
+      {
+      std::cerr << "Line " << __LINE__ << ": expected a partial read, got "
+                << streamedImageData->GetNumberOfPoints() << " of " << numberOfVoxels << " voxels" << std::endl;
+      return EXIT_FAILURE;
+      }
+    int* extent = streamedImageData->GetExtent();
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      if (extent[2*axis] > requestedExtent[2*axis] || extent[2*axis+1] < requestedExtent[2*axis+1])
+        {
+        std::cerr << "Line " << __LINE__ << ": streamed extent does not contain requested extent" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    for (int k = requestedExtent[4]; k <= requestedExtent[5]; ++k)
+      {
+      for (int j = requestedExtent[2]; j <= requestedExtent[3]; ++j)
+        {
+        for (int i = requestedExtent[0]; i <= requestedExtent[1]; ++i)
+          {
+          CHECK_INT(*static_cast<short*>(streamedImageData->GetScalarPointer(i, j, k)),
+                    *static_cast<short*>(imageData->GetScalarPointer(i, j, k)));
+          }
+        }
+      }
+    }
+
+  // The whole volume is read when the whole extent is requested
+  producer->Update();
+  int* dims = streamedImageData->GetDimensions();
+  CHECK_INT(dims[0], dimensions[0]);
+  CHECK_INT(dims[1], dimensions[1]);
+  CHECK_INT(dims[2], dimensions[2]);
+  CHECK_INT(*static_cast<short*>(streamedImageData->GetScalarPointer(19, 29, 39)),
+            *static_cast<short*>(imageData->GetScalarPointer(19, 29, 39)));
+
+  return EXIT_SUCCESS;
+}
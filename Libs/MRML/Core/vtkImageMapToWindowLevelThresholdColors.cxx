@@ -0,0 +1,439 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkImageMapToWindowLevelThresholdColors.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataArray.h>
+#include <vtkExecutive.h>
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkScalarsToColors.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageMapToWindowLevelThresholdColors);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Windowed (luminance) value of a voxel, computed the same way as
+// vtkImageMapToWindowLevelColors does
+template <class T>
+class WindowLevelMapper
+{
+public:
+  WindowLevelMapper(double window, double level, double typeMin, double typeMax)
+  {
+    this->Shift = window / 2.0 - level;
+    this->Scale = 255.0 / window;
+
+    double fLower = level - fabs(window) / 2.0;
+    double fUpper = fLower + fabs(window);
+    double adjustedLower, adjustedUpper;
+    if (fLower <= typeMax)
+      {
+      if (fLower >= typeMin)
+        {
+        this->Lower = static_cast<T>(fLower);
+        adjustedLower = fLower;
+        }
+      else
+        {
+        this->Lower = static_cast<T>(typeMin);
+        adjustedLower = typeMin;
+        }
+      }
+    else
+      {
+      this->Lower = static_cast<T>(typeMax);
+      adjustedLower = typeMax;
+      }
+    if (fUpper >= typeMin)
+      {
+      if (fUpper <= typeMax)
+        {
+        this->Upper = static_cast<T>(fUpper);
+        adjustedUpper = fUpper;
+        }
+      else
+        {
+        this->Upper = static_cast<T>(typeMax);
+        adjustedUpper = typeMax;
+        }
+      }
+    else
+      {
+      this->Upper = static_cast<T>(typeMin);
+      adjustedUpper = typeMin;
+      }
+
+    double fLowerValue = 0.;
+    double fUpperValue = 255.;
+    if (window > 0)
+      {
+      fLowerValue = 255.0 * (adjustedLower - fLower) / window;
+      fUpperValue = 255.0 * (adjustedUpper - fLower) / window;
+      }
+    else if (window < 0)
+      {
+      fLowerValue = 255.0 + 255.0 * (adjustedLower - fLower) / window;
+      fUpperValue = 255.0 + 255.0 * (adjustedUpper - fLower) / window;
+      }
+    this->LowerValue = ClampToByte(fLowerValue);
+    this->UpperValue = ClampToByte(fUpperValue);
+  }
+
+  unsigned char operator()(T value)const
+  {
+    if (value <= this->Lower)
+      {
+      return this->LowerValue;
+      }
+    if (value >= this->Upper)
+      {
+      return this->UpperValue;
+      }
+    return static_cast<unsigned char>((value + this->Shift) * this->Scale);
+  }
+
+protected:
+  static unsigned char ClampToByte(double value)
+  {
+    if (value > 255.)
+      {
+      return 255;
+      }
+    if (value < 0.)
+      {
+      return 0;
+      }
+    return static_cast<unsigned char>(value);
+  }
+
+  double Shift;
+  double Scale;
+  T Lower;
+  T Upper;
+  unsigned char LowerValue;
+  unsigned char UpperValue;
+};
+
+//----------------------------------------------------------------------------
+// Threshold test, computed the same way as vtkImageThreshold does
+template <class T>
+class ThresholdTester
+{
+public:
+  ThresholdTester(double lower, double upper, bool apply, double typeMin, double typeMax)
+    : Apply(apply)
+  {
+    this->Lower = static_cast<T>(lower < typeMin ? typeMin : (lower > typeMax ? typeMax : lower));
+    this->Upper = static_cast<T>(upper < typeMin ? typeMin : (upper > typeMax ? typeMax : upper));
+  }
+
+  bool operator()(T value)const
+  {
+    return !this->Apply || (this->Lower <= value && value <= this->Upper);
+  }
+
+protected:
+  bool Apply;
+  T Lower;
+  T Upper;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+bool HasValueTable()
+{
+  return sizeof(T) <= 2 && std::numeric_limits<T>::is_integer;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void BuildValueTable(vtkImageMapToWindowLevelThresholdColors* self, double typeMin, double typeMax,
+                     const std::vector<unsigned char>& colors, std::vector<unsigned char>& valueColors)
+{
+  WindowLevelMapper<T> windowLevel(self->GetWindow(), self->GetLevel(), typeMin, typeMax);
+  ThresholdTester<T> threshold(self->GetLowerThreshold(), self->GetUpperThreshold(),
+                               self->GetApplyThreshold() != 0, typeMin, typeMax);
+  const int numberOfValues = static_cast<int>(typeMax - typeMin) + 1;
+  valueColors.resize(4 * numberOfValues);
+  unsigned char* valueColor = &valueColors[0];
+  for (int i = 0; i < numberOfValues; ++i, valueColor += 4)
+    {
+    T value = static_cast<T>(typeMin + i);
+    const unsigned char* color = &colors[4 * windowLevel(value)];
+    valueColor[0] = color[0];
+    valueColor[1] = color[1];
+    valueColor[2] = color[2];
+    valueColor[3] = (threshold(value) && color[3] != 0) ? 255 : 0;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void MapVoxels(vtkImageMapToWindowLevelThresholdColors* self, vtkImageData* inData, T* inPtr,
+               vtkImageData* outData, unsigned char* outPtr, vtkImageStencilData* stencil,
+               const std::vector<unsigned char>& colors, const std::vector<unsigned char>& valueColors,
+               int extent[6])
+{
+  const double typeMin = inData->GetScalarTypeMin();
+  const double typeMax = inData->GetScalarTypeMax();
+  WindowLevelMapper<T> windowLevel(self->GetWindow(), self->GetLevel(), typeMin, typeMax);
+  ThresholdTester<T> threshold(self->GetLowerThreshold(), self->GetUpperThreshold(),
+                               self->GetApplyThreshold() != 0, typeMin, typeMax);
+  const bool useValueColors = !valueColors.empty();
+  const int valueOffset = useValueColors ? -static_cast<int>(typeMin) : 0;
+
+  const int numberOfComponents = inData->GetNumberOfScalarComponents();
+  vtkIdType inIncX, inIncY, inIncZ;
+  vtkIdType outIncX, outIncY, outIncZ;
+  inData->GetContinuousIncrements(extent, inIncX, inIncY, inIncZ);
+  outData->GetContinuousIncrements(extent, outIncX, outIncY, outIncZ);
+  const int rowLength = extent[1] - extent[0] + 1;
+
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      unsigned char* rowPtr = outPtr;
+      if (useValueColors)
+        {
+        const unsigned char* table = &valueColors[0];
+        for (int x = 0; x < rowLength; ++x, inPtr += numberOfComponents, outPtr += 4)
+          {
+          memcpy(outPtr, table + 4 * (static_cast<int>(*inPtr) + valueOffset), 4);
+          }
+        }
+      else
+        {
+        for (int x = 0; x < rowLength; ++x, inPtr += numberOfComponents, outPtr += 4)
+          {
+          const unsigned char* color = &colors[4 * windowLevel(*inPtr)];
+          outPtr[0] = color[0];
+          outPtr[1] = color[1];
+          outPtr[2] = color[2];
+          outPtr[3] = (threshold(*inPtr) && color[3] != 0) ? 255 : 0;
+          }
+        }
+      if (stencil)
+        {
+        // voxels outside of the stencil are transparent
+        int iter = 0;
+        int r1, r2;
+        int nextX = extent[0];
+        while (stencil->GetNextExtent(r1, r2, extent[0], extent[1], y, z, iter))
+          {
+          for (int x = nextX; x < r1; ++x)
+            {
+            rowPtr[4 * (x - extent[0]) + 3] = 0;
+            }
+          nextX = r2 + 1;
+          }
+        for (int x = nextX; x <= extent[1]; ++x)
+          {
+          rowPtr[4 * (x - extent[0]) + 3] = 0;
+          }
+        }
+      inPtr += inIncY;
+      outPtr += outIncY;
+      }
+    inPtr += inIncZ;
+    outPtr += outIncZ;
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageMapToWindowLevelThresholdColors::vtkImageMapToWindowLevelThresholdColors()
+{
+  this->Window = 255.;
+  this->Level = 127.5;
+  this->LowerThreshold = VTK_SHORT_MIN;
+  this->UpperThreshold = VTK_SHORT_MAX;
+  this->ApplyThreshold = 0;
+  this->LookupTable = 0;
+  this->TablesScalarType = -1;
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageMapToWindowLevelThresholdColors::~vtkImageMapToWindowLevelThresholdColors()
+{
+  this->SetLookupTable(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "Window: " << this->Window << "\n";
+  os << indent << "Level: " << this->Level << "\n";
+  os << indent << "LowerThreshold: " << this->LowerThreshold << "\n";
+  os << indent << "UpperThreshold: " << this->UpperThreshold << "\n";
+  os << indent << "ApplyThreshold: " << this->ApplyThreshold << "\n";
+  os << indent << "LookupTable: " << this->LookupTable << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkImageMapToWindowLevelThresholdColors, LookupTable, vtkScalarsToColors);
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::SetStencilConnection(vtkAlgorithmOutput* stencilConnection)
+{
+  this->SetInputConnection(1, stencilConnection);
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkImageMapToWindowLevelThresholdColors::GetStencilConnection()
+{
+  return this->GetNumberOfInputConnections(1) ? this->GetInputConnection(1, 0) : 0;
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkImageMapToWindowLevelThresholdColors::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->LookupTable)
+    {
+    vtkMTimeType lookupTableMTime = this->LookupTable->GetMTime();
+    mTime = (lookupTableMTime > mTime ? lookupTableMTime : mTime);
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::FillInputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageStencilData");
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    return 1;
+    }
+  return this->Superclass::FillInputPortInformation(port, info);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::RequestInformation(
+  vtkInformation * vtkNotUsed(request),
+  vtkInformationVector **vtkNotUsed(inputVector),
+  vtkInformationVector *outputVector)
+{
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageMapToWindowLevelThresholdColors::RequestData(
+  vtkInformation *request, vtkInformationVector **inputVector, vtkInformationVector *outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  if (!input || !input->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("RequestData: no input scalars");
+    return 0;
+    }
+  // tables are shared by all the threads, build them before splitting the work
+  this->UpdateTables(input);
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::UpdateTables(vtkImageData* input)
+{
+  const int scalarType = input->GetScalarType();
+  if (scalarType == this->TablesScalarType
+    && this->TablesBuildTime > this->GetMTime())
+    {
+    return;
+    }
+
+  this->Colors.resize(4 * 256);
+  if (this->LookupTable)
+    {
+    unsigned char values[256];
+    for (int i = 0; i < 256; ++i)
+      {
+      values[i] = static_cast<unsigned char>(i);
+      }
+    this->LookupTable->Build();
+    this->LookupTable->MapScalarsThroughTable2(values, &this->Colors[0],
+                                               VTK_UNSIGNED_CHAR, 256, 1, VTK_RGBA);
+    }
+  else
+    {
+    for (int i = 0; i < 256; ++i)
+      {
+      this->Colors[4 * i] = this->Colors[4 * i + 1] = this->Colors[4 * i + 2] = static_cast<unsigned char>(i);
+      this->Colors[4 * i + 3] = 255;
+      }
+    }
+
+  this->ValueColors.clear();
+  const double typeMin = input->GetScalarTypeMin();
+  const double typeMax = input->GetScalarTypeMax();
+  switch (scalarType)
+    {
+    vtkTemplateMacro(
+      if (HasValueTable<VTK_TT>())
+        {
+        BuildValueTable<VTK_TT>(this, typeMin, typeMax, this->Colors, this->ValueColors);
+        });
+    }
+
+  this->TablesScalarType = scalarType;
+  this->TablesBuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageMapToWindowLevelThresholdColors::ThreadedRequestData(
+  vtkInformation * vtkNotUsed(request),
+  vtkInformationVector ** vtkNotUsed(inputVector),
+  vtkInformationVector * vtkNotUsed(outputVector),
+  vtkImageData ***inData,
+  vtkImageData **outData,
+  int extent[6], int vtkNotUsed(threadId))
+{
+  vtkImageData* input = inData[0][0];
+  vtkImageData* output = outData[0];
+  vtkImageStencilData* stencil = this->GetNumberOfInputConnections(1) ?
+    vtkImageStencilData::SafeDownCast(this->GetExecutive()->GetInputData(1, 0)) : 0;
+
+  void* inPtr = input->GetScalarPointerForExtent(extent);
+  unsigned char* outPtr = static_cast<unsigned char*>(output->GetScalarPointerForExtent(extent));
+
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(
+      MapVoxels<VTK_TT>(this, input, static_cast<VTK_TT*>(inPtr), output, outPtr, stencil,
+                        this->Colors, this->ValueColors, extent));
+    default:
+      vtkErrorMacro("ThreadedRequestData: unsupported scalar type");
+      return;
+    }
+}
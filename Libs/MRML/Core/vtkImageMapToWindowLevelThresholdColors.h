@@ -0,0 +1,116 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageMapToWindowLevelThresholdColors_h
+#define __vtkImageMapToWindowLevelThresholdColors_h
+
+// MRML includes
+#include "vtkMRML.h"
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+// STD includes
+#include <vector>
+
+class vtkAlgorithmOutput;
+class vtkScalarsToColors;
+
+/// \brief Map scalars to RGBA colors through a window/level, a color lookup
+/// table and a threshold in a single pass.
+///
+/// The output is the same as the one of the pipeline of
+/// vtkMRMLScalarVolumeDisplayNode: vtkImageMapToWindowLevelColors (luminance),
+/// vtkImageMapToColors (RGBA), vtkImageThreshold and vtkImageLogic combining the
+/// threshold with the alpha of the colors and with an optional stencil.
+/// The output alpha is either 0 or 255.
+///
+/// For 8 and 16-bit integer scalars, the color of every possible scalar value
+/// is computed once in a table when the window, level, threshold or lookup
+/// table change, voxels are then mapped with a single table lookup.
+/// Other scalar types are windowed voxel by voxel and mapped through a table
+/// of the 256 colors of the lookup table.
+/// Only the first component of the input is used.
+class VTK_MRML_EXPORT vtkImageMapToWindowLevelThresholdColors : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageMapToWindowLevelThresholdColors *New();
+  vtkTypeMacro(vtkImageMapToWindowLevelThresholdColors, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Window and level, as in vtkImageMapToWindowLevelColors
+  vtkSetMacro(Window, double);
+  vtkGetMacro(Window, double);
+  vtkSetMacro(Level, double);
+  vtkGetMacro(Level, double);
+
+  /// Voxels with a value outside of [LowerThreshold, UpperThreshold] are
+  /// transparent if ApplyThreshold is enabled
+  vtkSetMacro(LowerThreshold, double);
+  vtkGetMacro(LowerThreshold, double);
+  vtkSetMacro(UpperThreshold, double);
+  vtkGetMacro(UpperThreshold, double);
+  vtkSetMacro(ApplyThreshold, int);
+  vtkGetMacro(ApplyThreshold, int);
+  vtkBooleanMacro(ApplyThreshold, int);
+
+  /// Lookup table mapping the windowed values (0 to 255) to colors.
+  /// If not set, the output is grey.
+  virtual void SetLookupTable(vtkScalarsToColors* lookupTable);
+  vtkGetObjectMacro(LookupTable, vtkScalarsToColors);
+
+  /// Optional stencil, voxels outside of the stencil are transparent
+  void SetStencilConnection(vtkAlgorithmOutput* stencilConnection);
+  vtkAlgorithmOutput* GetStencilConnection();
+
+  /// Include the modification time of the lookup table
+  vtkMTimeType GetMTime() VTK_OVERRIDE;
+
+protected:
+  vtkImageMapToWindowLevelThresholdColors();
+  ~vtkImageMapToWindowLevelThresholdColors();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info) VTK_OVERRIDE;
+  virtual int RequestInformation(vtkInformation *, vtkInformationVector **,
+                                 vtkInformationVector *) VTK_OVERRIDE;
+  virtual int RequestData(vtkInformation *, vtkInformationVector **,
+                          vtkInformationVector *) VTK_OVERRIDE;
+  virtual void ThreadedRequestData(vtkInformation *request,
+                                   vtkInformationVector **inputVector,
+                                   vtkInformationVector *outputVector,
+                                   vtkImageData ***inData,
+                                   vtkImageData **outData,
+                                   int extent[6], int threadId) VTK_OVERRIDE;
+
+  /// Rebuild the color tables if the parameters or the input scalar type changed
+  void UpdateTables(vtkImageData* input);
+
+  double Window;
+  double Level;
+  double LowerThreshold;
+  double UpperThreshold;
+  int ApplyThreshold;
+  vtkScalarsToColors* LookupTable;
+
+  /// RGBA of the 256 windowed values
+  std::vector<unsigned char> Colors;
+  /// RGBA of every value of 8 and 16-bit scalar types, starting from the
+  /// minimum value of the type. Empty for other scalar types
+  std::vector<unsigned char> ValueColors;
+  int TablesScalarType;
+  vtkTimeStamp TablesBuildTime;
+
+private:
+  vtkImageMapToWindowLevelThresholdColors(const vtkImageMapToWindowLevelThresholdColors&);
+  void operator=(const vtkImageMapToWindowLevelThresholdColors&);
+};
+
+#endif
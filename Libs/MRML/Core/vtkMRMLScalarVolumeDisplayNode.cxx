@@ -31,6 +31,7 @@ Version:   $Revision: 1.2 $
 #include <vtkImageData.h>
 #include <vtkImageLogic.h>
 #include <vtkImageMapToWindowLevelColors.h>
+#include <vtkImageMapToWindowLevelThresholdColors.h>
 #include <vtkImageStencil.h>
 #include <vtkImageThreshold.h>
 #include <vtkObjectFactory.h>
@@ -105,6 +106,13 @@ vtkMRMLScalarVolumeDisplayNode::vtkMRMLScalarVolumeDisplayNode()
   this->AppendComponents->AddInputConnection(0, this->ExtractRGB->GetOutputPort() );
   this->AppendComponents->AddInputConnection(0, this->AlphaLogic->GetOutputPort() );
 
+  this->MapToWindowLevelThresholdColors = vtkImageMapToWindowLevelThresholdColors::New();
+  this->MapToWindowLevelThresholdColors->SetWindow(256.);
+  this->MapToWindowLevelThresholdColors->SetLevel(128.);
+  this->MapToWindowLevelThresholdColors->SetLowerThreshold(VTK_SHORT_MIN);
+  this->MapToWindowLevelThresholdColors->SetUpperThreshold(VTK_SHORT_MAX);
+  this->MapToWindowLevelThresholdColors->SetApplyThreshold(0);
+
   this->Bimodal = NULL;
   this->Accumulate = NULL;
   this->IsInCalculateAutoLevels = false;
@@ -126,6 +134,7 @@ vtkMRMLScalarVolumeDisplayNode::~vtkMRMLScalarVolumeDisplayNode()
   this->ExtractRGB->Delete();
   this->ExtractAlpha->Delete();
   this->MultiplyAlpha->Delete();
+  this->MapToWindowLevelThresholdColors->Delete();
 
   if (this->Bimodal)
     {
@@ -178,6 +187,7 @@ void vtkMRMLScalarVolumeDisplayNode
 {
   this->Threshold->SetInputConnection(imageDataConnection);
   this->MapToWindowLevelColors->SetInputConnection(imageDataConnection);
+  this->MapToWindowLevelThresholdColors->SetInputConnection(imageDataConnection);
 }
 
 //----------------------------------------------------------------------------
@@ -185,6 +195,7 @@ void vtkMRMLScalarVolumeDisplayNode
 ::SetBackgroundImageStencilDataConnection(vtkAlgorithmOutput *imageDataConnection)
 {
   this->MultiplyAlpha->SetStencilConnection(imageDataConnection);
+  this->MapToWindowLevelThresholdColors->SetStencilConnection(imageDataConnection);
 }
 //----------------------------------------------------------------------------
 vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetBackgroundImageStencilDataConnection()
@@ -206,6 +217,10 @@ vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetInputImageDataConnection(
 //----------------------------------------------------------------------------
 vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetOutputImageDataConnection()
 {
+  if (this->MapToWindowLevelThresholdColors->GetNumberOfInputConnections(0))
+    {
+    return this->MapToWindowLevelThresholdColors->GetOutputPort();
+    }
   return this->AppendComponents->GetOutputPort();
 }
 
@@ -441,6 +456,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetWindow(double window)
     }
 
   this->MapToWindowLevelColors->SetWindow(window);
+  this->MapToWindowLevelThresholdColors->SetWindow(window);
   this->Modified();
 }
 
@@ -459,6 +475,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetLevel(double level)
     }
 
   this->MapToWindowLevelColors->SetLevel(level);
+  this->MapToWindowLevelThresholdColors->SetLevel(level);
   this->Modified();
 }
 
@@ -473,6 +490,8 @@ void vtkMRMLScalarVolumeDisplayNode::SetWindowLevel(double window, double level)
 
   this->MapToWindowLevelColors->SetWindow(window);
   this->MapToWindowLevelColors->SetLevel(level);
+  this->MapToWindowLevelThresholdColors->SetWindow(window);
+  this->MapToWindowLevelThresholdColors->SetLevel(level);
   this->Modified();
 }
 
@@ -509,6 +528,7 @@ void vtkMRMLScalarVolumeDisplayNode::SetApplyThreshold(int apply)
     }
   this->ApplyThreshold = apply;
   this->Threshold->SetOutValue(apply ? 0 : 255);
+  this->MapToWindowLevelThresholdColors->SetApplyThreshold(apply);
   this->Modified();
 }
 
@@ -545,6 +565,8 @@ void vtkMRMLScalarVolumeDisplayNode::SetThreshold(double lowerThreshold, double
     return;
     }
   this->Threshold->ThresholdBetween( lowerThreshold, upperThreshold );
+  this->MapToWindowLevelThresholdColors->SetLowerThreshold(lowerThreshold);
+  this->MapToWindowLevelThresholdColors->SetUpperThreshold(upperThreshold);
   this->Modified();
 }
 
@@ -572,6 +594,7 @@ void vtkMRMLScalarVolumeDisplayNode::UpdateLookupTable(vtkMRMLColorNode* newColo
       }
     }
   this->MapToColors->SetLookupTable(lookupTable);
+  this->MapToWindowLevelThresholdColors->SetLookupTable(lookupTable);
 }
 
 //---------------------------------------------------------------------------
@@ -27,6 +27,7 @@ class vtkImageCast;
 class vtkImageLogic;
 class vtkImageMapToColors;
 class vtkImageMapToWindowLevelColors;
+class vtkImageMapToWindowLevelThresholdColors;
 class vtkImageStencil;
 class vtkImageThreshold;
 class vtkImageExtractComponents;
@@ -236,6 +237,13 @@ protected:
   vtkImageExtractComponents *ExtractAlpha;
   vtkImageStencil *MultiplyAlpha;
 
+  /// Single pass equivalent of the pipeline above, used as output when the
+  /// input is connected by SetInputToImageDataPipeline() (subclasses that
+  /// rewire the pipeline keep the output of AppendComponents).
+  /// Window, level, threshold and lookup table are kept in sync with the
+  /// filters above.
+  vtkImageMapToWindowLevelThresholdColors *MapToWindowLevelThresholdColors;
+
   ///
   /// window level presets
   std::vector<WindowLevelPreset> WindowLevelPresets;
@@ -87,6 +87,9 @@ Version:   $Revision: 1.18 $
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
 
+// vtkAddon includes
+#include <vtkTracingMacros.h>
+
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
 #include <vtksys/SystemTools.hxx>
@@ -296,6 +299,7 @@ void vtkMRMLScene::SceneCallback( vtkObject *vtkNotUsed(caller),
 //------------------------------------------------------------------------------
 void vtkMRMLScene::Clear(int removeSingletons)
 {
+  vtkTraceScopeMacro("MRML", "vtkMRMLScene::Clear");
 #ifdef MRMLSCENE_VERBOSE
   vtkTimerLog* timer = vtkTimerLog::New();
   timer->StartTimer();
@@ -710,6 +714,7 @@ void vtkMRMLScene::ProgressState(unsigned long state, int progress)
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Connect()
 {
+  vtkTraceScopeMacro("MRML", "vtkMRMLScene::Connect");
   if (this->IsClosing())
     {
     vtkWarningMacro("vtkMRMLScene::Connect(): scene is in closing state");
@@ -741,6 +746,7 @@ int vtkMRMLScene::Connect()
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Import()
 {
+  vtkTraceScopeMacro("MRML", "vtkMRMLScene::Import");
 #ifdef MRMLSCENE_VERBOSE
   vtkTimerLog* addNodesTimer = vtkTimerLog::New();
   vtkTimerLog* updateSceneTimer = vtkTimerLog::New();
@@ -942,6 +948,7 @@ int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
 //------------------------------------------------------------------------------
 int vtkMRMLScene::Commit(const char* url)
 {
+  vtkTraceScopeMacro("MRML", "vtkMRMLScene::Commit");
   if (url == NULL)
     {
     if (this->URL != "")
@@ -29,6 +29,7 @@ Version:   $Revision: 1.14 $
 
 // STD includes
 #include <cassert>
+#include <set>
 #include <sstream>
 #include <stack>
 
@@ -51,6 +52,20 @@ vtkMRMLSceneViewNode::~vtkMRMLSceneViewNode()
 {
   if (this->SnapshotScene)
     {
+    // Nodes shared with other scene views must not keep a pointer to the
+    // deleted scene, the other scene views take them back with
+    // UpdateStoredNodeScenes().
+    vtkCollectionSimpleIterator it;
+    vtkMRMLNode* node = NULL;
+    vtkCollection* storedNodes = this->SnapshotScene->GetNodes();
+    for (storedNodes->InitTraversal(it);
+         (node = vtkMRMLNode::SafeDownCast(storedNodes->GetNextItemAsObject(it))) ;)
+      {
+      if (node->GetScene() == this->SnapshotScene)
+        {
+        node->SetScene(NULL);
+        }
+      }
     this->SnapshotScene->Delete();
     this->SnapshotScene = 0;
     }
@@ -82,6 +97,7 @@ void vtkMRMLSceneViewNode::WriteNodeBodyXML(ostream& of, int nIndent)
     return;
     }
 
+  this->UpdateStoredNodeScenes();
   // first make sure that the scene view scene is to be saved relative to the same place as the main scene
   this->SnapshotScene->SetRootDirectory(this->GetScene()->GetRootDirectory());
   this->SetAbsentStorageFileNames();
@@ -243,6 +259,7 @@ void vtkMRMLSceneViewNode::Copy(vtkMRMLNode *anode)
     this->SnapshotScene->GetNodes()->RemoveAllItems();
     this->SnapshotScene->ClearNodeIDs();
     }
+  this->StoredNodeModifiedTimes = snode->StoredNodeModifiedTimes;
   vtkMRMLNode *node = NULL;
   if ( snode->SnapshotScene != NULL )
     {
@@ -300,6 +317,8 @@ void vtkMRMLSceneViewNode::UpdateStoredScene()
     return;
     }
 
+  this->UpdateStoredNodeScenes();
+
   unsigned int nnodesSanpshot = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
   vtkMRMLNode *node = NULL;
@@ -314,11 +333,12 @@ void vtkMRMLSceneViewNode::UpdateStoredScene()
       }
     }
 
-  // update nodes in the snapshot
+  // update nodes in the snapshot, shared nodes are updated by the scene view
+  // they belong to
   for (n=0; n<nnodesSanpshot; n++)
     {
     node  = vtkMRMLNode::SafeDownCast(this->SnapshotScene->GetNodes()->GetItemAsObject(n));
-    if (node)
+    if (node && node->GetScene() == this->SnapshotScene)
       {
       node->UpdateScene(this->SnapshotScene);
       }
@@ -349,15 +369,12 @@ void vtkMRMLSceneViewNode::StoreScene()
     {
     this->SnapshotScene = vtkMRMLScene::New();
     }
-  else
-    {
-    this->SnapshotScene->Clear(1);
-    }
 
   if (this->GetScene())
     {
     this->SnapshotScene->SetRootDirectory(this->GetScene()->GetRootDirectory());
     }
+  this->UpdateStoredNodeScenes();
 
   // make sure that any storable nodes in the scene have storage nodes before
   // saving them to the scene view, this prevents confusion on scene view
@@ -389,13 +406,94 @@ void vtkMRMLSceneViewNode::StoreScene()
       }
     }
 
-  /// \todo: GetNumberOfNodes/GetNthNode is slow, fasten by using collection
-  /// iterators.
-  for (int n=0; n < this->Scene->GetNumberOfNodes(); n++)
+  // Nodes stored previously are reused instead of clearing the stored scene:
+  // the ones that have not been modified since they were stored or restored
+  // are kept as they are, the others are copied again. Nodes that another
+  // scene view stored and that have not been modified since are shared.
+  std::vector<vtkMRMLSceneViewNode*> otherSceneViewNodes;
+  this->GetOtherSceneViewNodes(otherSceneViewNodes);
+  std::map<std::string, vtkSmartPointer<vtkMRMLNode> > previouslyStoredNodes;
+  vtkCollectionSimpleIterator it;
+  vtkMRMLNode* storedNode = NULL;
+  vtkCollection* storedNodes = this->SnapshotScene->GetNodes();
+  for (storedNodes->InitTraversal(it);
+       (storedNode = vtkMRMLNode::SafeDownCast(storedNodes->GetNextItemAsObject(it))) ;)
     {
-    vtkMRMLNode *node = this->Scene->GetNthNode(n);
-    if (this->IncludeNodeInSceneView(node) &&
-        node->GetSaveWithScene() )
+    if (storedNode->GetID())
+      {
+      previouslyStoredNodes[storedNode->GetID()] = storedNode;
+      }
+    }
+  std::map<std::string, NodeModifiedTimes> previousModifiedTimes;
+  previousModifiedTimes.swap(this->StoredNodeModifiedTimes);
+
+  vtkMRMLNode* node = NULL;
+  vtkCollection* sceneNodes = this->Scene->GetNodes();
+  for (sceneNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it))) ;)
+    {
+    if (!this->IncludeNodeInSceneView(node) ||
+        !node->GetSaveWithScene() )
+      {
+      continue;
+      }
+    storedNode = NULL;
+    std::map<std::string, vtkSmartPointer<vtkMRMLNode> >::iterator storedNodeIt =
+      previouslyStoredNodes.find(node->GetID());
+    if (storedNodeIt != previouslyStoredNodes.end())
+      {
+      bool isStored = (this->SnapshotScene->GetNodeByID(node->GetID()) == storedNodeIt->second);
+      if (isStored && strcmp(storedNodeIt->second->GetClassName(), node->GetClassName()) == 0)
+        {
+        storedNode = storedNodeIt->second;
+        }
+      else if (isStored)
+        {
+        this->RemoveStoredNode(storedNodeIt->second, otherSceneViewNodes);
+        }
+      previouslyStoredNodes.erase(storedNodeIt);
+      }
+
+    if (storedNode)
+      {
+      std::map<std::string, NodeModifiedTimes>::iterator modifiedTimesIt =
+        previousModifiedTimes.find(node->GetID());
+      if (modifiedTimesIt != previousModifiedTimes.end())
+        {
+        this->StoredNodeModifiedTimes[node->GetID()] = modifiedTimesIt->second;
+        }
+      if (this->IsStoredNodeUpToDate(node, storedNode))
+        {
+        continue;
+        }
+      }
+
+    vtkMRMLNode* sharedNode = this->GetSharedStoredNode(node, otherSceneViewNodes);
+    if (storedNode && sharedNode == storedNode)
+      {
+      // already shared with a scene view that stored or restored it since
+      this->SetStoredNodeUpToDate(node, storedNode);
+      continue;
+      }
+    if (storedNode && !sharedNode && !this->GetOtherSceneViewStoringNode(storedNode, otherSceneViewNodes))
+      {
+      // the stored node is not shared, update it in place
+      storedNode->CopyWithoutModifiedEvent(node);
+      this->SetStoredNodeUpToDate(node, storedNode);
+      continue;
+      }
+    if (storedNode)
+      {
+      // copy-on-write: the other scene views keep the stored node unchanged
+      this->RemoveStoredNode(storedNode, otherSceneViewNodes);
+      }
+
+    if (sharedNode)
+      {
+      this->AddSharedStoredNode(sharedNode);
+      storedNode = sharedNode;
+      }
+    else
       {
       vtkSmartPointer<vtkMRMLNode> newNode = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
 
@@ -409,8 +507,22 @@ void vtkMRMLSceneViewNode::StoreScene()
 
       // sanity check
       assert(newNode->GetScene() == this->SnapshotScene);
+      storedNode = newNode;
       }
+    this->SetStoredNodeUpToDate(node, storedNode);
     }
+
+  // Remove the stored nodes that are not in the scene anymore.
+  // Removing a node can have the side effect of removing other nodes.
+  std::map<std::string, vtkSmartPointer<vtkMRMLNode> >::iterator removedNodeIt;
+  for (removedNodeIt = previouslyStoredNodes.begin(); removedNodeIt != previouslyStoredNodes.end(); ++removedNodeIt)
+    {
+    if (this->SnapshotScene->GetNodeByID(removedNodeIt->first) == removedNodeIt->second)
+      {
+      this->RemoveStoredNode(removedNodeIt->second, otherSceneViewNodes);
+      }
+    }
+
   this->SnapshotScene->CopyNodeReferences(this->GetScene());
   this->SnapshotScene->CopyNodeChangedIDs(this->GetScene());
 }
@@ -501,6 +613,8 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
     return;
     }
 
+  this->UpdateStoredNodeScenes();
+
   unsigned int numNodesInSceneView = this->SnapshotScene->GetNodes()->GetNumberOfItems();
   unsigned int n;
   vtkMRMLNode *node = NULL;
@@ -550,6 +664,7 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
       removedNodes.push(vtkSmartPointer<vtkMRMLNode>(node));
       }
     }
+  bool nodesRemoved = !removedNodes.empty();
   while(!removedNodes.empty())
     {
     vtkMRMLNode* nodeToRemove = removedNodes.top().GetPointer();
@@ -579,6 +694,7 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
     }
 
   std::vector<vtkMRMLNode *> addedNodes;
+  std::set<vtkMRMLNode*> unmodifiedNodes;
   for (n=0; n < numNodesInSceneView; n++)
     {
     node = vtkMRMLNode::SafeDownCast(this->SnapshotScene->GetNodes()->GetItemAsObject(n));
@@ -592,10 +708,17 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
         if (snode)
           {
           snode->SetScene(this->Scene);
+          if (this->IsStoredNodeUpToDate(snode, node))
+            {
+            // the node has not changed since it was stored or restored
+            unmodifiedNodes.insert(snode);
+            continue;
+            }
           // to prevent copying of default info if not stored in snapshot
           snode->CopyWithSingleModifiedEvent(node);
           // to prevent reading data on UpdateScene()
           snode->SetAddToSceneNoModify(0);
+          this->SetStoredNodeUpToDate(snode, node);
           }
         else
           {
@@ -619,10 +742,17 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 
   //this->Scene->UpdateNodeReferences(this->Nodes);
 
+  // Unmodified nodes don't need to be updated, unless nodes they may
+  // reference have been added or removed.
+  if (nodesRemoved || !addedNodes.empty())
+    {
+    unmodifiedNodes.clear();
+    }
   for (sceneNodes->InitTraversal(it);
        (node = vtkMRMLNode::SafeDownCast(sceneNodes->GetNextItemAsObject(it))) ;)
     {
-    if (this->IncludeNodeInSceneView(node) && node->GetSaveWithScene())
+    if (this->IncludeNodeInSceneView(node) && node->GetSaveWithScene() &&
+        unmodifiedNodes.find(node) == unmodifiedNodes.end())
       {
       node->UpdateScene(this->Scene);
       }
@@ -647,9 +777,157 @@ void vtkMRMLSceneViewNode::RestoreScene(bool removeNodes)
 #endif
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLSceneViewNode::IsStoredNodeUpToDate(vtkMRMLNode* sceneNode, vtkMRMLNode* storedNode)
+{
+  if (!sceneNode || !storedNode || !sceneNode->GetID())
+    {
+    return false;
+    }
+  if (vtkMRMLStorableNode::SafeDownCast(sceneNode))
+    {
+    return false;
+    }
+  if (sceneNode->GetModifiedEventPending() > 0)
+    {
+    // the node is being modified
+    return false;
+    }
+  std::map<std::string, NodeModifiedTimes>::iterator modifiedTimesIt =
+    this->StoredNodeModifiedTimes.find(sceneNode->GetID());
+  if (modifiedTimesIt == this->StoredNodeModifiedTimes.end())
+    {
+    return false;
+    }
+  return modifiedTimesIt->second.SceneNodeMTime == sceneNode->GetMTime()
+    && modifiedTimesIt->second.StoredNodeMTime == storedNode->GetMTime();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneViewNode::SetStoredNodeUpToDate(vtkMRMLNode* sceneNode, vtkMRMLNode* storedNode)
+{
+  if (!sceneNode || !storedNode || !sceneNode->GetID())
+    {
+    return;
+    }
+  NodeModifiedTimes modifiedTimes;
+  modifiedTimes.SceneNodeMTime = sceneNode->GetMTime();
+  modifiedTimes.StoredNodeMTime = storedNode->GetMTime();
+  this->StoredNodeModifiedTimes[sceneNode->GetID()] = modifiedTimes;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneViewNode::GetOtherSceneViewNodes(std::vector<vtkMRMLSceneViewNode*>& sceneViewNodes)
+{
+  sceneViewNodes.clear();
+  if (this->Scene == NULL)
+    {
+    return;
+    }
+  std::vector<vtkMRMLNode*> nodes;
+  this->Scene->GetNodesByClass("vtkMRMLSceneViewNode", nodes);
+  for (std::vector<vtkMRMLNode*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+    {
+    vtkMRMLSceneViewNode* sceneViewNode = vtkMRMLSceneViewNode::SafeDownCast(*it);
+    if (sceneViewNode && sceneViewNode != this && sceneViewNode->SnapshotScene)
+      {
+      sceneViewNodes.push_back(sceneViewNode);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLSceneViewNode::GetSharedStoredNode(vtkMRMLNode* sceneNode,
+  const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes)
+{
+  if (!sceneNode || !sceneNode->GetID())
+    {
+    return NULL;
+    }
+  for (std::vector<vtkMRMLSceneViewNode*>::const_iterator it = otherSceneViewNodes.begin();
+       it != otherSceneViewNodes.end(); ++it)
+    {
+    vtkMRMLNode* storedNode = (*it)->SnapshotScene->GetNodeByID(sceneNode->GetID());
+    if (storedNode && (*it)->IsStoredNodeUpToDate(sceneNode, storedNode))
+      {
+      return storedNode;
+      }
+    }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLSceneViewNode* vtkMRMLSceneViewNode::GetOtherSceneViewStoringNode(vtkMRMLNode* storedNode,
+  const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes)
+{
+  if (!storedNode || !storedNode->GetID())
+    {
+    return NULL;
+    }
+  for (std::vector<vtkMRMLSceneViewNode*>::const_iterator it = otherSceneViewNodes.begin();
+       it != otherSceneViewNodes.end(); ++it)
+    {
+    if ((*it)->SnapshotScene->GetNodeByID(storedNode->GetID()) == storedNode)
+      {
+      return *it;
+      }
+    }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneViewNode::AddSharedStoredNode(vtkMRMLNode* storedNode)
+{
+  // The node keeps belonging to the stored scene of the other scene view.
+  this->SnapshotScene->GetNodes()->vtkCollection::AddItem(storedNode);
+  this->SnapshotScene->AddNodeID(storedNode);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneViewNode::RemoveStoredNode(vtkMRMLNode* storedNode,
+  const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes)
+{
+  vtkMRMLSceneViewNode* otherSceneViewNode = this->GetOtherSceneViewStoringNode(storedNode, otherSceneViewNodes);
+  if (!otherSceneViewNode && storedNode->GetScene() == this->SnapshotScene)
+    {
+    this->SnapshotScene->RemoveNode(storedNode);
+    return;
+    }
+  // Keep the node unchanged for the other scene views: no reference is
+  // updated and no event is invoked.
+  vtkSmartPointer<vtkMRMLNode> sharedNode = storedNode;
+  this->SnapshotScene->GetNodes()->vtkCollection::RemoveItem(sharedNode.GetPointer());
+  this->SnapshotScene->RemoveNodeID(sharedNode->GetID());
+  if (otherSceneViewNode && sharedNode->GetScene() == this->SnapshotScene)
+    {
+    sharedNode->SetScene(otherSceneViewNode->SnapshotScene);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSceneViewNode::UpdateStoredNodeScenes()
+{
+  if (this->SnapshotScene == NULL)
+    {
+    return;
+    }
+  vtkCollectionSimpleIterator it;
+  vtkMRMLNode* node = NULL;
+  vtkCollection* storedNodes = this->SnapshotScene->GetNodes();
+  for (storedNodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(storedNodes->GetNextItemAsObject(it))) ;)
+    {
+    if (node->GetScene() == NULL)
+      {
+      node->SetScene(this->SnapshotScene);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLScene* vtkMRMLSceneViewNode::GetStoredScene()
 {
+  this->UpdateStoredNodeScenes();
   return this->SnapshotScene;
 }
 
@@ -22,7 +22,31 @@
 class vtkCollection;
 class vtkImageData;
 
+// STD includes
+#include <map>
+#include <vector>
+
 class vtkMRMLStorageNode;
+
+/// \brief MRML node to store a snapshot of the scene.
+///
+/// Each scene view stores a copy of every node of the scene in
+/// GetStoredScene(). StoreScene() and RestoreScene() only copy the nodes that
+/// have been modified since they were last stored or restored.
+///
+/// Scene views of the same scene share their stored nodes: when a node has not
+/// been modified since another scene view stored or restored it, StoreScene()
+/// adds the node stored by the other scene view instead of copying it again.
+/// Shared stored nodes are never modified: a scene view that needs to store a
+/// new version of a shared node stores a new copy (copy-on-write).
+/// A shared node belongs to the stored scene of one of the scene views
+/// (vtkMRMLNode::GetScene()) and is handed over to another scene view when it
+/// is removed from it.
+///
+/// No per-property delta is computed. Storable nodes are never shared, as
+/// modifications of their data do not always modify the node. Bulk data is
+/// shared by reference for volume and model nodes, but is copied in each scene
+/// view for nodes that deep copy their data (e.g. segmentation and table nodes).
 class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
 {
   public:
@@ -69,7 +93,10 @@ class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
   vtkMRMLScene* GetStoredScene();
 
   ///
-  /// Store content of the scene
+  /// Store content of the scene.
+  /// Nodes already stored are reused: nodes that have not been modified since
+  /// they were last stored or restored are not copied again, and are shared
+  /// with the other scene views that store them.
   /// \sa GetStoredScene() RestoreScene()
   void StoreScene();
 
@@ -83,6 +110,8 @@ class VTK_MRML_EXPORT vtkMRMLSceneViewNode : public vtkMRMLStorableNode
   /// do no appear in the scene view. If it is false, and nodes are found that will be
   /// deleted, don't remove them, print a warning, set the scene error code to 1, save
   /// the warning to the scene error message, and return.
+  /// Only the nodes that have been modified since they were last stored or
+  /// restored are copied from the scene view.
   /// \sa GetStoredScene() StoreScene() AddMissingNodes()
   void RestoreScene(bool removeNodes = true);
 
@@ -134,9 +163,45 @@ protected:
   vtkMRMLSceneViewNode(const vtkMRMLSceneViewNode&);
   void operator=(const vtkMRMLSceneViewNode&);
 
+  /// Return true if the scene node and the stored node have not been modified
+  /// since SetStoredNodeUpToDate() was last called for them.
+  /// Storable nodes are never considered up to date as modifications of their
+  /// data (e.g. segments, table content) do not always modify the node.
+  bool IsStoredNodeUpToDate(vtkMRMLNode* sceneNode, vtkMRMLNode* storedNode);
+  /// Record that the scene node and the stored node have the same content.
+  void SetStoredNodeUpToDate(vtkMRMLNode* sceneNode, vtkMRMLNode* storedNode);
+
+  /// Get the other scene view nodes of the scene that have a stored scene.
+  void GetOtherSceneViewNodes(std::vector<vtkMRMLSceneViewNode*>& sceneViewNodes);
+  /// Return the node stored by one of the scene views that has the same content
+  /// as the scene node, NULL if there is none.
+  vtkMRMLNode* GetSharedStoredNode(vtkMRMLNode* sceneNode,
+    const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes);
+  /// Return one of the scene views that also stores the stored node,
+  /// NULL if the node is only stored by this scene view.
+  vtkMRMLSceneViewNode* GetOtherSceneViewStoringNode(vtkMRMLNode* storedNode,
+    const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes);
+  /// Add a node stored by another scene view to the stored scene.
+  void AddSharedStoredNode(vtkMRMLNode* storedNode);
+  /// Remove a node from the stored scene. A node shared with other scene
+  /// views is kept unchanged for them, and handed over to one of them if it
+  /// belongs to the stored scene of this scene view.
+  void RemoveStoredNode(vtkMRMLNode* storedNode,
+    const std::vector<vtkMRMLSceneViewNode*>& otherSceneViewNodes);
+  /// Set the stored scene of the shared nodes whose scene view was deleted.
+  void UpdateStoredNodeScenes();
 
   vtkMRMLScene* SnapshotScene;
 
+  /// Modified times of the scene and stored nodes when they were known to be
+  /// identical, indexed by node ID.
+  struct NodeModifiedTimes
+    {
+    vtkMTimeType SceneNodeMTime;
+    vtkMTimeType StoredNodeMTime;
+    };
+  std::map<std::string, NodeModifiedTimes> StoredNodeModifiedTimes;
+
   /// The associated Description
   vtkStdString SceneViewDescription;
 
@@ -27,6 +27,9 @@ Version:   $Revision: 1.1.1.1 $
 #include <vtkStringArray.h>
 #include <vtkURIHandler.h>
 
+// vtkAddon includes
+#include <vtkTracingMacros.h>
+
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
@@ -1143,6 +1146,7 @@ bool vtkMRMLStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *refNode)
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 {
+  vtkTraceScopeWithDetailMacro("MRML", "vtkMRMLStorageNode::ReadData", this->GetClassName());
   if (refNode == NULL)
     {
     vtkErrorMacro("ReadData: can't read into a null node");
@@ -1201,6 +1205,7 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
 {
+  vtkTraceScopeWithDetailMacro("MRML", "vtkMRMLStorageNode::WriteData", this->GetClassName());
   if (refNode == NULL)
     {
     vtkErrorMacro("WriteData: can't write, input node is null");
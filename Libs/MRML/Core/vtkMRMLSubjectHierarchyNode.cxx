@@ -107,6 +107,18 @@ public:
   /// It can be static as the item IDs are unique in one application session.
   static std::map<vtkIdType, vtkSubjectHierarchyItem*> ItemCache;
 
+  /// Indices to speed up lookup by data node and by UID (exact match).
+  /// They are static like \sa ItemCache, so they may contain items of other subject hierarchy nodes
+  /// or unresolved items, therefore the found items need to be validated by the caller.
+  typedef std::multimap<vtkMRMLNode*, vtkSubjectHierarchyItem*> DataNodeIndexType;
+  static DataNodeIndexType DataNodeIndex;
+  typedef std::multimap<std::pair<std::string, std::string>, vtkSubjectHierarchyItem*> UIDIndexType;
+  static UIDIndexType UIDIndex;
+
+  /// Data node the item is indexed by in \sa DataNodeIndex. Stored separately from the weak pointer
+  /// \sa DataNode so that the index entry can be removed after the data node has been deleted.
+  vtkMRMLNode* IndexedDataNode;
+
 // Get/set functions
 public:
   /// Add data item to tree under parent, specifying basic properties
@@ -130,6 +142,8 @@ public:
   /// Get a UID with a given name
   /// \return The UID value if exists, empty string if does not
   std::string GetUID(std::string uidName);
+  /// Determine whether the item has a UID with a given name and value
+  bool HasUID(const std::string& uidName, const std::string& uidValue);
   /// Set attribute to item
   /// \parameter attributeValue Value of attribute. If empty string, then attribute is removed
   void SetAttribute(std::string attributeName, std::string attributeValue);
@@ -167,11 +181,11 @@ public:
   /// Find child by UID (exact match)
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, NULL otherwise
-  vtkSubjectHierarchyItem* FindChildByUID(std::string uidName, std::string uidValue, bool recursive=true);
+  vtkSubjectHierarchyItem* FindChildByUID(const std::string& uidName, const std::string& uidValue, bool recursive=true);
   /// Find child by UID list (containing). For example find UID in instance UID list
   /// \param recursive Flag whether to find only direct children (false) or in the whole branch (true). True by default
   /// \return Item if found, NULL otherwise
-  vtkSubjectHierarchyItem* FindChildByUIDList(std::string uidName, std::string uidValue, bool recursive=true);
+  vtkSubjectHierarchyItem* FindChildByUIDList(const std::string& uidName, const std::string& uidValue, bool recursive=true);
   /// Find children by name
   /// \param name Name (or part of a name) to find
   /// \param foundItemIDs List of found item IDs. Needs to be empty when passing as argument!
@@ -185,6 +199,8 @@ public:
   void GetDataNodesInBranch(vtkCollection *children, const char* childClass=NULL);
   /// Get IDs of all children in the branch recursively
   void GetAllChildren(std::vector<vtkIdType> &childIDs);
+  /// Append IDs of all children in the branch recursively to the list, in depth-first order
+  void AppendAllChildren(std::vector<vtkIdType> &childIDs);
   /// Get list of IDs of all direct children of this item
   void GetDirectChildren(std::vector<vtkIdType> &childIDs);
   /// Print all children with correct indentation
@@ -214,6 +230,16 @@ public:
   void ReparentChildrenToParent();
   /// Remove all children. Do not delete data nodes from the scene. Used in destructor, and for deleting virtual branches
   void RemoveAllChildren();
+  /// Determine whether the item is in the branch of a given item (not counting the given item itself)
+  bool IsInBranch(vtkSubjectHierarchyItem* ancestorItem);
+
+// Index related functions
+public:
+  /// Add item to the data node and UID indices. Items already in the indices are not added again
+  void AddToIndices();
+  /// Remove item from the data node and UID indices
+  void RemoveFromIndices();
+
   /// Remove all observers from item and its data node if any
   //void RemoveAllObservers(); //TODO: Needed? (the callback object belongs to the SH node so introduction of a new member would be needed)
 
@@ -249,6 +275,10 @@ vtkIdType vtkSubjectHierarchyItem::NextSubjectHierarchyItemID = vtkMRMLSubjectHi
 
 std::map<vtkIdType, vtkSubjectHierarchyItem*> vtkSubjectHierarchyItem::ItemCache = std::map<vtkIdType, vtkSubjectHierarchyItem*>();
 
+vtkSubjectHierarchyItem::DataNodeIndexType vtkSubjectHierarchyItem::DataNodeIndex = vtkSubjectHierarchyItem::DataNodeIndexType();
+
+vtkSubjectHierarchyItem::UIDIndexType vtkSubjectHierarchyItem::UIDIndex = vtkSubjectHierarchyItem::UIDIndexType();
+
 //---------------------------------------------------------------------------
 // vtkSubjectHierarchyItem methods
 
@@ -263,6 +293,7 @@ vtkSubjectHierarchyItem::vtkSubjectHierarchyItem()
   , TemporaryID(vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
   , TemporaryDataNodeID("")
   , TemporaryParentItemID(vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+  , IndexedDataNode(NULL)
 {
   this->Children.clear();
   this->Attributes.clear();
@@ -274,6 +305,9 @@ vtkSubjectHierarchyItem::~vtkSubjectHierarchyItem()
 {
   this->RemoveAllChildren();
 
+  // Make sure no index entry refers to the deleted item
+  this->RemoveFromIndices();
+
   this->Attributes.clear();
   this->UIDs.clear();
 }
@@ -303,6 +337,7 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, vt
 
     // Add to cache
     vtkSubjectHierarchyItem::ItemCache[this->ID] = this;
+    this->AddToIndices();
     }
   else
     {
@@ -340,6 +375,7 @@ vtkIdType vtkSubjectHierarchyItem::AddToTree(vtkSubjectHierarchyItem* parent, st
 
     // Add to cache
     vtkSubjectHierarchyItem::ItemCache[this->ID] = this;
+    this->AddToIndices();
     }
   else if (! ( (!name.compare("Scene") && !level.compare("Scene"))
             || (!name.compare("UnresolvedItems") && !level.compare("UnresolvedItems")) ) )
@@ -758,7 +794,7 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByDataNode(vtkMRMLNod
 }
 
 //---------------------------------------------------------------------------
-vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUID(std::string uidName, std::string uidValue, bool recursive/*=true*/)
+vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUID(const std::string& uidName, const std::string& uidValue, bool recursive/*=true*/)
 {
   if (uidName.empty() || uidValue.empty())
     {
@@ -768,7 +804,7 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUID(std::string uid
   for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
     {
     vtkSubjectHierarchyItem* currentItem = childIt->GetPointer();
-    if (!currentItem->GetUID(uidName).compare(uidValue))
+    if (currentItem->HasUID(uidName, uidValue))
       {
       return currentItem;
       }
@@ -785,7 +821,7 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUID(std::string uid
 }
 
 //---------------------------------------------------------------------------
-vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUIDList(std::string uidName, std::string uidValue, bool recursive/*=true*/)
+vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUIDList(const std::string& uidName, const std::string& uidValue, bool recursive/*=true*/)
 {
   if (uidName.empty() || uidValue.empty())
     {
@@ -795,7 +831,8 @@ vtkSubjectHierarchyItem* vtkSubjectHierarchyItem::FindChildByUIDList(std::string
   for (childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
     {
     vtkSubjectHierarchyItem* currentItem = childIt->GetPointer();
-    if (currentItem->GetUID(uidName).find(uidValue) != std::string::npos)
+    std::map<std::string, std::string>::const_iterator uidIt = currentItem->UIDs.find(uidName);
+    if (uidIt != currentItem->UIDs.end() && uidIt->second.find(uidValue) != std::string::npos)
       {
       return currentItem;
       }
@@ -885,7 +922,34 @@ void vtkSubjectHierarchyItem::GetDataNodesInBranch(vtkCollection* dataNodeCollec
 void vtkSubjectHierarchyItem::GetAllChildren(std::vector<vtkIdType> &childIDs)
 {
   childIDs.clear();
-  this->FindChildrenByName("", childIDs, true);
+  this->AppendAllChildren(childIDs);
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::AppendAllChildren(std::vector<vtkIdType> &childIDs)
+{
+  for (ChildVector::iterator childIt=this->Children.begin(); childIt!=this->Children.end(); ++childIt)
+    {
+    childIDs.push_back((*childIt)->ID);
+    (*childIt)->AppendAllChildren(childIDs);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool vtkSubjectHierarchyItem::IsInBranch(vtkSubjectHierarchyItem* ancestorItem)
+{
+  if (!ancestorItem)
+    {
+    return false;
+    }
+  for (vtkSubjectHierarchyItem* currentItem = this->Parent; currentItem; currentItem = currentItem->Parent)
+    {
+    if (currentItem == ancestorItem)
+      {
+      return true;
+      }
+    }
+  return false;
 }
 
 //---------------------------------------------------------------------------
@@ -1107,6 +1171,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkSubjectHierarchyItem* item)
 
   // Remove from cache
   vtkSubjectHierarchyItem::ItemCache.erase(removedItem->ID);
+  removedItem->RemoveFromIndices();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, item);
@@ -1151,6 +1216,7 @@ bool vtkSubjectHierarchyItem::RemoveChild(vtkIdType itemID)
 
   // Remove from cache
   vtkSubjectHierarchyItem::ItemCache.erase(removedItem->ID);
+  removedItem->RemoveFromIndices();
 
   // Invoke events
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemRemovedEvent, removedItem.GetPointer());
@@ -1201,29 +1267,24 @@ void vtkSubjectHierarchyItem::RemoveAllChildren()
 {
   std::vector<vtkIdType> childIDs;
   this->GetAllChildren(childIDs);
-  while (childIDs.size())
+
+  // Remove items in reverse depth-first order, so that all children of an item are
+  // removed before the item itself, and each removed item is a leaf
+  std::vector<vtkIdType>::reverse_iterator childIt;
+  for (childIt=childIDs.rbegin(); childIt!=childIDs.rend(); ++childIt)
     {
-    // Remove first leaf item found
-    std::vector<vtkIdType>::iterator childIt;
-    for (childIt=childIDs.begin(); childIt!=childIDs.end(); ++childIt)
+    if ((*childIt) == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
       {
-      if ((*childIt) == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
-        {
-        // This can happen when UnresolvedItems are deleted. In that case the items will automatically deconstruct
-        childIDs.erase(childIt);
-        break;
-        }
-      vtkSubjectHierarchyItem* currentItem = this->FindChildByID(*childIt);
-      if (currentItem && !currentItem->HasChildren())
-        {
-        // Remove leaf item
-        currentItem->Parent->RemoveChild(*childIt);
-        // Remove ID of deleted item from list and keep deleting until empty
-        childIDs.erase(childIt);
-        break;
-        }
+      // This can happen when UnresolvedItems are deleted. In that case the items will automatically deconstruct
+      continue;
+      }
+    vtkSubjectHierarchyItem* currentItem = this->FindChildByID(*childIt);
+    if (currentItem && currentItem->Parent)
+      {
+      // Item may have been removed already (e.g. with a virtual branch) when it is not found
+      currentItem->Parent->RemoveChild(currentItem);
       }
-    } // While there are children to delete
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -1253,12 +1314,104 @@ void vtkSubjectHierarchyItem::SetUID(std::string uidName, std::string uidValue)
       {
       return; // Do nothing if the UID values match
       }
+
+    // Remove replaced UID from index
+    std::pair<UIDIndexType::iterator, UIDIndexType::iterator> range =
+      vtkSubjectHierarchyItem::UIDIndex.equal_range(std::make_pair(uidName, this->UIDs[uidName]));
+    for (UIDIndexType::iterator indexIt=range.first; indexIt!=range.second; ++indexIt)
+      {
+      if (indexIt->second == this)
+        {
+        vtkSubjectHierarchyItem::UIDIndex.erase(indexIt);
+        break;
+        }
+      }
     }
   this->UIDs[uidName] = uidValue;
+  this->AddToIndices();
   this->InvokeEvent(vtkMRMLSubjectHierarchyNode::SubjectHierarchyItemUIDAddedEvent, this);
   this->Modified();
 }
 
+//---------------------------------------------------------------------------
+bool vtkSubjectHierarchyItem::HasUID(const std::string& uidName, const std::string& uidValue)
+{
+  std::map<std::string, std::string>::const_iterator uidIt = this->UIDs.find(uidName);
+  return (uidIt != this->UIDs.end() && uidIt->second == uidValue);
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::AddToIndices()
+{
+  // Data node
+  vtkMRMLNode* dataNode = this->DataNode.GetPointer();
+  if (this->IndexedDataNode != dataNode)
+    {
+    this->RemoveFromIndices();
+    }
+  if (dataNode && this->IndexedDataNode != dataNode)
+    {
+    vtkSubjectHierarchyItem::DataNodeIndex.insert(std::make_pair(dataNode, this));
+    this->IndexedDataNode = dataNode;
+    }
+
+  // UIDs
+  std::map<std::string, std::string>::iterator uidIt;
+  for (uidIt=this->UIDs.begin(); uidIt!=this->UIDs.end(); ++uidIt)
+    {
+    std::pair<UIDIndexType::iterator, UIDIndexType::iterator> range =
+      vtkSubjectHierarchyItem::UIDIndex.equal_range(*uidIt);
+    UIDIndexType::iterator indexIt;
+    for (indexIt=range.first; indexIt!=range.second; ++indexIt)
+      {
+      if (indexIt->second == this)
+        {
+        break;
+        }
+      }
+    if (indexIt == range.second)
+      {
+      vtkSubjectHierarchyItem::UIDIndex.insert(range.second, std::make_pair(*uidIt, this));
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSubjectHierarchyItem::RemoveFromIndices()
+{
+  // Data node
+  if (this->IndexedDataNode)
+    {
+    std::pair<DataNodeIndexType::iterator, DataNodeIndexType::iterator> range =
+      vtkSubjectHierarchyItem::DataNodeIndex.equal_range(this->IndexedDataNode);
+    for (DataNodeIndexType::iterator indexIt=range.first; indexIt!=range.second; ++indexIt)
+      {
+      if (indexIt->second == this)
+        {
+        vtkSubjectHierarchyItem::DataNodeIndex.erase(indexIt);
+        break;
+        }
+      }
+    this->IndexedDataNode = NULL;
+    }
+
+  // UIDs
+  std::map<std::string, std::string>::iterator uidIt;
+  for (uidIt=this->UIDs.begin(); uidIt!=this->UIDs.end(); ++uidIt)
+    {
+    std::pair<UIDIndexType::iterator, UIDIndexType::iterator> range =
+      vtkSubjectHierarchyItem::UIDIndex.equal_range(*uidIt);
+    for (UIDIndexType::iterator indexIt=range.first; indexIt!=range.second; ++indexIt)
+      {
+      if (indexIt->second == this)
+        {
+        vtkSubjectHierarchyItem::UIDIndex.erase(indexIt);
+        break;
+        }
+      }
+    }
+}
+
 //---------------------------------------------------------------------------
 std::string vtkSubjectHierarchyItem::GetUID(std::string uidName)
 {
@@ -1410,6 +1563,12 @@ public:
 
   /// Utility function to find item in whole subject hierarchy by ID, including the scene item
   vtkSubjectHierarchyItem* FindItemByID(vtkIdType itemID);
+  /// Find item under the scene item by associated data node using the data node index.
+  /// If multiple items are associated to the data node then the first one in the tree is returned
+  vtkSubjectHierarchyItem* FindItemByDataNode(vtkMRMLNode* dataNode);
+  /// Find item under the scene item by UID (exact match) using the UID index.
+  /// If multiple items have the UID then the first one in the tree is returned
+  vtkSubjectHierarchyItem* FindItemByUID(const std::string& uidName, const std::string& uidValue);
 
   /// Resolve all unresolved items in this subject hierarchy node.
   /// Used when merging a subject hierarchy node into the singleton one after scene import.
@@ -1489,6 +1648,64 @@ vtkSubjectHierarchyItem* vtkMRMLSubjectHierarchyNode::vtkInternal::FindItemByID(
   return this->SceneItem->FindChildByID(itemID);
 }
 
+//---------------------------------------------------------------------------
+vtkSubjectHierarchyItem* vtkMRMLSubjectHierarchyNode::vtkInternal::FindItemByDataNode(vtkMRMLNode* dataNode)
+{
+  if (!dataNode)
+    {
+    return NULL;
+    }
+
+  vtkSubjectHierarchyItem* foundItem = NULL;
+  std::pair<vtkSubjectHierarchyItem::DataNodeIndexType::iterator, vtkSubjectHierarchyItem::DataNodeIndexType::iterator> range =
+    vtkSubjectHierarchyItem::DataNodeIndex.equal_range(dataNode);
+  for (vtkSubjectHierarchyItem::DataNodeIndexType::iterator indexIt=range.first; indexIt!=range.second; ++indexIt)
+    {
+    vtkSubjectHierarchyItem* currentItem = indexIt->second;
+    // Index entries of items in other subject hierarchies or of unresolved items are ignored
+    if (currentItem->DataNode.GetPointer() != dataNode || !currentItem->IsInBranch(this->SceneItem))
+      {
+      continue;
+      }
+    if (foundItem)
+      {
+      // Multiple items are associated to the data node, find the first one in the tree
+      return this->SceneItem->FindChildByDataNode(dataNode);
+      }
+    foundItem = currentItem;
+    }
+  return foundItem;
+}
+
+//---------------------------------------------------------------------------
+vtkSubjectHierarchyItem* vtkMRMLSubjectHierarchyNode::vtkInternal::FindItemByUID(const std::string& uidName, const std::string& uidValue)
+{
+  if (uidName.empty() || uidValue.empty())
+    {
+    return NULL;
+    }
+
+  vtkSubjectHierarchyItem* foundItem = NULL;
+  std::pair<vtkSubjectHierarchyItem::UIDIndexType::iterator, vtkSubjectHierarchyItem::UIDIndexType::iterator> range =
+    vtkSubjectHierarchyItem::UIDIndex.equal_range(std::make_pair(uidName, uidValue));
+  for (vtkSubjectHierarchyItem::UIDIndexType::iterator indexIt=range.first; indexIt!=range.second; ++indexIt)
+    {
+    vtkSubjectHierarchyItem* currentItem = indexIt->second;
+    // Index entries of items in other subject hierarchies or of unresolved items are ignored
+    if (!currentItem->HasUID(uidName, uidValue) || !currentItem->IsInBranch(this->SceneItem))
+      {
+      continue;
+      }
+    if (foundItem)
+      {
+      // Multiple items have the UID, find the first one in the tree
+      return this->SceneItem->FindChildByUID(uidName, uidValue);
+      }
+    foundItem = currentItem;
+    }
+  return foundItem;
+}
+
 //---------------------------------------------------------------------------
 bool vtkMRMLSubjectHierarchyNode::vtkInternal::ResolveUnresolvedItems()
 {
@@ -2477,7 +2694,7 @@ bool vtkMRMLSubjectHierarchyNode::ReparentItemByDataNode(vtkIdType itemID, vtkMR
     }
 
   // Get new parent item by the given data node
-  vtkSubjectHierarchyItem* newParentItem = this->Internal->SceneItem->FindChildByDataNode(newParentNode);
+  vtkSubjectHierarchyItem* newParentItem = this->Internal->FindItemByDataNode(newParentNode);
   if (!newParentItem)
     {
     vtkErrorMacro("ReparentItem: Failed to find subject hierarchy item by data MRML node " << newParentNode->GetName());
@@ -2513,7 +2730,7 @@ vtkIdType vtkMRMLSubjectHierarchyNode::GetItemByUID(const char* uidName, const c
     vtkErrorMacro("GetSubjectHierarchyNodeByUID: Invalid UID name or value");
     return INVALID_ITEM_ID;
     }
-  vtkSubjectHierarchyItem* item = this->Internal->SceneItem->FindChildByUID(uidName, uidValue);
+  vtkSubjectHierarchyItem* item = this->Internal->FindItemByUID(uidName, uidValue);
   return (item ? item->ID : INVALID_ITEM_ID);
 }
 
@@ -2538,7 +2755,7 @@ vtkIdType vtkMRMLSubjectHierarchyNode::GetItemByDataNode(vtkMRMLNode* dataNode)
     return INVALID_ITEM_ID;
     }
 
-  vtkSubjectHierarchyItem* item = this->Internal->SceneItem->FindChildByDataNode(dataNode);
+  vtkSubjectHierarchyItem* item = this->Internal->FindItemByDataNode(dataNode);
   return (item ? item->ID : INVALID_ITEM_ID);
 }
 
@@ -30,16 +30,117 @@
 #include <vtkTable.h>
 #include <vtkStringArray.h>
 #include <vtkBitArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkSQLQuery.h>
-#include <vtkRowQueryToTable.h>
 #include <vtkSQLDatabase.h>
 #include <vtkSQLiteDatabase.h>
 #include <vtkSQLiteQuery.h>
 #include <vtkSmartPointer.h>
+#include <vtkTypeInt64Array.h>
+#include <vtkVariantArray.h>
 
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <vector>
+
+namespace
+{
+enum ColumnStorageType
+{
+  TextColumn,
+  RealColumn,
+  IntegerColumn
+};
+
+//----------------------------------------------------------------------------
+// Type of the SQLite column used to store a table column
+ColumnStorageType GetColumnStorageType(vtkAbstractArray* column)
+{
+  std::string columnType = column->GetClassName();
+  if( (columnType.find("String") != std::string::npos) ||
+      (columnType.find("Data") != std::string::npos) ||
+      (columnType.find("Variant") != std::string::npos) )
+    {
+    return TextColumn;
+    }
+  else if( (columnType.find("Double") != std::string::npos) ||
+           (columnType.find("Float") != std::string::npos) )
+    {
+    return RealColumn;
+    }
+  return IntegerColumn;
+}
+
+//----------------------------------------------------------------------------
+// Type of table column created for a SQLite declared column type,
+// following the SQLite type affinity rules.
+// Return -1 if the declared type does not determine the column type.
+int GetColumnStorageTypeFromDeclaredType(std::string declaredType)
+{
+  std::transform(declaredType.begin(), declaredType.end(), declaredType.begin(), ::toupper);
+  if (declaredType.empty())
+    {
+    return -1;
+    }
+  if (declaredType.find("INT") != std::string::npos)
+    {
+    return IntegerColumn;
+    }
+  if (declaredType.find("CHAR") != std::string::npos
+    || declaredType.find("CLOB") != std::string::npos
+    || declaredType.find("TEXT") != std::string::npos)
+    {
+    return TextColumn;
+    }
+  if (declaredType.find("REAL") != std::string::npos
+    || declaredType.find("FLOA") != std::string::npos
+    || declaredType.find("DOUB") != std::string::npos)
+    {
+    return RealColumn;
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+// SQL identifier in double quotes, so that table and column names can contain
+// spaces, quotes or be keywords
+std::string QuoteIdentifier(const std::string& identifier)
+{
+  std::string quoted("\"");
+  for (std::string::const_iterator it = identifier.begin(); it != identifier.end(); ++it)
+    {
+    if (*it == '"')
+      {
+      quoted += '"';
+      }
+    quoted += *it;
+    }
+  quoted += '"';
+  return quoted;
+}
+
+//----------------------------------------------------------------------------
+// Copy of an integer column as variants, used once a SQL NULL is found in it
+vtkVariantArray* CreateVariantColumn(vtkTypeInt64Array* integerColumn)
+{
+  vtkVariantArray* variantColumn = vtkVariantArray::New();
+  variantColumn->SetName(integerColumn->GetName());
+  vtkIdType numberOfValues = integerColumn->GetNumberOfTuples();
+  variantColumn->SetNumberOfValues(numberOfValues);
+  for (vtkIdType i = 0; i < numberOfValues; ++i)
+    {
+    variantColumn->SetValue(i, vtkVariant(integerColumn->GetValue(i)));
+    }
+  return variantColumn;
+}
+}
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLTableSQLiteStorageNode);
 
@@ -48,6 +149,9 @@ vtkMRMLTableSQLiteStorageNode::vtkMRMLTableSQLiteStorageNode()
 {
   this->TableName = 0;
   this->Password = 0;
+  this->FirstRowToRead = 0;
+  this->MaximumNumberOfRowsToRead = 0;
+  this->AppendRows = false;
   this->DefaultWriteFileExtension = "sqlite3";
 }
 
@@ -60,6 +164,9 @@ vtkMRMLTableSQLiteStorageNode::~vtkMRMLTableSQLiteStorageNode()
 void vtkMRMLTableSQLiteStorageNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   vtkMRMLStorageNode::PrintSelf(os,indent);
+  os << indent << "FirstRowToRead: " << this->FirstRowToRead << "\n";
+  os << indent << "MaximumNumberOfRowsToRead: " << this->MaximumNumberOfRowsToRead << "\n";
+  os << indent << "AppendRows: " << this->AppendRows << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -102,18 +209,129 @@ int vtkMRMLTableSQLiteStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (!this->TableName || std::string(this->TableName).empty())
+    {
+    vtkErrorMacro("ReadData: no table name specified");
+    return 0;
+    }
+
   vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
                    vtkSQLiteQuery::SafeDownCast( database->GetQueryInstance()));
+
+  // Declared column types
+  std::map<std::string, int> declaredColumnTypes;
+  std::string tableInfoQuery = std::string("PRAGMA table_info(") + QuoteIdentifier(this->TableName) + ")";
+  query->SetQuery(tableInfoQuery.c_str());
+  if (query->Execute())
+    {
+    while (query->NextRow())
+      {
+      // table_info columns: cid, name, type, notnull, dflt_value, pk
+      declaredColumnTypes[query->DataValue(1).ToString()] =
+        GetColumnStorageTypeFromDeclaredType(query->DataValue(2).ToString());
+      }
+    }
+
+  // LIMIT -1 means no limit
   std::string queryString("select * from ");
-  queryString += std::string(this->TableName);
+  queryString += QuoteIdentifier(this->TableName);
+  queryString += " LIMIT ? OFFSET ?";
   query->SetQuery(queryString.c_str());
-  query->Execute();
+  query->BindParameter(0, static_cast<vtkTypeInt64>(
+    this->MaximumNumberOfRowsToRead > 0 ? this->MaximumNumberOfRowsToRead : -1));
+  query->BindParameter(1, static_cast<vtkTypeInt64>(std::max(this->FirstRowToRead, vtkIdType(0))));
+  if (!query->Execute())
+    {
+    vtkErrorMacro("ReadData: failed to read table '" << this->TableName << "' from database file '" << fullName
+      << "': " << query->GetLastErrorText());
+    return 0;
+    }
 
-  vtkSmartPointer<vtkRowQueryToTable> queryToTable = vtkSmartPointer<vtkRowQueryToTable>::New();
-  queryToTable->SetQuery(query);
-  queryToTable->Update();
+  // Create typed columns
+  int numberOfFields = query->GetNumberOfFields();
+  std::vector<vtkSmartPointer<vtkAbstractArray> > columns(numberOfFields);
+  std::vector<vtkDoubleArray*> realColumns(numberOfFields, static_cast<vtkDoubleArray*>(NULL));
+  std::vector<vtkTypeInt64Array*> integerColumns(numberOfFields, static_cast<vtkTypeInt64Array*>(NULL));
+  std::vector<vtkVariantArray*> variantColumns(numberOfFields, static_cast<vtkVariantArray*>(NULL));
+  std::vector<vtkStringArray*> textColumns(numberOfFields, static_cast<vtkStringArray*>(NULL));
+  for (int col = 0; col < numberOfFields; ++col)
+    {
+    std::string columnName = query->GetFieldName(col);
+    int columnType = -1;
+    std::map<std::string, int>::iterator declaredTypeIt = declaredColumnTypes.find(columnName);
+    if (declaredTypeIt != declaredColumnTypes.end())
+      {
+      columnType = declaredTypeIt->second;
+      }
+    if (columnType < 0)
+      {
+      // No declared type, use the type of the value in the first row
+      int fieldType = query->GetFieldType(col);
+      columnType = (fieldType == VTK_INT ? IntegerColumn :
+        (fieldType == VTK_DOUBLE ? RealColumn : TextColumn));
+      }
+    if (columnType == RealColumn)
+      {
+      realColumns[col] = vtkDoubleArray::New();
+      columns[col].TakeReference(realColumns[col]);
+      }
+    else if (columnType == IntegerColumn)
+      {
+      // SQLite integers are 64-bit
+      integerColumns[col] = vtkTypeInt64Array::New();
+      columns[col].TakeReference(integerColumns[col]);
+      }
+    else
+      {
+      textColumns[col] = vtkStringArray::New();
+      columns[col].TakeReference(textColumns[col]);
+      }
+    columns[col]->SetName(columnName.c_str());
+    }
 
-  vtkSmartPointer<vtkTable> table = queryToTable->GetOutput();
+  // Fill columns. vtkSQLiteQuery only returns values as variants, they are
+  // converted right away to the type of the column.
+  while (query->NextRow())
+    {
+    for (int col = 0; col < numberOfFields; ++col)
+      {
+      if (realColumns[col])
+        {
+        vtkVariant value = query->DataValue(col);
+        realColumns[col]->InsertNextValue(value.IsValid() ? value.ToDouble() : vtkMath::Nan());
+        }
+      else if (integerColumns[col])
+        {
+        vtkVariant value = query->DataValue(col);
+        if (value.IsValid())
+          {
+          integerColumns[col]->InsertNextValue(value.ToTypeInt64());
+          continue;
+          }
+        // A SQL NULL has no integer representation: store the column
+        // as variants, NULL being an invalid variant
+        variantColumns[col] = CreateVariantColumn(integerColumns[col]);
+        columns[col].TakeReference(variantColumns[col]);
+        integerColumns[col] = NULL;
+        variantColumns[col]->InsertNextValue(value);
+        }
+      else if (variantColumns[col])
+        {
+        variantColumns[col]->InsertNextValue(query->DataValue(col));
+        }
+      else
+        {
+        vtkVariant value = query->DataValue(col);
+        textColumns[col]->InsertNextValue(value.IsValid() ? value.ToString() : vtkStdString());
+        }
+      }
+    }
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  for (int col = 0; col < numberOfFields; ++col)
+    {
+    columns[col]->Squeeze();
+    table->AddColumn(columns[col]);
+    }
 
   tableNode->SetAndObserveTable(table);
 
@@ -151,10 +369,10 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 
   std::string dbname = std::string("sqlite://") + fullName;
 
-  //vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
-  vtkSQLiteDatabase *database = vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str()));
+  vtkSmartPointer<vtkSQLiteDatabase> database = vtkSmartPointer<vtkSQLiteDatabase>::Take(
+                   vtkSQLiteDatabase::SafeDownCast( vtkSQLiteDatabase::CreateFromURL(dbname.c_str())));
 
-  if (!database || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
+  if (!database.GetPointer() || !database->Open(this->GetPassword(), vtkSQLiteDatabase::USE_EXISTING_OR_CREATE))
     {
     vtkErrorMacro("ReadData: database file '" << fullName << "cannot be openned");
     return 0;
@@ -173,95 +391,141 @@ int vtkMRMLTableSQLiteStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  // first try to drop the table
-  this->DropTable(this->TableName, database);
+  if (!this->AppendRows)
+    {
+    // first try to drop the table
+    this->DropTable(this->TableName, database);
+    }
 
   //converting this table to SQLite will require two queries: one to create
   //the table, and another to populate its rows with data.
   std::string createTableQuery = "CREATE TABLE IF NOT EXISTS ";
-  createTableQuery += this->TableName;
+  createTableQuery += QuoteIdentifier(this->TableName);
   createTableQuery += "(";
 
-  std::string insertPreamble = "INSERT into ";
-  insertPreamble += this->TableName;
-  insertPreamble += "(";
+  std::string insertQuery = "INSERT into ";
+  insertQuery += QuoteIdentifier(this->TableName);
+  insertQuery += "(";
+  std::string insertValues = " VALUES (";
 
   //get the columns from the vtkTable to finish the query
   vtkIdType numColumns = table->GetNumberOfColumns();
+  std::vector<int> columnTypes(numColumns);
+  std::vector<vtkDataArray*> dataColumns(numColumns);
+  std::vector<vtkStringArray*> stringColumns(numColumns);
   for(vtkIdType i = 0; i < numColumns; i++)
     {
+    vtkAbstractArray* column = table->GetColumn(i);
     //get this column's name
-    std::string columnName = table->GetColumn(i)->GetName();
-    createTableQuery += columnName;
-    insertPreamble += "'" + columnName + "'";
+    std::string columnName = column->GetName() ? column->GetName() : "";
+    createTableQuery += QuoteIdentifier(columnName);
+    insertQuery += QuoteIdentifier(columnName);
+    insertValues += "?";
 
     //figure out what type of data is stored in this column
-    std::string columnType = table->GetColumn(i)->GetClassName();
-
-    if( (columnType.find("String") != std::string::npos) ||
-        (columnType.find("Data") != std::string::npos) ||
-        (columnType.find("Variant") != std::string::npos) )
+    columnTypes[i] = GetColumnStorageType(column);
+    switch (columnTypes[i])
       {
-      createTableQuery += " TEXT";
+      case TextColumn:
+        createTableQuery += " TEXT";
+        break;
+      case RealColumn:
+        createTableQuery += " REAL";
+        break;
+      default:
+        createTableQuery += " INTEGER";
       }
-    else if( (columnType.find("Double") != std::string::npos) ||
-             (columnType.find("Float") != std::string::npos) )
+    // single component numeric and string columns are bound directly,
+    // other columns are converted to string
+    dataColumns[i] = vtkDataArray::SafeDownCast(column);
+    if (dataColumns[i] && dataColumns[i]->GetNumberOfComponents() != 1)
       {
-      createTableQuery += " REAL";
-      }
-    else
-      {
-      createTableQuery += " INTEGER";
+      dataColumns[i] = NULL;
       }
+    stringColumns[i] = vtkStringArray::SafeDownCast(column);
+
     if(i == numColumns - 1)
       {
       createTableQuery += ");";
-      insertPreamble += ") VALUES (";
+      insertQuery += ")";
+      insertValues += ");";
       }
     else
       {
       createTableQuery += ", ";
-      insertPreamble += ", ";
+      insertQuery += ", ";
+      insertValues += ", ";
       }
     }
+  insertQuery += insertValues;
 
   //perform the create table query
-  vtkSQLiteQuery *query =
-    static_cast<vtkSQLiteQuery*>(database->GetQueryInstance());
+  vtkSmartPointer<vtkSQLiteQuery> query = vtkSmartPointer<vtkSQLiteQuery>::Take(
+    vtkSQLiteQuery::SafeDownCast(database->GetQueryInstance()));
 
   query->SetQuery(createTableQuery.c_str());
-  cout << "creating the table" << endl;
+  vtkDebugMacro("WriteData: creating the table");
   if(!query->Execute())
     {
     vtkErrorMacro(<<"Error performing 'create table' query");
     }
 
-  //iterate over the rows of the vtkTable to complete the insert query
+  //insert all the rows with the same prepared statement in a single transaction
+  if (!query->BeginTransaction())
+    {
+    vtkErrorMacro(<<"Error starting transaction: " << query->GetLastErrorText());
+    database->Close();
+    return 0;
+    }
+  if (!query->SetQuery(insertQuery.c_str()))
+    {
+    vtkErrorMacro(<<"Error preparing 'insert' query: " << query->GetLastErrorText());
+    query->RollbackTransaction();
+    database->Close();
+    return 0;
+    }
+
   vtkIdType numRows = table->GetNumberOfRows();
   for(vtkIdType i = 0; i < numRows; i++)
     {
-    std::string insertQuery = insertPreamble;
     for (vtkIdType j = 0; j < numColumns; j++)
       {
-      insertQuery += "'" + table->GetValue(i, j).ToString() + "'";
-      if(j < numColumns - 1)
+      int parameterIndex = static_cast<int>(j);
+      if (dataColumns[j] && columnTypes[j] == RealColumn)
         {
-        insertQuery += ", ";
+        query->BindParameter(parameterIndex, dataColumns[j]->GetComponent(i, 0));
+        }
+      else if (dataColumns[j] && columnTypes[j] == IntegerColumn)
+        {
+        query->BindParameter(parameterIndex, static_cast<vtkTypeInt64>(dataColumns[j]->GetComponent(i, 0)));
+        }
+      else if (stringColumns[j])
+        {
+        query->BindParameter(parameterIndex, stringColumns[j]->GetValue(i));
+        }
+      else
+        {
+        query->BindParameter(parameterIndex, table->GetValue(i, j).ToString());
         }
       }
-    insertQuery += ");";
     //perform the insert query for this row
-    query->SetQuery(insertQuery.c_str());
     if(!query->Execute())
       {
-      vtkErrorMacro(<<"Error performing 'insert' query");
+      vtkErrorMacro(<<"Error performing 'insert' query: " << query->GetLastErrorText());
+      query->RollbackTransaction();
+      database->Close();
+      return 0;
       }
     }
+  if (!query->CommitTransaction())
+    {
+    vtkErrorMacro(<<"Error committing transaction: " << query->GetLastErrorText());
+    database->Close();
+    return 0;
+    }
 
   //cleanup and return
-  query->Delete();
   database->Close();
-  database->Delete();
 
   vtkDebugMacro("WriteData: successfully wrote table to database: " << fullName);
   return 1;
@@ -290,7 +554,7 @@ int vtkMRMLTableSQLiteStorageNode::DropTable(char *tableName, vtkSQLiteDatabase*
     if (!tables->GetValue(i).compare(tableName))
       {
       std::string dropTableQuery = "DROP TABLE ";
-      dropTableQuery += tableName;
+      dropTableQuery += QuoteIdentifier(tableName);
       query->SetQuery(dropTableQuery.c_str());
       query->Execute();
       break;
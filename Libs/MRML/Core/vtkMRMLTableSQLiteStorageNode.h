@@ -30,7 +30,16 @@
 /// vtkMRMLTableSQLiteStorageNode allows reading/writing of table node from
 /// SQLight database.
 ///
+/// Rows are written with a single prepared statement inside one transaction
+/// and read directly into typed columns (vtkTypeInt64Array for INTEGER,
+/// vtkDoubleArray for REAL and vtkStringArray for other columns). INTEGER
+/// columns that contain NULL values are read into a vtkVariantArray, where
+/// NULL values are invalid variants.
 ///
+/// Tables that do not fit in memory can be processed in chunks: set
+/// FirstRowToRead and MaximumNumberOfRowsToRead to read a range of rows,
+/// and enable AppendRows to add the rows of the table node to an existing
+/// database table instead of replacing it.
 
 class vtkSQLiteDatabase;
 
@@ -57,6 +66,21 @@ public:
   vtkSetStringMacro(TableName);
   vtkGetStringMacro(TableName);
 
+  /// Index of the first row read from the database table. Default is 0.
+  vtkSetMacro(FirstRowToRead, vtkIdType);
+  vtkGetMacro(FirstRowToRead, vtkIdType);
+
+  /// Maximum number of rows read from the database table.
+  /// Default is 0, which reads all the rows.
+  vtkSetMacro(MaximumNumberOfRowsToRead, vtkIdType);
+  vtkGetMacro(MaximumNumberOfRowsToRead, vtkIdType);
+
+  /// If enabled, rows are appended to the database table if it already exists.
+  /// If disabled (default), the database table is replaced.
+  vtkSetMacro(AppendRows, bool);
+  vtkGetMacro(AppendRows, bool);
+  vtkBooleanMacro(AppendRows, bool);
+
   /// Drop a specified table from the database
   static int DropTable(char *tableName, vtkSQLiteDatabase* database);
 
@@ -80,6 +104,9 @@ protected:
 
   char *TableName;
   char *Password;
+  vtkIdType FirstRowToRead;
+  vtkIdType MaximumNumberOfRowsToRead;
+  bool AppendRows;
 };
 
 #endif
@@ -40,6 +40,7 @@ Version:   $Revision: 1.6 $
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkStringArray.h>
 #include <vtksys/Directory.hxx>
 
@@ -56,6 +57,7 @@ vtkMRMLVolumeArchetypeStorageNode::vtkMRMLVolumeArchetypeStorageNode()
   this->CenterImage = 0;
   this->SingleFile  = 0;
   this->UseOrientationFromFile = 1;
+  this->StreamingRead = 0;
   this->DefaultWriteFileExtension = "nrrd";
 }
 
@@ -78,6 +80,11 @@ void vtkMRMLVolumeArchetypeStorageNode::WriteXML(ostream& of, int nIndent)
   ss << this->UseOrientationFromFile;
   of << " UseOrientationFromFile=\"" << ss.str() << "\"";
   }
+  {
+  std::stringstream ss;
+  ss << this->StreamingRead;
+  of << " streamingRead=\"" << ss.str() << "\"";
+  }
   // SingleFile attribute is not written to file. GetNumberOfFileNames()
   // is used to determine if reader should read from single/multiple files.
 }
@@ -107,6 +114,12 @@ void vtkMRMLVolumeArchetypeStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->UseOrientationFromFile;
       }
+    if (!strcmp(attName, "streamingRead"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      ss >> this->StreamingRead;
+      }
     }
 
   // SingleFile attribute used to be read from the scene, but often
@@ -131,6 +144,7 @@ void vtkMRMLVolumeArchetypeStorageNode::Copy(vtkMRMLNode *anode)
   this->SetCenterImage(node->CenterImage);
   this->SetSingleFile(node->SingleFile);
   this->SetUseOrientationFromFile(node->UseOrientationFromFile);
+  this->SetStreamingRead(node->StreamingRead);
 
   this->EndModify(disabledModify);
 }
@@ -142,6 +156,7 @@ void vtkMRMLVolumeArchetypeStorageNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "CenterImage:   " << this->CenterImage << "\n";
   os << indent << "SingleFile:   " << this->SingleFile << "\n";
   os << indent << "UseOrientationFromFile:   " << this->UseOrientationFromFile << "\n";
+  os << indent << "StreamingRead:   " << this->StreamingRead << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -305,7 +320,10 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     }
   else
     {
-    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader> scalarReader =
+      vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    scalarReader->SetStreamingRead(this->GetStreamingRead() != 0);
+    reader = scalarReader;
     reader->SetSingleFile( this->GetSingleFile() );
     reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
     }
@@ -342,12 +360,25 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     reader->SetUseNativeOriginOn();
     }
 
+  // In streaming mode only the image information is read here,
+  // voxels are read when the pipeline is updated.
+  vtkITKArchetypeImageSeriesScalarReader* scalarReader =
+    vtkITKArchetypeImageSeriesScalarReader::SafeDownCast(reader);
+  bool streaming = (scalarReader != NULL && scalarReader->GetStreamingRead());
+
   bool readingWorked = true;
   std::string errorMessage = "";
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
-    reader->Update();
+    if (streaming)
+      {
+      reader->UpdateInformation();
+      }
+    else
+      {
+      reader->Update();
+      }
     if (reader->GetErrorCode() != vtkErrorCode::NoError)
       {
       readingWorked = false;
@@ -387,7 +418,11 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     }
 
   vtkPointData * pointData = reader->GetOutput()->GetPointData();
-  if (volNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+  if (streaming)
+    {
+    // voxels have not been read yet
+    }
+  else if (volNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
     {
     if (pointData->GetTensors() == NULL || pointData->GetTensors()->GetNumberOfTuples() == 0)
       {
@@ -446,23 +481,40 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   ici->SetInputConnection(reader->GetOutputPort());
   ici->SetOutputSpacing( 1, 1, 1 );
   ici->SetOutputOrigin( 0, 0, 0 );
-  ici->Update();
 
-  if (ici->GetOutput() == NULL)
+  if (streaming)
     {
-    vtkErrorMacro("vtkMRMLVolumeArchetypeStorageNode: Cannot read file: " << fullName);
-    return 0;
+    // Keep the reader in the pipeline so that consumers read the extents they request
+    ici->UpdateInformation();
+    volNode->SetImageDataConnection(ici->GetOutputPort());
+
+    int wholeExtent[6] = {0, -1, 0, -1, 0, -1};
+    ici->GetOutputInformation(0)->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+    vtkInfoMacro(<<"Opened volume for streaming from file: "<<fullName \
+      <<". Dimensions: "<<wholeExtent[1]-wholeExtent[0]+1<<"x"<<wholeExtent[3]-wholeExtent[2]+1<<"x"<<wholeExtent[5]-wholeExtent[4]+1 \
+      <<". Number of components: "<<reader->GetNumberOfComponents() \
+      <<". Pixel type: "<<vtkImageScalarTypeNameMacro(reader->GetOutputScalarType())<<".");
     }
+  else
+    {
+    ici->Update();
+
+    if (ici->GetOutput() == NULL)
+      {
+      vtkErrorMacro("vtkMRMLVolumeArchetypeStorageNode: Cannot read file: " << fullName);
+      return 0;
+      }
 
-  vtkNew<vtkImageData> iciOutputCopy;
-  iciOutputCopy->ShallowCopy(ici->GetOutput());
-  volNode->SetAndObserveImageData(iciOutputCopy.GetPointer());
+    vtkNew<vtkImageData> iciOutputCopy;
+    iciOutputCopy->ShallowCopy(ici->GetOutput());
+    volNode->SetAndObserveImageData(iciOutputCopy.GetPointer());
 
-  // Log volume size to the application log. It helps to identify potential out-of-memory issues.
-  vtkInfoMacro(<<"Loaded volume from file: "<<fullName \
-    <<". Dimensions: "<<iciOutputCopy->GetDimensions()[0]<<"x"<<iciOutputCopy->GetDimensions()[1]<<"x"<<iciOutputCopy->GetDimensions()[2] \
-    <<". Number of components: "<<iciOutputCopy->GetNumberOfScalarComponents() \
-    <<". Pixel type: "<<vtkImageScalarTypeNameMacro(iciOutputCopy->GetScalarType())<<".");
+    // Log volume size to the application log. It helps to identify potential out-of-memory issues.
+    vtkInfoMacro(<<"Loaded volume from file: "<<fullName \
+      <<". Dimensions: "<<iciOutputCopy->GetDimensions()[0]<<"x"<<iciOutputCopy->GetDimensions()[1]<<"x"<<iciOutputCopy->GetDimensions()[2] \
+      <<". Number of components: "<<iciOutputCopy->GetNumberOfScalarComponents() \
+      <<". Pixel type: "<<vtkImageScalarTypeNameMacro(iciOutputCopy->GetScalarType())<<".");
+    }
 
   vtkMatrix4x4* mat = reader->GetRasToIjkMatrix();
   if ( mat == NULL )
@@ -73,6 +73,21 @@ public:
   vtkSetMacro(UseOrientationFromFile, int);
   vtkGetMacro(UseOrientationFromFile, int);
 
+  ///
+  /// Read scalar volumes on demand. Instead of reading the whole file,
+  /// only the image header is read and the volume node is connected to the
+  /// reader pipeline: each consumer (e.g. slice views) then reads only the
+  /// extent it requests. Formats that support streamed reading (uncompressed
+  /// NRRD, NIfTI, MetaImage...) keep memory usage bounded by the largest
+  /// requested extent; other formats are read completely on first request.
+  /// Components accessing vtkMRMLVolumeNode::GetImageData() directly must
+  /// update the image data connection before using the voxels.
+  /// Off by default.
+  /// \sa vtkITKArchetypeImageSeriesScalarReader::SetStreamingRead()
+  vtkSetMacro(StreamingRead, int);
+  vtkGetMacro(StreamingRead, int);
+  vtkBooleanMacro(StreamingRead, int);
+
   /// Return true if the reference node is supported by the storage node
   virtual bool CanReadInReferenceNode(vtkMRMLNode* refNode) VTK_OVERRIDE;
   virtual bool CanWriteFromReferenceNode(vtkMRMLNode* refNode) VTK_OVERRIDE;
@@ -110,6 +125,7 @@ protected:
   int CenterImage;
   int SingleFile;
   int UseOrientationFromFile;
+  int StreamingRead;
 
 };
 
@@ -42,6 +42,9 @@
 #include <vtkSmartPointer.h>
 #include <vtkWeakPointer.h>
 
+// vtkAddon includes
+#include <vtkTracingMacros.h>
+
 // STD includes
 #include <cassert>
 #include <algorithm>
@@ -851,6 +854,7 @@ void vtkMRMLAbstractDisplayableManager::RequestRender()
 
   if (this->Internal->UpdateFromMRMLRequested)
     {
+    vtkTraceScopeWithDetailMacro("DisplayableManager", "vtkMRMLAbstractDisplayableManager::UpdateFromMRML", this->GetClassName());
     this->UpdateFromMRML();
     }
 
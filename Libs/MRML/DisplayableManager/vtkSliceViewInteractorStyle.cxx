@@ -669,17 +669,8 @@ void vtkSliceViewInteractorStyle::DecrementSlice()
 //----------------------------------------------------------------------------
 void vtkSliceViewInteractorStyle::MoveSlice(double delta)
 {
-  double offset = this->SliceLogic->GetSliceOffset();
-  double newOffset = offset + delta;
-
-  double sliceBounds[6] = {0, -1, 0, -1, 0, -1};
-  this->SliceLogic->GetSliceBounds(sliceBounds);
-  if (newOffset >= sliceBounds[4] && newOffset <= sliceBounds[5])
-    {
-    this->SliceLogic->StartSliceNodeInteraction(vtkMRMLSliceNode::SliceToRASFlag);
-    this->SliceLogic->SetSliceOffset(newOffset);
-    this->SliceLogic->EndSliceNodeInteraction();
-    }
+  // successive steps are resliced once per frame (see vtkMRMLSliceLogic::StepSliceOffset)
+  this->SliceLogic->StepSliceOffset(delta);
 }
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,227 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include <vtkArchive.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// LibArchive includes
+#include <archive.h>
+#include <archive_entry.h>
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+void writeFile(const std::string& fileName, const std::string& content)
+{
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+  file.write(content.data(), content.size());
+}
+
+//-----------------------------------------------------------------------------
+std::string readFile(const std::string& fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+//-----------------------------------------------------------------------------
+// Content that does not compress to nothing, large enough to report progress several times
+std::string largeContent()
+{
+  std::string content(3 * 1024 * 1024 + 123, '\0');
+  unsigned int seed = 12345;
+  for (std::string::size_type i = 0; i < content.size(); ++i)
+    {
+    seed = seed * 1103515245 + 12345;
+    content[i] = static_cast<char>((seed >> 16) & 0x0f);
+    }
+  return content;
+}
+
+//-----------------------------------------------------------------------------
+struct ProgressRecorder
+{
+  ProgressRecorder() : CancelAt(-1.) {}
+  std::vector<double> Progress;
+  // cancel when the progress reaches this value, never if negative
+  double CancelAt;
+
+  static bool callback(double progress, void* clientData)
+    {
+    ProgressRecorder* self = reinterpret_cast<ProgressRecorder*>(clientData);
+    self->Progress.push_back(progress);
+    return self->CancelAt < 0. || progress < self->CancelAt;
+    }
+};
+
+//-----------------------------------------------------------------------------
+int checkProgress(const ProgressRecorder& recorder)
+{
+  CHECK_BOOL(recorder.Progress.size() >= 3, true);
+  CHECK_DOUBLE(recorder.Progress.front(), 0.);
+  CHECK_DOUBLE(recorder.Progress.back(), 1.);
+  for (size_t i = 1; i < recorder.Progress.size(); ++i)
+    {
+    CHECK_BOOL(recorder.Progress[i] >= recorder.Progress[i - 1], true);
+    }
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int testZipUnzip(const std::string& tempDir)
+{
+  std::string bundleDir = tempDir + "/Bundle";
+  vtksys::SystemTools::MakeDirectory((bundleDir + "/Data").c_str());
+  std::string large = largeContent();
+  writeFile(bundleDir + "/Bundle.mrml", "<MRML></MRML>");
+  writeFile(bundleDir + "/Data/volume.nrrd", large);
+  writeFile(bundleDir + "/Data/model.vtk.gz", large.substr(0, 1000));
+
+  // Zip reports progress from 0 to 1
+  std::string zipFileName = tempDir + "/Bundle.mrb";
+  ProgressRecorder zipProgress;
+  CHECK_BOOL(zip(zipFileName.c_str(), bundleDir.c_str(), &ProgressRecorder::callback, &zipProgress), true);
+  CHECK_EXIT_SUCCESS(checkProgress(zipProgress));
+  CHECK_BOOL(vtksys::SystemTools::FileExists((zipFileName + ".partial").c_str()), false);
+
+  // Unzip reports progress from 0 to 1 and restores the files
+  std::string extractDir = tempDir + "/Extract";
+  vtksys::SystemTools::MakeDirectory(extractDir.c_str());
+  ProgressRecorder unzipProgress;
+  CHECK_BOOL(unzip(zipFileName.c_str(), extractDir.c_str(), &ProgressRecorder::callback, &unzipProgress), true);
+  CHECK_EXIT_SUCCESS(checkProgress(unzipProgress));
+  CHECK_BOOL(readFile(extractDir + "/Bundle/Bundle.mrml") == "<MRML></MRML>", true);
+  CHECK_BOOL(readFile(extractDir + "/Bundle/Data/volume.nrrd") == large, true);
+  CHECK_BOOL(readFile(extractDir + "/Bundle/Data/model.vtk.gz") == large.substr(0, 1000), true);
+
+  // Canceling a zip keeps the existing zip file and removes the partial one
+  std::string zipContent = readFile(zipFileName);
+  writeFile(bundleDir + "/Data/volume2.nrrd", large);
+  ProgressRecorder canceledZipProgress;
+  canceledZipProgress.CancelAt = 0.1;
+  CHECK_BOOL(zip(zipFileName.c_str(), bundleDir.c_str(), &ProgressRecorder::callback, &canceledZipProgress), false);
+  CHECK_BOOL(canceledZipProgress.Progress.back() < 1., true);
+  CHECK_BOOL(readFile(zipFileName) == zipContent, true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((zipFileName + ".partial").c_str()), false);
+
+  // Canceling before starting does not create anything
+  std::string newZipFileName = tempDir + "/New.mrb";
+  ProgressRecorder immediateCancelProgress;
+  immediateCancelProgress.CancelAt = 0.;
+  CHECK_BOOL(zip(newZipFileName.c_str(), bundleDir.c_str(), &ProgressRecorder::callback, &immediateCancelProgress), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists(newZipFileName.c_str()), false);
+
+  // A successful zip replaces the existing zip file
+  CHECK_BOOL(zip(zipFileName.c_str(), bundleDir.c_str()), true);
+  std::vector<std::string> files;
+  CHECK_BOOL(list_archive(zipFileName.c_str(), files), true);
+  CHECK_BOOL(std::find(files.begin(), files.end(), "Bundle/Data/volume2.nrrd") != files.end(), true);
+
+  // Canceling an unzip stops extracting
+  std::string canceledExtractDir = tempDir + "/CanceledExtract";
+  vtksys::SystemTools::MakeDirectory(canceledExtractDir.c_str());
+  ProgressRecorder canceledUnzipProgress;
+  canceledUnzipProgress.CancelAt = 0.1;
+  CHECK_BOOL(unzip(zipFileName.c_str(), canceledExtractDir.c_str(), &ProgressRecorder::callback, &canceledUnzipProgress), false);
+  CHECK_BOOL(canceledUnzipProgress.Progress.back() < 1., true);
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+bool writeArchive(const std::string& zipFileName, const std::vector<std::string>& entryPaths)
+{
+  struct archive* zipArchive = archive_write_new();
+  archive_write_set_format_zip(zipArchive);
+  if (archive_write_open_filename(zipArchive, zipFileName.c_str()) != ARCHIVE_OK)
+    {
+    archive_write_free(zipArchive);
+    return false;
+    }
+  for (std::vector<std::string>::const_iterator pathIt = entryPaths.begin(); pathIt != entryPaths.end(); ++pathIt)
+    {
+    struct archive_entry* entry = archive_entry_new();
+    archive_entry_set_pathname(entry, pathIt->c_str());
+    archive_entry_set_size(entry, pathIt->size());
+    archive_entry_set_filetype(entry, AE_IFREG);
+    archive_entry_set_perm(entry, 0644);
+    archive_write_header(zipArchive, entry);
+    archive_write_data(zipArchive, pathIt->c_str(), pathIt->size());
+    archive_entry_free(entry);
+    }
+  archive_write_close(zipArchive);
+  return archive_write_free(zipArchive) == ARCHIVE_OK;
+}
+
+//-----------------------------------------------------------------------------
+int testUnsafeEntries(const std::string& tempDir)
+{
+  // Archive with entries escaping the extraction directory, each entry contains its path
+  std::string zipFileName = tempDir + "/Unsafe.zip";
+  std::vector<std::string> entryPaths;
+  entryPaths.push_back("Bundle/safe.txt");
+  entryPaths.push_back("../escaped.txt");
+  entryPaths.push_back("Bundle/../../escapedFromBundle.txt");
+  entryPaths.push_back(tempDir + "/absolute.txt");
+  entryPaths.push_back("Bundle/safe..name.txt");
+  CHECK_BOOL(writeArchive(zipFileName, entryPaths), true);
+
+  // Unsafe entries are skipped and reported as a failure, safe entries are extracted
+  std::string extractDir = tempDir + "/UnsafeExtract";
+  vtksys::SystemTools::MakeDirectory(extractDir.c_str());
+  CHECK_BOOL(unzip(zipFileName.c_str(), extractDir.c_str()), false);
+  CHECK_BOOL(readFile(extractDir + "/Bundle/safe.txt") == "Bundle/safe.txt", true);
+  CHECK_BOOL(readFile(extractDir + "/Bundle/safe..name.txt") == "Bundle/safe..name.txt", true);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((tempDir + "/escaped.txt").c_str()), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((tempDir + "/escapedFromBundle.txt").c_str()), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((tempDir + "/absolute.txt").c_str()), false);
+  CHECK_BOOL(vtksys::SystemTools::FileExists((extractDir + tempDir + "/absolute.txt").c_str()), false);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkArchiveTest1(int argc, char * argv [] )
+{
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = vtksys::SystemTools::CollapseFullPath(argv[1]) + "/vtkArchiveTest1";
+  vtksys::SystemTools::RemoveADirectory(tempDir.c_str());
+  CHECK_BOOL(vtksys::SystemTools::MakeDirectory(tempDir.c_str()), true);
+
+  CHECK_EXIT_SUCCESS(testZipUnzip(tempDir));
+  CHECK_EXIT_SUCCESS(testUnsafeEntries(tempDir));
+
+  vtksys::SystemTools::RemoveADirectory(tempDir.c_str());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkImageLabelOutline.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageCast.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void fillLabelmap(vtkImageData* image)
+{
+  image->SetDimensions(61, 47, 1);
+  image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+  unsigned short* ptr = static_cast<unsigned short*>(image->GetScalarPointer());
+  for (int y = 0; y < 47; ++y)
+    {
+    for (int x = 0; x < 61; ++x)
+      {
+      unsigned short label = 0;
+      if ((x - 20) * (x - 20) + (y - 20) * (y - 20) < 150)
+        {
+        label = 1;
+        }
+      else if (x > 35 && y > 10 && y < 40)
+        {
+        label = (x < 50 ? 2 : 3);
+        }
+      else if (x > 55)
+        {
+        label = 4;
+        }
+      *(ptr++) = label;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool testOutline(vtkImageData* labelmap, int outline, int numberOfThreads)
+{
+  // Fast path (unsigned short)
+  vtkNew<vtkImageLabelOutline> fastOutline;
+  fastOutline->SetInputData(labelmap);
+  fastOutline->SetOutline(outline);
+  fastOutline->SetNumberOfThreads(numberOfThreads);
+  fastOutline->Update();
+
+  // Generic path (float)
+  vtkNew<vtkImageCast> cast;
+  cast->SetInputData(labelmap);
+  cast->SetOutputScalarTypeToFloat();
+  vtkNew<vtkImageLabelOutline> genericOutline;
+  genericOutline->SetInputConnection(cast->GetOutputPort());
+  genericOutline->SetOutline(outline);
+  genericOutline->SetNumberOfThreads(1);
+  genericOutline->Update();
+
+  vtkImageData* fastOutput = fastOutline->GetOutput();
+  vtkImageData* genericOutput = genericOutline->GetOutput();
+  int* dims = labelmap->GetDimensions();
+  int numberOfOutlinePixels = 0;
+  for (int y = 0; y < dims[1]; ++y)
+    {
+    for (int x = 0; x < dims[0]; ++x)
+      {
+      double fastValue = fastOutput->GetScalarComponentAsDouble(x, y, 0, 0);
+      double genericValue = genericOutput->GetScalarComponentAsDouble(x, y, 0, 0);
+      if (fastValue != genericValue)
+        {
+        std::cerr << "Line " << __LINE__ << " - outline " << outline
+                  << ", threads " << numberOfThreads << ": mismatch at ("
+                  << x << ", " << y << "): " << fastValue
+                  << " != " << genericValue << std::endl;
+        return false;
+        }
+      if (fastValue != 0.)
+        {
+        ++numberOfOutlinePixels;
+        }
+      }
+    }
+  if (numberOfOutlinePixels == 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - no outline pixels" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelOutlineTest1(int , char * [] )
+{
+  vtkNew<vtkImageLabelOutline> filter;
+  EXERCISE_BASIC_OBJECT_METHODS(filter.GetPointer());
+
+  vtkNew<vtkImageData> labelmap;
+  fillLabelmap(labelmap.GetPointer());
+
+  for (int outline = 1; outline <= 3; ++outline)
+    {
+    if (!testOutline(labelmap.GetPointer(), outline, 1) ||
+        !testOutline(labelmap.GetPointer(), outline, 4))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include <vtkMRMLSliceLayerLogic.h>
+#include <vtkMRMLSliceLogic.h>
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceNode.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+
+//-----------------------------------------------------------------------------
+int vtkMRMLSliceLayerLogicStreamingTest1(int argc, char * argv [] )
+{
+  itk::itkFactoryRegistration();
+
+  if (argc != 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string fileName = std::string(argv[1]) + "/vtkMRMLSliceLayerLogicStreamingTest1.nrrd";
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSliceNode::AddDefaultSliceOrientationPresets(scene.GetPointer());
+
+  // Write an uncompressed volume centered on the origin
+  const int dimension = 64;
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(dimension, dimension, dimension);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  vtkIdType numberOfVoxels = imageData->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    voxels[i] = static_cast<short>(i % 1000);
+    }
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  volumeNode->SetOrigin(-(dimension-1)/2.0, -(dimension-1)/2.0, -(dimension-1)/2.0);
+  scene->AddNode(volumeNode.GetPointer());
+
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetUseCompression(0);
+  CHECK_BOOL(storageNode->WriteData(volumeNode.GetPointer()), true);
+
+  // Open the volume for streaming
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  // Auto window/level would compute the histogram of the whole volume
+  displayNode->SetAutoWindowLevel(false);
+  displayNode->SetWindowLevel(1000., 500.);
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  scene->AddNode(displayNode.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeNode> streamedVolumeNode;
+  scene->AddNode(streamedVolumeNode.GetPointer());
+  streamedVolumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  storageNode->StreamingReadOn();
+  CHECK_BOOL(storageNode->ReadData(streamedVolumeNode.GetPointer()), true);
+  vtkImageData* streamedImageData = streamedVolumeNode->GetImageData();
+  CHECK_NOT_NULL(streamedImageData);
+  CHECK_INT(streamedImageData->GetNumberOfPoints(), 0);
+
+  // Display the volume in an axial slice view
+  vtkNew<vtkMRMLSliceLogic> sliceLogic;
+  sliceLogic->SetName("Red");
+  sliceLogic->SetMRMLScene(scene.GetPointer());
+  vtkMRMLSliceNode* sliceNode = sliceLogic->GetSliceNode();
+  sliceNode->SetOrientationToAxial();
+  sliceNode->SetDimensions(dimension, dimension, 1);
+  sliceNode->SetFieldOfView(dimension, dimension, 1);
+  sliceNode->SetSliceOffset(0.);
+
+  vtkNew<vtkMRMLSliceLayerLogic> sliceLayerLogic;
+  sliceLogic->SetBackgroundLayer(sliceLayerLogic.GetPointer());
+  sliceLogic->GetSliceCompositeNode()->SetBackgroundVolumeID(streamedVolumeNode->GetID());
+  sliceLogic->UpdatePipeline();
+  sliceLayerLogic->UpdateTransforms();
+  sliceLayerLogic->UpdateImageDisplay();
+
+  vtkAlgorithmOutput* sliceImageConnection = sliceLayerLogic->GetImageDataConnection();
+  CHECK_NOT_NULL(sliceImageConnection);
+  sliceImageConnection->GetProducer()->Update();
+
+  // Rendering the slice reads only the slab of the volume that it intersects
+  vtkIdType numberOfReadVoxels = streamedImageData->GetNumberOfPoints();
+  std::cout << "Read " << numberOfReadVoxels << " of " << numberOfVoxels << " voxels" << std::endl;
+  if (numberOfReadVoxels <= 0 || numberOfReadVoxels > 2 * dimension * dimension)
+    {
+    std::cerr << "Line " << __LINE__ << ": expected a partial read of at most 2 slices, got "
+              << numberOfReadVoxels << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Moving the slice reads another slab
+  sliceNode->SetSliceOffset(20.);
+  sliceLayerLogic->UpdateTransforms();
+  sliceImageConnection->GetProducer()->Update();
+  numberOfReadVoxels = streamedImageData->GetNumberOfPoints();
+  if (numberOfReadVoxels <= 0 || numberOfReadVoxels > 2 * dimension * dimension)
+    {
+    std::cerr << "Line " << __LINE__ << ": expected a partial read of at most 2 slices, got "
+              << numberOfReadVoxels << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,223 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include <vtkMRMLSliceLogic.h>
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceNode.h>
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void countEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Check that the slice image is only computed by UpdateFrame() when
+// DeferredFrameUpdate is enabled, and that intermediate changes are combined,
+// including the slice offset steps of the mouse wheel and the keyboard.
+int vtkMRMLSliceLogicTest6(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSliceNode::AddDefaultSliceOrientationPresets(scene.GetPointer());
+
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(32, 32, 32);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  for (vtkIdType i = 0; i < imageData->GetNumberOfPoints(); ++i)
+    {
+    voxels[i] = static_cast<short>(i % 256);
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  scene->AddNode(displayNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  vtkNew<vtkMRMLSliceLogic> sliceLogic;
+  sliceLogic->SetName("Red");
+  sliceLogic->SetMRMLScene(scene.GetPointer());
+  sliceLogic->GetSliceNode()->SetDimensions(64, 48, 1);
+  sliceLogic->GetSliceCompositeNode()->SetBackgroundVolumeID(volumeNode->GetID());
+
+  vtkNew<vtkCallbackCommand> callback;
+  int numberOfRequests = 0;
+  callback->SetClientData(&numberOfRequests);
+  callback->SetCallback(countEvent);
+  sliceLogic->AddObserver(vtkMRMLSliceLogic::FrameUpdateRequestedEvent, callback.GetPointer());
+
+  // Not deferred: no request, nothing to update
+  sliceLogic->SetSliceOffset(2.);
+  CHECK_INT(numberOfRequests, 0);
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), false);
+  CHECK_BOOL(sliceLogic->UpdateFrame(), false);
+  vtkAlgorithmOutput* blendConnection = sliceLogic->GetImageDataConnection();
+  CHECK_NOT_NULL(blendConnection);
+
+  // Enabling computes the first frame right away, without request
+  sliceLogic->SetDeferredFrameUpdate(true);
+  CHECK_INT(numberOfRequests, 0);
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), false);
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 1);
+  vtkAlgorithmOutput* frameConnection = sliceLogic->GetImageDataConnection();
+  CHECK_NOT_NULL(frameConnection);
+  CHECK_BOOL(frameConnection != blendConnection, true);
+  vtkImageData* frame = vtkImageData::SafeDownCast(
+    frameConnection->GetProducer()->GetOutputDataObject(0));
+  CHECK_NOT_NULL(frame);
+  int* dimensions = frame->GetDimensions();
+  CHECK_INT(dimensions[0], 64);
+  CHECK_INT(dimensions[1], 48);
+  CHECK_INT(frame->GetNumberOfScalarComponents(), 4);
+
+  // Changes are combined into a single request
+  for (int i = 0; i < 10; ++i)
+    {
+    sliceLogic->SetSliceOffset(i);
+    displayNode->SetWindowLevel(100. + i, 50.);
+    }
+  CHECK_INT(numberOfRequests, 1);
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), true);
+
+  CHECK_BOOL(sliceLogic->UpdateFrame(), true);
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), false);
+  CHECK_BOOL(sliceLogic->UpdateFrame(), false);
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 2);
+
+  // The frame shares the pixels of the pipeline output, without copy
+  vtkAlgorithm* blendProducer = blendConnection->GetProducer();
+  vtkImageData* blendOutput = vtkImageData::SafeDownCast(
+    blendProducer->GetOutputDataObject(blendConnection->GetIndex()));
+  CHECK_NOT_NULL(blendOutput);
+  vtkDataArray* frameScalars = frame->GetPointData()->GetScalars();
+  CHECK_NOT_NULL(frameScalars);
+  CHECK_POINTER(frameScalars, blendOutput->GetPointData()->GetScalars());
+  vtkNew<vtkUnsignedCharArray> framePixels;
+  framePixels->DeepCopy(frameScalars);
+
+  // The frame does not change until the next update, even if the pipeline
+  // computes a new image: the new image is written into another buffer
+  vtkMTimeType frameMTime = frame->GetMTime();
+  displayNode->SetWindowLevel(10., 5.);
+  sliceLogic->SetSliceOffset(5.);
+  CHECK_INT(numberOfRequests, 2);
+  blendProducer->Update(blendConnection->GetIndex());
+  CHECK_BOOL(frame->GetMTime() == frameMTime, true);
+  CHECK_POINTER(frame->GetPointData()->GetScalars(), frameScalars);
+  CHECK_POINTER_DIFFERENT(blendOutput->GetPointData()->GetScalars(), frameScalars);
+  CHECK_INT(frameScalars->GetNumberOfTuples(), framePixels->GetNumberOfTuples());
+  for (vtkIdType i = 0; i < framePixels->GetNumberOfValues(); ++i)
+    {
+    if (frameScalars->GetComponent(i / 4, i % 4) != framePixels->GetValue(i))
+      {
+      std::cerr << "Line " << __LINE__ << ": displayed frame modified by the pipeline at value " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  CHECK_BOOL(sliceLogic->UpdateFrame(), true);
+  CHECK_BOOL(frame->GetMTime() > frameMTime, true);
+  CHECK_POINTER(frame->GetPointData()->GetScalars(), blendOutput->GetPointData()->GetScalars());
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 3);
+
+  int histogramTotal = 0;
+  for (int bin = 0; bin < vtkMRMLSliceLogic::NUMBER_OF_FRAME_UPDATE_LATENCY_BINS; ++bin)
+    {
+    histogramTotal += sliceLogic->GetFrameUpdateLatencyBinCount(bin);
+    }
+  CHECK_INT(histogramTotal, 3);
+  sliceLogic->ResetFrameUpdateLatencyHistogram();
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 0);
+
+  // Disabling restores the direct connection and releases the frame
+  sliceLogic->SetDeferredFrameUpdate(false);
+  CHECK_POINTER(sliceLogic->GetImageDataConnection(), blendConnection);
+  CHECK_NULL(frame->GetPointData()->GetScalars());
+
+  // Slice offset steps (mouse wheel, keyboard) go through the deferred frame
+  // updates: a burst of steps is resliced once, at the latest offset
+  double sliceBounds[6] = {0, -1, 0, -1, 0, -1};
+  sliceLogic->GetSliceBounds(sliceBounds);
+  const double startOffset = 0.5 * (sliceBounds[4] + sliceBounds[5]);
+  sliceLogic->SetSliceOffset(startOffset);
+  numberOfRequests = 0;
+  CHECK_BOOL(sliceLogic->StepSliceOffset(1.), true);
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), true);
+  CHECK_BOOL(sliceLogic->GetSliceOffsetStepping(), true);
+  CHECK_POINTER(sliceLogic->GetImageDataConnection(), frameConnection);
+  // the frame at the start offset is computed when the stepping starts
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 1);
+  for (int i = 0; i < 4; ++i)
+    {
+    CHECK_BOOL(sliceLogic->StepSliceOffset(1.), true);
+    }
+  CHECK_BOOL(sliceLogic->StepSliceOffset(-2.), true);
+  CHECK_DOUBLE_TOLERANCE(sliceLogic->GetSliceOffset(), startOffset + 3., 1e-6);
+  CHECK_INT(numberOfRequests, 1);
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 1);
+  CHECK_BOOL(sliceLogic->UpdateFrame(), true);
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), 2);
+
+  // Steps out of the slice bounds are ignored
+  CHECK_BOOL(sliceLogic->StepSliceOffset(sliceBounds[5] - sliceBounds[4] + 1.), false);
+  CHECK_DOUBLE_TOLERANCE(sliceLogic->GetSliceOffset(), startOffset + 3., 1e-6);
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), false);
+  CHECK_INT(numberOfRequests, 1);
+
+  // Ending the stepping restores the direct connection
+  sliceLogic->EndSliceOffsetStepping();
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), false);
+  CHECK_BOOL(sliceLogic->GetSliceOffsetStepping(), false);
+  CHECK_POINTER(sliceLogic->GetImageDataConnection(), blendConnection);
+
+  // Steps made while DeferredFrameUpdate is enabled (e.g. during a drag) do
+  // not disable it when the stepping ends
+  sliceLogic->SetDeferredFrameUpdate(true);
+  CHECK_BOOL(sliceLogic->StepSliceOffset(-1.), true);
+  CHECK_BOOL(sliceLogic->GetSliceOffsetStepping(), false);
+  CHECK_INT(numberOfRequests, 2);
+  sliceLogic->EndSliceOffsetStepping();
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), true);
+  sliceLogic->SetDeferredFrameUpdate(false);
+
+  return EXIT_SUCCESS;
+}
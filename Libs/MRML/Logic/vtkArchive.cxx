@@ -215,6 +215,58 @@ long copy_data(struct archive *ar, struct archive *aw)
   return r;
 }
 
+// --------------------------------------------------------------------------
+// Report progress at most every this many bytes, to keep the callback overhead low
+const unsigned long ProgressReportBytes = 1024 * 1024;
+
+// --------------------------------------------------------------------------
+// Files with these extensions are already compressed, deflating them again
+// would only cost time
+bool isCompressedFile(const std::string& fileName)
+{
+  const char* compressedExtensions[] =
+    { ".gz", ".tgz", ".bz2", ".xz", ".zip", ".mrb", ".png", ".jpg", ".jpeg", 0 };
+  std::string lowerFileName = vtksys::SystemTools::LowerCase(fileName);
+  for (int i = 0; compressedExtensions[i]; ++i)
+    {
+    std::string extension(compressedExtensions[i]);
+    if (lowerFileName.size() >= extension.size()
+      && lowerFileName.compare(lowerFileName.size() - extension.size(), extension.size(), extension) == 0)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+// --------------------------------------------------------------------------
+// Return true if the entry path is absolute or has a ".." component,
+// i.e. if it could point outside of the directory it is extracted into
+bool isUnsafeEntryPath(const std::string& entryPath)
+{
+  if (entryPath.empty()
+    || entryPath[0] == '/' || entryPath[0] == '\\'
+    || (entryPath.size() > 1 && entryPath[1] == ':'))
+    {
+    return true;
+    }
+  std::string::size_type componentStart = 0;
+  while (componentStart <= entryPath.size())
+    {
+    std::string::size_type componentEnd = entryPath.find_first_of("/\\", componentStart);
+    if (componentEnd == std::string::npos)
+      {
+      componentEnd = entryPath.size();
+      }
+    if (entryPath.compare(componentStart, componentEnd - componentStart, "..") == 0)
+      {
+      return true;
+      }
+    componentStart = componentEnd + 1;
+    }
+  return false;
+}
+
 } // end of anonymous namespace
 
 //-----------------------------------------------------------------------------
@@ -346,7 +398,8 @@ bool extract_tar(const char* tarFileName, bool verbose, bool extract, std::vecto
 //-----------------------------------------------------------------------------
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-bool zip(const char* zipFileName, const char* directoryToZip)
+bool zip(const char* zipFileName, const char* directoryToZip,
+         vtkArchiveProgressCallback progressCallback, void* progressClientData)
 {
 
   //
@@ -385,6 +438,25 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     }
   std::vector<std::string> files = glob.GetFiles();
 
+  // total size is used for reporting progress
+  unsigned long totalLength = 0;
+  std::vector<std::string>::const_iterator sit;
+  for (sit = files.begin(); sit != files.end(); ++sit)
+    {
+    totalLength += vtksys::SystemTools::FileLength(sit->c_str());
+    }
+  unsigned long processedLength = 0;
+  unsigned long lastReportedLength = 0;
+  bool canceled = false;
+  if (progressCallback && !progressCallback(0.0, progressClientData))
+    {
+    return false;
+    }
+
+  // the archive is written next to the zip file and renamed when complete,
+  // so that a failed or canceled zip leaves an existing zip file untouched
+  std::string partialZipFileName = std::string(zipFileName) + ".partial";
+
   // now zip it up using LibArchive
   struct archive *zipArchive;
   struct archive_entry *entry, *dirEntry;
@@ -406,7 +478,12 @@ bool zip(const char* zipFileName, const char* directoryToZip)
 
   archive_write_set_format_option(zipArchive, "zip", "compression", compression_type.c_str());
 
-  archive_write_open_filename(zipArchive, zipFileName);
+  if (archive_write_open_filename(zipArchive, partialZipFileName.c_str()) != ARCHIVE_OK)
+    {
+    vtkArchiveTools::Error("Zip: cannot create", partialZipFileName.c_str());
+    archive_write_free(zipArchive);
+    return false;
+    }
 
   // add the data directory
   dirEntry = archive_entry_new();
@@ -418,9 +495,8 @@ bool zip(const char* zipFileName, const char* directoryToZip)
   archive_entry_free(dirEntry);
 
   // add the files
-  std::vector<std::string>::const_iterator sit;
   sit = files.begin();
-  while (sit != files.end())
+  while (sit != files.end() && !canceled)
     {
     vtkArchiveTools::Message("Zip: adding:", (*sit).c_str());
     const char *fileName = (*sit).c_str();
@@ -443,6 +519,9 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     archive_entry_set_size(entry, fileLength);
     archive_entry_set_filetype(entry, AE_IFREG);
     archive_entry_set_perm(entry, 0644);
+    // compression option applies to the entries added after setting it
+    archive_write_set_format_option(zipArchive, "zip", "compression",
+      isCompressedFile(relFileName) ? "store" : compression_type.c_str());
     archive_write_header(zipArchive, entry);
 
     //
@@ -451,7 +530,7 @@ bool zip(const char* zipFileName, const char* directoryToZip)
     fd = fopen(fileName, "rb");
     if (!fd)
       {
-      vtkArchiveTools::Error("Zip: cannot open:", (*sit).c_str());
+      vtkArchiveTools::Error("Zip: cannot open:", fileName);
       }
     else
       {
@@ -459,6 +538,16 @@ bool zip(const char* zipFileName, const char* directoryToZip)
       while ( len > 0 )
         {
         archive_write_data(zipArchive, buff, len);
+        processedLength += static_cast<unsigned long>(len);
+        if (progressCallback && processedLength - lastReportedLength >= ProgressReportBytes)
+          {
+          lastReportedLength = processedLength;
+          if (!progressCallback(totalLength > 0 ? double(processedLength) / totalLength : 1.0, progressClientData))
+            {
+            canceled = true;
+            break;
+            }
+          }
         len = fread(buff, sizeof(char), sizeof(buff), fd);
         }
       fclose(fd);
@@ -468,27 +557,45 @@ bool zip(const char* zipFileName, const char* directoryToZip)
 
   archive_write_close(zipArchive);
   int retval = archive_write_free(zipArchive);
+  if (canceled)
+    {
+    vtkArchiveTools::Message("Zip:", "canceled");
+    vtksys::SystemTools::RemoveFile(partialZipFileName.c_str());
+    return false;
+    }
   if (retval != ARCHIVE_OK)
     {
     vtkArchiveTools::Error("Zip:", "error on close!");
+    vtksys::SystemTools::RemoveFile(partialZipFileName.c_str());
+    return false;
+    }
+  if (!vtksys::SystemTools::RenameFile(partialZipFileName.c_str(), zipFileName))
+    {
+    vtkArchiveTools::Error("Zip: cannot replace", zipFileName);
+    vtksys::SystemTools::RemoveFile(partialZipFileName.c_str());
     return false;
     }
+  if (progressCallback)
+    {
+    progressCallback(1.0, progressClientData);
+    }
   return true;
 }
 
 //-----------------------------------------------------------------------------
 // unzips zip file into destinationDirectory
-bool unzip(const char* zipFileName, const char* destinationDirectory)
+bool unzip(const char* zipFileName, const char* destinationDirectory,
+           vtkArchiveProgressCallback progressCallback, void* progressClientData)
 {
   //
   // Unziping the archive
   // - check that files and directories exist
-  // - cd to destination
   // - create an extracter from the file
   // - create a writer to disk
-  // - read all headers and data into disk
+  // - read all headers and data into disk, prefixing the path of each
+  //   entry with the destination directory (the current directory is not
+  //   changed, as it is shared by all the threads of the process)
   // - close up the archives
-  // - cd back to original directory
   //
 
   if ( !zipFileName || !destinationDirectory )
@@ -509,11 +616,19 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
     return false;
     }
 
-  std::string cwd = vtksys::SystemTools::GetCurrentWorkingDirectory(true);
+  std::string destinationPrefix = vtksys::SystemTools::CollapseFullPath(destinationDirectory);
+  if (destinationPrefix.empty() || destinationPrefix[destinationPrefix.size() - 1] != '/')
+    {
+    destinationPrefix += "/";
+    }
 
-  if ( vtksys::SystemTools::ChangeDirectory(destinationDirectory) )
+  // compressed size is used for reporting progress
+  unsigned long totalLength = vtksys::SystemTools::FileLength(zipFileName);
+  unsigned long lastReportedLength = 0;
+  bool canceled = false;
+  bool skippedUnsafeEntries = false;
+  if (progressCallback && !progressCallback(0.0, progressClientData))
     {
-    vtkArchiveTools::Error("Unzip:", "could not change to destination directory");
     return false;
     }
 
@@ -536,8 +651,10 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
 
   diskDestination = archive_write_disk_new();
   archive_write_disk_set_standard_lookup(diskDestination);
+  // entries are relative to the destination directory, refuse to write elsewhere
+  archive_write_disk_set_options(diskDestination, ARCHIVE_EXTRACT_SECURE_NODOTDOT | ARCHIVE_EXTRACT_SECURE_SYMLINKS);
 
-  for (;;)
+  while (!canceled)
     {
     // for each file entry
     result = archive_read_next_header(zipArchive, &entry);
@@ -553,6 +670,24 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
         break;
         }
       }
+    // entries must be relative to the destination directory and stay inside of it
+    const char* entryPathName = archive_entry_pathname(entry);
+    if (!entryPathName || isUnsafeEntryPath(entryPathName)
+      || (archive_entry_hardlink(entry) && isUnsafeEntryPath(archive_entry_hardlink(entry))))
+      {
+      vtkArchiveTools::Error("Unzip: skipping entry outside of destination directory:",
+                             entryPathName);
+      skippedUnsafeEntries = true;
+      archive_read_data_skip(zipArchive);
+      continue;
+      }
+    std::string entryPath = destinationPrefix + entryPathName;
+    archive_entry_copy_pathname(entry, entryPath.c_str());
+    if (archive_entry_hardlink(entry))
+      {
+      std::string hardlinkPath = destinationPrefix + archive_entry_hardlink(entry);
+      archive_entry_copy_hardlink(entry, hardlinkPath.c_str());
+      }
     result = archive_write_header(diskDestination, entry);
     if (result != ARCHIVE_OK)
       {
@@ -591,6 +726,21 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
           vtkArchiveTools::Error("Unzip error:", archive_error_string(diskDestination));
           break;
           }
+#if defined(ARCHIVE_VERSION_NUMBER) && ARCHIVE_VERSION_NUMBER >= 3000000
+        if (progressCallback)
+          {
+          unsigned long readLength = static_cast<unsigned long>(archive_filter_bytes(zipArchive, -1));
+          if (readLength - lastReportedLength >= ProgressReportBytes)
+            {
+            lastReportedLength = readLength;
+            if (!progressCallback(totalLength > 0 ? double(readLength) / totalLength : 1.0, progressClientData))
+              {
+              canceled = true;
+              break;
+              }
+            }
+          }
+#endif
         }
       }
     }
@@ -620,12 +770,19 @@ bool unzip(const char* zipFileName, const char* destinationDirectory)
     return false;
     }
 
-
-  if ( vtksys::SystemTools::ChangeDirectory(cwd.c_str()) )
+  if (canceled)
     {
-    vtkArchiveTools::Error("Unzip:", "could not change back to working directory");
+    vtkArchiveTools::Message("Unzip:", "canceled");
     return false;
     }
+  if (skippedUnsafeEntries)
+    {
+    return false;
+    }
+  if (progressCallback)
+    {
+    progressCallback(1.0, progressClientData);
+    }
 
   return (result == ARCHIVE_OK);
 }
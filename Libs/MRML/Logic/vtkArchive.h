@@ -35,13 +35,29 @@ VTK_MRML_LOGIC_EXPORT bool list_archive(
 VTK_MRML_LOGIC_EXPORT bool extract_tar(const char* tarFileName, bool verbose, bool extract,
                                        std::vector<std::string> * extracted_files = 0);
 
+// callback reporting the progress of zip and unzip, between 0 and 1.
+// It is called from the thread running zip or unzip.
+// Returning false cancels the operation.
+typedef bool (*vtkArchiveProgressCallback)(double progress, void* clientData);
+
 // creates a zip file with the full contents of the directory (recurses)
 // zip entries will include relative path of including tail of directoryToZip
-VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip);
+// Files that are already compressed (e.g. .gz, .png) are stored without compression.
+// The archive is written into zipFileName.partial, which replaces zipFileName
+// only on success: if the operation fails or is canceled by the progress
+// callback then an existing zip file is left untouched.
+VTK_MRML_LOGIC_EXPORT bool zip(const char* zipFileName, const char* directoryToZip,
+                               vtkArchiveProgressCallback progressCallback = 0,
+                               void* progressClientData = 0);
 
 // unzips zip file into specified directory
 // (internally this supports many formats of archive, not just zip)
-VTK_MRML_LOGIC_EXPORT bool unzip(const char* zipFileName, const char *destinationDirectory);
+// It does not change the current directory, so it can run in a background thread.
+// Entries pointing outside of the destination directory (absolute paths or
+// paths with ".." components) are not extracted and make unzip return false.
+VTK_MRML_LOGIC_EXPORT bool unzip(const char* zipFileName, const char *destinationDirectory,
+                                 vtkArchiveProgressCallback progressCallback = 0,
+                                 void* progressClientData = 0);
 #ifdef __cplusplus
 }
 #endif
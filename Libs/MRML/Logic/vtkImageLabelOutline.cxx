@@ -20,6 +20,10 @@
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkVersion.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkImageLabelOutline);
 
@@ -199,6 +203,129 @@ static void vtkImageLabelOutlineExecute(vtkImageLabelOutline *self,
     }//for2
 }
 
+//----------------------------------------------------------------------------
+// Description:
+// Fast path used for the integer scalar types labelmaps are stored in.
+// Instead of visiting the neighborhood of every pixel, the filter works on
+// whole rows: each neighbor row is compared to the center row for every
+// horizontal offset and the results are or-ed into a per-row edge mask.
+// The inner loops are branch-free and run over contiguous memory so that
+// the compiler can vectorize them. Rows of the output extent are split
+// between threads by the threaded image algorithm.
+template <class T>
+static void vtkImageLabelOutlineExecuteRows(vtkImageLabelOutline *self,
+                     vtkImageData *inData, vtkImageData *outData,
+                     int outExt[6], int id)
+{
+  // The extent of the whole input image
+  int inImageExt[6];
+  self->GetInputInformation()->Get(
+        vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), inImageExt);
+
+  vtkIdType inInc0, inInc1, inInc2;
+  inData->GetIncrements(inInc0, inInc1, inInc2);
+
+  const T backgroundLabelValue = static_cast<T>(self->GetBackground());
+  const int outline = self->GetOutline();
+  const int rowLength = outExt[1] - outExt[0] + 1;
+  if (rowLength <= 0)
+    {
+    return;
+    }
+
+  // Pixels whose neighborhood reaches outside of the input domain
+  // in the row direction are always outline pixels.
+  std::vector<unsigned char> columnOnBorder(rowLength, 0);
+  for (int i = 0; i < rowLength; ++i)
+    {
+    const int idx0 = outExt[0] + i;
+    columnOnBorder[i] = (idx0 - outline < inImageExt[0] ||
+                         idx0 + outline > inImageExt[1]) ? 1 : 0;
+    }
+  std::vector<unsigned char> edge(rowLength);
+
+  unsigned long count = 0;
+  unsigned long target =
+    (unsigned long)((outExt[5]-outExt[4]+1)*(outExt[3]-outExt[2]+1)/50.0);
+  target++;
+
+  for (int outIdx2 = outExt[4]; outIdx2 <= outExt[5]; ++outIdx2)
+    {
+    for (int outIdx1 = outExt[2];
+         !self->AbortExecute && outIdx1 <= outExt[3]; ++outIdx1)
+      {
+      if (!id)
+        {
+        if (!(count%target))
+          {
+          self->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+
+      const T* inRow = static_cast<T*>(
+        inData->GetScalarPointer(outExt[0], outIdx1, outIdx2));
+      T* outRow = static_cast<T*>(
+        outData->GetScalarPointer(outExt[0], outIdx1, outIdx2));
+
+      // Skip neighborhood comparisons for rows that only contain background
+      bool rowHasLabel = false;
+      for (int i = 0; i < rowLength; ++i)
+        {
+        rowHasLabel |= (inRow[i] != backgroundLabelValue);
+        }
+      if (!rowHasLabel)
+        {
+        std::fill(outRow, outRow + rowLength, backgroundLabelValue);
+        continue;
+        }
+
+      if (outIdx1 - outline < inImageExt[2] || outIdx1 + outline > inImageExt[3])
+        {
+        // neighborhood reaches outside of the input domain
+        std::fill(edge.begin(), edge.end(), 1);
+        }
+      else
+        {
+        std::copy(columnOnBorder.begin(), columnOnBorder.end(), edge.begin());
+        }
+
+      for (int hoodIdx1 = -outline; hoodIdx1 <= outline; ++hoodIdx1)
+        {
+        if (outIdx1 + hoodIdx1 < inImageExt[2] ||
+            outIdx1 + hoodIdx1 > inImageExt[3])
+          {
+          // the whole row is already marked as outline
+          continue;
+          }
+        const T* hoodRow = inRow + hoodIdx1 * inInc1;
+        for (int hoodIdx0 = -outline; hoodIdx0 <= outline; ++hoodIdx0)
+          {
+          // only compare with neighbors that are inside the input domain,
+          // the others are handled by columnOnBorder
+          const int iMin = std::max(0, inImageExt[0] - outExt[0] - hoodIdx0);
+          const int iMax = std::min(rowLength - 1,
+                                    inImageExt[1] - outExt[0] - hoodIdx0);
+          const T* hoodPtr = hoodRow + hoodIdx0;
+          unsigned char* edgePtr = &edge[0];
+          for (int i = iMin; i <= iMax; ++i)
+            {
+            edgePtr[i] |= (hoodPtr[i] != inRow[i]);
+            }
+          }
+        }
+
+      // If a neighbor value is not the same label value then this is an
+      // outline pixel (border is within neighborhood).
+      const unsigned char* edgePtr = &edge[0];
+      for (int i = 0; i < rowLength; ++i)
+        {
+        outRow[i] = edgePtr[i] ? inRow[i] : backgroundLabelValue;
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 // Description:
 // This method is passed a input and output data, and executes the filter
@@ -248,20 +375,16 @@ void vtkImageLabelOutline::ThreadedExecute(vtkImageData *inData,
       outData, outExt, id);
     break;
   case VTK_SHORT:
-    vtkImageLabelOutlineExecute(this, inData, (short *)(inPtr),
-      outData, outExt, id);
+    vtkImageLabelOutlineExecuteRows<short>(this, inData, outData, outExt, id);
     break;
   case VTK_UNSIGNED_SHORT:
-    vtkImageLabelOutlineExecute(this, inData, (unsigned short *)(inPtr),
-      outData, outExt, id);
+    vtkImageLabelOutlineExecuteRows<unsigned short>(this, inData, outData, outExt, id);
     break;
   case VTK_CHAR:
-    vtkImageLabelOutlineExecute(this, inData, (char *)(inPtr),
-      outData, outExt, id);
+    vtkImageLabelOutlineExecuteRows<char>(this, inData, outData, outExt, id);
     break;
   case VTK_UNSIGNED_CHAR:
-    vtkImageLabelOutlineExecute(this, inData, (unsigned char *)(inPtr),
-      outData, outExt, id);
+    vtkImageLabelOutlineExecuteRows<unsigned char>(this, inData, outData, outExt, id);
     break;
   default:
     vtkErrorMacro(<< "Execute: Unknown input ScalarType");
@@ -484,10 +484,16 @@ std::string vtkMRMLApplicationLogic::UnpackSlicerDataBundle(const char *sdbFileP
     return "";
     }
 
+  return this->FindSlicerDataBundleSceneFile(temporaryDirectory);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkMRMLApplicationLogic::FindSlicerDataBundleSceneFile(const char *directory)
+{
   vtksys::Glob glob;
   glob.RecurseOn();
   glob.RecurseThroughSymlinksOff();
-  std::string globPattern(temporaryDirectory);
+  std::string globPattern(directory);
   if ( !glob.FindFiles( globPattern + "/*.mrml" ) )
     {
     vtkErrorMacro("could not search archive");
@@ -135,7 +135,7 @@ public:
   /// Returns success or failure.
   bool Zip(const char *zipFileName, const char *directoryToZip);
 
-  /// unzip the zip file to the current working directory
+  /// unzip the zip file into the destination directory
   /// Returns success or failure.
   bool Unzip(const char *zipFileName, const char *destinationDirectory);
 
@@ -167,6 +167,11 @@ public:
   /// directory will be used.
   std::string UnpackSlicerDataBundle(const char *sdbFilePath, const char *temporaryDirectory);
 
+  /// Return the first scene file found in a directory where a data bundle
+  /// was unpacked, or an empty string if there is none.
+  /// \sa UnpackSlicerDataBundle
+  std::string FindSlicerDataBundleSceneFile(const char *directory);
+
   /// Load any default parameter sets into the specified scene
   /// Returns the total number of loaded parameter sets
   static int LoadDefaultParameterSets(vtkMRMLScene * scene,
@@ -736,8 +736,10 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
 //      {
 //      volumeNode->GetImageData()->Print(std::cout);
 //      }
-    this->Reslice->SetInputData(volumeNode->GetImageData());
-    this->ResliceUVW->SetInputData(volumeNode->GetImageData());
+    // Connect to the volume pipeline (not its output data) so that a streamed
+    // volume only reads the extent needed by the reslice
+    this->Reslice->SetInputConnection(volumeNode->GetImageDataConnection());
+    this->ResliceUVW->SetInputConnection(volumeNode->GetImageDataConnection());
     // use the label outline if we have a label map volume, this is the label
     // layer (turned on in slice logic when the label layer is instantiated)
     // and the slice node is set to use it.
@@ -46,11 +46,14 @@
 #include <vtkPolyDataCollection.h>
 #include <vtkSmartPointer.h>
 #include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtkTransform.h>
+#include <vtkTrivialProducer.h>
 #include <vtkVersion.h>
 
 // VTKAddon includes
 #include <vtkAddonMathUtilities.h>
+#include <vtkTracingMacros.h>
 
 // STD includes
 #include <algorithm>
@@ -60,6 +63,8 @@ const int vtkMRMLSliceLogic::SLICE_INDEX_ROTATED=-1;
 const int vtkMRMLSliceLogic::SLICE_INDEX_OUT_OF_VOLUME=-2;
 const int vtkMRMLSliceLogic::SLICE_INDEX_NO_VOLUME=-3;
 const std::string vtkMRMLSliceLogic::SLICE_MODEL_NODE_NAME_SUFFIX = std::string("Volume Slice");
+const int vtkMRMLSliceLogic::NUMBER_OF_FRAME_UPDATE_LATENCY_BINS = 50;
+const double vtkMRMLSliceLogic::FRAME_UPDATE_LATENCY_BIN_WIDTH = 0.01;
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLSliceLogic);
@@ -90,6 +95,13 @@ vtkMRMLSliceLogic::vtkMRMLSliceLogic()
   this->SetName("");
   this->SliceModelDisplayNode = 0;
   this->ImageDataConnection = 0;
+  this->DeferredFrameUpdate = false;
+  this->FrameProducer = vtkTrivialProducer::New();
+  vtkNew<vtkImageData> frame;
+  this->FrameProducer->SetOutput(frame.GetPointer());
+  this->FrameUpdateRequestTime = -1.;
+  this->SliceOffsetStepping = false;
+  this->FrameUpdateLatencyHistogram.resize(NUMBER_OF_FRAME_UPDATE_LATENCY_BINS, 0);
   this->SliceSpacing[0] = this->SliceSpacing[1] = this->SliceSpacing[2] = 1;
   this->AddingSliceModelNodes = false;
 }
@@ -125,6 +137,8 @@ vtkMRMLSliceLogic::~vtkMRMLSliceLogic()
     this->ActiveSliceTransform->Delete();
     this->ActiveSliceTransform = 0;
     }
+  this->FrameProducer->Delete();
+  this->FrameProducer = 0;
   this->PolyDataCollection->Delete();
   this->LookupTableCollection->Delete();
 
@@ -202,6 +216,7 @@ void vtkMRMLSliceLogic::SetMRMLSceneInternal(vtkMRMLScene * newScene)
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdateSliceNode()
 {
+  vtkTraceScopeMacro("MRMLLogic", "vtkMRMLSliceLogic::UpdateSliceNode");
   if (!this->GetMRMLScene())
     {
     this->SetSliceNode(0);
@@ -581,6 +596,8 @@ void vtkMRMLSliceLogic::ProcessMRMLLogicsEvents()
       }
     }
 
+  this->RequestFrameUpdate();
+
   // This is called when a slice layer is modified, so pass it on
   // to anyone interested in changes to this sub-pipeline
   this->Modified();
@@ -803,6 +820,10 @@ vtkAlgorithmOutput * vtkMRMLSliceLogic::GetImageDataConnection()
        (this->GetLabelLayer() != 0 && this->GetLabelLayer()->GetImageDataConnection() != 0) )
     {
 */
+    if (this->DeferredFrameUpdate && this->ImageDataConnection)
+      {
+      return this->FrameProducer->GetOutputPort();
+      }
     return this->ImageDataConnection;
 /*
     }
@@ -854,6 +875,7 @@ void vtkMRMLSliceLogic::UpdateImageData ()
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdatePipeline()
 {
+  vtkTraceScopeMacro("MRMLLogic", "vtkMRMLSliceLogic::UpdatePipeline");
   int modified = 0;
   if ( this->SliceCompositeNode )
     {
@@ -1130,11 +1152,119 @@ void vtkMRMLSliceLogic::UpdatePipeline()
         {
         this->SliceModelNode->GetPolyData()->Modified();
         }
+      this->RequestFrameUpdate();
       this->Modified();
       }
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLogic::SetDeferredFrameUpdate(bool deferred)
+{
+  if (this->DeferredFrameUpdate == deferred)
+    {
+    return;
+    }
+  this->DeferredFrameUpdate = deferred;
+  this->FrameUpdateRequestTime = -1.;
+  this->SliceOffsetStepping = false;
+  if (deferred)
+    {
+    // the current frame is empty, compute it now so that the views never show it
+    this->FrameUpdateRequestTime = vtkTimerLog::GetUniversalTime();
+    this->UpdateFrame();
+    }
+  else
+    {
+    // release the image shared with the pipeline
+    vtkImageData::SafeDownCast(this->FrameProducer->GetOutputDataObject(0))->Initialize();
+    }
+  // GetImageDataConnection() changed
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLogic::RequestFrameUpdate()
+{
+  if (!this->DeferredFrameUpdate || this->IsFrameUpdatePending())
+    {
+    // already requested, the frame update will reflect the latest state
+    return;
+    }
+  this->FrameUpdateRequestTime = vtkTimerLog::GetUniversalTime();
+  this->InvokeEvent(vtkMRMLSliceLogic::FrameUpdateRequestedEvent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLogic::IsFrameUpdatePending()const
+{
+  return this->FrameUpdateRequestTime >= 0.;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLogic::UpdateFrame()
+{
+  if (!this->DeferredFrameUpdate || !this->IsFrameUpdatePending())
+    {
+    return false;
+    }
+  vtkTraceScopeMacro("MRMLLogic", "vtkMRMLSliceLogic::UpdateFrame");
+  const double requestTime = this->FrameUpdateRequestTime;
+  // changes made while computing the frame request a new one
+  this->FrameUpdateRequestTime = -1.;
+
+  vtkImageData* frame = vtkImageData::SafeDownCast(this->FrameProducer->GetOutputDataObject(0));
+  if (this->ImageDataConnection)
+    {
+    vtkAlgorithm* producer = this->ImageDataConnection->GetProducer();
+    producer->Update(this->ImageDataConnection->GetIndex());
+    // No copy of the pixels: the frame shares the scalars of the pipeline output.
+    // Filters reuse their output scalars only if nothing else references them
+    // (see vtkImageData::AllocateScalars), so while the frame is displayed the
+    // pipeline allocates a new buffer for the next frame instead of overwriting it.
+    frame->ShallowCopy(producer->GetOutputDataObject(this->ImageDataConnection->GetIndex()));
+    }
+  else
+    {
+    frame->Initialize();
+    }
+  frame->Modified();
+
+  const double latency = vtkTimerLog::GetUniversalTime() - requestTime;
+  int bin = static_cast<int>(latency / FRAME_UPDATE_LATENCY_BIN_WIDTH);
+  bin = std::max(0, std::min(bin, NUMBER_OF_FRAME_UPDATE_LATENCY_BINS - 1));
+  ++this->FrameUpdateLatencyHistogram[bin];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSliceLogic::GetFrameUpdateLatencyBinCount(int bin)
+{
+  if (bin < 0 || bin >= NUMBER_OF_FRAME_UPDATE_LATENCY_BINS)
+    {
+    vtkErrorMacro("GetFrameUpdateLatencyBinCount: invalid bin " << bin);
+    return 0;
+    }
+  return this->FrameUpdateLatencyHistogram[bin];
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLSliceLogic::GetNumberOfFrameUpdates()const
+{
+  int numberOfFrameUpdates = 0;
+  for (int bin = 0; bin < NUMBER_OF_FRAME_UPDATE_LATENCY_BINS; ++bin)
+    {
+    numberOfFrameUpdates += this->FrameUpdateLatencyHistogram[bin];
+    }
+  return numberOfFrameUpdates;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLogic::ResetFrameUpdateLatencyHistogram()
+{
+  std::fill(this->FrameUpdateLatencyHistogram.begin(), this->FrameUpdateLatencyHistogram.end(), 0);
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -1143,6 +1273,7 @@ void vtkMRMLSliceLogic::PrintSelf(ostream& os, vtkIndent indent)
   nextIndent = indent.GetNextIndent();
 
   os << indent << "SlicerSliceLogic:             " << this->GetClassName() << "\n";
+  os << indent << "DeferredFrameUpdate:          " << this->DeferredFrameUpdate << "\n";
 
   if (this->SliceNode)
     {
@@ -2126,6 +2257,40 @@ void vtkMRMLSliceLogic::EndSliceOffsetInteraction()
   this->EndSliceNodeInteraction();
 }
 
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLogic::StepSliceOffset(double delta)
+{
+  double newOffset = this->GetSliceOffset() + delta;
+  double sliceBounds[6] = {0, -1, 0, -1, 0, -1};
+  this->GetSliceBounds(sliceBounds);
+  if (newOffset < sliceBounds[4] || newOffset > sliceBounds[5])
+    {
+    return false;
+    }
+  if (!this->DeferredFrameUpdate)
+    {
+    // the frame at the current offset is already computed by the pipeline
+    this->SetDeferredFrameUpdate(true);
+    this->SliceOffsetStepping = true;
+    }
+  this->StartSliceOffsetInteraction();
+  this->SetSliceOffset(newOffset);
+  this->EndSliceOffsetInteraction();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLogic::EndSliceOffsetStepping()
+{
+  if (!this->SliceOffsetStepping)
+    {
+    return;
+    }
+  // the pipeline output is the last computed frame unless an update is pending,
+  // in which case the view updates it when rendered
+  this->SetDeferredFrameUpdate(false);
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::SnapSliceOffsetToIJK()
 {
@@ -37,6 +37,7 @@ class vtkTransform;
 class vtkImageData;
 class vtkImageReslice;
 class vtkPolyDataCollection;
+class vtkTrivialProducer;
 class vtkTransform;
 
 /// \brief Slicer logic class for slice manipulation.
@@ -148,11 +149,55 @@ public:
   /// represents the filmsheet display output
   vtkGetObjectMacro(ExtractModelTexture, vtkImageReslice);
 
+  enum Events
+  {
+    /// Invoked when the slice image needs to be updated by UpdateFrame()
+    /// while DeferredFrameUpdate is enabled. It is invoked only once until
+    /// UpdateFrame() is called, no matter how many changes are made.
+    FrameUpdateRequestedEvent = vtkCommand::UserEvent + 200
+  };
+
   ///
   /// the tail of the pipeline
   /// -- returns NULL if none of the inputs exist
+  /// If DeferredFrameUpdate is enabled, it is the last image computed by
+  /// UpdateFrame() instead.
   vtkAlgorithmOutput *GetImageDataConnection();
 
+  /// If enabled, changes of the slice (offset, orientation, window/level...)
+  /// do not make the slice image recomputed when the view is rendered.
+  /// Instead, FrameUpdateRequestedEvent is invoked and the image returned by
+  /// GetImageDataConnection() keeps the last computed frame until
+  /// UpdateFrame() is called. Changes made in the meantime are combined:
+  /// only the latest state is resliced and intermediate states are dropped,
+  /// so that the views keep up with fast interactions.
+  /// Enabling it computes the first frame right away.
+  /// qMRMLSliceWidget enables it while the user drags in the slice view, and
+  /// StepSliceOffset() while the user steps through the slices.
+  /// Disabled by default.
+  void SetDeferredFrameUpdate(bool deferred);
+  vtkGetMacro(DeferredFrameUpdate, bool);
+  vtkBooleanMacro(DeferredFrameUpdate, bool);
+
+  /// Compute the slice image if an update was requested since the last frame.
+  /// Return true if a new frame was computed.
+  /// \sa DeferredFrameUpdate, FrameUpdateRequestedEvent
+  bool UpdateFrame();
+
+  /// Return true if a frame update is requested and UpdateFrame() not called yet
+  bool IsFrameUpdatePending()const;
+
+  /// Histogram of the latencies of the frame updates, the time between the
+  /// first change of the slice and the end of the computation of the frame
+  /// reflecting it. Bins are FRAME_UPDATE_LATENCY_BIN_WIDTH seconds wide, the
+  /// last bin also counts all the longer latencies.
+  static const int NUMBER_OF_FRAME_UPDATE_LATENCY_BINS;
+  static const double FRAME_UPDATE_LATENCY_BIN_WIDTH;
+  int GetFrameUpdateLatencyBinCount(int bin);
+  /// Number of frames computed by UpdateFrame() since the last reset
+  int GetNumberOfFrameUpdates()const;
+  void ResetFrameUpdateLatencyHistogram();
+
   ///
   /// update the pipeline to reflect the current state of the nodes
   void UpdatePipeline();
@@ -294,6 +339,19 @@ public:
   /// Indicate the slice offset value has completed its change
   void EndSliceOffsetInteraction();
 
+  /// Move the slice by delta along its normal, as the mouse wheel and the
+  /// keyboard do in the slice view. Return false if the new offset is out of
+  /// the slice bounds.
+  /// The steps go through the deferred frame updates: DeferredFrameUpdate is
+  /// enabled by the first step, so that a burst of steps is resliced once at
+  /// the latest offset, until EndSliceOffsetStepping() is called.
+  /// qMRMLSliceControllerWidget calls it once the steps stop.
+  bool StepSliceOffset(double delta);
+  /// Disable DeferredFrameUpdate if it was enabled by StepSliceOffset()
+  void EndSliceOffsetStepping();
+  /// True if DeferredFrameUpdate was enabled by StepSliceOffset()
+  vtkGetMacro(SliceOffsetStepping, bool);
+
   ///
   /// Set the current distance so that it corresponds to the closest center of
   /// a voxel in IJK space (integer value)
@@ -372,6 +430,10 @@ protected:
   void UpdateSliceNodes();
   void SetupCrosshairNode();
 
+  /// Record that the slice image must be recomputed if DeferredFrameUpdate is
+  /// enabled, and invoke FrameUpdateRequestedEvent for the first request.
+  void RequestFrameUpdate();
+
   virtual void OnMRMLNodeModified(vtkMRMLNode* node) VTK_OVERRIDE;
   static vtkMRMLSliceCompositeNode* GetSliceCompositeNode(vtkMRMLScene* scene,
                                                           const char* layoutName);
@@ -402,6 +464,14 @@ protected:
   vtkPolyDataCollection * PolyDataCollection;
   vtkCollection *         LookupTableCollection;
 
+  /// Output of the deferred frame updates
+  bool                          DeferredFrameUpdate;
+  vtkTrivialProducer *          FrameProducer;
+  /// Time of the first request since the last frame update, negative if none
+  double                        FrameUpdateRequestTime;
+  bool                          SliceOffsetStepping;
+  std::vector<int>              FrameUpdateLatencyHistogram;
+
   vtkMRMLModelNode *            SliceModelNode;
   vtkMRMLModelDisplayNode *     SliceModelDisplayNode;
   vtkMRMLLinearTransformNode *  SliceModelTransformNode;
@@ -0,0 +1,119 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// QT includes
+#include <QApplication>
+
+// Slicer includes
+#include "vtkSlicerConfigure.h"
+
+// qMRML includes
+#include "qMRMLSliceView.h"
+#include "qMRMLSliceWidget.h"
+
+// MRMLDisplayableManager includes
+#include <vtkSliceViewInteractorStyle.h>
+
+// MRML includes
+#include <vtkMRMLApplicationLogic.h>
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceLogic.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#ifdef Slicer_VTK_USE_QVTKOPENGLWIDGET
+#include <QVTKOpenGLWidget.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Check that the slice image updates are deferred while the user drags in the
+// view, and that the requested frames are computed from the event loop.
+int qMRMLSliceWidgetTest3(int argc, char * argv [] )
+{
+#ifdef Slicer_VTK_USE_QVTKOPENGLWIDGET
+  // Set default surface format for QVTKOpenGLWidget
+  QSurfaceFormat format = QVTKOpenGLWidget::defaultFormat();
+  format.setSamples(0);
+  QSurfaceFormat::setDefaultFormat(format);
+#endif
+
+  QApplication app(argc, argv);
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(32, 32, 32);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  for (vtkIdType i = 0; i < imageData->GetNumberOfPoints(); ++i)
+    {
+    voxels[i] = static_cast<short>(i % 256);
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  scene->AddNode(displayNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  qMRMLSliceWidget sliceWidget;
+  sliceWidget.setMRMLScene(scene.GetPointer());
+  vtkMRMLSliceLogic* sliceLogic = sliceWidget.sliceLogic();
+  CHECK_NOT_NULL(sliceLogic);
+  sliceLogic->GetSliceCompositeNode()->SetBackgroundVolumeID(volumeNode->GetID());
+  sliceWidget.show();
+  qApp->processEvents();
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), false);
+  vtkAlgorithmOutput* blendConnection = sliceLogic->GetImageDataConnection();
+  CHECK_NOT_NULL(blendConnection);
+
+  vtkSliceViewInteractorStyle* interactorStyle = sliceWidget.sliceView()->sliceViewInteractorStyle();
+  CHECK_NOT_NULL(interactorStyle);
+
+  // Starting a drag defers the frame updates
+  interactorStyle->SetActionState(vtkSliceViewInteractorStyle::Translate);
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), true);
+  CHECK_POINTER_DIFFERENT(sliceLogic->GetImageDataConnection(), blendConnection);
+  int numberOfFrameUpdates = sliceLogic->GetNumberOfFrameUpdates();
+
+  // Moves during the drag are combined into a frame computed from the event loop
+  for (int i = 0; i < 10; ++i)
+    {
+    sliceLogic->SetSliceOffset(i);
+    }
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), true);
+  qApp->processEvents();
+  CHECK_BOOL(sliceLogic->IsFrameUpdatePending(), false);
+  CHECK_INT(sliceLogic->GetNumberOfFrameUpdates(), numberOfFrameUpdates + 1);
+
+  // Ending the drag renders the pipeline output directly
+  interactorStyle->SetActionState(vtkSliceViewInteractorStyle::None);
+  CHECK_BOOL(sliceLogic->GetDeferredFrameUpdate(), false);
+  CHECK_POINTER(sliceLogic->GetImageDataConnection(), blendConnection);
+
+  return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSpinBox>
+#include <QTimer>
 #include <QWidgetAction>
 
 // CTK includes
@@ -86,6 +87,7 @@ qMRMLSliceControllerWidgetPrivate::qMRMLSliceControllerWidgetPrivate(qMRMLSliceC
 
   this->FitToWindowToolButton = 0;
   this->SliceOffsetSlider = 0;
+  this->SliceOffsetSteppingTimer = 0;
 
   this->LightboxMenu = 0;
   this->CompositingMenu = 0;
@@ -396,6 +398,14 @@ void qMRMLSliceControllerWidgetPrivate::init()
   this->FitToWindowToolButton->setFixedSize(15, 15);
   this->BarLayout->insertWidget(2, this->FitToWindowToolButton);
 
+  // Slice offset steps made less than this interval apart are resliced
+  // once per frame (see vtkMRMLSliceLogic::StepSliceOffset)
+  this->SliceOffsetSteppingTimer = new QTimer(q);
+  this->SliceOffsetSteppingTimer->setSingleShot(true);
+  this->SliceOffsetSteppingTimer->setInterval(250);
+  this->connect(this->SliceOffsetSteppingTimer, SIGNAL(timeout()),
+                this, SLOT(endSliceOffsetStepping()));
+
   this->SliceOffsetSlider = new qMRMLSliderWidget(q);
   this->SliceOffsetSlider->setTracking(false);
   this->SliceOffsetSlider->setToolTip(q->tr("Slice distance from RAS origin"));
@@ -1640,6 +1650,43 @@ void qMRMLSliceControllerWidget::setMRMLScene(vtkMRMLScene* newScene)
     }
 }
 
+// --------------------------------------------------------------------------
+void qMRMLSliceControllerWidgetPrivate::onSliceLogicFrameUpdateRequested()
+{
+  // The frame is computed once the pending events (e.g. mouse moves) are
+  // processed, all the changes made in the meantime are in the same frame.
+  QTimer::singleShot(0, this, SLOT(updateSliceLogicFrame()));
+}
+
+// --------------------------------------------------------------------------
+void qMRMLSliceControllerWidgetPrivate::updateSliceLogicFrame()
+{
+  Q_Q(qMRMLSliceControllerWidget);
+  if (this->SliceLogic && this->SliceLogic->UpdateFrame())
+    {
+    emit q->renderRequested();
+    }
+  if (this->SliceLogic && this->SliceLogic->GetSliceOffsetStepping())
+    {
+    this->SliceOffsetSteppingTimer->start();
+    }
+}
+
+// --------------------------------------------------------------------------
+void qMRMLSliceControllerWidgetPrivate::endSliceOffsetStepping()
+{
+  if (!this->SliceLogic)
+    {
+    return;
+    }
+  if (this->SliceLogic->IsFrameUpdatePending())
+    {
+    // the timer is restarted once the frame is computed
+    return;
+    }
+  this->SliceLogic->EndSliceOffsetStepping();
+}
+
 //---------------------------------------------------------------------------
 void qMRMLSliceControllerWidget::setMRMLSliceNode(vtkMRMLSliceNode* newSliceNode)
 {
@@ -1664,6 +1711,8 @@ void qMRMLSliceControllerWidget::setSliceLogic(vtkMRMLSliceLogic * newSliceLogic
 
   d->qvtkReconnect(d->SliceLogic, newSliceLogic, vtkCommand::ModifiedEvent,
                    d, SLOT(onSliceLogicModifiedEvent()));
+  d->qvtkReconnect(d->SliceLogic, newSliceLogic, vtkMRMLSliceLogic::FrameUpdateRequestedEvent,
+                   d, SLOT(onSliceLogicFrameUpdateRequested()));
 
   d->SliceLogic = newSliceLogic;
 
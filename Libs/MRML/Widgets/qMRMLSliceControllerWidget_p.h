@@ -55,6 +55,7 @@ class ctkSignalMapper;
 class ctkDoubleSpinBox;
 class ctkVTKSliceView;
 class QSpinBox;
+class QTimer;
 class qMRMLSliderWidget;
 class vtkMRMLSliceNode;
 class vtkObject;
@@ -158,6 +159,14 @@ public slots:
   /// Called after the SliceLogic is modified
   void onSliceLogicModifiedEvent();
 
+  /// Called when the SliceLogic defers the update of its image
+  /// \sa vtkMRMLSliceLogic::DeferredFrameUpdate
+  void onSliceLogicFrameUpdateRequested();
+  void updateSliceLogicFrame();
+  /// Called when no slice offset step (mouse wheel, keyboard) has been made
+  /// for a while \sa vtkMRMLSliceLogic::StepSliceOffset()
+  void endSliceOffsetStepping();
+
   void applyCustomLightbox();
 
 protected:
@@ -210,6 +219,8 @@ public:
   ctkSignalMapper*                    OrientationMarkerSizesMapper;
 
   ctkSignalMapper*                    RulerTypesMapper;
+
+  QTimer*                             SliceOffsetSteppingTimer;
 };
 
 #endif
@@ -33,6 +33,7 @@
 #include <vtkSliceViewInteractorStyle.h>
 
 // MRML includes
+#include <vtkMRMLSliceLogic.h>
 #include <vtkMRMLSliceNode.h>
 #include <vtkMRMLScene.h>
 
@@ -65,6 +66,9 @@ void qMRMLSliceWidgetPrivate::init()
 
   this->SliceView->sliceViewInteractorStyle()
     ->SetSliceLogic(this->SliceController->sliceLogic());
+  // the action state of the interactor style changes when a drag starts or ends
+  this->qvtkConnect(this->SliceView->sliceViewInteractorStyle(), vtkCommand::ModifiedEvent,
+                    this, SLOT(onInteractorStyleModified()));
 
   connect(this->SliceView, SIGNAL(resized(QSize)),
           this, SLOT(setSliceViewSize(QSize)));
@@ -109,6 +113,19 @@ void qMRMLSliceWidgetPrivate::setImageDataConnection(vtkAlgorithmOutput * imageD
   this->SliceView->setImageDataConnection(imageDataConnection);
 }
 
+// --------------------------------------------------------------------------
+void qMRMLSliceWidgetPrivate::onInteractorStyleModified()
+{
+  vtkSliceViewInteractorStyle* interactorStyle = this->SliceView->sliceViewInteractorStyle();
+  vtkMRMLSliceLogic* sliceLogic = this->SliceController->sliceLogic();
+  if (!interactorStyle || !sliceLogic)
+    {
+    return;
+    }
+  sliceLogic->SetDeferredFrameUpdate(
+    interactorStyle->GetActionState() != vtkSliceViewInteractorStyle::None);
+}
+
 // --------------------------------------------------------------------------
 // qMRMLSliceView methods
 
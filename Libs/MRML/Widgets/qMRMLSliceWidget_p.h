@@ -68,6 +68,11 @@ public slots:
   void endProcessing();
   /// Set the image data to the slice view
   void setImageDataConnection(vtkAlgorithmOutput * imageDataConnection);
+  /// Defer the slice image updates while the user drags in the view (translate,
+  /// zoom, window/level...), intermediate states are dropped when the reslice
+  /// cannot keep up with the mouse moves.
+  /// \sa vtkMRMLSliceLogic::SetDeferredFrameUpdate()
+  void onInteractorStyleModified();
 
 
 };
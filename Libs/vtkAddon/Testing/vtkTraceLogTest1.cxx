@@ -0,0 +1,151 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkTraceLog.h>
+#include <vtkTracingMacros.h>
+
+// VTK includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+void TracedFunction()
+{
+  vtkTraceScopeWithDetailMacro("Test", "TracedFunction", "detail with \"quotes\"");
+}
+
+//----------------------------------------------------------------------------
+std::string ReadFile(const std::string& fileName)
+{
+  std::ifstream input(fileName.c_str());
+  return std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+//----------------------------------------------------------------------------
+int CountOccurrences(const std::string& text, const std::string& pattern)
+{
+  int count = 0;
+  for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+    {
+    ++count;
+    }
+  return count;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkTraceLogTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string traceFile = std::string(argv[1]) + "/vtkTraceLogTest1.json";
+
+  // Spans are ignored while recording is stopped
+  vtkTraceLog::Stop();
+  TracedFunction();
+  if (vtkTraceLog::IsEnabled() || vtkTraceLog::GetNumberOfSpans() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": spans recorded while tracing is disabled" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkTraceLog::Start(traceFile.c_str());
+  TracedFunction();
+  TracedFunction();
+#ifdef VTKADDON_USE_TRACING
+  int expectedNumberOfSpans = 2;
+#else
+  int expectedNumberOfSpans = 0;
+#endif
+  if (vtkTraceLog::GetNumberOfSpans() != expectedNumberOfSpans)
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << expectedNumberOfSpans
+              << " spans, got " << vtkTraceLog::GetNumberOfSpans() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (!vtkTraceLog::Stop() || vtkTraceLog::IsEnabled())
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << traceFile << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::string content = ReadFile(traceFile);
+  vtksys::SystemTools::RemoveFile(traceFile.c_str());
+  if (content.find("[") != 0 || content.find("\n]\n") != content.size() - 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected trace content:\n" << content << std::endl;
+    return EXIT_FAILURE;
+    }
+#ifdef VTKADDON_USE_TRACING
+  if (content.find("\"name\":\"TracedFunction\",\"cat\":\"Test\",\"ph\":\"X\"") == std::string::npos
+    || content.find("\"detail\":\"detail with \\\"quotes\\\"\"") == std::string::npos)
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected trace content:\n" << content << std::endl;
+    return EXIT_FAILURE;
+    }
+#endif
+
+  // The buffer is appended to the file while recording
+  int flushNumberOfSpans = vtkTraceLog::GetFlushNumberOfSpans();
+  double flushIntervalSeconds = vtkTraceLog::GetFlushIntervalSeconds();
+  vtkTraceLog::SetFlushNumberOfSpans(2);
+  vtkTraceLog::SetFlushIntervalSeconds(3600.0);
+  vtkTraceLog::Start(traceFile.c_str());
+  for (int i = 0; i < 5; ++i)
+    {
+    TracedFunction();
+    }
+  content = ReadFile(traceFile);
+#ifdef VTKADDON_USE_TRACING
+  int expectedNumberOfWrittenSpans = 4;
+#else
+  int expectedNumberOfWrittenSpans = 0;
+#endif
+  if (content.find("[") != 0 || content.find("]") != std::string::npos
+    || CountOccurrences(content, "\"name\":\"TracedFunction\"") != expectedNumberOfWrittenSpans)
+    {
+    std::cerr << "Line " << __LINE__ << ": expected " << expectedNumberOfWrittenSpans
+              << " spans written before stopping, got trace content:\n" << content << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!vtkTraceLog::Stop() || vtkTraceLog::GetNumberOfDroppedSpans() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << traceFile << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkTraceLog::SetFlushNumberOfSpans(flushNumberOfSpans);
+  vtkTraceLog::SetFlushIntervalSeconds(flushIntervalSeconds);
+  content = ReadFile(traceFile);
+  vtksys::SystemTools::RemoveFile(traceFile.c_str());
+  if (CountOccurrences(content, "\"name\":\"TracedFunction\"") != expectedNumberOfWrittenSpans / 4 * 5
+    || content.find("\n]\n") != content.size() - 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected trace content:\n" << content << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
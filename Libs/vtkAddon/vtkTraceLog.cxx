@@ -0,0 +1,440 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include "vtkTraceLog.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemInformation.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkAtomic<int> vtkTraceLog::Enabled(0);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct TraceSpan
+{
+  const char* Category;
+  const char* Name;
+  std::string Detail;
+  double StartMicroseconds;
+  double DurationMicroseconds;
+  int ThreadIndex;
+};
+
+//----------------------------------------------------------------------------
+class TraceLogInternal
+{
+public:
+  TraceLogInternal()
+    : NumberOfSpans(0)
+    , NumberOfDroppedSpans(0)
+    , NumberOfWrittenSpans(0)
+    , Closed(true)
+    , LastFlushMicroseconds(0.0)
+    , FlushNumberOfSpans(10000)
+    , FlushIntervalSeconds(1.0)
+    , MaximumNumberOfBufferedSpans(1000000)
+  {
+  }
+
+  ~TraceLogInternal()
+  {
+    // Write pending trace when the application exits
+    if (vtkTraceLog::IsEnabled())
+      {
+      vtkTraceLog::Stop();
+      }
+  }
+
+  /// Discard the recorded spans and start a new trace file
+  void Start(const char* fileName)
+  {
+    this->FileLock.Lock();
+    this->Lock.Lock();
+    this->FileName = fileName ? fileName : "";
+    this->Spans.clear();
+    this->Threads.clear();
+    this->NumberOfSpans = 0;
+    this->NumberOfDroppedSpans = 0;
+    this->LastFlushMicroseconds = vtkTraceLog::GetTimeMicroseconds();
+    this->Lock.Unlock();
+
+    this->NumberOfWrittenSpans = 0;
+    this->Closed = false;
+    if (!this->FileName.empty())
+      {
+      std::ofstream output(this->FileName.c_str());
+      output << "[";
+      if (!output.good())
+        {
+        vtkGenericWarningMacro("vtkTraceLog: failed to open trace file " << this->FileName);
+        }
+      }
+    this->FileLock.Unlock();
+  }
+
+  /// Return a small index identifying the calling thread. Must be called with Lock held.
+  int GetCurrentThreadIndex()
+  {
+    vtkMultiThreaderIDType currentThread = vtkMultiThreader::GetCurrentThreadID();
+    for (size_t i = 0; i < this->Threads.size(); ++i)
+      {
+      if (vtkMultiThreader::ThreadsEqual(this->Threads[i], currentThread))
+        {
+        return static_cast<int>(i);
+        }
+      }
+    this->Threads.push_back(currentThread);
+    return static_cast<int>(this->Threads.size() - 1);
+  }
+
+  /// Buffer a span. Return true if the buffer should be flushed.
+  bool Add(TraceSpan& span)
+  {
+    this->Lock.Lock();
+    ++this->NumberOfSpans;
+    bool flush = false;
+    if (static_cast<int>(this->Spans.size()) >= this->MaximumNumberOfBufferedSpans)
+      {
+      ++this->NumberOfDroppedSpans;
+      }
+    else
+      {
+      span.ThreadIndex = this->GetCurrentThreadIndex();
+      this->Spans.push_back(span);
+      }
+    double endMicroseconds = span.StartMicroseconds + span.DurationMicroseconds;
+    if (static_cast<int>(this->Spans.size()) >= this->FlushNumberOfSpans
+      || endMicroseconds - this->LastFlushMicroseconds >= this->FlushIntervalSeconds * 1.0e6)
+      {
+      this->LastFlushMicroseconds = endMicroseconds;
+      flush = true;
+      }
+    this->Lock.Unlock();
+    return flush;
+  }
+
+  static void WriteEscaped(std::ostream& os, const char* text)
+  {
+    os << '"';
+    for (const char* c = text; c && *c; ++c)
+      {
+      switch (*c)
+        {
+        case '"': os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\r': os << "\\r"; break;
+        case '\t': os << "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(*c) >= 0x20)
+            {
+            os << *c;
+            }
+        }
+      }
+    os << '"';
+  }
+
+  /// Append the buffered spans to the trace file, and close the event array
+  /// if the trace is stopped. Spans that cannot be written are dropped.
+  bool Write(bool close)
+  {
+    // The file lock is taken first so that the spans are appended in order,
+    // while other threads keep recording into the emptied buffer.
+    this->FileLock.Lock();
+    if (this->Closed)
+      {
+      // Spans that were being recorded when the trace was stopped
+      this->FileLock.Unlock();
+      return false;
+      }
+    this->Lock.Lock();
+    std::vector<TraceSpan> spans;
+    spans.swap(this->Spans);
+    this->Lock.Unlock();
+
+    bool success = false;
+    std::ofstream output;
+    if (!this->FileName.empty())
+      {
+      output.open(this->FileName.c_str(), std::ios::out | std::ios::app);
+      }
+    if (output.is_open())
+      {
+      vtksys::SystemInformation systemInformation;
+      int processId = systemInformation.GetProcessId();
+
+      output.setf(std::ios::fixed);
+      output.precision(3);
+      for (size_t i = 0; i < spans.size(); ++i)
+        {
+        const TraceSpan& span = spans[i];
+        output << (this->NumberOfWrittenSpans + i > 0 ? ",\n" : "\n") << "{\"name\":";
+        WriteEscaped(output, span.Name);
+        output << ",\"cat\":";
+        WriteEscaped(output, span.Category);
+        output << ",\"ph\":\"X\",\"ts\":" << span.StartMicroseconds
+               << ",\"dur\":" << span.DurationMicroseconds
+               << ",\"pid\":" << processId
+               << ",\"tid\":" << span.ThreadIndex;
+        if (!span.Detail.empty())
+          {
+          output << ",\"args\":{\"detail\":";
+          WriteEscaped(output, span.Detail.c_str());
+          output << "}";
+          }
+        output << "}";
+        }
+      if (close)
+        {
+        output << "\n]\n";
+        }
+      output.flush();
+      success = output.good();
+      }
+    if (success)
+      {
+      this->NumberOfWrittenSpans += spans.size();
+      }
+    else
+      {
+      this->Lock.Lock();
+      this->NumberOfDroppedSpans += static_cast<int>(spans.size());
+      this->Lock.Unlock();
+      }
+    this->Closed = close;
+    this->FileLock.Unlock();
+    return success;
+  }
+
+  /// Protects the buffer and the counters
+  vtkSimpleCriticalSection Lock;
+  /// Serializes the writes into the trace file, taken before Lock
+  vtkSimpleCriticalSection FileLock;
+  std::string FileName;
+  std::vector<TraceSpan> Spans;
+  std::vector<vtkMultiThreaderIDType> Threads;
+  int NumberOfSpans;
+  int NumberOfDroppedSpans;
+  size_t NumberOfWrittenSpans;
+  bool Closed;
+  double LastFlushMicroseconds;
+  int FlushNumberOfSpans;
+  double FlushIntervalSeconds;
+  int MaximumNumberOfBufferedSpans;
+};
+
+//----------------------------------------------------------------------------
+TraceLogInternal& GetTraceLogInternal()
+{
+  static TraceLogInternal internal;
+  return internal;
+}
+
+//----------------------------------------------------------------------------
+// Make sure the environment variable is checked at startup
+class TraceLogInitialize
+{
+public:
+  TraceLogInitialize()
+  {
+    const char* fileName = vtksys::SystemTools::GetEnv(vtkTraceLog::GetTraceFileEnvironmentVariableName());
+    if (fileName != NULL && fileName[0] != '\0')
+      {
+      vtkTraceLog::Start(fileName);
+      }
+  }
+};
+TraceLogInitialize TraceLogInitializer;
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkTraceLog);
+
+//----------------------------------------------------------------------------
+vtkTraceLog::vtkTraceLog()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkTraceLog::~vtkTraceLog()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Enabled: " << (vtkTraceLog::IsEnabled() ? "true" : "false") << "\n";
+  os << indent << "NumberOfSpans: " << vtkTraceLog::GetNumberOfSpans() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::Start(const char* fileName)
+{
+  GetTraceLogInternal().Start(fileName);
+  vtkTraceLog::Enabled = 1;
+}
+
+//----------------------------------------------------------------------------
+bool vtkTraceLog::Stop()
+{
+  if (!vtkTraceLog::IsEnabled())
+    {
+    return false;
+    }
+  vtkTraceLog::Enabled = 0;
+  bool success = GetTraceLogInternal().Write(true);
+  int numberOfDroppedSpans = vtkTraceLog::GetNumberOfDroppedSpans();
+  if (numberOfDroppedSpans > 0)
+    {
+    vtkGenericWarningMacro("vtkTraceLog: " << numberOfDroppedSpans << " spans could not be written");
+    }
+  return success && numberOfDroppedSpans == 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkTraceLog::Flush()
+{
+  if (!vtkTraceLog::IsEnabled())
+    {
+    return false;
+    }
+  return GetTraceLogInternal().Write(false);
+}
+
+//----------------------------------------------------------------------------
+double vtkTraceLog::GetTimeMicroseconds()
+{
+  return vtkTimerLog::GetUniversalTime() * 1.0e6;
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::AddSpan(const char* category, const char* name, const char* detail,
+                          double startMicroseconds, double endMicroseconds)
+{
+  if (!vtkTraceLog::IsEnabled())
+    {
+    return;
+    }
+  TraceSpan span;
+  span.Category = category ? category : "";
+  span.Name = name ? name : "";
+  if (detail)
+    {
+    span.Detail = detail;
+    }
+  span.StartMicroseconds = startMicroseconds;
+  span.DurationMicroseconds = endMicroseconds - startMicroseconds;
+  span.ThreadIndex = 0;
+
+  TraceLogInternal& internal = GetTraceLogInternal();
+  if (internal.Add(span))
+    {
+    internal.Write(false);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkTraceLog::GetNumberOfSpans()
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  int numberOfSpans = internal.NumberOfSpans;
+  internal.Lock.Unlock();
+  return numberOfSpans;
+}
+
+//----------------------------------------------------------------------------
+int vtkTraceLog::GetNumberOfDroppedSpans()
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  int numberOfDroppedSpans = internal.NumberOfDroppedSpans;
+  internal.Lock.Unlock();
+  return numberOfDroppedSpans;
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::SetFlushNumberOfSpans(int numberOfSpans)
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  internal.FlushNumberOfSpans = numberOfSpans;
+  internal.Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+int vtkTraceLog::GetFlushNumberOfSpans()
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  int numberOfSpans = internal.FlushNumberOfSpans;
+  internal.Lock.Unlock();
+  return numberOfSpans;
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::SetFlushIntervalSeconds(double seconds)
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  internal.FlushIntervalSeconds = seconds;
+  internal.Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+double vtkTraceLog::GetFlushIntervalSeconds()
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  double seconds = internal.FlushIntervalSeconds;
+  internal.Lock.Unlock();
+  return seconds;
+}
+
+//----------------------------------------------------------------------------
+void vtkTraceLog::SetMaximumNumberOfBufferedSpans(int numberOfSpans)
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  internal.MaximumNumberOfBufferedSpans = numberOfSpans;
+  internal.Lock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+int vtkTraceLog::GetMaximumNumberOfBufferedSpans()
+{
+  TraceLogInternal& internal = GetTraceLogInternal();
+  internal.Lock.Lock();
+  int numberOfSpans = internal.MaximumNumberOfBufferedSpans;
+  internal.Lock.Unlock();
+  return numberOfSpans;
+}
@@ -0,0 +1,108 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkTraceLog_h
+#define __vtkTraceLog_h
+
+#include "vtkAddon.h"
+
+#include <vtkAtomic.h>
+#include <vtkObject.h>
+
+/// \brief Records timed spans of hot code paths in Chrome trace-event format.
+///
+/// Spans are recorded using the vtkTraceScopeMacro (see vtkTracingMacros.h)
+/// and buffered in memory. The buffer is appended to the trace file every
+/// FlushNumberOfSpans spans or FlushIntervalSeconds seconds, and when the
+/// trace is stopped by Stop() or at application exit, so that the memory
+/// used by long sessions is bounded and a crash only loses the last spans.
+/// Spans that cannot be written are dropped, and the buffer never grows
+/// beyond MaximumNumberOfBufferedSpans. The file is written in the JSON array
+/// format of trace events, whose closing bracket is optional, and can be
+/// opened in chrome://tracing or any other viewer supporting it.
+///
+/// Recording is disabled by default. It is enabled by calling Start() or
+/// by setting the environment variable \a SLICER_TRACE_FILE to the path of
+/// the output file. When disabled, a span only costs a boolean check.
+/// Tracing can be removed at compile time by turning off the
+/// vtkAddon_USE_TRACING CMake option.
+///
+/// Spans can be recorded from any thread.
+class VTK_ADDON_EXPORT vtkTraceLog : public vtkObject
+{
+public:
+  static vtkTraceLog *New();
+  vtkTypeMacro(vtkTraceLog, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Start recording spans. Previously recorded spans are discarded.
+  /// \param fileName File the trace is written into
+  static void Start(const char* fileName);
+
+  /// Stop recording and write the remaining spans into the file given to Start().
+  /// \return false if the trace could not be written entirely
+  static bool Stop();
+
+  /// Return true if spans are being recorded.
+  static bool IsEnabled() { return vtkTraceLog::Enabled != 0; }
+
+  /// Get the current time in microseconds, as used for the span timestamps.
+  static double GetTimeMicroseconds();
+
+  /// Record a complete span. \a detail is optional (can be NULL) and is stored
+  /// in the arguments of the trace event.
+  static void AddSpan(const char* category, const char* name, const char* detail,
+                      double startMicroseconds, double endMicroseconds);
+
+  /// Get number of spans recorded since Start(), written or not.
+  static int GetNumberOfSpans();
+
+  /// Write the buffered spans into the trace file.
+  /// \return false if the spans could not be written
+  static bool Flush();
+
+  /// Number of buffered spans that triggers a flush. Default is 10000.
+  static void SetFlushNumberOfSpans(int numberOfSpans);
+  static int GetFlushNumberOfSpans();
+
+  /// Time in seconds after which a new span triggers a flush. Default is 1.
+  static void SetFlushIntervalSeconds(double seconds);
+  static double GetFlushIntervalSeconds();
+
+  /// Number of buffered spans beyond which new spans are dropped, when
+  /// FlushNumberOfSpans is larger. Default is 1000000.
+  static void SetMaximumNumberOfBufferedSpans(int numberOfSpans);
+  static int GetMaximumNumberOfBufferedSpans();
+
+  /// Get number of spans dropped since Start(), because the buffer was full
+  /// or the trace file could not be written.
+  static int GetNumberOfDroppedSpans();
+
+  /// Name of the environment variable enabling tracing at startup
+  static const char* GetTraceFileEnvironmentVariableName() { return "SLICER_TRACE_FILE"; }
+
+protected:
+  vtkTraceLog();
+  ~vtkTraceLog();
+
+  /// Read by the spans of all threads without locking
+  static vtkAtomic<int> Enabled;
+
+private:
+  vtkTraceLog(const vtkTraceLog&);  // Not implemented.
+  void operator=(const vtkTraceLog&);  // Not implemented.
+};
+
+#endif
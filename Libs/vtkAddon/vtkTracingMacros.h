@@ -0,0 +1,88 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+#ifndef __vtkTracingMacros_h
+#define __vtkTracingMacros_h
+
+#include "vtkAddon.h"
+
+// Macros for recording the time spent in a scope with vtkTraceLog.
+//
+// Example:
+//
+//   void vtkMRMLScene::Import()
+//   {
+//     vtkTraceScopeMacro("MRML", "vtkMRMLScene::Import");
+//     ...
+//   }
+//
+// vtkTraceScopeWithDetailMacro additionally stores a detail string (e.g. the
+// class name of the object) in the trace event arguments.
+// The macros expand to nothing if vtkAddon_USE_TRACING is disabled.
+
+#ifdef VTKADDON_USE_TRACING
+
+#include "vtkTraceLog.h"
+
+/// \brief Records a span from its construction to its destruction.
+///
+/// Use vtkTraceScopeMacro instead of instantiating it directly so that
+/// spans are removed when tracing is disabled at compile time.
+/// \a category, \a name and \a detail must remain valid while the scope exists.
+class vtkTraceScope
+{
+public:
+  vtkTraceScope(const char* category, const char* name, const char* detail = 0)
+    : Category(category)
+    , Name(name)
+    , Detail(detail)
+    , StartMicroseconds(vtkTraceLog::IsEnabled() ? vtkTraceLog::GetTimeMicroseconds() : -1.)
+    {
+    }
+  ~vtkTraceScope()
+    {
+    if (this->StartMicroseconds >= 0.)
+      {
+      vtkTraceLog::AddSpan(this->Category, this->Name, this->Detail,
+        this->StartMicroseconds, vtkTraceLog::GetTimeMicroseconds());
+      }
+    }
+
+private:
+  vtkTraceScope(const vtkTraceScope&);  // Not implemented.
+  void operator=(const vtkTraceScope&);  // Not implemented.
+
+  const char* Category;
+  const char* Name;
+  const char* Detail;
+  double StartMicroseconds;
+};
+
+#define vtkTraceConcatenateMacro2(a, b) a##b
+#define vtkTraceConcatenateMacro(a, b) vtkTraceConcatenateMacro2(a, b)
+
+#define vtkTraceScopeMacro(category, name) \
+  vtkTraceScope vtkTraceConcatenateMacro(vtkTraceScope_, __LINE__)(category, name)
+
+#define vtkTraceScopeWithDetailMacro(category, name, detail) \
+  vtkTraceScope vtkTraceConcatenateMacro(vtkTraceScope_, __LINE__)(category, name, detail)
+
+#else
+
+#define vtkTraceScopeMacro(category, name)
+#define vtkTraceScopeWithDetailMacro(category, name, detail)
+
+#endif
+
+#endif
@@ -45,11 +45,46 @@ vtkAOSDataArrayTemplate<T>* DownCast(vtkAbstractArray* a)
   return vtkAOSDataArrayTemplate<T>::FastDownCast(a);
 }
 
+//----------------------------------------------------------------------------
+// Update the filter output for the given extent, or for the largest possible
+// region if extent is NULL, and set the extent of the buffered region on data.
+template <class TImage>
+void UpdateFilterExtent(itk::ImageSource<TImage>* filter, const int* extent, vtkImageData* data)
+{
+  if (extent == NULL)
+    {
+    filter->UpdateLargestPossibleRegion();
+    return;
+    }
+  filter->UpdateOutputInformation();
+  TImage* image = filter->GetOutput();
+  typename TImage::RegionType region;
+  for (unsigned int i = 0; i < 3; ++i)
+    {
+    region.SetIndex(i, extent[2*i]);
+    region.SetSize(i, extent[2*i+1] - extent[2*i] + 1);
+    }
+  region.Crop(image->GetLargestPossibleRegion());
+  image->SetRequestedRegion(region);
+  image->Update();
+
+  // The reader may have read a larger region than requested
+  const typename TImage::RegionType& bufferedRegion = image->GetBufferedRegion();
+  int bufferedExtent[6];
+  for (unsigned int i = 0; i < 3; ++i)
+    {
+    bufferedExtent[2*i] = bufferedRegion.GetIndex()[i];
+    bufferedExtent[2*i+1] = bufferedRegion.GetIndex()[i] + static_cast<int>(bufferedRegion.GetSize()[i]) - 1;
+    }
+  data->SetExtent(bufferedExtent);
+}
+
 };
 
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesScalarReader::vtkITKArchetypeImageSeriesScalarReader()
 {
+  this->StreamingRead = false;
 }
 
 //----------------------------------------------------------------------------
@@ -62,6 +97,37 @@ void vtkITKArchetypeImageSeriesScalarReader::PrintSelf(ostream& os, vtkIndent in
 {
   this->Superclass::PrintSelf(os,indent);
   os << indent << "vtk ITK Archetype Image Series Scalar Reader\n";
+  os << indent << "StreamingRead: " << (this->StreamingRead ? "On" : "Off") << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkITKArchetypeImageSeriesScalarReader::CanReadSubExtent()
+{
+  // Series are assembled from multiple files and reorientation requires
+  // the whole image, so only a single file in native orientation is streamed.
+  return this->StreamingRead
+    && this->FileNames.size() == 1
+    && this->UseNativeCoordinateOrientation
+    && this->GetNumberOfComponents() == 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesScalarReader::RequestInformation(
+  vtkInformation* request,
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  int result = this->Superclass::RequestInformation(request, inputVector, outputVector);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  if (this->CanReadSubExtent())
+    {
+    outInfo->Set(vtkAlgorithm::CAN_PRODUCE_SUB_EXTENT(), 1);
+    }
+  else
+    {
+    outInfo->Remove(vtkAlgorithm::CAN_PRODUCE_SUB_EXTENT());
+    }
+  return result;
 }
 
 //----------------------------------------------------------------------------
@@ -92,6 +158,20 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
     vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()));
   this->SetMetaDataScalarRangeToPointDataInfo(data);
 
+  // Extent to read if only part of the image is requested
+  const int* streamedExtent = NULL;
+  if (this->CanReadSubExtent() && outInfo->Has(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT()))
+    {
+    streamedExtent = outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT());
+    if (streamedExtent[0] > streamedExtent[1]
+      || streamedExtent[2] > streamedExtent[3]
+      || streamedExtent[4] > streamedExtent[5])
+      {
+      // empty extent, read the whole image
+      streamedExtent = NULL;
+      }
+    }
+
 #ifdef VTKITK_BUILD_DICOM_SUPPORT
 #define vtkITKExecuteDataDeclareDICOMImageIO \
       typedef itk::ImageIOBase ImageIOType; \
@@ -189,7 +269,7 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
         orient2##typeN->SetDesiredCoordinateOrientation(this->DesiredCoordinateOrientation); \
         filter = orient2##typeN; \
         } \
-      filter->UpdateLargestPossibleRegion();\
+      UpdateFilterExtent<image2##typeN>(filter.GetPointer(), streamedExtent, data);\
       itk::ImportImageContainer<itk::SizeValueType, type>::Pointer PixelContainer2##typeN;\
       PixelContainer2##typeN = filter->GetOutput()->GetPixelContainer();\
       void *ptr = static_cast<void *> (PixelContainer2##typeN->GetBufferPointer());\
@@ -27,12 +27,29 @@ class VTK_ITK_EXPORT vtkITKArchetypeImageSeriesScalarReader : public vtkITKArche
   vtkTypeMacro(vtkITKArchetypeImageSeriesScalarReader,vtkITKArchetypeImageSeriesReader);
   void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
 
+  ///
+  /// Read only the extent requested by the downstream pipeline instead of
+  /// the whole image. Streaming is only used when a single file is read in
+  /// its native orientation, otherwise the whole image is always read.
+  /// Formats that support streamed reading (uncompressed NRRD, NIfTI,
+  /// MetaImage, ...) are read without loading the complete file.
+  /// Off by default.
+  vtkSetMacro(StreamingRead, bool);
+  vtkGetMacro(StreamingRead, bool);
+  vtkBooleanMacro(StreamingRead, bool);
+
  protected:
   vtkITKArchetypeImageSeriesScalarReader();
   ~vtkITKArchetypeImageSeriesScalarReader();
 
+  int RequestInformation(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) VTK_OVERRIDE;
   int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) VTK_OVERRIDE;
   static void ReadProgressCallback(itk::ProcessObject* obj,const itk::ProgressEvent&, void* data);
+
+  /// Return true if the requested extent can be read instead of the whole image
+  bool CanReadSubExtent();
+
+  bool StreamingRead;
   /// private:
 };
 
@@ -32,18 +32,165 @@
 #include <vtkVersion.h>
 #include <vtkSmartPointer.h>
 #include <vtkNew.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
-#include <vtkImageCast.h>
-#include <vtkImageStencil.h>
+#include <vtkImageStencilData.h>
+#include <vtkMultiThreader.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkStripper.h>
 #include <vtkTriangleFilter.h>
 #include <vtkPolyDataToImageStencil.h>
 
 // STD includes
+#include <algorithm>
+#include <cstring>
 #include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct StencilSlabsThreadStruct
+{
+  /// First slice of each slab, followed by the slice after the last slab
+  std::vector<int> SlabFirstSlices;
+  /// Cells of the surface that cross each slab
+  std::vector<vtkSmartPointer<vtkPolyData> > SlabSurfaces;
+  vtkOrientedImageData* BinaryLabelMap;
+};
+
+//----------------------------------------------------------------------------
+// Split the slices of the labelmap into slabs and collect the polygons and strips of
+// the surface that cross each slab. Each slab gets its own cell arrays and shares the
+// points of the surface, so that the threads only read the shared data: traversing
+// a cell array is not thread-safe, but it costs much less than copying the surface.
+void ClipSurfaceToSlabs(vtkPolyData* closedSurfacePolyData, int numberOfSlabs, StencilSlabsThreadStruct& str)
+{
+  vtkOrientedImageData* binaryLabelMap = str.BinaryLabelMap;
+  int extent[6] = {0,-1,0,-1,0,-1};
+  binaryLabelMap->GetExtent(extent);
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  double origin = binaryLabelMap->GetOrigin()[2];
+  double spacing = binaryLabelMap->GetSpacing()[2];
+
+  str.SlabFirstSlices.resize(numberOfSlabs + 1);
+  for (int slab = 0; slab <= numberOfSlabs; ++slab)
+    {
+    str.SlabFirstSlices[slab] = extent[4] + numberOfSlices * slab / numberOfSlabs;
+    }
+
+  vtkPoints* points = closedSurfacePolyData->GetPoints();
+  vtkCellArray* cellArrays[2] = { closedSurfacePolyData->GetPolys(), closedSurfacePolyData->GetStrips() };
+  std::vector<vtkSmartPointer<vtkCellArray> > slabCellArrays[2];
+  str.SlabSurfaces.resize(numberOfSlabs);
+  for (int slab = 0; slab < numberOfSlabs; ++slab)
+    {
+    str.SlabSurfaces[slab] = vtkSmartPointer<vtkPolyData>::New();
+    str.SlabSurfaces[slab]->SetPoints(points);
+    for (int type = 0; type < 2; ++type)
+      {
+      slabCellArrays[type].push_back(vtkSmartPointer<vtkCellArray>::New());
+      }
+    str.SlabSurfaces[slab]->SetPolys(slabCellArrays[0][slab]);
+    str.SlabSurfaces[slab]->SetStrips(slabCellArrays[1][slab]);
+    }
+
+  for (int type = 0; type < 2; ++type)
+    {
+    vtkIdType numberOfCellPoints = 0;
+    vtkIdType* cellPointIds = NULL;
+    for (cellArrays[type]->InitTraversal(); cellArrays[type]->GetNextCell(numberOfCellPoints, cellPointIds); )
+      {
+      if (numberOfCellPoints < 1)
+        {
+        continue;
+        }
+      double point[3] = {0.0, 0.0, 0.0};
+      points->GetPoint(cellPointIds[0], point);
+      double zMin = point[2];
+      double zMax = point[2];
+      for (vtkIdType i = 1; i < numberOfCellPoints; ++i)
+        {
+        points->GetPoint(cellPointIds[i], point);
+        zMin = std::min(zMin, point[2]);
+        zMax = std::max(zMax, point[2]);
+        }
+      // Add the cell to the slabs that have a slice between its lowest and highest point
+      for (int slab = 0; slab < numberOfSlabs; ++slab)
+        {
+        double slabZMin = origin + str.SlabFirstSlices[slab] * spacing;
+        double slabZMax = origin + (str.SlabFirstSlices[slab + 1] - 1) * spacing;
+        if (zMax >= slabZMin && zMin <= slabZMax)
+          {
+          slabCellArrays[type][slab]->InsertNextCell(numberOfCellPoints, cellPointIds);
+          }
+        }
+      }
+    }
+
+  // Computing the bounds caches them in the surfaces and in the shared points,
+  // so that the threads do not compute them concurrently
+  for (int slab = 0; slab < numberOfSlabs; ++slab)
+    {
+    str.SlabSurfaces[slab]->GetBounds();
+    }
+}
+
+//----------------------------------------------------------------------------
+// Rasterize one slab of slices of the labelmap. The surface is cut slice by slice and
+// the resulting contours are filled scanline by scanline, so each slab is independent.
+VTK_THREAD_RETURN_TYPE StencilSlabThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  StencilSlabsThreadStruct* str = static_cast<StencilSlabsThreadStruct*>(info->UserData);
+  vtkOrientedImageData* binaryLabelMap = str->BinaryLabelMap;
+
+  int extent[6] = {0,-1,0,-1,0,-1};
+  binaryLabelMap->GetExtent(extent);
+  int firstSlice = str->SlabFirstSlices[info->ThreadID];
+  int lastSlice = str->SlabFirstSlices[info->ThreadID + 1] - 1;
+  vtkPolyData* slabSurface = str->SlabSurfaces[info->ThreadID];
+  if (firstSlice > lastSlice || slabSurface->GetNumberOfCells() == 0)
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+  int slabExtent[6] = { extent[0], extent[1], extent[2], extent[3], firstSlice, lastSlice };
+
+  vtkNew<vtkPolyDataToImageStencil> polyDataToImageStencil;
+  polyDataToImageStencil->SetInputData(slabSurface);
+  polyDataToImageStencil->SetOutputSpacing(binaryLabelMap->GetSpacing());
+  polyDataToImageStencil->SetOutputOrigin(binaryLabelMap->GetOrigin());
+  polyDataToImageStencil->SetOutputWholeExtent(slabExtent);
+  polyDataToImageStencil->Update();
+  vtkImageStencilData* stencilData = polyDataToImageStencil->GetOutput();
+
+  // Fill the inside runs of each scanline with the foreground value
+  vtkIdType increments[3] = {0,0,0};
+  binaryLabelMap->GetIncrements(increments);
+  unsigned char* voxelsPointer = static_cast<unsigned char*>(binaryLabelMap->GetScalarPointer(extent[0], extent[2], extent[4]));
+  for (int k = firstSlice; k <= lastSlice; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      unsigned char* rowPointer = voxelsPointer + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      int iter = 0;
+      int r1 = 0;
+      int r2 = 0;
+      while (stencilData->GetNextExtent(r1, r2, extent[0], extent[1], j, k, iter))
+        {
+        memset(rowPointer + (r1 - extent[0]), 1, r2 - r1 + 1);
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
 
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkClosedSurfaceToBinaryLabelmapConversionRule);
@@ -51,6 +198,7 @@ vtkSegmentationConverterRuleNewMacro(vtkClosedSurfaceToBinaryLabelmapConversionR
 //----------------------------------------------------------------------------
 vtkClosedSurfaceToBinaryLabelmapConversionRule::vtkClosedSurfaceToBinaryLabelmapConversionRule()
   : UseOutputImageDataGeometry(false)
+  , NumberOfThreads(0)
 {
   // Reference image geometry parameter
   this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()] = std::make_pair("",
@@ -153,7 +301,9 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkDataObject* sour
   // Allocate output image data
   binaryLabelMap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
 
-  void* binaryLabelMapVoxelsPointer = binaryLabelMap->GetScalarPointerForExtent(binaryLabelMap->GetExtent());
+  int extent[6] = {0,-1,0,-1,0,-1};
+  binaryLabelMap->GetExtent(extent);
+  void* binaryLabelMapVoxelsPointer = binaryLabelMap->GetScalarPointerForExtent(extent);
   if (!binaryLabelMapVoxelsPointer)
     {
     vtkErrorMacro("Convert: Failed to allocate memory for output labelmap image!");
@@ -162,8 +312,6 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkDataObject* sour
   else
     {
     // Set voxel values to 0
-    int extent[6] = {0,-1,0,-1,0,-1};
-    binaryLabelMap->GetExtent(extent);
     memset(binaryLabelMapVoxelsPointer, 0, ((extent[1]-extent[0]+1)*(extent[3]-extent[2]+1)*(extent[5]-extent[4]+1) * binaryLabelMap->GetScalarSize() * binaryLabelMap->GetNumberOfScalarComponents()));
     }
 
@@ -200,27 +348,20 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkDataObject* sour
   // Convert to triangle strip
   vtkSmartPointer<vtkStripper> stripper=vtkSmartPointer<vtkStripper>::New();
   stripper->SetInputConnection(triangle->GetOutputPort());
-
-  // Convert polydata to stencil
-  vtkNew<vtkPolyDataToImageStencil> polyDataToImageStencil;
-  polyDataToImageStencil->SetInputConnection(stripper->GetOutputPort());
-  polyDataToImageStencil->SetOutputSpacing(binaryLabelMap->GetSpacing());
-  polyDataToImageStencil->SetOutputOrigin(binaryLabelMap->GetOrigin());
-  polyDataToImageStencil->SetOutputWholeExtent(binaryLabelMap->GetExtent());
-
-  // Convert stencil to image
-  vtkNew<vtkImageStencil> stencil;
-  stencil->SetInputData(binaryLabelMap);
-  stencil->SetStencilConnection(polyDataToImageStencil->GetOutputPort());
-  stencil->ReverseStencilOn();
-  stencil->SetBackgroundValue(1); // General foreground value is 1 (background value because of reverse stencil)
-
-  // Save result to output
-  vtkNew<vtkImageCast> imageCast;
-  imageCast->SetInputConnection(stencil->GetOutputPort());
-  imageCast->SetOutputScalarTypeToUnsignedChar();
-  imageCast->Update();
-  binaryLabelMap->ShallowCopy(imageCast->GetOutput());
+  stripper->Update();
+
+  // Convert polydata to labelmap: the slices are split into slabs that are cut and
+  // filled in parallel, directly into the output voxels (foreground value is 1)
+  StencilSlabsThreadStruct str;
+  str.BinaryLabelMap = binaryLabelMap;
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfSlices = extent[5] - extent[4] + 1;
+  int numberOfThreads = (this->NumberOfThreads > 0 ? this->NumberOfThreads : threader->GetNumberOfThreads());
+  threader->SetNumberOfThreads(std::max(1, std::min(numberOfThreads, numberOfSlices)));
+  ClipSurfaceToSlabs(stripper->GetOutput(), threader->GetNumberOfThreads(), str);
+  threader->SetSingleMethod(StencilSlabThreadFunction, &str);
+  threader->SingleMethodExecute();
 
   // Restore geometry of the labelmap that we set to identity before conversion
   // (so that we can perform the stencil operations in IJK space)
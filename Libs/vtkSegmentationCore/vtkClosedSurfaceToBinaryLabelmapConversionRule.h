@@ -32,7 +32,9 @@ class vtkPolyData;
 /// \ingroup SegmentationCore
 /// \brief Convert closed surface representation (vtkPolyData type) to binary
 ///   labelmap representation (vtkOrientedImageData type). The conversion algorithm
-///   is based on image stencil.
+///   is based on image stencil: the surface is cut by each slice of the labelmap and
+///   the resulting contours are filled scanline by scanline. Slabs of slices are
+///   rasterized in parallel.
 class vtkSegmentationCore_EXPORT vtkClosedSurfaceToBinaryLabelmapConversionRule
   : public vtkSegmentationConverterRule
 {
@@ -76,6 +78,11 @@ public:
 
   vtkSetMacro(UseOutputImageDataGeometry, bool);
 
+  /// Number of threads used to rasterize the surface. If 0 (default), then the
+  /// default number of threads of vtkMultiThreader is used.
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   /// Calculate actual geometry of the output labelmap volume by verifying that the reference image geometry
   /// encompasses the input surface model, and extending it to the proper directions if necessary.
@@ -99,6 +106,9 @@ protected:
   /// then stitching them back together).
   bool UseOutputImageDataGeometry;
 
+  /// Number of threads used to rasterize the surface (0 means default)
+  int NumberOfThreads;
+
 protected:
   vtkClosedSurfaceToBinaryLabelmapConversionRule();
   ~vtkClosedSurfaceToBinaryLabelmapConversionRule();
@@ -42,6 +42,9 @@
 #include <vtkPolyData.h>
 #include <vtkTransformPolyDataFilter.h>
 
+// vtkAddon includes
+#include <vtkTracingMacros.h>
+
 // STD includes
 #include <sstream>
 #include <algorithm>
@@ -959,7 +962,10 @@ bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentati
       }
 
     // Perform conversion step
-    currentConversionRule->Convert(sourceRepresentation, targetRepresentation);
+      {
+      vtkTraceScopeWithDetailMacro("Segmentation", "vtkSegmentationConverterRule::Convert", currentConversionRule->GetName());
+      currentConversionRule->Convert(sourceRepresentation, targetRepresentation);
+      }
 
     // Add representation to segment
     segment->AddRepresentation(currentConversionRule->GetTargetRepresentationName(), targetRepresentation);
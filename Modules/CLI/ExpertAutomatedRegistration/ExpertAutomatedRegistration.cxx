@@ -1,6 +1,7 @@
 
 #include "ExpertAutomatedRegistrationCLP.h"
 #include "itkImageToImageRegistrationHelper.h"
+#include "itkTimeProbe.h"
 
 // Use an anonymous namespace to keep class types and function names
 // from colliding when module is used as shared object module.  Every
@@ -412,6 +413,24 @@ int DoIt( int argc, char *argv[] )
     std::cout << "###BSplineSamplingRatio: " << bsplineSamplingRatio
               << std::endl;
     }
+  reger->SetRigidNumberOfLevels( rigidNumberOfLevels );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###RigidNumberOfLevels: " << rigidNumberOfLevels
+              << std::endl;
+    }
+  reger->SetAffineNumberOfLevels( affineNumberOfLevels );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###AffineNumberOfLevels: " << affineNumberOfLevels
+              << std::endl;
+    }
+  reger->SetBSplineNumberOfLevels( bsplineNumberOfLevels );
+  if( verbosity >= STANDARD )
+    {
+    std::cout << "###BSplineNumberOfLevels: " << bsplineNumberOfLevels
+              << std::endl;
+    }
 
   /** not sure */
   if( interpolation == "NearestNeighbor" )
@@ -508,7 +527,15 @@ int DoIt( int argc, char *argv[] )
       {
       std::cout << "###Starting registration..." << std::endl;
       }
+    itk::TimeProbe registrationTime;
+    registrationTime.Start();
     reger->Update();
+    registrationTime.Stop();
+    if( verbosity >= STANDARD )
+      {
+      std::cout << "###RegistrationTime: " << registrationTime.GetTotal()
+                << " " << registrationTime.GetUnit() << std::endl;
+      }
     }
   catch( itk::ExceptionObject & excep )
     {
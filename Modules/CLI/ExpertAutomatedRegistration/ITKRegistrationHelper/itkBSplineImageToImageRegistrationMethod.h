@@ -88,9 +88,6 @@ public:
   itkSetClampMacro( NumberOfControlPoints, unsigned int, 3, 2000 );
   itkGetConstMacro( NumberOfControlPoints, unsigned int );
 
-  itkSetClampMacro( NumberOfLevels, unsigned int, 1, 5 );
-  itkGetConstMacro( NumberOfLevels, unsigned int );
-
   BSplineTransformPointer GetBSplineTransform( void ) const;
 
   void ComputeGridRegion( int numberOfControlPoints,
@@ -115,7 +112,9 @@ protected:
 
   virtual void GradientOptimize( MetricType * metric, InterpolatorType * interpolator );
 
-  virtual void MultiResolutionOptimize( MetricType * metric, InterpolatorType * interpolator );
+  /** Register each level of the image pyramids with a control point grid
+   *  that is refined from one level to the next */
+  virtual void MultiResolutionOptimize( void ) ITK_OVERRIDE;
 
   virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
 
@@ -128,8 +127,6 @@ private:
 
   unsigned int m_NumberOfControlPoints;
 
-  unsigned int m_NumberOfLevels;
-
   bool m_GradientOptimizeOnly;
 
 };
@@ -122,7 +122,6 @@ BSplineImageToImageRegistrationMethod<TImage>
 ::BSplineImageToImageRegistrationMethod( void )
 {
   m_NumberOfControlPoints = 10;
-  m_NumberOfLevels = 4;
   m_ExpectedDeformationMagnitude = 10;
   m_GradientOptimizeOnly = false;
   this->SetTransformMethodEnum( Superclass::BSPLINE_TRANSFORM );
@@ -131,6 +130,7 @@ BSplineImageToImageRegistrationMethod<TImage>
   this->SetMaxIterations( 40 );
   this->SetNumberOfSamples( 800000 );
   this->SetInterpolationMethodEnum( Superclass::BSPLINE_INTERPOLATION );
+  this->SetNumberOfLevels( 4 );
 }
 
 template <class TImage>
@@ -254,14 +254,9 @@ void
 BSplineImageToImageRegistrationMethod<TImage>
 ::Optimize( MetricType * metric, InterpolatorType * interpolator )
 {
-  if( this->GetGradientOptimizeOnly() )
-    {
-    this->GradientOptimize( metric, interpolator );
-    }
-  else
-    {
-    this->MultiResolutionOptimize( metric, interpolator );
-    }
+  // The levels of the multi-resolution optimization are registered by
+  // instances of this class that only do gradient optimization
+  this->GradientOptimize( metric, interpolator );
 }
 
 template <class TImage>
@@ -450,19 +445,20 @@ BSplineImageToImageRegistrationMethod<TImage>
 template <class TImage>
 void
 BSplineImageToImageRegistrationMethod<TImage>
-::MultiResolutionOptimize( MetricType * itkNotUsed(metric),
-                           InterpolatorType * itkNotUsed(interpolator) )
+::MultiResolutionOptimize( void )
 {
+  if( this->GetGradientOptimizeOnly() )
+    {
+    this->OptimizeImages( this->GetFixedImage(), this->GetMovingImage(), this->GetNumberOfSamples() );
+    return;
+    }
+
   if( this->GetReportProgress() )
     {
     std::cout << "BSpline MULTIRESOLUTION START" << std::endl;
     }
 
-  typedef RecursiveMultiResolutionPyramidImageFilter<ImageType,
-                                                     ImageType>
-  PyramidType;
-  typename PyramidType::Pointer fixedPyramid = PyramidType::New();
-  typename PyramidType::Pointer movingPyramid = PyramidType::New();
+  const unsigned int numberOfLevels = this->GetNumberOfLevels();
 
   /**/
   /* Determine the control points, samples, and scales to be used at each level */
@@ -470,14 +466,9 @@ BSplineImageToImageRegistrationMethod<TImage>
   double       controlPointFactor = 2;
   unsigned int levelNumberOfControlPoints =
     this->GetNumberOfControlPoints();
-  double levelScale = 1;
-  if( this->m_NumberOfLevels > 1 )
+  for( unsigned int level = 1; level < numberOfLevels; level++ )
     {
-    for( unsigned int level = 1; level < this->m_NumberOfLevels; level++ )
-      {
-      levelNumberOfControlPoints = (unsigned int)(levelNumberOfControlPoints / controlPointFactor);
-      levelScale *= controlPointFactor;
-      }
+    levelNumberOfControlPoints = (unsigned int)(levelNumberOfControlPoints / controlPointFactor);
     }
   if( levelNumberOfControlPoints < 3 )
     {
@@ -485,76 +476,29 @@ BSplineImageToImageRegistrationMethod<TImage>
     }
 
   /**/
-  /* Setup the multi-scale image pyramids */
+  /* Setup the multi-scale image pyramids, each level halves the resolution
+   *   like the control point grid. They may be shared with the other
+   *   registration stages. */
   /**/
-  fixedPyramid->SetNumberOfLevels( this->m_NumberOfLevels );
-  movingPyramid->SetNumberOfLevels( this->m_NumberOfLevels );
-
   typename ImageType::SpacingType fixedSpacing =
     this->GetFixedImage()->GetSpacing();
-  typename ImageType::SpacingType movingSpacing =
-    this->GetFixedImage()->GetSpacing();
-
-  typename PyramidType::ScheduleType fixedSchedule =
-    fixedPyramid->GetSchedule();
-  typename PyramidType::ScheduleType movingSchedule =
-    movingPyramid->GetSchedule();
-
-  /**/
-  /*   First, determine the pyramid at level 0 */
-  /**/
-  unsigned int level = 0;
-  for( unsigned int i = 0; i < ImageDimension; i++ )
+  typename Superclass::ImagePyramidType::Pointer fixedPyramid = this->GetFixedImagePyramid();
+  if( fixedPyramid.IsNull()
+      || fixedPyramid->GetInput() != this->GetFixedImage()
+      || fixedPyramid->GetNumberOfLevels() < numberOfLevels )
     {
-    fixedSchedule[0][i] = (unsigned int)(levelScale
-                                         * fixedSpacing[0] / fixedSpacing[i]);
-    if( fixedSchedule[0][i] < 1 )
-      {
-      fixedSchedule[0][i] = 1;
-      }
-    movingSchedule[0][i] = (unsigned int)(levelScale
-                                          * fixedSpacing[0] / movingSpacing[i]);
-    if( movingSchedule[0][i] < 1 )
-      {
-      movingSchedule[0][i] = 1;
-      }
+    fixedPyramid = Superclass::ComputeImagePyramid( this->GetFixedImage(), numberOfLevels, fixedSpacing );
+    this->SetFixedImagePyramid( fixedPyramid );
     }
-  /**/
-  /*   Second, determine the pyramid at the remaining levels */
-  /**/
-  for( level = 1; level < this->m_NumberOfLevels; level++ )
+  typename Superclass::ImagePyramidType::Pointer movingPyramid = this->GetMovingImagePyramid();
+  if( movingPyramid.IsNull()
+      || movingPyramid->GetInput() != this->GetMovingImage()
+      || movingPyramid->GetNumberOfLevels() < numberOfLevels )
     {
-    for( unsigned int i = 0; i < ImageDimension; i++ )
-      {
-      fixedSchedule[level][i] = (int)(fixedSchedule[level - 1][i]
-                                      / controlPointFactor);
-      if( fixedSchedule[level][i] < 1 )
-        {
-        fixedSchedule[level][i] = 1;
-        }
-      movingSchedule[level][i] = (int)(movingSchedule[level - 1][i]
-                                       / controlPointFactor);
-      if( movingSchedule[level][i] < 1 )
-        {
-        movingSchedule[level][i] = 1;
-        }
-      }
+    movingPyramid = Superclass::ComputeImagePyramid( this->GetMovingImage(), numberOfLevels, fixedSpacing );
+    this->SetMovingImagePyramid( movingPyramid );
     }
 
-  /**/
-  /*   Third, apply pyramid to fixed image */
-  /**/
-  fixedPyramid->SetSchedule( fixedSchedule );
-  fixedPyramid->SetInput( this->GetFixedImage() );
-  fixedPyramid->Update();
-
-  /**/
-  /*   Fourth, apply pyramid to moving image */
-  /**/
-  movingPyramid->SetSchedule( movingSchedule );
-  movingPyramid->SetInput( this->GetMovingImage() );
-  movingPyramid->Update();
-
   /**/
   /* Assign initial transform parameters at coarse level based on
    *   initial transform parameters - initial transform parameters are
@@ -563,31 +507,30 @@ BSplineImageToImageRegistrationMethod<TImage>
   typename Superclass::TransformParametersType levelParameters;
   this->ResampleControlGrid( levelNumberOfControlPoints, levelParameters );
   /* Perform registration at each level */
-  for( level = 0; level < this->m_NumberOfLevels; level++ )
+  for( unsigned int level = 0; level < numberOfLevels; level++ )
     {
+    /**/
+    /* Get the fixed and moving images for this pyramid level, the
+     *   pyramids may have more levels than this registration */
+    /**/
+    typename ImageType::ConstPointer fixedImage =
+      Superclass::GetImagePyramidLevel( fixedPyramid, numberOfLevels, level );
+    typename ImageType::ConstPointer movingImage =
+      Superclass::GetImagePyramidLevel( movingPyramid, numberOfLevels, level );
+
     if( this->GetReportProgress() )
       {
       std::cout << "MULTIRESOLUTION LEVEL = " << level << std::endl;
       std::cout << "   Number of control points = "
                 << levelNumberOfControlPoints << std::endl;
       std::cout << "   Fixed image = "
-                << fixedPyramid->GetOutput(level)
-      ->GetLargestPossibleRegion().GetSize()
+                << fixedImage->GetLargestPossibleRegion().GetSize()
                 << std::endl;
       std::cout << "   Moving image = "
-                << movingPyramid->GetOutput(level)
-      ->GetLargestPossibleRegion().GetSize()
+                << movingImage->GetLargestPossibleRegion().GetSize()
                 << std::endl;
       }
 
-    /**/
-    /* Get the fixed and moving images for this pyramid level */
-    /**/
-    typename ImageType::ConstPointer fixedImage =
-      fixedPyramid->GetOutput(level);
-    typename ImageType::ConstPointer movingImage =
-      movingPyramid->GetOutput(level);
-
     /*
     typedef itk::ImageFileWriter< ImageType > FileWriterType;
     typename FileWriterType::Pointer writer = FileWriterType::New();
@@ -643,6 +586,8 @@ BSplineImageToImageRegistrationMethod<TImage>
     reg->SetNumberOfSamples( levelNumberOfSamples );
     reg->SetExpectedDeformationMagnitude( levelDeformationMagnitude );
     reg->SetGradientOptimizeOnly( true );
+    reg->SetNumberOfLevels( 1 );
+    reg->SetRegistrationNumberOfThreads( this->GetRegistrationNumberOfThreads() );
     reg->SetTargetError( this->GetTargetError() );
     reg->SetSampleFromOverlap( this->GetSampleFromOverlap() );
     reg->SetFixedImageSamplesIntensityThreshold(
@@ -656,7 +601,7 @@ BSplineImageToImageRegistrationMethod<TImage>
     // For the last two levels (the ones at the highest resolution, use
     //   user-specified values of MinimizeMemory, otherwise do not
     //   minimizeMemory so as to maximize speed.
-    if( level >= this->m_NumberOfLevels - 2 )
+    if( level >= numberOfLevels - 2 )
       {
       reg->SetMinimizeMemory( this->GetMinimizeMemory() );
       }
@@ -718,11 +663,11 @@ BSplineImageToImageRegistrationMethod<TImage>
       }
     */
 
-    if( level < this->m_NumberOfLevels - 1 )
+    if( level < numberOfLevels - 1 )
       {
       levelNumberOfControlPoints = (unsigned int)(levelNumberOfControlPoints * controlPointFactor);
       if( levelNumberOfControlPoints > this->GetNumberOfControlPoints() ||
-          level == this->m_NumberOfLevels - 2 )
+          level == numberOfLevels - 2 )
         {
         levelNumberOfControlPoints = this->GetNumberOfControlPoints();
         }
@@ -367,6 +367,9 @@ public:
   itkSetMacro( RigidMaxIterations, unsigned int );
   itkGetConstMacro( RigidMaxIterations, unsigned int );
 
+  itkSetClampMacro( RigidNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( RigidNumberOfLevels, unsigned int );
+
   itkSetMacro( RigidMetricMethodEnum, MetricMethodEnumType );
   itkGetConstMacro( RigidMetricMethodEnum, MetricMethodEnumType );
 
@@ -388,6 +391,9 @@ public:
   itkSetMacro( AffineMaxIterations, unsigned int );
   itkGetConstMacro( AffineMaxIterations, unsigned int );
 
+  itkSetClampMacro( AffineNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( AffineNumberOfLevels, unsigned int );
+
   itkSetMacro( AffineMetricMethodEnum, MetricMethodEnumType );
   itkGetConstMacro( AffineMetricMethodEnum, MetricMethodEnumType );
 
@@ -409,6 +415,9 @@ public:
   itkSetMacro( BSplineMaxIterations, unsigned int );
   itkGetConstMacro( BSplineMaxIterations, unsigned int );
 
+  itkSetClampMacro( BSplineNumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( BSplineNumberOfLevels, unsigned int );
+
   itkSetMacro( BSplineControlPointPixelSpacing, double );
   itkGetConstMacro( BSplineControlPointPixelSpacing, double );
 
@@ -428,6 +437,11 @@ protected:
   void PrintSelfHelper( std::ostream & os, Indent indent, const std::string basename, MetricMethodEnumType metric,
                         InterpolationMethodEnumType interpolation ) const;
 
+  /** Compute the pyramids of the fixed and current moving images if they
+   *  are out of date or have less than numberOfLevels levels, so that
+   *  consecutive stages share the same pyramids. */
+  void UpdateImagePyramids( unsigned int numberOfLevels );
+
   void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
 
 private:
@@ -500,6 +514,11 @@ private:
   typename MatrixTransformType::Pointer   m_LoadedMatrixTransform;
   typename BSplineTransformType::Pointer  m_LoadedBSplineTransform;
 
+  //  Image pyramids shared by the registration stages
+  typedef typename OptimizedRegistrationMethodType::ImagePyramidType ImagePyramidType;
+  typename ImagePyramidType::Pointer      m_FixedImagePyramid;
+  typename ImagePyramidType::Pointer      m_MovingImagePyramid;
+
   //  Initial Parameters
   InitialMethodEnumType                   m_InitialMethodEnum;
   typename InitialTransformType::Pointer  m_InitialTransform;
@@ -510,6 +529,7 @@ private:
   double       m_RigidSamplingRatio;
   double       m_RigidTargetError;
   unsigned int m_RigidMaxIterations;
+  unsigned int m_RigidNumberOfLevels;
 
   typename RigidTransformType::Pointer m_RigidTransform;
   MetricMethodEnumType                 m_RigidMetricMethodEnum;
@@ -521,6 +541,7 @@ private:
   double       m_AffineSamplingRatio;
   double       m_AffineTargetError;
   unsigned int m_AffineMaxIterations;
+  unsigned int m_AffineNumberOfLevels;
 
   typename AffineTransformType::Pointer m_AffineTransform;
   MetricMethodEnumType                  m_AffineMetricMethodEnum;
@@ -532,6 +553,7 @@ private:
   double       m_BSplineSamplingRatio;
   double       m_BSplineTargetError;
   unsigned int m_BSplineMaxIterations;
+  unsigned int m_BSplineNumberOfLevels;
   double       m_BSplineControlPointPixelSpacing;
 
   typename BSplineTransformType::Pointer m_BSplineTransform;
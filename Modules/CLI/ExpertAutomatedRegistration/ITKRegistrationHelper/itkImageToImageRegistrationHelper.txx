@@ -109,6 +109,9 @@ ImageToImageRegistrationHelper<TImage>
   m_LoadedMatrixTransform = NULL;
   m_LoadedBSplineTransform = NULL;
 
+  m_FixedImagePyramid = NULL;
+  m_MovingImagePyramid = NULL;
+
   // Initial
   m_InitialMethodEnum = INIT_WITH_CENTERS_OF_MASS;
   m_InitialTransform = NULL;
@@ -117,6 +120,7 @@ ImageToImageRegistrationHelper<TImage>
   m_RigidSamplingRatio = 0.01;
   m_RigidTargetError = 0.0001;
   m_RigidMaxIterations = 100;
+  m_RigidNumberOfLevels = 1;
   m_RigidTransform = NULL;
   m_RigidMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
   m_RigidInterpolationMethodEnum = OptimizedRegistrationMethodType::LINEAR_INTERPOLATION;
@@ -126,6 +130,7 @@ ImageToImageRegistrationHelper<TImage>
   m_AffineSamplingRatio = 0.02;
   m_AffineTargetError = 0.0001;
   m_AffineMaxIterations = 50;
+  m_AffineNumberOfLevels = 1;
   m_AffineTransform = NULL;
   m_AffineMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
   m_AffineInterpolationMethodEnum = OptimizedRegistrationMethodType::LINEAR_INTERPOLATION;
@@ -135,6 +140,7 @@ ImageToImageRegistrationHelper<TImage>
   m_BSplineSamplingRatio = 0.10;
   m_BSplineTargetError = 0.0001;
   m_BSplineMaxIterations = 20;
+  m_BSplineNumberOfLevels = 4;
   m_BSplineControlPointPixelSpacing = 40;
   m_BSplineTransform = NULL;
   m_BSplineMetricMethodEnum = OptimizedRegistrationMethodType::MATTES_MI_METRIC;
@@ -426,6 +432,10 @@ ImageToImageRegistrationHelper<TImage>
     regRigid->SetSampleFromOverlap( m_SampleFromOverlap );
     regRigid->SetMinimizeMemory( m_MinimizeMemory );
     regRigid->SetMaxIterations( m_RigidMaxIterations );
+    regRigid->SetNumberOfLevels( m_RigidNumberOfLevels );
+    this->UpdateImagePyramids( m_RigidNumberOfLevels );
+    regRigid->SetFixedImagePyramid( m_FixedImagePyramid );
+    regRigid->SetMovingImagePyramid( m_MovingImagePyramid );
     regRigid->SetTargetError( m_RigidTargetError );
     if( m_UseFixedImageMaskObject )
       {
@@ -551,6 +561,10 @@ ImageToImageRegistrationHelper<TImage>
     regAff->SetSampleFromOverlap( m_SampleFromOverlap );
     regAff->SetMinimizeMemory( m_MinimizeMemory );
     regAff->SetMaxIterations( m_AffineMaxIterations );
+    regAff->SetNumberOfLevels( m_AffineNumberOfLevels );
+    this->UpdateImagePyramids( m_AffineNumberOfLevels );
+    regAff->SetFixedImagePyramid( m_FixedImagePyramid );
+    regAff->SetMovingImagePyramid( m_MovingImagePyramid );
     regAff->SetTargetError( m_AffineTargetError );
     if( m_EnableRigidRegistration )
       {
@@ -676,6 +690,10 @@ ImageToImageRegistrationHelper<TImage>
     regBspline->SetSampleFromOverlap( m_SampleFromOverlap );
     regBspline->SetMinimizeMemory( m_MinimizeMemory );
     regBspline->SetMaxIterations( m_BSplineMaxIterations );
+    regBspline->SetNumberOfLevels( m_BSplineNumberOfLevels );
+    this->UpdateImagePyramids( m_BSplineNumberOfLevels );
+    regBspline->SetFixedImagePyramid( m_FixedImagePyramid );
+    regBspline->SetMovingImagePyramid( m_MovingImagePyramid );
     regBspline->SetTargetError( m_BSplineTargetError );
     if( m_UseFixedImageMaskObject )
       {
@@ -725,9 +743,44 @@ ImageToImageRegistrationHelper<TImage>
       std::cout << "BSpline results stored" << std::endl;
       }
     }
+
+  // The pyramids are only shared by the stages of this update
+  m_FixedImagePyramid = NULL;
+  m_MovingImagePyramid = NULL;
+
   // this->SaveImage("c:/result.mha",m_CurrentMovingImage);
 }
 
+template <class TImage>
+void
+ImageToImageRegistrationHelper<TImage>
+::UpdateImagePyramids( unsigned int numberOfLevels )
+{
+  if( numberOfLevels < 2 )
+    {
+    return;
+    }
+
+  // All the stages use the same schedule, computed from the fixed image
+  // spacing for both images, so that a pyramid computed by one stage is reused by the next
+  // as long as its input has not been resampled and it has enough levels.
+  typename TImage::SpacingType fixedSpacing = m_FixedImage->GetSpacing();
+  if( m_FixedImagePyramid.IsNull()
+      || m_FixedImagePyramid->GetInput() != m_FixedImage.GetPointer()
+      || m_FixedImagePyramid->GetNumberOfLevels() < numberOfLevels )
+    {
+    m_FixedImagePyramid = OptimizedRegistrationMethodType::ComputeImagePyramid(
+        m_FixedImage, numberOfLevels, fixedSpacing );
+    }
+  if( m_MovingImagePyramid.IsNull()
+      || m_MovingImagePyramid->GetInput() != m_CurrentMovingImage.GetPointer()
+      || m_MovingImagePyramid->GetNumberOfLevels() < numberOfLevels )
+    {
+    m_MovingImagePyramid = OptimizedRegistrationMethodType::ComputeImagePyramid(
+        m_CurrentMovingImage, numberOfLevels, fixedSpacing );
+    }
+}
+
 template <class TImage>
 typename TImage::ConstPointer
 ImageToImageRegistrationHelper<TImage>
@@ -1445,6 +1498,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "Rigid Sampling Ratio = " << m_RigidSamplingRatio << std::endl;
   os << indent << "Rigid Target Error = " << m_RigidTargetError << std::endl;
   os << indent << "Rigid Max Iterations = " << m_RigidMaxIterations << std::endl;
+  os << indent << "Rigid Number Of Levels = " << m_RigidNumberOfLevels << std::endl;
   PrintSelfHelper( os, indent, "Rigid", m_RigidMetricMethodEnum,
                    m_RigidInterpolationMethodEnum );
   os << indent << std::endl;
@@ -1460,6 +1514,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "Affine Sampling Ratio = " << m_AffineSamplingRatio << std::endl;
   os << indent << "Affine Target Error = " << m_AffineTargetError << std::endl;
   os << indent << "Affine Max Iterations = " << m_AffineMaxIterations << std::endl;
+  os << indent << "Affine Number Of Levels = " << m_AffineNumberOfLevels << std::endl;
   PrintSelfHelper( os, indent, "Affine", m_AffineMetricMethodEnum,
                    m_AffineInterpolationMethodEnum );
   os << indent << std::endl;
@@ -1475,6 +1530,7 @@ ImageToImageRegistrationHelper<TImage>
   os << indent << "BSpline Sampling Ratio = " << m_BSplineSamplingRatio << std::endl;
   os << indent << "BSpline Target Error = " << m_BSplineTargetError << std::endl;
   os << indent << "BSpline Max Iterations = " << m_BSplineMaxIterations << std::endl;
+  os << indent << "BSpline Number Of Levels = " << m_BSplineNumberOfLevels << std::endl;
   os << indent << "BSpline Control Point Pixel Spacing = " << m_BSplineControlPointPixelSpacing << std::endl;
   PrintSelfHelper( os, indent, "BSpline", m_BSplineMetricMethodEnum,
                    m_BSplineInterpolationMethodEnum );
@@ -19,6 +19,7 @@
 #define itkOptimizedImageToImageRegistrationMethod_h
 
 #include "itkImage.h"
+#include "itkRecursiveMultiResolutionPyramidImageFilter.h"
 
 #include "itkImageToImageRegistrationMethod.h"
 
@@ -55,6 +56,8 @@ public:
 
   typedef typename TransformType::ParametersType TransformParametersScalesType;
 
+  typedef RecursiveMultiResolutionPyramidImageFilter<ImageType, ImageType> ImagePyramidType;
+
   itkStaticConstMacro( ImageDimension, unsigned int,
                        TImage::ImageDimension );
 
@@ -130,6 +133,40 @@ public:
   itkGetConstMacro( InterpolationMethodEnum, InterpolationMethodEnumType );
 
   itkGetMacro( FinalMetricValue, double );
+
+  /** Number of levels of the image pyramids. If more than 1, the images are
+   *  registered from the coarsest level to the finest one (the input images),
+   *  each level being initialized with the transform found at the previous one. */
+  itkSetClampMacro( NumberOfLevels, unsigned int, 1, 5 );
+  itkGetConstMacro( NumberOfLevels, unsigned int );
+
+  /** Optional precomputed pyramids of the fixed and moving images, see
+   *  ComputeImagePyramid(). They are computed by the method if not set or if
+   *  they have less than NumberOfLevels levels, only their NumberOfLevels
+   *  finest levels are used. Registration stages that use the same images
+   *  should share them. */
+  itkSetObjectMacro( FixedImagePyramid, ImagePyramidType );
+  itkGetObjectMacro( FixedImagePyramid, ImagePyramidType );
+  itkSetObjectMacro( MovingImagePyramid, ImagePyramidType );
+  itkGetObjectMacro( MovingImagePyramid, ImagePyramidType );
+
+  /** Compute the pyramid of an image. Each level halves the resolution of the
+   *  next one, the shrink factors are chosen so that the coarser levels of an
+   *  image of spacing scheduleSpacing have a spacing close to isotropic. The
+   *  registration methods use the fixed image spacing for both the fixed and
+   *  the moving pyramids, as the B-spline registration always did. */
+  static typename ImagePyramidType::Pointer ComputeImagePyramid( const ImageType * image,
+                                                                 unsigned int numberOfLevels,
+                                                                 const typename ImageType::SpacingType & scheduleSpacing );
+
+  /** Image of a pyramid computed by ComputeImagePyramid() at the given level
+   *  of a numberOfLevels levels schedule. The schedule of a level only depends
+   *  on its distance to the finest level, so a pyramid with more levels than
+   *  numberOfLevels has the same images at its finest levels. */
+  static const ImageType * GetImagePyramidLevel( ImagePyramidType * pyramid,
+                                                 unsigned int numberOfLevels,
+                                                 unsigned int level );
+
 protected:
 
   OptimizedImageToImageRegistrationMethod( void );
@@ -142,6 +179,18 @@ protected:
   typedef InterpolateImageFunction<TImage, double> InterpolatorType;
   typedef ImageToImageMetric<TImage, TImage>       MetricType;
 
+  /** Register the given images (the input images or the images of a pyramid
+   *  level): create the metric, the fixed image samples and the interpolator,
+   *  then call Optimize() */
+  virtual void OptimizeImages( const ImageType * fixedImage, const ImageType * movingImage,
+                               unsigned int numberOfSamples );
+
+  /** Register each level of the image pyramids, from the coarsest to the finest.
+   *  The number of samples is scaled with the number of pixels of each level and
+   *  evolutionary optimization is only run at the coarsest level. */
+  virtual void MultiResolutionOptimize( void );
+
+  /** Optimize the transform for the images of the metric */
   virtual void Optimize( MetricType * metric, InterpolatorType * interpolator );
 
   virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
@@ -182,6 +231,11 @@ private:
   InterpolationMethodEnumType m_InterpolationMethodEnum;
 
   double m_FinalMetricValue;
+
+  unsigned int m_NumberOfLevels;
+
+  typename ImagePyramidType::Pointer m_FixedImagePyramid;
+  typename ImagePyramidType::Pointer m_MovingImagePyramid;
 };
 
 }
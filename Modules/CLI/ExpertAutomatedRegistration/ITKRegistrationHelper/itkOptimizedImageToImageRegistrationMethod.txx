@@ -46,6 +46,7 @@
 #include <itkConstantBoundaryCondition.h>
 
 
+#include <algorithm>
 #include <sstream>
 
 namespace itk
@@ -175,6 +176,10 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   m_FinalMetricValue = 0;
 
+  m_NumberOfLevels = 1;
+
+  m_FixedImagePyramid = 0;
+  m_MovingImagePyramid = 0;
 }
 
 template <class TImage>
@@ -206,6 +211,142 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   this->GetTransform()->SetParametersByValue( this->GetInitialTransformParameters() );
 
+  if( m_NumberOfLevels > 1 )
+    {
+    this->MultiResolutionOptimize();
+    }
+  else
+    {
+    this->OptimizeImages( this->GetFixedImage(), this->GetMovingImage(), m_NumberOfSamples );
+    }
+
+  if( this->GetReportProgress() )
+    {
+    std::cout << "UPDATE END" << std::endl;
+    }
+}
+
+template <class TImage>
+typename OptimizedImageToImageRegistrationMethod<TImage>::ImagePyramidType::Pointer
+OptimizedImageToImageRegistrationMethod<TImage>
+::ComputeImagePyramid( const ImageType * image, unsigned int numberOfLevels,
+                       const typename ImageType::SpacingType & scheduleSpacing )
+{
+  typename ImagePyramidType::Pointer pyramid = ImagePyramidType::New();
+  pyramid->SetNumberOfLevels( numberOfLevels );
+
+  typename ImagePyramidType::ScheduleType schedule = pyramid->GetSchedule();
+  for( unsigned int level = 0; level < numberOfLevels; level++ )
+    {
+    double levelScale = 1 << ( numberOfLevels - 1 - level );
+    for( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      schedule[level][i] = (unsigned int)(levelScale * scheduleSpacing[0] / scheduleSpacing[i]);
+      if( schedule[level][i] < 1 )
+        {
+        schedule[level][i] = 1;
+        }
+      }
+    }
+  pyramid->SetSchedule( schedule );
+  pyramid->SetInput( image );
+  pyramid->Update();
+
+  return pyramid;
+}
+
+template <class TImage>
+const typename OptimizedImageToImageRegistrationMethod<TImage>::ImageType *
+OptimizedImageToImageRegistrationMethod<TImage>
+::GetImagePyramidLevel( ImagePyramidType * pyramid, unsigned int numberOfLevels, unsigned int level )
+{
+  return pyramid->GetOutput( pyramid->GetNumberOfLevels() - numberOfLevels + level );
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::MultiResolutionOptimize( void )
+{
+  if( this->GetReportProgress() )
+    {
+    std::cout << "MULTIRESOLUTION START" << std::endl;
+    }
+
+  // The pyramids may be shared with other registration stages, only compute
+  // them if they were not given or do not have enough levels
+  typename ImageType::SpacingType fixedSpacing = this->GetFixedImage()->GetSpacing();
+  if( m_FixedImagePyramid.IsNull()
+      || m_FixedImagePyramid->GetInput() != this->GetFixedImage()
+      || m_FixedImagePyramid->GetNumberOfLevels() < m_NumberOfLevels )
+    {
+    m_FixedImagePyramid = ComputeImagePyramid( this->GetFixedImage(), m_NumberOfLevels, fixedSpacing );
+    }
+  if( m_MovingImagePyramid.IsNull()
+      || m_MovingImagePyramid->GetInput() != this->GetMovingImage()
+      || m_MovingImagePyramid->GetNumberOfLevels() < m_NumberOfLevels )
+    {
+    m_MovingImagePyramid = ComputeImagePyramid( this->GetMovingImage(), m_NumberOfLevels, fixedSpacing );
+    }
+
+  TransformParametersType initialTransformParameters = this->GetInitialTransformParameters();
+  bool                    useEvolutionaryOptimization = this->GetUseEvolutionaryOptimization();
+
+  const double fixedImageNumberOfPixels =
+    this->GetFixedImage()->GetLargestPossibleRegion().GetNumberOfPixels();
+  const unsigned int minimumNumberOfSamples = 1000;
+
+  for( unsigned int level = 0; level < m_NumberOfLevels; level++ )
+    {
+    typename ImageType::ConstPointer fixedImage =
+      GetImagePyramidLevel( m_FixedImagePyramid, m_NumberOfLevels, level );
+    typename ImageType::ConstPointer movingImage =
+      GetImagePyramidLevel( m_MovingImagePyramid, m_NumberOfLevels, level );
+
+    // Keep the sampling ratio of the input images
+    unsigned int levelNumberOfPixels = fixedImage->GetLargestPossibleRegion().GetNumberOfPixels();
+    unsigned int levelNumberOfSamples = (unsigned int)( m_NumberOfSamples * levelNumberOfPixels
+                                                        / fixedImageNumberOfPixels );
+    if( levelNumberOfSamples < minimumNumberOfSamples )
+      {
+      levelNumberOfSamples = std::min( minimumNumberOfSamples, levelNumberOfPixels );
+      }
+
+    if( this->GetReportProgress() )
+      {
+      std::cout << "MULTIRESOLUTION LEVEL = " << level << std::endl;
+      std::cout << "   Fixed image = "
+                << fixedImage->GetLargestPossibleRegion().GetSize() << std::endl;
+      std::cout << "   Moving image = "
+                << movingImage->GetLargestPossibleRegion().GetSize() << std::endl;
+      std::cout << "   Number of samples = " << levelNumberOfSamples << std::endl;
+      }
+
+    if( level > 0 )
+      {
+      // The global search is only done at the coarsest level
+      this->SetInitialTransformParameters( this->GetLastTransformParameters() );
+      m_UseEvolutionaryOptimization = false;
+      }
+
+    this->OptimizeImages( fixedImage, movingImage, levelNumberOfSamples );
+    }
+
+  m_InitialTransformParameters = initialTransformParameters;
+  m_UseEvolutionaryOptimization = useEvolutionaryOptimization;
+
+  if( this->GetReportProgress() )
+    {
+    std::cout << "MULTIRESOLUTION END" << std::endl;
+    }
+}
+
+template <class TImage>
+void
+OptimizedImageToImageRegistrationMethod<TImage>
+::OptimizeImages( const ImageType * fixedImage, const ImageType * movingImage,
+                  unsigned int numberOfSamples )
+{
   typename MetricType::Pointer metric;
 
   switch( this->GetMetricMethodEnum() )
@@ -243,13 +384,13 @@ OptimizedImageToImageRegistrationMethod<TImage>
     metric->ReinitializeSeed();
     }
 
-  typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-  typename ImageType::ConstPointer movingImage = this->GetMovingImage();
-
   metric->SetFixedImage( fixedImage );
   metric->SetMovingImage( movingImage );
 
-  metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+  metric->SetNumberOfSpatialSamples( numberOfSamples );
+
+  // Metric values and derivatives are accumulated per thread
+  metric->SetNumberOfThreads( this->GetRegistrationNumberOfThreads() );
 
   if( this->GetUseRegionOfInterest() ||
       this->GetSampleFromOverlap() ||
@@ -322,7 +463,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
       ++count;
       }
-    double samplingRate = (double)(m_NumberOfSamples + 2) / (double)count;
+    double samplingRate = (double)(numberOfSamples + 2) / (double)count;
     if( this->GetReportProgress() )
       {
       std::cout << "...Second pass, sampling rate = " << samplingRate << std::endl;
@@ -332,8 +473,8 @@ OptimizedImageToImageRegistrationMethod<TImage>
       {
       samplingRate = 1;
       itkWarningMacro(<< "Adjusting the number of samples due to restrictive threshold/overlap criteria.");
-      this->SetNumberOfSamples( count );
-      metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+      numberOfSamples = count;
+      metric->SetNumberOfSpatialSamples( numberOfSamples );
       }
     double step = 0;
     typename MetricType::FixedImageIndexContainer indexList;
@@ -377,18 +518,18 @@ OptimizedImageToImageRegistrationMethod<TImage>
           step -= 1;
           }
 
-        if( indexList.size() == m_NumberOfSamples )
+        if( indexList.size() == numberOfSamples )
           {
           break;
           }
         }
       }
-    if( indexList.size() != m_NumberOfSamples )
+    if( indexList.size() != numberOfSamples )
       {
       itkWarningMacro(<< "Full set of samples not collected. Collected "
-                      << indexList.size() << " of " << m_NumberOfSamples );
-      this->SetNumberOfSamples( indexList.size() );
-      metric->SetNumberOfSpatialSamples( m_NumberOfSamples );
+                      << indexList.size() << " of " << numberOfSamples );
+      numberOfSamples = indexList.size();
+      metric->SetNumberOfSpatialSamples( numberOfSamples );
       }
     std::cout << "Passing index list to metric..." << std::endl;
     std::cout << "  List size = " << indexList.size() << std::endl;
@@ -424,7 +565,7 @@ OptimizedImageToImageRegistrationMethod<TImage>
                                                           double>::New();
       break;
     }
-  interpolator->SetInputImage( this->GetMovingImage() );
+  interpolator->SetInputImage( movingImage );
 
   try
     {
@@ -434,11 +575,6 @@ OptimizedImageToImageRegistrationMethod<TImage>
     {
     std::cerr << "Optimization threw an exception." << std::endl;
     }
-
-  if( this->GetReportProgress() )
-    {
-    std::cout << "UPDATE END" << std::endl;
-    }
 }
 
 template <class TImage>
@@ -490,12 +626,11 @@ OptimizedImageToImageRegistrationMethod<TImage>
       }
 
     typename RegType::Pointer reg = RegType::New();
-    typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-    typename ImageType::ConstPointer movingImage = this->GetMovingImage();
+    typename ImageType::ConstPointer fixedImage = metric->GetFixedImage();
+    typename ImageType::ConstPointer movingImage = metric->GetMovingImage();
     reg->SetFixedImage( fixedImage );
     reg->SetMovingImage( movingImage );
-    reg->SetFixedImageRegion( this->GetFixedImage()
-                              ->GetLargestPossibleRegion() );
+    reg->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
     reg->SetTransform( this->GetTransform() );
     reg->SetInitialTransformParameters(
       this->GetInitialTransformParameters() );
@@ -577,12 +712,11 @@ OptimizedImageToImageRegistrationMethod<TImage>
     }
 
   typename RegType::Pointer reg = RegType::New();
-  typename ImageType::ConstPointer fixedImage = this->GetFixedImage();
-  typename ImageType::ConstPointer movingImage = this->GetMovingImage();
+  typename ImageType::ConstPointer fixedImage = metric->GetFixedImage();
+  typename ImageType::ConstPointer movingImage = metric->GetMovingImage();
   reg->SetFixedImage( fixedImage );
   reg->SetMovingImage( movingImage );
-  reg->SetFixedImageRegion( this->GetFixedImage()
-                            ->GetLargestPossibleRegion() );
+  reg->SetFixedImageRegion( fixedImage->GetLargestPossibleRegion() );
   reg->SetTransform( this->GetTransform() );
   reg->SetInitialTransformParameters( this->GetTransform()->GetParameters() );
   reg->SetMetric( metric );
@@ -671,6 +805,8 @@ OptimizedImageToImageRegistrationMethod<TImage>
 
   os << indent << "Number of Samples = " << m_NumberOfSamples << std::endl;
 
+  os << indent << "Number of Levels = " << m_NumberOfLevels << std::endl;
+
   os << indent << "Samples threshold = " << m_FixedImageSamplesIntensityThreshold << std::endl;
 
   os << indent << "Target Error = " << m_TargetError << std::endl;
@@ -17,10 +17,29 @@
 //  + Processing utilities of the graph
 //  ===============================================
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
 #include "SkelGraph.h"
 
+namespace
+{
+bool point_xyz_less(const point & a, const point & b)
+{
+  if( a.x != b.x )
+    {
+    return a.x < b.x;
+    }
+  if( a.y != b.y )
+    {
+    return a.y < b.y;
+    }
+  return a.z < b.z;
+}
+}
+
 /*
 ===============================================
 Constructors, Destructor
@@ -216,11 +235,9 @@ void SkelGraph::Extract_skel_graph(unsigned char *orig_image, int orig_dim[3])
     }
   int size_image = dim[0] * dim[1] * dim[2];
 
-  label_image = new int[size_image];
-  for( int i = 0; i < size_image; i++ )
-    {
-    label_image[i] = 0;
-    }
+  // only whether a point is labeled is used, one byte per voxel is enough
+  label_image = new unsigned char[size_image];
+  memset(label_image, 0, size_image);
 
   // determine endpoints = points that have exactly 1 neighbor
   find_endpoints();
@@ -258,7 +275,7 @@ void SkelGraph::Extract_skel_graph(unsigned char *orig_image, int orig_dim[3])
         int     branchID = act_branch->branchID;
         // label endpoint
         label_image[act_point->x
-                    + dim[0] * (act_point->y + dim[1] * act_point->z)] = branchID;
+                    + dim[0] * (act_point->y + dim[1] * act_point->z)] = 1;
         while( !branch_done )
           {
           list<point> * neighbors = new list<point>();
@@ -280,7 +297,7 @@ void SkelGraph::Extract_skel_graph(unsigned char *orig_image, int orig_dim[3])
                                         + abs(act_point->z - pt->z) );
             act_point->x = pt->x; act_point->y = pt->y; act_point->z = pt->z;
             label_image[act_point->x
-                        + dim[0] * (act_point->y + dim[1] * act_point->z)] = branchID;
+                        + dim[0] * (act_point->y + dim[1] * act_point->z)] = 1;
             }
           else
             {
@@ -298,7 +315,7 @@ void SkelGraph::Extract_skel_graph(unsigned char *orig_image, int orig_dim[3])
               elems[i]->end_1_point->y = elems[i]->end_2_point->y = pt->y;
               elems[i]->end_1_point->z = elems[i]->end_2_point->z = pt->z;
               label_image[pt->x + dim[0]
-                          * (pt->y + dim[1] * pt->z)] = elems[i]->branchID;
+                          * (pt->y + dim[1] * pt->z)] = 1;
               // update ends with act_branch
               if( !elems[i]->end_1_neighbors )
                 {
@@ -433,6 +450,15 @@ void SkelGraph::Extract_max_axis_in_graph()
     ++act_endbranch;
     }
 
+  // since the graph_id's are the location of its member in the list,
+  // the branches can be accessed by id in constant time
+  vector<skel_branch *> branches;
+  branches.reserve(graph->size() );
+  for( act_endbranch = graph->begin(); act_endbranch != graph->end(); ++act_endbranch )
+    {
+    branches.push_back(&(*act_endbranch) );
+    }
+
   act_endbranch = graph->begin();
 
   while( act_endbranch != graph->end() )
@@ -475,11 +501,6 @@ void SkelGraph::Extract_max_axis_in_graph()
         act_node->acc_path = new list<int>();
         }
       act_node->acc_path->push_back(act_node->branchID);
-      int                         act_pos_id = act_node->branchID;
-      list<skel_branch>::iterator act_pos_list = graph->begin();
-      // since the graph_id's are the location of its member in the list,
-      // we can use advance for random access
-      advance(act_pos_list, act_pos_id - 1);
       // cout << "A " << act_pos_id  << endl;
       for( int i = 0; i < 2; i++ )
         {
@@ -502,10 +523,7 @@ void SkelGraph::Extract_max_axis_in_graph()
           while( neighbors != cont_end->end() )
             {
             // get neighbours entry
-            int                         distance = *neighbors - act_pos_id;
-            list<skel_branch>::iterator act_pos_neigh = act_pos_list;
-            advance(act_pos_neigh, distance);
-            skel_branch * act_neighbor = &(*(act_pos_neigh) );
+            skel_branch * act_neighbor = branches[*neighbors - 1];
             if( !act_neighbor->acc_path )
               {
               // neighbour not yet treated
@@ -743,28 +761,31 @@ void SkelGraph::find_endpoints()
 {
   point elem;
 
-  endpoints = new list<point>;
-
-  // search image
-  for( int x = 1; x < dim[0] - 1; x++ )
+  // search image in memory order
+  vector<point> found;
+  for( int z = 1; z < dim[2] - 1; z++ )
     {
     for( int y = 1; y < dim[1] - 1; y++ )
       {
-      for( int z = 1; z < dim[2] - 1; z++ )
+      const unsigned char * row = image + dim[0] * ( y + dim[1] * z );
+      for( int x = 1; x < dim[0] - 1; x++ )
         {
-        if( image[x + dim[0] * ( y + dim[1] * z )] && endpoint_Test(x, y, z) )
+        if( row[x] && endpoint_Test(x, y, z) )
           {
           // x,y,z is an endpoint
           elem.x = x;
           elem.y = y;
           elem.z = z;
-          endpoints->insert(endpoints->end(), elem);
-          // appends copy of elem at end
+          found.push_back(elem);
           }
         }
       }
     }
 
+  // the graph is extracted from the endpoints ordered by x, y then z
+  sort(found.begin(), found.end(), point_xyz_less);
+  endpoints = new list<point>(found.begin(), found.end() );
+
 }
 
 int SkelGraph::endpoint_Test(int x, int y, int z)
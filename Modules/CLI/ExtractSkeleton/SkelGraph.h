@@ -52,8 +52,8 @@ private:
   // Image to extract from
   unsigned char *image;
   int            dim[3];
-  // Label image, only of temporary use
-  int *label_image;
+  // Label image (non-zero if labeled), only of temporary use
+  unsigned char *label_image;
 
   skel_branch * max_node;   // for storage of start of maximal path
   double        max_length;
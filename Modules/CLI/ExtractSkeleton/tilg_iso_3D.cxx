@@ -23,6 +23,11 @@
 /*****************************************************************************/
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include <itkMultiThreader.h>
 
 /********************************  Konstanten  *******************************/
 #define LIM  1 /* Voxelwert >= LIM => Objekt (Input-Bild) */
@@ -38,6 +43,7 @@ static int            nx, ny, nz, nzz;
 static unsigned char *workbuf, *result;
 static int            f_tab[26];
 static unsigned char  p[5][5][5];
+static int            face_offset[6];
 
 /*******************************  Hilfsprozeduren ****************************/
 int bitcount(int i)
@@ -171,6 +177,37 @@ int Env_Code_3(int i)
   return nc;
 }
 
+/* Only object voxels with a background 6-neighbor (neighbors 4, 10, 12, 14,  */
+/* 16 and 22) can be deleted: all the direction masks contain one of them and */
+/* de - df + du == 0 when the 6 of them are object voxels. The thinning       */
+/* therefore only visits the border voxels, and adds the neighbors of the    */
+/* deleted voxels to the border as they get exposed.                          */
+int is_border(int i)
+{
+  for( int f = 0; f < 6; f++ )
+    {
+    if( result[i + face_offset[f]] == BG )
+      {
+      return 1;
+      }
+    }
+  return 0;
+}
+
+void add_exposed_neighbors(int i, std::vector<unsigned char> & in_border, std::vector<int> & border)
+/* adds the object 6-neighbors of the deleted voxel i to the border */
+{
+  for( int f = 0; f < 6; f++ )
+    {
+    int j = i + face_offset[f];
+    if( result[j] == OBJ && !in_border[j] )
+      {
+      in_border[j] = 1;
+      border.push_back(j);
+      }
+    }
+}
+
 /*************************** ENDE  Hilfsprozeduren **************************/
 
 /******************************  Hauptprozedur ******************************/
@@ -592,6 +629,45 @@ int Tilg_Test_3(int c, int d, int type)
   return OBJ;
 }
 
+struct tilg_thread_struct
+  {
+  const std::vector<int> *         border;
+  std::vector<std::vector<int> > * deletable;
+  int                              dir;
+  int                              dir_mask;
+  int                              type;
+  };
+
+ITK_THREAD_RETURN_TYPE tilg_subcycle_thread(void *arg)
+/* tests a part of the border voxels against the same state of the image, */
+/* the deletable voxels are only removed once all threads are done         */
+{
+  itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  tilg_thread_struct*                   str = static_cast<tilg_thread_struct*>(info->UserData);
+
+  const std::vector<int> & border = *(str->border);
+  std::vector<int> &       deletable = (*(str->deletable))[info->ThreadID];
+  size_t                   begin = border.size() * info->ThreadID / info->NumberOfThreads;
+  size_t                   end = border.size() * (info->ThreadID + 1) / info->NumberOfThreads;
+  deletable.clear();
+  for( size_t k = begin; k < end; k++ )
+    {
+    int i = border[k];
+    int nc = Env_Code_3(i);
+    if( ( (~ nc) & str->dir_mask) == str->dir_mask )
+      {
+      if( bitcount(nc) > 2 )
+        {
+        if( Tilg_Test_3(nc, str->dir, str->type) == BG )
+          {
+          deletable.push_back(i);
+          }
+        }
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 void tilg_iso_3D(int dx, int dy, int dz,
                  unsigned char *data,
                  unsigned char *res,
@@ -606,7 +682,6 @@ void tilg_iso_3D(int dx, int dy, int dz,
   int nc, x, y, z;
   int end, i, dir, dir_mask;
   // int free_mask;
-  int *list;
   int  dir_tab[26];
 
   // int b[3][3][3];
@@ -618,12 +693,12 @@ void tilg_iso_3D(int dx, int dy, int dz,
 
   workbuf = data;
   nzz = nx * ny;
-  /* Speicher allozieren */
-  if( (list = (int *) malloc(nzz * nz * sizeof(int) / 4) ) == NULL )
-    {
-    printf("out of memory\n");
-    return;
-    }
+  face_offset[0] = -nzz;
+  face_offset[1] = -nx;
+  face_offset[2] = -1;
+  face_offset[3] = 1;
+  face_offset[4] = nx;
+  face_offset[5] = nzz;
   /* Arbeitskopie des Bildes erstellen und binaerisieren */
   end = nx * ny * nz;
   for( i = 0; i < end; i++ )
@@ -693,8 +768,28 @@ void tilg_iso_3D(int dx, int dy, int dz,
   f_tab[16] =   131072;    /* 17 */
   f_tab[17] =      512;    /*  9 */
 
-  /* eigentliches Bildparsing */
+  /* Randvoxel sammeln */
+  std::vector<unsigned char> in_border(end, 0);
+  std::vector<int>           border;
   end = end - nzz - nx - 1;
+  for( i = nzz + nx + 1; i < end; i++ )
+    {
+    if( result[i] == OBJ && is_border(i) )
+      {
+      in_border[i] = 1;
+      border.push_back(i);
+      }
+    }
+
+  /* eigentliches Bildparsing: the voxels of a subcycle are tested in parallel */
+  int number_of_threads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::vector<std::vector<int> > deletable(number_of_threads);
+  tilg_thread_struct             str;
+  str.border = &border;
+  str.deletable = &deletable;
+  str.type = type;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetSingleMethod(tilg_subcycle_thread, &str);
   cnt = 1;
   while( cnt )
     {
@@ -703,53 +798,73 @@ void tilg_iso_3D(int dx, int dy, int dz,
       {
       cnt1 = 0;
       dir_mask = dir_tab[dir];
-      for( i = nzz + nx + 1; i < end; i++ )
+      str.dir = dir;
+      str.dir_mask = dir_mask;
+      threader->SetNumberOfThreads(
+        std::max(1, std::min(number_of_threads, static_cast<int>(border.size() / 1024) + 1) ) );
+      threader->SingleMethodExecute();
+      /* Voxel der Liste loeschen */
+      for( size_t t = 0; t < deletable.size(); t++ )
         {
-        if( result[i] == OBJ )
+        for( size_t k = 0; k < deletable[t].size(); k++ )
           {
-          nc = Env_Code_3(i);
-          if( ( (~ nc) & dir_mask) == dir_mask )
-            {
-            if( bitcount(nc) > 2 )
-              {
-              if( Tilg_Test_3(nc, dir, type) == BG )
-                {
-                list[cnt1++] = i;
-                }
-              }
-            }
+          result[deletable[t][k]] = BG;
           }
+        cnt1 += static_cast<int>(deletable[t].size() );
         }
-      /* Voxel der Liste loeschen */
-      for( i = 0; i < cnt1; i++ )
+      if( cnt1 )
         {
-        result[list[i]] = BG;
+        /* Rand aktualisieren */
+        size_t kept = 0;
+        for( size_t k = 0; k < border.size(); k++ )
+          {
+          if( result[border[k]] == OBJ )
+            {
+            border[kept++] = border[k];
+            }
+          }
+        border.resize(kept);
+        for( size_t t = 0; t < deletable.size(); t++ )
+          {
+          for( size_t k = 0; k < deletable[t].size(); k++ )
+            {
+            add_exposed_neighbors(deletable[t][k], in_border, border);
+            }
+          deletable[t].clear();
+          }
         }
       cnt += cnt1;
       }
     }
 
-  /* sequentiell maximal Verduennen */
+  /* sequentiell maximal Verduennen: the border voxels are visited in the */
+  /* order of the image, exposed voxels ahead of the current one are      */
+  /* visited in the same pass                                             */
+  std::set<int>    ordered_border(border.begin(), border.end() );
+  std::vector<int> exposed;
   cnt = 1;
   while( cnt )
     {
     cnt = 0;
-    for( i = nzz + nx + 1; i < end; i++ )
+    std::set<int>::iterator it = ordered_border.begin();
+    while( it != ordered_border.end() )
       {
-      if( result[i] == OBJ )
+      i = *it;
+      nc = Env_Code_3(i);
+      if( bitcount(nc) > 2 )
         {
-        nc = Env_Code_3(i);
-        if( bitcount(nc) > 2 )
+        if( Tilg_Test_3(nc, 18, type) == BG )
           {
-          if( Tilg_Test_3(nc, 18, type) == BG )
-            {
-            cnt++;
-            result[i] = BG;
-            }
+          cnt++;
+          result[i] = BG;
+          exposed.clear();
+          add_exposed_neighbors(i, in_border, exposed);
+          ordered_border.insert(exposed.begin(), exposed.end() );
+          ordered_border.erase(it++);
+          continue;
           }
         }
+      ++it;
       }
     }
-
-  free(list);
 }
@@ -30,37 +30,528 @@ Version:   $Revision$
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 
 // VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
 #include <vtkDebugLeaks.h>
 #include <vtkDecimatePro.h>
 #include <vtkDiscreteMarchingCubes.h>
-#include <vtkGeometryFilter.h>
-#include <vtkImageAccumulate.h>
 #include <vtkImageChangeInformation.h>
 #include <vtkImageConstantPad.h>
 #include <vtkImageData.h>
-#include <vtkImageThreshold.h>
-#include <vtkImageToStructuredPoints.h>
 #include <vtkInformation.h>
 #include <vtkLookupTable.h>
+#include <vtkMarchingCubes.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkReverseSense.h>
+#include <vtkSimpleCriticalSection.h>
 #include <vtkSmartPointer.h>
 #include <vtkSmoothPolyDataFilter.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkStripper.h>
-#include <vtkThreshold.h>
+#include <vtkTimerLog.h>
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
-#include <vtkUnstructuredGrid.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 #include <vtkVersion.h>
 
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Voxel index bounding box and number of voxels of a label
+struct LabelExtent
+{
+  int Extent[6];
+  vtkIdType NumberOfVoxels;
+};
+typedef std::map<int, LabelExtent> LabelExtentMap;
+
+//----------------------------------------------------------------------------
+// Find the bounding box of every label of the volume in a single scan.
+// Runs of voxels with the same label along a row are accounted for at once.
+template <class T>
+void ComputeLabelExtents(vtkImageData* image, T* scalars, LabelExtentMap& labelExtents)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      T* rowPtr = scalars + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      int i = extent[0];
+      while (i <= extent[1])
+        {
+        T value = rowPtr[(i - extent[0]) * increments[0]];
+        int runStart = i;
+        while (i <= extent[1] && rowPtr[(i - extent[0]) * increments[0]] == value)
+          {
+          ++i;
+          }
+        int label = static_cast<int>(value);
+        LabelExtentMap::iterator it = labelExtents.find(label);
+        if (it == labelExtents.end())
+          {
+          LabelExtent labelExtent;
+          labelExtent.Extent[0] = runStart;
+          labelExtent.Extent[1] = i - 1;
+          labelExtent.Extent[2] = labelExtent.Extent[3] = j;
+          labelExtent.Extent[4] = labelExtent.Extent[5] = k;
+          labelExtent.NumberOfVoxels = 0;
+          it = labelExtents.insert(std::make_pair(label, labelExtent)).first;
+          }
+        int* labelExtent = it->second.Extent;
+        labelExtent[0] = std::min(labelExtent[0], runStart);
+        labelExtent[1] = std::max(labelExtent[1], i - 1);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        labelExtent[5] = k;
+        it->second.NumberOfVoxels += i - runStart;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Threshold a label in its bounding box grown by one voxel, which is all the
+// marching cubes needs to extract the surface of the label. With padding the
+// box can extend one voxel outside of the volume, these voxels are 0.
+// Voxels of the label are set to 200, other voxels to 0.
+template <class T>
+void ThresholdLabel(vtkImageData* image, T* scalars, int label, const int labelExtent[6],
+                    bool pad, vtkImageData* output)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+
+  int outExtent[6];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    outExtent[2 * axis] = labelExtent[2 * axis] - 1;
+    outExtent[2 * axis + 1] = labelExtent[2 * axis + 1] + 1;
+    if (!pad)
+      {
+      outExtent[2 * axis] = std::max(outExtent[2 * axis], extent[2 * axis]);
+      outExtent[2 * axis + 1] = std::min(outExtent[2 * axis + 1], extent[2 * axis + 1]);
+      }
+    }
+  output->SetExtent(outExtent);
+  output->SetOrigin(image->GetOrigin());
+  output->SetSpacing(image->GetSpacing());
+  output->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+
+  unsigned char* outPtr = static_cast<unsigned char*>(output->GetScalarPointer());
+  for (int k = outExtent[4]; k <= outExtent[5]; ++k)
+    {
+    bool insideK = (k >= extent[4] && k <= extent[5]);
+    for (int j = outExtent[2]; j <= outExtent[3]; ++j)
+      {
+      bool insideJK = insideK && (j >= extent[2] && j <= extent[3]);
+      T* rowPtr = scalars + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      for (int i = outExtent[0]; i <= outExtent[1]; ++i)
+        {
+        bool inside = insideJK && (i >= extent[0] && i <= extent[1]);
+        *outPtr++ = (inside && static_cast<double>(rowPtr[(i - extent[0]) * increments[0]]) == label) ? 200 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// A model to generate from a label
+struct LabelModel
+{
+  int Label;
+  std::string Name;
+  /// Voxel index bounding box of the label in the input volume
+  int Extent[6];
+  /// Piece of the jointly smoothed surface of all the labels that belongs to
+  /// this label, only used with joint smoothing
+  vtkSmartPointer<vtkPolyData> JointSurface;
+  /// Generated model, in RAS. Empty if no polygons could be created, and
+  /// released once the model is written.
+  vtkSmartPointer<vtkPolyData> Surface;
+  /// File the model is written to
+  std::string FileName;
+  /// True if polygons could be created for the label
+  bool Generated;
+  bool Failed;
+};
+
+//----------------------------------------------------------------------------
+// Split the jointly smoothed surface of all the labels into the surface of
+// each model, in a single pass over the cells. The cell scalars of the surface
+// produced by vtkDiscreteMarchingCubes are the labels.
+void SplitSurfaceByLabel(vtkPolyData* surface, std::vector<LabelModel>& models)
+{
+  std::map<int, ::size_t> modelIndices;
+  for (::size_t m = 0; m < models.size(); m++)
+    {
+    modelIndices[models[m].Label] = m;
+    }
+  std::vector< std::vector<vtkIdType> > modelCells(models.size());
+  vtkDataArray* cellLabels = surface->GetCellData()->GetScalars();
+  for (vtkIdType cellId = 0; cellLabels && cellId < surface->GetNumberOfCells(); ++cellId)
+    {
+    std::map<int, ::size_t>::iterator it =
+      modelIndices.find(static_cast<int>(cellLabels->GetTuple1(cellId)));
+    if (it != modelIndices.end())
+      {
+      modelCells[it->second].push_back(cellId);
+      }
+    }
+
+  // index of the points of the surface in the model being split out, -1 if not used yet
+  std::vector<vtkIdType> pointMap(surface->GetNumberOfPoints(), -1);
+  for (::size_t m = 0; m < models.size(); m++)
+    {
+    const std::vector<vtkIdType>& cells = modelCells[m];
+    vtkSmartPointer<vtkPolyData> modelSurface = vtkSmartPointer<vtkPolyData>::New();
+    vtkNew<vtkPoints> points;
+    if (surface->GetPoints())
+      {
+      points->SetDataType(surface->GetPoints()->GetDataType());
+      }
+    vtkNew<vtkCellArray> polys;
+    modelSurface->GetPointData()->CopyAllocate(surface->GetPointData());
+    modelSurface->GetCellData()->CopyAllocate(surface->GetCellData(), static_cast<vtkIdType>(cells.size()));
+    std::vector<vtkIdType> usedPoints;
+    for (::size_t c = 0; c < cells.size(); c++)
+      {
+      vtkIdType npts = 0;
+      vtkIdType *pts = NULL;
+      surface->GetCellPoints(cells[c], npts, pts);
+      polys->InsertNextCell(npts);
+      for (vtkIdType p = 0; p < npts; ++p)
+        {
+        if (pointMap[pts[p]] < 0)
+          {
+          pointMap[pts[p]] = points->InsertNextPoint(surface->GetPoint(pts[p]));
+          modelSurface->GetPointData()->CopyData(surface->GetPointData(), pts[p], pointMap[pts[p]]);
+          usedPoints.push_back(pts[p]);
+          }
+        polys->InsertCellPoint(pointMap[pts[p]]);
+        }
+      modelSurface->GetCellData()->CopyData(surface->GetCellData(), cells[c], static_cast<vtkIdType>(c));
+      }
+    for (::size_t p = 0; p < usedPoints.size(); p++)
+      {
+      pointMap[usedPoints[p]] = -1;
+      }
+    modelSurface->SetPoints(points.GetPointer());
+    modelSurface->SetPolys(polys.GetPointer());
+    models[m].JointSurface = modelSurface;
+    }
+}
+
+//----------------------------------------------------------------------------
+void WriteIntermediateModel(vtkPolyData* surface, const std::string& rootDir,
+                            const std::string& labelName, const char* suffix, bool debug)
+{
+  std::string fileName = labelName + std::string(suffix);
+  if (rootDir != "")
+    {
+    fileName = rootDir + std::string("/") + fileName;
+    }
+  if (debug)
+    {
+    std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
+    }
+  vtkNew<vtkPolyDataWriter> writer;
+  writer->SetInputData(surface);
+  writer->SetFileType(2);
+  writer->SetFileName(fileName.c_str());
+  if (!writer->Write())
+    {
+    std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Report the progress of the model generation the same way
+// vtkPluginFilterWatcher reports the progress of a filter
+void ReportProgress(ModuleProcessInformation* processInformation,
+                    const char* comment, double progress, bool quiet)
+{
+  if (processInformation)
+    {
+    strncpy(processInformation->ProgressMessage, comment, 1023);
+    processInformation->Progress = progress;
+    if (processInformation->ProgressCallbackFunction
+        && processInformation->ProgressCallbackClientData)
+      {
+      (*(processInformation->ProgressCallbackFunction))(processInformation->ProgressCallbackClientData);
+      }
+    }
+  else if (!quiet)
+    {
+    std::cout << "<filter-progress>" << progress << "</filter-progress>" << std::endl;
+    std::cout << std::flush;
+    }
+}
+
+//----------------------------------------------------------------------------
+struct ModelMakerThreadStruct
+{
+  std::vector<LabelModel>* Models;
+  /// Input label map, not padded
+  vtkImageData* Image;
+  bool Pad;
+  bool JointSmoothing;
+  bool SincFilter;
+  int Smooth;
+  double Decimate;
+  bool SplitNormals;
+  bool PointNormals;
+  vtkMatrix4x4* IJKToRAS;
+  bool ReverseSense;
+  bool SaveIntermediateModels;
+  std::string RootDir;
+  bool Debug;
+
+  /// Models are handed out to the threads one at a time
+  vtkSimpleCriticalSection Lock;
+  ::size_t NextModel;
+  ::size_t CompletedModels;
+
+  ModuleProcessInformation* ProcessInformation;
+  double ProgressStart;
+  double ProgressFraction;
+};
+
+//----------------------------------------------------------------------------
+// Generate the model of a label: marching cubes in the bounding box of the
+// label (unless joint smoothing was done), decimation, smoothing, transform
+// to RAS, normals and triangle strips. The filters of each model make an
+// independent pipeline, so that models can be generated in parallel.
+void GenerateLabelModel(ModelMakerThreadStruct* str, LabelModel* model)
+{
+  vtkSmartPointer<vtkPolyData> surface;
+  if (!str->JointSmoothing)
+    {
+    vtkNew<vtkImageData> labelImage;
+    switch (str->Image->GetScalarType())
+      {
+      vtkTemplateMacro(ThresholdLabel(str->Image, static_cast<VTK_TT*>(str->Image->GetScalarPointer()),
+                                      model->Label, model->Extent, str->Pad, labelImage.GetPointer()));
+      }
+
+    vtkNew<vtkMarchingCubes> mcubes;
+    mcubes->SetInputData(labelImage.GetPointer());
+    mcubes->SetValue(0, 100.5);
+    mcubes->ComputeScalarsOff();
+    mcubes->ComputeGradientsOff();
+    mcubes->ComputeNormalsOff();
+    mcubes->Update();
+    if (str->Debug)
+      {
+      std::cout << "\nNumber of polygons for label " << model->Label << " = "
+                << mcubes->GetOutput()->GetNumberOfPolys() << endl;
+      }
+    if (mcubes->GetOutput()->GetNumberOfPolys() == 0)
+      {
+      return;
+      }
+    surface = mcubes->GetOutput();
+    if (str->SaveIntermediateModels)
+      {
+      WriteIntermediateModel(surface, str->RootDir, model->Name, "-MarchingCubes.vtk", str->Debug);
+      }
+    }
+  else
+    {
+    surface = model->JointSurface;
+    }
+
+  // In switch from vtk 4 to vtk 5, vtkDecimate was deprecated from the Patented dir, use vtkDecimatePro
+  // TODO: look at vtkQuadraticDecimation
+  vtkNew<vtkDecimatePro> decimator;
+  decimator->SetInputData(surface);
+  decimator->SetFeatureAngle(60);
+  decimator->SplittingOff();
+  decimator->PreserveTopologyOn();
+  decimator->SetMaximumError(1);
+  decimator->SetTargetReduction(str->Decimate);
+  decimator->Update();
+  if (str->Debug)
+    {
+    std::cout << "After decimation, number of polygons for label " << model->Label << " = "
+              << decimator->GetOutput()->GetNumberOfPolys() << endl;
+    }
+  if (str->SaveIntermediateModels)
+    {
+    WriteIntermediateModel(decimator->GetOutput(), str->RootDir, model->Name, "-Decimated.vtk", str->Debug);
+    }
+  vtkAlgorithmOutput* outputPort = decimator->GetOutputPort();
+
+  vtkNew<vtkReverseSense> reverser;
+  if (str->ReverseSense)
+    {
+    reverser->SetInputConnection(outputPort);
+    reverser->ReverseNormalsOn();
+    outputPort = reverser->GetOutputPort();
+    }
+
+  vtkNew<vtkWindowedSincPolyDataFilter> smootherSinc;
+  vtkNew<vtkSmoothPolyDataFilter> smootherPoly;
+  if (!str->JointSmoothing)
+    {
+    if (str->SincFilter)
+      {
+      smootherSinc->SetPassBand(0.1);
+      smootherSinc->SetInputConnection(outputPort);
+      smootherSinc->SetNumberOfIterations(str->Smooth);
+      smootherSinc->FeatureEdgeSmoothingOff();
+      smootherSinc->BoundarySmoothingOff();
+      outputPort = smootherSinc->GetOutputPort();
+      }
+    else
+      {
+      // this next line massively rounds corners
+      smootherPoly->SetRelaxationFactor(0.33);
+      smootherPoly->SetFeatureAngle(60);
+      smootherPoly->SetConvergence(0);
+      smootherPoly->SetInputConnection(outputPort);
+      smootherPoly->SetNumberOfIterations(str->Smooth);
+      smootherPoly->FeatureEdgeSmoothingOff();
+      smootherPoly->BoundarySmoothingOff();
+      outputPort = smootherPoly->GetOutputPort();
+      }
+    if (str->SaveIntermediateModels)
+      {
+      vtkPolyData* smoothed = NULL;
+      if (str->SincFilter)
+        {
+        smootherSinc->Update();
+        smoothed = smootherSinc->GetOutput();
+        }
+      else
+        {
+        smootherPoly->Update();
+        smoothed = smootherPoly->GetOutput();
+        }
+      WriteIntermediateModel(smoothed, str->RootDir, model->Name, "-Smoothed.vtk", str->Debug);
+      }
+    }
+
+  vtkNew<vtkTransform> transformIJKtoRAS;
+  transformIJKtoRAS->SetMatrix(str->IJKToRAS);
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetInputConnection(outputPort);
+  transformer->SetTransform(transformIJKtoRAS.GetPointer());
+
+  vtkNew<vtkPolyDataNormals> normals;
+  if (str->PointNormals)
+    {
+    normals->ComputePointNormalsOn();
+    }
+  else
+    {
+    normals->ComputePointNormalsOff();
+    }
+  normals->SetInputConnection(transformer->GetOutputPort());
+  normals->SetFeatureAngle(60);
+  normals->SetSplitting(str->SplitNormals);
+
+  vtkNew<vtkStripper> stripper;
+  stripper->SetInputConnection(normals->GetOutputPort());
+  stripper->Update();
+
+  model->Surface = vtkSmartPointer<vtkPolyData>::New();
+  model->Surface->ShallowCopy(stripper->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+// Write the model as soon as it is generated and release it, so that only the
+// models being processed by the threads are in memory
+void WriteLabelModel(ModelMakerThreadStruct* str, LabelModel* model)
+{
+  model->Generated = (model->Surface != NULL);
+  if (model->Generated)
+    {
+    if (str->Debug)
+      {
+      std::cout << "Writing model " << " " << model->Name << " to file " << model->FileName << endl;
+      }
+    vtkNew<vtkPolyDataWriter> writer;
+    writer->SetInputData(model->Surface);
+    writer->SetFileType(2);
+    writer->SetFileName(model->FileName.c_str());
+    if (!writer->Write())
+      {
+      std::cerr << "ERROR: Failed to write model file " << model->FileName.c_str() << std::endl;
+      }
+    }
+  model->Surface = NULL;
+  model->JointSurface = NULL;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE GenerateLabelModelsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ModelMakerThreadStruct* str = static_cast<ModelMakerThreadStruct*>(info->UserData);
+
+  while (true)
+    {
+    str->Lock.Lock();
+    ::size_t m = str->NextModel++;
+    str->Lock.Unlock();
+    if (m >= str->Models->size())
+      {
+      break;
+      }
+
+    LabelModel* model = &(*str->Models)[m];
+    try
+      {
+      GenerateLabelModel(str, model);
+      WriteLabelModel(str, model);
+      }
+    catch(...)
+      {
+      model->Failed = true;
+      }
+
+    str->Lock.Lock();
+    ::size_t completedModels = ++str->CompletedModels;
+    str->Lock.Unlock();
+    // only the calling thread reports progress
+    if (info->ThreadID == 0)
+      {
+      std::string comment = "Generate and write " + model->Name;
+      ReportProgress(str->ProcessInformation, comment.c_str(),
+                     str->ProgressStart + str->ProgressFraction * completedModels / str->Models->size(),
+                     str->Debug);
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 int main(int argc, char * argv[])
 {
   PARSE_ARGS;
@@ -86,6 +577,7 @@ int main(int argc, char * argv[])
     std::cout << "Calculate point normals? " << PointNormals << std::endl;
     std::cout << "Pad? " << Pad << std::endl;
     std::cout << "Filter type: " << FilterType << std::endl;
+    std::cout << "Number of threads: " << NumberOfThreads << std::endl;
     std::cout << "Input color hierarchy scene file: "
               << (ModelHierarchyFile.size() > 0 ? ModelHierarchyFile.c_str() : "None")  << std::endl;
     std::cout << "Output model scene file: "
@@ -275,25 +767,11 @@ int main(int argc, char * argv[])
   vtkSmartPointer<vtkWindowedSincPolyDataFilter>    smoother;
   bool                                              makeMultiple = false;
   bool                                              useStartEnd = false;
-  vtkSmartPointer<vtkImageAccumulate>               hist;
   std::vector<int>                                  skippedModels;
   std::vector<int>                                  madeModels;
-  vtkSmartPointer<vtkWindowedSincPolyDataFilter>    smootherSinc;
-  vtkSmartPointer<vtkSmoothPolyDataFilter>          smootherPoly;
 
   vtkSmartPointer<vtkImageConstantPad>        padder;
-  vtkSmartPointer<vtkDecimatePro>             decimator;
-  vtkSmartPointer<vtkMarchingCubes>           mcubes;
-  vtkSmartPointer<vtkImageThreshold>          imageThreshold;
-  vtkSmartPointer<vtkThreshold>               threshold;
-  vtkSmartPointer<vtkImageToStructuredPoints> imageToStructuredPoints;
-  vtkSmartPointer<vtkGeometryFilter>          geometryFilter;
   vtkSmartPointer<vtkTransform>               transformIJKtoRAS;
-  vtkSmartPointer<vtkReverseSense>            reverser;
-  vtkSmartPointer<vtkTransformPolyDataFilter> transformer;
-  vtkSmartPointer<vtkPolyDataNormals>         normals;
-  vtkSmartPointer<vtkStripper>                stripper;
-  vtkSmartPointer<vtkPolyDataWriter>          writer;
 
   // keep track of number of models that will be generated, for filter
   // watcher reporting
@@ -347,17 +825,13 @@ int main(int argc, char * argv[])
     useStartEnd = true;
     }
 
+  // reading the volume and finding its labels, plus marching cubes and
+  // smoothing of all the labels at once when joint smoothing
+  numSingletonFilterSteps = (JointSmoothing ? 4 : 2);
+  // generating and writing each model
+  numRepeatedFilterSteps = 2;
   if (makeMultiple)
     {
-    numSingletonFilterSteps = 4;
-    if (JointSmoothing)
-      {
-      numRepeatedFilterSteps = 7;
-      }
-    else
-      {
-      numRepeatedFilterSteps = 9;
-      }
     if (useStartEnd)
       {
       numModelsToGenerate = EndLabel - StartLabel + 1;
@@ -366,7 +840,7 @@ int main(int argc, char * argv[])
       {
       if (GenerateAll)
         {
-        // this will be calculated later from the histogram output
+        // this will be calculated later from the labels found in the volume
         }
       else
         {
@@ -374,23 +848,7 @@ int main(int argc, char * argv[])
         }
       }
     }
-  else
-    {
-    numSingletonFilterSteps = 1;
-    numRepeatedFilterSteps = 9;
-    }
   numFilterSteps = numSingletonFilterSteps + (numRepeatedFilterSteps * numModelsToGenerate);
-  if (SaveIntermediateModels)
-    {
-    if (JointSmoothing)
-      {
-      numFilterSteps += numModelsToGenerate;
-      }
-    else
-      {
-      numFilterSteps += 3 * numModelsToGenerate;
-      }
-    }
 
   if (debug)
     {
@@ -509,310 +967,72 @@ int main(int argc, char * argv[])
   modelScene->AddNode(dnd.GetPointer());
   rtnd->SetAndObserveDisplayNodeID(dnd->GetID());
 
-  // If making mulitple models, figure out which labels have voxels
+  // Find the labels that have voxels and their bounding boxes, in a single
+  // pass over the volume. Only the bounding box of each label is processed
+  // when generating its model.
+  LabelExtentMap labelExtents;
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(ComputeLabelExtents(image, static_cast<VTK_TT*>(image->GetScalarPointer()), labelExtents));
+    default:
+      std::cerr << "ERROR: unsupported scalar type " << image->GetScalarTypeAsString() << std::endl;
+      return EXIT_FAILURE;
+    }
+  currentFilterOffset += 1.0;
+  if (debug)
+    {
+    std::cout << "Found " << labelExtents.size() << " distinct voxel values in the volume" << endl;
+    }
+
   if (makeMultiple)
     {
-    hist = vtkSmartPointer<vtkImageAccumulate>::New();
-    hist->SetInputData(image);
-    // need to figure out how many bins
-    int extentMax = 0;
-    if (useColorNode)
-      {
-      // get the max integer that the colour node can map
-      extentMax = colorNode->GetNumberOfColors() - 1;
-      if (debug)
-        {
-        std::cout << "Using color node to get max label" << endl;
-        }
-      }
-    else
+    if (GenerateAll)
       {
-      // use the full range of the scalar type
-      double dImageScalarMax = image->GetScalarTypeMax();
-      if (debug)
+      // all the labels of the volume, skipping 0 and negative values
+      LabelExtentMap::iterator firstLabel = labelExtents.upper_bound(0);
+      if (firstLabel != labelExtents.end())
         {
-        std::cout << "Image scalar max as double = " << dImageScalarMax << endl;
-        }
-      extentMax = (int)(floor(dImageScalarMax - 1.0));
-      int biggestBin = 1000000;     // VTK_INT_MAX - 1;
-      if (extentMax < 0 || extentMax > biggestBin)
-        {
-        std::cout << "\nWARNING: due to lack of color label information and an image with a scalar maximum of "
-                  << dImageScalarMax << ", using  " << biggestBin << " as the histogram number of bins" << endl;
-        extentMax = biggestBin;
+        StartLabel = firstLabel->first;
+        EndLabel = labelExtents.rbegin()->first;
         }
       else
         {
-        std::cout
-        <<
-        "\nWARNING: due to lack of color label information, using the full scalar range of the input image when calculating the histogram over the image: "
-        << extentMax << endl;
-        }
-      }
-    if (debug)
-      {
-      std::cout << "Setting histogram extentMax = " << extentMax << endl;
-      }
-    // hist->SetComponentExtent(0, 1023, 0, 0, 0, 0);
-    hist->SetComponentExtent(0, extentMax, 0, 0, 0, 0);
-    hist->SetComponentOrigin(0, 0, 0);
-    hist->SetComponentSpacing(1, 1, 1);
-    // try and update and get the min/max here, as need them for the
-    // marching cubes
-    comment = "Histogram All Models";
-    vtkPluginFilterWatcher watchImageAccumulate(hist,
-                                                comment.c_str(),
-                                                CLPProcessInformation,
-                                                1.0 / numFilterSteps,
-                                                currentFilterOffset / numFilterSteps);
-    currentFilterOffset += 1.0;
-    if (debug)
-      {
-      watchImageAccumulate.QuietOn();
-      }
-    hist->Update();
-    double *max = hist->GetMax();
-    double *min = hist->GetMin();
-    if (min[0] == 0)
-      {
-      if (debug)
-        {
-        std::cout << "Skipping 0" << endl;
-        }
-      min[0]++;
-      }
-    if (min[0] < 0)
-      {
-      if (debug)
-        {
-        std::cout << "Histogram min was less than zero: " << min[0] << ", resetting to 1\n";
-        }
-      min[0] = 1;
-      }
-
-    if (debug)
-      {
-      std::cout << "Hist: Min = " << min[0] << " and max = " << max[0] << " (image scalar type = "
-                << image->GetScalarType() << ", max = " << image->GetScalarTypeMax() << ")" << endl;
-      }
-    if (GenerateAll)
-      {
-      if (debug)
-        {
-        std::cout << "GenerateAll flag is true, resetting the start and end labels from: " << StartLabel << " and "
-                  << EndLabel << " to " << min[0] << " and " << max[0] << endl;
+        StartLabel = 1;
+        EndLabel = 0;
         }
-      StartLabel = (int)floor(min[0]);
-      EndLabel = (int)floor(max[0]);
       useStartEnd = true;
-      // recalculate the number of filter steps, discount the labels with no
-      // voxels
-      numModelsToGenerate = 0;
-      for(int i = StartLabel; i <= EndLabel; i++)
-        {
-        if ((int)floor((((hist->GetOutput())->GetPointData())->GetScalars())->GetTuple1(i)) > 0)
-          {
-          if (debug && i < 0 && i > -100)
-            {
-            std::cout << i << " ";
-            }
-          numModelsToGenerate++;
-          }
-        }
+      numModelsToGenerate = static_cast<float>(std::distance(firstLabel, labelExtents.end()));
       if (debug)
         {
-        std::cout << endl << "GenerateAll: there are " << numModelsToGenerate << " models to be generated." << endl;
+        std::cout << "GenerateAll flag is true, reset the start and end labels to " << StartLabel << " and "
+                  << EndLabel << ", there are " << numModelsToGenerate << " models to be generated." << endl;
         }
       numFilterSteps = numSingletonFilterSteps + (numRepeatedFilterSteps * numModelsToGenerate);
-      if (SaveIntermediateModels)
-        {
-        if (JointSmoothing)
-          {
-          // save after decimation
-          numFilterSteps += 1 * numModelsToGenerate;
-          }
-        else
-          {
-          // if not doing joint smoothing, save after marching cubes and
-          // smoothing as well as decimation
-          numFilterSteps += 3 * numModelsToGenerate;
-          }
-        }
       if (debug)
         {
         std::cout << "Reset numFilterSteps to " << numFilterSteps << endl;
         }
       }
 
-    if (cubes)
-      {
-      cubes->SetInputData(NULL);
-      cubes = NULL;
-      }
-    cubes = vtkSmartPointer<vtkDiscreteMarchingCubes>::New();
-    std::string            comment1 = "Discrete Marching Cubes";
-    vtkPluginFilterWatcher watchDMCubes(cubes,
-                                        comment1.c_str(),
-                                        CLPProcessInformation,
-                                        1.0 / numFilterSteps,
-                                        currentFilterOffset / numFilterSteps);
-    if (debug)
-      {
-      watchDMCubes.QuietOn();
-      }
-    currentFilterOffset += 1.0;
-    // add padding if flag is set
-    if (Pad)
-      {
-      cubes->SetInputConnection(padder->GetOutputPort());
-      }
-    else
-      {
-      cubes->SetInputData(image);
-      }
-    if (useStartEnd)
+    if (useColorNode)
       {
-      if (debug)
+      // but if we didn't get a named color node, try to guess
+      if (colorNode == NULL)
         {
-        std::cout << "Marching cubes: Using end label = " << EndLabel << ", start label = " << StartLabel << endl;
+        std::cerr << "ERROR: must have a color node! Should be associated with the input label map volume.\n";
+        return EXIT_FAILURE;
         }
-      cubes->GenerateValues((EndLabel - StartLabel + 1), StartLabel, EndLabel);
       }
-    else
-      {
-      if (debug)
-        {
-        std::cout << "Marching cubes: Using max = " << labelsMax << ", min = " << labelsMin << endl;
-        }
-      cubes->GenerateValues((labelsMax - labelsMin + 1), labelsMin, labelsMax);
-      }
-    try
-      {
-      cubes->Update();
-      }
-    catch(...)
-      {
-      std::cerr << "ERROR while updating marching cubes filter." << std::endl;
-      return EXIT_FAILURE;
-      }
-    if (JointSmoothing)
-      {
-      float passBand = 0.001;
-      if (smoother)
-        {
-        smoother->SetInputData(NULL);
-        smoother = NULL;
-        }
-      smoother = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-      std::stringstream stream;
-      stream << "Joint Smooth All Models (";
-      stream << numModelsToGenerate;
-      stream << " to process)";
-      std::string            comment2 = stream.str();
-      vtkPluginFilterWatcher watchSmoother(smoother,
-                                           comment2.c_str(),
-                                           CLPProcessInformation,
-                                           1.0 / numFilterSteps,
-                                           currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchSmoother.QuietOn();
-        }
-      cubes->ReleaseDataFlagOn();
-      smoother->SetInputConnection(cubes->GetOutputPort());
-      smoother->SetNumberOfIterations(Smooth);
-      smoother->BoundarySmoothingOff();
-      smoother->FeatureEdgeSmoothingOff();
-      smoother->SetFeatureAngle(120.0l);
-      smoother->SetPassBand(passBand);
-      smoother->NonManifoldSmoothingOn();
-      smoother->NormalizeCoordinatesOn();
-
-      try
-        {
-        smoother->Update();
-        }
-      catch(...)
-        {
-        std::cerr << "ERROR while updating smoothing filter." << std::endl;
-        return EXIT_FAILURE;
-        }
-      //        smoother->ReleaseDataFlagOn();
-      }
-/*
-      vtkPluginFilterWatcher watchImageAccumulate(hist,
-                                                 "Histogram All Models",
-                                                 CLPProcessInformation,
-                                                 1.0/numFilterSteps,
-                                                 currentFilterOffset/numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchImageAccumulate.QuietOn();
-        }
-      hist->Update();
-      double *max = hist->GetMax();
-      double *min = hist->GetMin();
-      if (min[0] == 0)
-        {
-        if (debug)
-          {
-          std::cout << "Skipping 0" << endl;
-          }
-        min[0]++;
-        }
-       if (debug)
-         {
-         std::cout << "Min = " << min[0] << " and max = " << max[0] << endl;
-         }
-
-      if (GenerateAll)
-        {
-        if (debug)
-          {
-          std::cout << "GenerateAll flag is true, resetting the start and end labels from: " << StartLabel << " and " << EndLabel << " to " << min[0] << " and " << max[0] << endl;
-          }
-        StartLabel = (int)floor(min[0]);
-        EndLabel = (int)floor(max[0]);
-        // recalculate the number of filter steps, discount the labels with no
-        // voxels
-        numModelsToGenerate = 0;
-        for (int i = StartLabel; i <= EndLabel; i++)
-          {
-          if((int)floor((((hist->GetOutput())->GetPointData())->GetScalars())->GetTuple1(i)) > 0)
-            {
-            if (debug && i < 0 && i > -100) { std::cout << i << " "; }
-            numModelsToGenerate++;
-            }
-          }
-        if (debug)
-          {
-          std::cout << endl << "GenerateAll: there are " << numModelsToGenerate << " models to be generated." << endl;
-          }
-        numFilterSteps = numSingletonFilterSteps + (numRepeatedFilterSteps * numModelsToGenerate);
-        }
-*/
-    if (useColorNode)
-      {
-      // but if we didn't get a named color node, try to guess
-      if (colorNode == NULL)
-        {
-        std::cerr << "ERROR: must have a color node! Should be associated with the input label map volume.\n";
-        return EXIT_FAILURE;
-        }
-      }
-    }   // end of make multiple
-  else
-    {
-    if (useStartEnd)
+    }   // end of make multiple
+  else
+    {
+    if (useStartEnd)
       {
       EndLabel = StartLabel;
       }
     }
 
   // ModelMakerMarch
-  double      labelFrequency = 0.0;;
   std::string labelName;
 
   // get the dimensions, marching cubes only works on 3d
@@ -834,20 +1054,15 @@ int main(int argc, char * argv[])
     }
   // Get the RAS to IJK matrix and invert it to get the IJK to RAS which will need
   // to be applied to the model as it will be built in pixel space
-  if (transformIJKtoRAS)
-    {
-    transformIJKtoRAS->SetInput(NULL);
-    transformIJKtoRAS = NULL;
-    }
   transformIJKtoRAS = vtkSmartPointer<vtkTransform>::New();
   transformIJKtoRAS->SetMatrix(reader->GetRasToIjkMatrix());
-  if (debug)
+  transformIJKtoRAS->Inverse();
+  bool reverseSense = ((transformIJKtoRAS->GetMatrix())->Determinant() < 0);
+  if (debug && reverseSense)
     {
-    // std::cout << "RasToIjk matrix from file = ";
-    // transformIJKtoRAS->GetMatrix()->Print(std::cout);
-    // std::cout << endl;
+    std::cout << "Determinant " << (transformIJKtoRAS->GetMatrix())->Determinant()
+              << " is less than zero, reversing..." << endl;
     }
-  transformIJKtoRAS->Inverse();
 
   //
   // Loop through all the labels
@@ -869,29 +1084,23 @@ int main(int argc, char * argv[])
       loopLabels.push_back(Labels[i]);
       }
     }
+  std::vector<LabelModel> models;
   for(::size_t l = 0; l < loopLabels.size(); l++)
     {
     // get the label out of the vector
     int i = loopLabels[l];
 
+    LabelExtentMap::iterator labelExtent = labelExtents.find(i);
     if (makeMultiple)
       {
-      labelFrequency = (((hist->GetOutput())->GetPointData())->GetScalars())->GetTuple1(i);
-      if (debug)
-        {
-        if (labelFrequency > 0.0)
-          {
-          std::cout << "Label    " << i << " has " << labelFrequency << " voxels." << endl;
-          }
-        }
-      if (labelFrequency == 0.0)
+      if (labelExtent == labelExtents.end())
         {
         skippedModels.push_back(i);
         continue;
         }
-      else
+      if (debug)
         {
-        madeModels.push_back(i);
+        std::cout << "Label    " << i << " has " << labelExtent->second.NumberOfVoxels << " voxels." << endl;
         }
 
       // name this model
@@ -922,7 +1131,6 @@ int main(int argc, char * argv[])
                         << ", skipping.\n";
               }
             skippedModels.push_back(i);
-            madeModels.pop_back();
             continue;
             }
           }
@@ -935,7 +1143,6 @@ int main(int argc, char * argv[])
               std::cout << "Null color name for " << i << endl;
               }
             skippedModels.push_back(i);
-            madeModels.pop_back();
             continue;
             }
           else
@@ -961,766 +1168,295 @@ int main(int argc, char * argv[])
       {
       // just make one
       labelName = Name;
-      /*
-      if (colorNode != NULL)
-        {
-        if (colorNode->GetColorNameAsFileName(i).c_str() != NULL)
-          {
-          std::stringstream    stream;
-          stream <<    i;
-          std::string stringI =    stream.str();
-          labelName = Name + std::string("_") + stringI + std::string("_") + std::string(colorNode->GetColorNameAsFileName(i));
-          }
-        }
-      else
+      if (labelExtent == labelExtents.end())
         {
-        labelName = Name;
+        std::cout << "Cannot create a model from label " << i
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        std::cout << "...continuing" << endl;
+        continue;
         }
-      */
       }
 
-    // threshold
-    if (JointSmoothing == 0)
+    LabelModel model;
+    model.Label = i;
+    model.Name = labelName;
+    std::copy(labelExtent->second.Extent, labelExtent->second.Extent + 6, model.Extent);
+    if (rootDir != "")
       {
-      if (imageThreshold)
-        {
-        imageThreshold->SetInputData(NULL);
-        imageThreshold->RemoveAllInputs();
-        imageThreshold = NULL;
-        }
-      imageThreshold = vtkSmartPointer<vtkImageThreshold>::New();
-      std::string            comment3 = "Threshold " + labelName;
-      vtkPluginFilterWatcher watchImageThreshold(imageThreshold,
-                                                 comment3.c_str(),
-                                                 CLPProcessInformation,
-                                                 1.0 / numFilterSteps,
-                                                 currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchImageThreshold.QuietOn();
-        }
-      if (Pad)
-        {
-        imageThreshold->SetInputConnection(padder->GetOutputPort());
-        }
-      else
-        {
-        imageThreshold->SetInputData(image);
-        }
-      imageThreshold->SetReplaceIn(1);
-      imageThreshold->SetReplaceOut(1);
-      imageThreshold->SetInValue(200);
-      imageThreshold->SetOutValue(0);
-
-      imageThreshold->ThresholdBetween(i, i);
-      imageThreshold->ReleaseDataFlagOn();
-
-      if (imageToStructuredPoints)
-        {
-        imageToStructuredPoints->SetInputData(NULL);
-        imageToStructuredPoints = NULL;
-        }
-      imageToStructuredPoints = vtkSmartPointer<vtkImageToStructuredPoints>::New();
-      imageToStructuredPoints->SetInputConnection(imageThreshold->GetOutputPort());
-      try
-        {
-        imageToStructuredPoints->Update();
-        }
-      catch(...)
-        {
-        std::cerr << "ERROR while updating image to structured points for label " << i << std::endl;
-        return EXIT_FAILURE;
-        }
-      imageToStructuredPoints->ReleaseDataFlagOn();
+      model.FileName = rootDir + std::string("/") + labelName + std::string(".vtk");
       }
     else
       {
-      // use the output of the smoother
-      if (threshold)
-        {
-        threshold->SetInputData(NULL);
-        threshold = NULL;
-        }
-      threshold = vtkSmartPointer<vtkThreshold>::New();
-      std::string            comment4 = "Threshold " + labelName;
-      vtkPluginFilterWatcher watchThreshold(threshold,
-                                            comment4.c_str(),
-                                            CLPProcessInformation,
-                                            1.0 / numFilterSteps,
-                                            currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchThreshold.QuietOn();
-        }
-      if (smoother == NULL)
-        {
-        std::cerr << "\nERROR smoothing filter is null for joint smoothing!" << std::endl;
-        return EXIT_FAILURE;
-        }
-      threshold->SetInputConnection(smoother->GetOutputPort());
-      // In VTK 5.0, this is deprecated - the default behaviour seems to
-      // be okay
-      // threshold->SetAttributeModeToUseCellData();
+      std::cout << "WARNING: output directory is an empty string..." << endl;
+      model.FileName = labelName + std::string(".vtk");
+      }
+    model.Generated = false;
+    model.Failed = false;
+    models.push_back(model);
+    }
 
-      threshold->ThresholdBetween(i, i);
-      threshold->ReleaseDataFlagOn();
+  if (JointSmoothing && !models.empty())
+    {
+    // Extract the surfaces of all the labels at once, as a single surface
+    // with the labels as cell scalars, and smooth them together
+    cubes = vtkSmartPointer<vtkDiscreteMarchingCubes>::New();
+    std::string            comment1 = "Discrete Marching Cubes";
+    vtkPluginFilterWatcher watchDMCubes(cubes,
+                                        comment1.c_str(),
+                                        CLPProcessInformation,
+                                        1.0 / numFilterSteps,
+                                        currentFilterOffset / numFilterSteps);
+    if (debug)
+      {
+      watchDMCubes.QuietOn();
+      }
+    currentFilterOffset += 1.0;
+    // add padding if flag is set
+    if (Pad)
+      {
+      cubes->SetInputConnection(padder->GetOutputPort());
+      }
+    else
+      {
+      cubes->SetInputData(image);
+      }
+    // only the labels that have a model to generate
+    cubes->SetNumberOfContours(static_cast<int>(models.size()));
+    for (::size_t m = 0; m < models.size(); m++)
+      {
+      cubes->SetValue(static_cast<int>(m), models[m].Label);
+      }
+    try
+      {
+      cubes->Update();
+      }
+    catch(...)
+      {
+      std::cerr << "ERROR while updating marching cubes filter." << std::endl;
+      return EXIT_FAILURE;
+      }
 
-      if (geometryFilter)
-        {
-        geometryFilter->SetInputData(NULL);
-        geometryFilter = NULL;
-        }
-      geometryFilter = vtkSmartPointer<vtkGeometryFilter>::New();
-      geometryFilter->SetInputConnection(threshold->GetOutputPort());
-      geometryFilter->ReleaseDataFlagOn();
+    float passBand = 0.001;
+    smoother = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+    std::stringstream stream;
+    stream << "Joint Smooth All Models (";
+    stream << models.size();
+    stream << " to process)";
+    std::string            comment2 = stream.str();
+    vtkPluginFilterWatcher watchSmoother(smoother,
+                                         comment2.c_str(),
+                                         CLPProcessInformation,
+                                         1.0 / numFilterSteps,
+                                         currentFilterOffset / numFilterSteps);
+    currentFilterOffset += 1.0;
+    if (debug)
+      {
+      watchSmoother.QuietOn();
       }
+    cubes->ReleaseDataFlagOn();
+    smoother->SetInputConnection(cubes->GetOutputPort());
+    smoother->SetNumberOfIterations(Smooth);
+    smoother->BoundarySmoothingOff();
+    smoother->FeatureEdgeSmoothingOff();
+    smoother->SetFeatureAngle(120.0l);
+    smoother->SetPassBand(passBand);
+    smoother->NonManifoldSmoothingOn();
+    smoother->NormalizeCoordinatesOn();
 
-    // if not joint smoothing, may need to skip this label
-    int skipLabel = 0;
-    if (JointSmoothing == 0)
+    try
       {
-      if (mcubes)
-        {
-        mcubes->SetInputData(NULL);
-        mcubes = NULL;
-        }
-      mcubes = vtkSmartPointer<vtkMarchingCubes>::New();
-      std::string            comment5 = "Marching Cubes " + labelName;
-      vtkPluginFilterWatcher watchThreshold(mcubes,
-                                            comment5.c_str(),
-                                            CLPProcessInformation,
-                                            1.0 / numFilterSteps,
-                                            currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchThreshold.QuietOn();
-        }
-      mcubes->SetInputConnection(imageToStructuredPoints->GetOutputPort());
-      mcubes->SetValue(0, 100.5);
-      mcubes->ComputeScalarsOff();
-      mcubes->ComputeGradientsOff();
-      mcubes->ComputeNormalsOff();
-      mcubes->ReleaseDataFlagOn();
-      try
-        {
-        mcubes->Update();
-        }
-      catch(...)
-        {
-        std::cerr << "ERROR while running marching cubes, for label " << i << std::endl;
-        return EXIT_FAILURE;
-        }
-      if (debug)
-        {
-        std::cout << "\nNumber of polygons = " << (mcubes->GetOutput())->GetNumberOfPolys() << endl;
-        }
+      smoother->Update();
+      }
+    catch(...)
+      {
+      std::cerr << "ERROR while updating smoothing filter." << std::endl;
+      return EXIT_FAILURE;
+      }
 
-      if ((mcubes->GetOutput())->GetNumberOfPolys()  == 0)
-        {
-        std::cout << "Cannot create a model from label " << i
-                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
-        if (transformIJKtoRAS)
-          {
-          transformIJKtoRAS = NULL;
-          }
-        if (imageThreshold)
-          {
-          if (debug)
-            {
-            std::cout << "Setting image threshold input to null" << endl;
-            }
-          imageThreshold->SetInputData(NULL);
-          imageThreshold->RemoveAllInputs();
-          imageThreshold = NULL;
+    SplitSurfaceByLabel(smoother->GetOutput(), models);
+    smoother->SetInputData(NULL);
+    smoother = NULL;
+    cubes->SetInputData(NULL);
+    cubes = NULL;
+    }
 
-          }
-        if (imageToStructuredPoints)
-          {
-          imageToStructuredPoints->SetInputData(NULL);
-          imageToStructuredPoints = NULL;
-          }
-        if (mcubes)
-          {
-          mcubes->SetInputData(NULL);
-          mcubes = NULL;
-          }
-        skipLabel = 1;
-        std::cout << "...continuing" << endl;
-        continue;
-        }
-      if (SaveIntermediateModels)
-        {
-        writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-        std::string            commentSaveCubes = "Writing intermediate model after marching cubes " + labelName;
-        vtkPluginFilterWatcher watchWriter(writer,
-                                           commentSaveCubes.c_str(),
-                                           CLPProcessInformation,
-                                           1.0 / numFilterSteps,
-                                           currentFilterOffset / numFilterSteps);
-        currentFilterOffset += 1.0;
-        writer->SetInputConnection(cubes->GetOutputPort());
-        writer->SetFileType(2);
-        std::string fileName;
-        if (rootDir != "")
-          {
-          fileName = rootDir + std::string("/") + labelName + std::string("-MarchingCubes.vtk");
-          }
-        else
-          {
-          fileName = labelName + std::string("-MarchingCubes.vtk");
-          }
-        if (debug)
-          {
-          watchWriter.QuietOn();
-          std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
-          }
-        writer->SetFileName(fileName.c_str());
-        if (!writer->Write())
-          {
-          std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
-          }
-        writer->SetInputData(NULL);
-        writer = NULL;
-        }
+  if (!JointSmoothing && strcmp(FilterType.c_str(), "Sinc") == 0 && Smooth == 1)
+    {
+    std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
+    Smooth = 2;
+    }
+
+  // Generate and write the models in parallel, each thread takes the next
+  // label to process until all the models are written
+  ModelMakerThreadStruct str;
+  str.Models = &models;
+  str.Image = image;
+  str.Pad = Pad;
+  str.JointSmoothing = JointSmoothing;
+  str.SincFilter = (strcmp(FilterType.c_str(), "Sinc") == 0);
+  str.Smooth = Smooth;
+  str.Decimate = Decimate;
+  str.SplitNormals = SplitNormals;
+  str.PointNormals = PointNormals;
+  str.IJKToRAS = transformIJKtoRAS->GetMatrix();
+  str.ReverseSense = reverseSense;
+  str.SaveIntermediateModels = SaveIntermediateModels;
+  str.RootDir = rootDir;
+  str.Debug = debug;
+  str.NextModel = 0;
+  str.CompletedModels = 0;
+  str.ProcessInformation = CLPProcessInformation;
+  str.ProgressStart = currentFilterOffset / numFilterSteps;
+  str.ProgressFraction = numRepeatedFilterSteps * models.size() / numFilterSteps;
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = (NumberOfThreads > 0 ? NumberOfThreads : threader->GetNumberOfThreads());
+  numberOfThreads = std::max(1, std::min(numberOfThreads, static_cast<int>(models.size())));
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(GenerateLabelModelsThread, &str);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  threader->SingleMethodExecute();
+  timer->StopTimer();
+  currentFilterOffset += numRepeatedFilterSteps * models.size();
+  std::cout << "Generated " << models.size() << " models in " << timer->GetElapsedTime()
+            << " seconds using " << threader->GetNumberOfThreads() << " threads" << std::endl;
+
+  for(::size_t m = 0; m < models.size(); m++)
+    {
+    int i = models[m].Label;
+    labelName = models[m].Name;
+    if (models[m].Failed)
+      {
+      std::cerr << "ERROR while generating the model for label " << i << std::endl;
+      return EXIT_FAILURE;
       }
-    else
+    if (!models[m].Generated)
       {
-      std::cout << "Skipping marching cubes..." << endl;
+      std::cout << "Cannot create a model from label " << i
+                << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+      std::cout << "...continuing" << endl;
+      continue;
       }
-    if (!skipLabel)
+    if (makeMultiple)
       {
-      // In switch from vtk 4 to vtk 5, vtkDecimate was deprecated from the Patented dir, use vtkDecimatePro
-      // TODO: look at vtkQuadraticDecimation
-      if (decimator != NULL)
-        {
-        decimator->SetInputData(NULL);
-        decimator = NULL;
-        }
-      decimator = vtkSmartPointer<vtkDecimatePro>::New();
-      std::string            comment6 = "Decimate " + labelName;
-      vtkPluginFilterWatcher watchImageThreshold(decimator,
-                                                 comment6.c_str(),
-                                                 CLPProcessInformation,
-                                                 1.0 / numFilterSteps,
-                                                 currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchImageThreshold.QuietOn();
-        }
-      if (JointSmoothing == 0)
-        {
-        decimator->SetInputConnection(mcubes->GetOutputPort());
-        }
-      else
-        {
-        decimator->SetInputConnection(geometryFilter->GetOutputPort());
-        }
-      decimator->SetFeatureAngle(60);
-      // decimator->SetMaximumIterations(Decimate);
-      // decimator->SetMaximumSubIterations(0);
-
-      // decimator->PreserveEdgesOn();
-      decimator->SplittingOff();
-      decimator->PreserveTopologyOn();
-
-      decimator->SetMaximumError(1);
-      decimator->SetTargetReduction(Decimate);
-      // decimator->SetInitialError(0.0002);
-      // decimator->SetErrorIncrement(0.002);
-      decimator->ReleaseDataFlagOff();
+      madeModels.push_back(i);
+      }
 
-      try
-        {
-        decimator->Update();
-        }
-      catch(...)
-        {
-        std::cerr << "ERROR decimating model " << i << std::endl;
-        return EXIT_FAILURE;
-        }
+    std::string fileName = models[m].FileName;
+    if (modelScene.GetPointer() != NULL)
+      {
       if (debug)
         {
-        std::cout << "After decimation, number of polygons = " << (decimator->GetOutput())->GetNumberOfPolys() << endl;
+        std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
+                  << endl;
         }
+      // each model needs a mrml node, a storage node and a display node
+      vtkNew<vtkMRMLModelNode> mnode;
+      mnode->SetScene(modelScene.GetPointer());
+      mnode->SetName(labelName.c_str());
 
-      if (SaveIntermediateModels)
+      vtkNew<vtkMRMLModelStorageNode> snode;
+      snode->SetFileName(fileName.c_str());
+      if (modelScene->AddNode(snode.GetPointer()) == NULL)
         {
-        writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-        std::string            commentSaveDecimation = "Writing intermediate model after decimation " + labelName;
-        vtkPluginFilterWatcher watchWriter(writer,
-                                           commentSaveDecimation.c_str(),
-                                           CLPProcessInformation,
-                                           1.0 / numFilterSteps,
-                                           currentFilterOffset / numFilterSteps);
-        currentFilterOffset += 1.0;
-        writer->SetInputConnection(decimator->GetOutputPort());
-        writer->SetFileType(2);
-        std::string fileName;
-        if (rootDir != "")
-          {
-          fileName = rootDir + std::string("/") + labelName + std::string("-Decimated.vtk");
-          }
-        else
-          {
-          fileName = labelName + std::string("-MarchingCubes.vtk");
-          }
-        if (debug)
-          {
-          watchWriter.QuietOn();
-          std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
-          }
-        writer->SetFileName(fileName.c_str());
-        if (!writer->Write())
-          {
-          std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
-          }
-        writer->SetInputData(NULL);
-        writer = NULL;
-        }
-      if (transformIJKtoRAS == NULL ||
-          transformIJKtoRAS->GetMatrix() == NULL)
-        {
-        std::cout << "transformIJKtoRAS is "
-                  << (transformIJKtoRAS ==
-            NULL ? "null" : "okay") << ", it's matrix is "
-                  << (transformIJKtoRAS->GetMatrix() == NULL ? "null" : "okay") << endl;
-        }
-      else if ((transformIJKtoRAS->GetMatrix())->Determinant() < 0)
-        {
-        if (debug)
-          {
-          std::cout << "Determinant " << (transformIJKtoRAS->GetMatrix())->Determinant()
-                    << " is less than zero, reversing..." << endl;
-          }
-        if (reverser)
-          {
-          reverser->SetInputData(NULL);
-          reverser = NULL;
-          }
-        reverser = vtkSmartPointer<vtkReverseSense>::New();
-        std::string            comment7 = "Reverse " + labelName;
-        vtkPluginFilterWatcher watchReverser(reverser,
-                                             comment7.c_str(),
-                                             CLPProcessInformation,
-                                             1.0 / numFilterSteps,
-                                             currentFilterOffset / numFilterSteps);
-        currentFilterOffset += 1.0;
-        if (debug)
-          {
-          watchReverser.QuietOn();
-          }
-        reverser->SetInputConnection(decimator->GetOutputPort());
-        reverser->ReverseNormalsOn();
-        reverser->ReleaseDataFlagOn();
+        std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
         }
-
-      if (JointSmoothing == 0)
+      vtkNew<vtkMRMLModelDisplayNode> dnode;
+      dnode->SetColor(0.5, 0.5, 0.5);
+      double *rgba;
+      if (colorNode != NULL)
         {
-        if (strcmp(FilterType.c_str(), "Sinc") == 0)
+        rgba = colorNode->GetLookupTable()->GetTableValue(i);
+        if (rgba != NULL)
           {
-
-          if (smootherSinc)
-            {
-            smootherSinc->SetInputData(NULL);
-            smootherSinc = NULL;
-            }
-          smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-          std::string            comment8 = "Smooth " + labelName;
-          vtkPluginFilterWatcher watchSmoother(smootherSinc,
-                                               comment8.c_str(),
-                                               CLPProcessInformation,
-                                               1.0 / numFilterSteps,
-                                               currentFilterOffset / numFilterSteps);
-          currentFilterOffset += 1.0;
           if (debug)
             {
-            watchSmoother.QuietOn();
-            }
-          smootherSinc->SetPassBand(0.1);
-          if (Smooth == 1)
-            {
-            std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
-            Smooth = 2;
-            }
-          if ((transformIJKtoRAS->GetMatrix())->Determinant() < 0)
-            {
-            smootherSinc->SetInputConnection(reverser->GetOutputPort());
-            }
-          else
-            {
-            smootherSinc->SetInputConnection(decimator->GetOutputPort());
-            }
-          smootherSinc->SetNumberOfIterations(Smooth);
-          smootherSinc->FeatureEdgeSmoothingOff();
-          smootherSinc->BoundarySmoothingOff();
-          smootherSinc->ReleaseDataFlagOn();
-          try
-            {
-            smootherSinc->Update();
-            }
-          catch(...)
-            {
-            std::cerr << "ERROR updating Sinc smoother for model " << i << std::endl;
-            return EXIT_FAILURE;
+            std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
             }
+          dnode->SetColor(rgba[0], rgba[1], rgba[2]);
           }
         else
           {
-          if (smootherPoly)
-            {
-            smootherPoly->SetInputData(NULL);
-            smootherPoly = NULL;
-            }
-          smootherPoly = vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
-          std::string            comment9 = "Smooth " + labelName;
-          vtkPluginFilterWatcher watchSmoother(smootherPoly,
-                                               comment9.c_str(),
-                                               CLPProcessInformation,
-                                               1.0 / numFilterSteps,
-                                               currentFilterOffset / numFilterSteps);
-          currentFilterOffset += 1.0;
-          if (debug)
-            {
-            watchSmoother.QuietOn();
-            }
-
-          // this next line massively rounds corners
-          smootherPoly->SetRelaxationFactor(0.33);
-          smootherPoly->SetFeatureAngle(60);
-          smootherPoly->SetConvergence(0);
-
-          if ((transformIJKtoRAS->GetMatrix())->Determinant() < 0)
-            {
-            smootherPoly->SetInputConnection(reverser->GetOutputPort());
-            }
-          else
-            {
-            smootherPoly->SetInputConnection(decimator->GetOutputPort());
-            }
-          smootherPoly->SetNumberOfIterations(Smooth);
-          smootherPoly->FeatureEdgeSmoothingOff();
-          smootherPoly->BoundarySmoothingOff();
-          smootherPoly->ReleaseDataFlagOn();
-          try
-            {
-            smootherPoly->Update();
-            }
-          catch(...)
-            {
-            std::cerr << "ERROR updating Poly smoother for model " << i << std::endl;
-            return EXIT_FAILURE;
-            }
-          }
-
-        if (SaveIntermediateModels)
-          {
-          writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-          std::string            commentSaveSmoothed = "Writing intermediate model after smoothing " + labelName;
-          vtkPluginFilterWatcher watchWriter(writer,
-                                             commentSaveSmoothed.c_str(),
-                                             CLPProcessInformation,
-                                             1.0 / numFilterSteps,
-                                             currentFilterOffset / numFilterSteps);
-          currentFilterOffset += 1.0;
-          if (strcmp(FilterType.c_str(), "Sinc") == 0)
-            {
-            writer->SetInputConnection(smootherSinc->GetOutputPort());
-            }
-          else
-            {
-            writer->SetInputConnection(smootherPoly->GetOutputPort());
-            }
-          writer->SetFileType(2);
-          std::string fileName;
-          if (rootDir != "")
-            {
-            fileName = rootDir + std::string("/") + labelName + std::string("-Smoothed.vtk");
-            }
-          else
-            {
-            fileName = labelName + std::string("-Smoothed.vtk");
-            }
-          if (debug)
-            {
-            watchWriter.QuietOn();
-            std::cout << "Writing intermediate file " << fileName.c_str() << std::endl;
-            }
-          writer->SetFileName(fileName.c_str());
-          if (!writer->Write())
-            {
-            std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
-            }
-          writer->SetInputData(NULL);
-          writer = NULL;
+          std::cerr << "Couldn't get look up table value for " << i << ", display node colour is not set (grey)"
+                    << endl;
           }
         }
 
-      if (transformer)
-        {
-        transformer->SetInputData(NULL);
-        transformer = NULL;
-        }
-      transformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      std::string            comment1 = "Transform " + labelName;
-      vtkPluginFilterWatcher watchTransformer(transformer,
-                                              comment1.c_str(),
-                                              CLPProcessInformation,
-                                              1.0 / numFilterSteps,
-                                              currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
+      dnode->SetVisibility(1);
+      modelScene->AddNode(dnode.GetPointer());
       if (debug)
         {
-        watchTransformer.QuietOn();
+        std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
+        std::cout << "Setting model's storage node: id = "
+                  << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
         }
-      if (JointSmoothing == 0)
+      mnode->SetAndObserveStorageNodeID(snode->GetID());
+      mnode->SetAndObserveDisplayNodeID(dnode->GetID());
+      modelScene->AddNode(mnode.GetPointer());
+
+      // put it in the hierarchy, either the flat one by default or
+      // try to find the matching color hierarchy node to make this an
+      // associated node
+      std::string colorName;
+      if (colorNode != NULL)
         {
-        if (strcmp(FilterType.c_str(), "Sinc") == 0)
-          {
-          transformer->SetInputConnection(smootherSinc->GetOutputPort());
-          }
-        else
-          {
-          transformer->SetInputConnection(smootherPoly->GetOutputPort());
-          }
+        colorName = std::string(colorNode->GetColorNameAsFileName(i));
         }
       else
         {
-        if ((transformIJKtoRAS->GetMatrix())->Determinant() < 0)
-          {
-          transformer->SetInputConnection(reverser->GetOutputPort());
-          }
-        else
+        // might be in a testing case where the hierarchy nodes are
+        // numbered (made from the generic colors)
+        std::stringstream ss;
+        ss << i;
+        colorName = ss.str();
+        if (debug)
           {
-          transformer->SetInputConnection(decimator->GetOutputPort());
+          std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
           }
         }
-
-      transformer->SetTransform(transformIJKtoRAS);
-      if (debug)
-        {
-        // transformIJKtoRAS->GetMatrix()->Print(std::cout);
-        }
-
-      transformer->ReleaseDataFlagOn();
-      if (normals)
-        {
-        normals->SetInputData(NULL);
-        normals = NULL;
-        }
-      normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-      std::string            comment2 = "Normals " + labelName;
-      vtkPluginFilterWatcher watchNormals(normals,
-                                          comment2.c_str(),
-                                          CLPProcessInformation,
-                                          1.0 / numFilterSteps,
-                                          currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchNormals.QuietOn();
-        }
-
-      if (PointNormals)
-        {
-        normals->ComputePointNormalsOn();
-        }
-      else
-        {
-        normals->ComputePointNormalsOff();
-        }
-      normals->SetInputConnection(transformer->GetOutputPort());
-      normals->SetFeatureAngle(60);
-      normals->SetSplitting(SplitNormals);
-
-      normals->ReleaseDataFlagOn();
-
-      if (stripper)
-        {
-        stripper->SetInputData(NULL);
-        stripper = NULL;
-        }
-      stripper = vtkSmartPointer<vtkStripper>::New();
-      std::string            comment3 = "Strip " + labelName;
-      vtkPluginFilterWatcher watchStripper(stripper,
-                                           comment3.c_str(),
-                                           CLPProcessInformation,
-                                           1.0 / numFilterSteps,
-                                           currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchStripper.QuietOn();
-        }
-      stripper->SetInputConnection(normals->GetOutputPort());
-      stripper->ReleaseDataFlagOff();
-
-      // the poly data output from the stripper can be set as an input to a
-      // model's polydata
-      try
-        {
-        stripper->Update();
-        }
-      catch(...)
+      vtkMRMLNode *mrmlNode = NULL;
+      if (colorName.compare("") != 0)
         {
-        std::cerr << "ERROR updating stripper for model " << i << std::endl;
-        return EXIT_FAILURE;
-        }
-
-      // but for now we're just going to write it out
-      writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-      std::string            comment4 = "Write " + labelName;
-      vtkPluginFilterWatcher watchWriter(writer,
-                                         comment4.c_str(),
-                                         CLPProcessInformation,
-                                         1.0 / numFilterSteps,
-                                         currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchWriter.QuietOn();
+        mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
         }
-      writer->SetInputConnection(stripper->GetOutputPort());
-      writer->SetFileType(2);
-      std::string fileName;
-      if (rootDir != "")
+      // if there's no color hierarchy, or no color name or the mrml node
+      // named for the color isn't a model hierarchy node, use a flat hierarchy
+      if (topColorHierarchyNode == NULL ||
+          colorName.compare("") == 0 ||
+          mrmlNode == NULL ||
+          strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
         {
-        fileName = rootDir + std::string("/") + labelName + std::string(".vtk");
+        vtkNew<vtkMRMLModelHierarchyNode> mhnd;
+        mhnd->SetHideFromEditors(1);
+        modelScene->AddNode(mhnd.GetPointer());
+        mhnd->SetParentNodeID(rnd->GetID());
+        mhnd->SetModelNodeID(mnode->GetID());
         }
       else
         {
-        std::cout << "WARNING: output directory is an empty string..." << endl;
-        fileName = labelName + std::string(".vtk");
-        }
-      writer->SetFileName(fileName.c_str());
-
-      if (debug)
-        {
-        std::cout << "Writing model " << " " << labelName << " to file " << writer->GetFileName()  << endl;
-        }
-      if (!writer->Write())
-        {
-        std::cerr << "ERROR: Failed to write model file " << fileName.c_str() << std::endl;
-        }
-      writer->SetInputData(NULL);
-      writer = NULL;
-      if (modelScene.GetPointer() != NULL)
-        {
-        if (debug)
-          {
-          std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
-                    << endl;
-          }
-        // each model needs a mrml node, a storage node and a display node
-        vtkNew<vtkMRMLModelNode> mnode;
-        mnode->SetScene(modelScene.GetPointer());
-        mnode->SetName(labelName.c_str());
-
-        vtkNew<vtkMRMLModelStorageNode> snode;
-        snode->SetFileName(fileName.c_str());
-        if (modelScene->AddNode(snode.GetPointer()) == NULL)
-          {
-          std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
-          }
-        vtkNew<vtkMRMLModelDisplayNode> dnode;
-        dnode->SetColor(0.5, 0.5, 0.5);
-        double *rgba;
-        if (colorNode != NULL)
-          {
-          rgba = colorNode->GetLookupTable()->GetTableValue(i);
-          if (rgba != NULL)
-            {
-            if (debug)
-              {
-              std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
-              }
-            dnode->SetColor(rgba[0], rgba[1], rgba[2]);
-            }
-          else
-            {
-            std::cerr << "Couldn't get look up table value for " << i << ", display node colour is not set (grey)"
-                      << endl;
-            }
-          }
-
-        dnode->SetVisibility(1);
-        modelScene->AddNode(dnode.GetPointer());
-        if (debug)
+        // use the template color hierarchy
+        vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
+        if (colorHierarchyNode)
           {
-          std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
-          std::cout << "Setting model's storage node: id = "
-                    << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
-          }
-        mnode->SetAndObserveStorageNodeID(snode->GetID());
-        mnode->SetAndObserveDisplayNodeID(dnode->GetID());
-        modelScene->AddNode(mnode.GetPointer());
-
-        // put it in the hierarchy, either the flat one by default or
-        // try to find the matching color hierarchy node to make this an
-        // associated node
-        std::string colorName;
-        if (colorNode != NULL)
-          {
-          colorName = std::string(colorNode->GetColorNameAsFileName(i));
-          }
-        else
-          {
-          // might be in a testing case where the hierarchy nodes are
-          // numbered (made from the generic colors)
-          std::stringstream ss;
-          ss << i;
-          colorName = ss.str();
+          colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
+          // and hide it so that it doesn't clutter up the tree
+          colorHierarchyNode->SetHideFromEditors(1);
           if (debug)
             {
-            std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
-            }
-          }
-        vtkMRMLNode *mrmlNode = NULL;
-        if (colorName.compare("") != 0)
-          {
-          mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
-          }
-        // if there's no color hierarchy, or no color name or the mrml node
-        // named for the color isn't a model hierarchy node, use a flat hierarchy
-        if (topColorHierarchyNode == NULL ||
-            colorName.compare("") == 0 ||
-            mrmlNode == NULL ||
-            strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
-          {
-          vtkNew<vtkMRMLModelHierarchyNode> mhnd;
-          mhnd->SetHideFromEditors(1);
-          modelScene->AddNode(mhnd.GetPointer());
-          mhnd->SetParentNodeID(rnd->GetID());
-          mhnd->SetModelNodeID(mnode->GetID());
-          }
-        else
-          {
-          // use the template color hierarchy
-          vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
-          if (colorHierarchyNode)
-            {
-            colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
-            // and hide it so that it doesn't clutter up the tree
-            colorHierarchyNode->SetHideFromEditors(1);
-            if (debug)
-              {
-              std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
-              }
+            std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
             }
           }
-        if (debug)
-          {
-          std::cout << "...done adding model to output scene" << endl;
-          }
         }
-      } // end of skipping an empty label
-    }   // end of loop over labels
+      if (debug)
+        {
+        std::cout << "...done adding model to output scene" << endl;
+        }
+      }
+    }   // end of loop over models
   if (debug)
     {
-    std::cout << "End of looping over labels" << endl;
+    std::cout << "End of looping over models" << endl;
     }
   // Report what was done
   if (madeModels.size() > 0)
@@ -1804,114 +1540,10 @@ int main(int argc, char * argv[])
     {
     std::cout << "Cleaning up" << endl;
     }
-  if (cubes)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting cubes" << endl;
-      }
-    cubes->SetInputData(NULL);
-    cubes = NULL;
-    }
   if (colorNode)
     {
     colorNode = NULL;
     }
-  if (smoother)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting smoother" << endl;
-      }
-    smoother->SetInputData(NULL);
-    smoother = NULL;
-    }
-  if (hist)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting hist" << endl;
-      }
-    hist->SetInputData(NULL);
-    hist = NULL;
-    }
-  if (smootherSinc)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting smootherSinc" << endl;
-      }
-    smootherSinc->SetInputData(NULL);
-    smootherSinc = NULL;
-    }
-  if (smootherPoly)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting smoother poly" << endl;
-      }
-    smootherPoly->SetInputData(NULL);
-    smootherPoly = NULL;
-    }
-  if (decimator)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting decimator" << endl;
-      }
-    decimator->SetInputData(NULL);
-    decimator = NULL;
-    }
-  if (mcubes)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting mcubes" << endl;
-      }
-    mcubes->SetInputData(NULL);
-    mcubes = NULL;
-    }
-  if (imageThreshold)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting image threshold" << endl;
-      }
-    imageThreshold->SetInputData(NULL);
-    imageThreshold->RemoveAllInputs();
-    imageThreshold = NULL;
-    if (debug)
-      {
-      std::cout << "... done deleting image threshold" << endl;
-      }
-    }
-  if (threshold)
-    {
-    if (debug)
-      {
-      cout << "Deleting threshold" << endl;
-      }
-    threshold->SetInputData(NULL);
-    threshold = NULL;
-    }
-  if (imageToStructuredPoints)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting image to structured points" << endl;
-      }
-    imageToStructuredPoints->SetInputData(NULL);
-    imageToStructuredPoints = NULL;
-    }
-  if (geometryFilter)
-    {
-    if (debug)
-      {
-      cout << "Deleting geometry filter" << endl;
-      }
-    geometryFilter->SetInputData(NULL);
-    geometryFilter = NULL;
-    }
   if (transformIJKtoRAS)
     {
     if (debug)
@@ -1921,41 +1553,14 @@ int main(int argc, char * argv[])
     transformIJKtoRAS->SetInput(NULL);
     transformIJKtoRAS = NULL;
     }
-  if (reverser)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting reverser" << endl;
-      }
-    reverser->SetInputData(NULL);
-    reverser = NULL;
-    }
-  if (transformer)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting transformer" << endl;
-      }
-    transformer->SetInputData(NULL);
-    transformer = NULL;
-    }
-  if (normals)
-    {
-    if (debug)
-      {
-      std::cout << "Deleting normals" << endl;
-      }
-    normals->SetInputData(NULL);
-    normals = NULL;
-    }
-  if (stripper)
+  if (padder)
     {
     if (debug)
       {
-      std::cout << "Deleting stripper" << endl;
+      std::cout << "Deleting padder" << endl;
       }
-    stripper->SetInputData(NULL);
-    stripper = NULL;
+    padder->SetInputData(NULL);
+    padder = NULL;
     }
   if (ici.GetPointer())
     {
@@ -0,0 +1,112 @@
+// ITK includes
+#include <itkImageFileWriter.h>
+#include <itkImage.h>
+#include <itkFactoryRegistration.h>
+
+// STD includes
+#include <cstdlib>
+#include <fstream>
+
+// Generate a label map with many labels to exercise and time the generation
+// of models: labels are balls laid out on a grid, some of them touching their
+// neighbors, and a color table naming every label.
+int main(int argc, char * * argv)
+{
+  itk::itkFactoryRegistration();
+
+  if( argc < 4 )
+    {
+    std::cerr << argv[0]
+              << " <numberOfLabels> <outputLabelMap> <outputColorTable>"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int numberOfLabels = atoi(argv[1]);
+  if( numberOfLabels < 1 )
+    {
+    std::cerr << "Invalid number of labels: " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int cellSize = 20;
+  int       cellsPerAxis = 1;
+  while( cellsPerAxis * cellsPerAxis * cellsPerAxis < numberOfLabels )
+    {
+    ++cellsPerAxis;
+    }
+
+  typedef itk::Image<short, 3> ImageType;
+
+  ImageType::Pointer  img = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = cellsPerAxis * cellSize;
+  size[1] = cellsPerAxis * cellSize;
+  size[2] = cellsPerAxis * cellSize;
+  img->SetRegions( size );
+  img->Allocate();
+  img->FillBuffer( 0 );
+
+  ImageType::IndexType indx;
+  for( indx[2] = 0; indx[2] < (int)size[2]; indx[2]++ )
+    {
+    for( indx[1] = 0; indx[1] < (int)size[1]; indx[1]++ )
+      {
+      for( indx[0] = 0; indx[0] < (int)size[0]; indx[0]++ )
+        {
+        int cell[3];
+        double distance2 = 0.0;
+        for( int axis = 0; axis < 3; axis++ )
+          {
+          cell[axis] = indx[axis] / cellSize;
+          double d = indx[axis] - (cell[axis] + 0.5) * cellSize;
+          distance2 += d * d;
+          }
+        int label = 1 + cell[0] + cellsPerAxis * (cell[1] + cellsPerAxis * cell[2]);
+        if( label > numberOfLabels )
+          {
+          continue;
+          }
+        // radius 10 and 11 balls touch the balls of the neighbor cells
+        double radius = 8 + label % 4;
+        if( distance2 <= radius * radius )
+          {
+          img->SetPixel(indx, label);
+          }
+        }
+      }
+    }
+
+  typedef itk::ImageFileWriter<ImageType> WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetFileName( argv[2] );
+  writer->SetInput( img );
+  writer->SetUseCompression( true );
+  try
+    {
+    writer->Update();
+    }
+  catch( itk::ExceptionObject & excep )
+    {
+    std::cerr << "Exception caught while writing " << argv[2] << std::endl;
+    std::cerr << excep << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::ofstream colorTable( argv[3] );
+  if( !colorTable.is_open() )
+    {
+    std::cerr << "Cannot write color table " << argv[3] << std::endl;
+    return EXIT_FAILURE;
+    }
+  colorTable << "# Color table file " << argv[3] << std::endl;
+  colorTable << "0 Background 0 0 0 0" << std::endl;
+  for( int label = 1; label <= numberOfLabels; label++ )
+    {
+    colorTable << label << " Label" << label << " "
+               << (label * 67) % 256 << " " << (label * 131) % 256 << " " << (label * 197) % 256
+               << " 255" << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataReader.h>
+
+#include <vtksys/Directory.hxx>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Compare the models generated by two runs of ModelMaker in the same
+// directory, named <baselineName>_* and <testName>_*: every model of a run
+// must have the same number of points and cells and the same bounds in the
+// other run (e.g. generated with one thread and in parallel).
+int ModelMakerCompareModelsTest(int argc, char * argv[])
+{
+  if (argc < 5)
+    {
+    std::cerr << argv[0] << " <directory> <baselineName> <testName> <numberOfModels>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = argv[1];
+  std::string baselinePrefix = std::string(argv[2]) + "_";
+  std::string testPrefix = std::string(argv[3]) + "_";
+  unsigned long expectedNumberOfModels = atol(argv[4]);
+
+  vtksys::Directory files;
+  if (!files.Load(directory.c_str()))
+    {
+    std::cerr << "Failed to list the files of " << directory << std::endl;
+    return EXIT_FAILURE;
+    }
+  unsigned long numberOfModels = 0;
+  for (unsigned long f = 0; f < files.GetNumberOfFiles(); ++f)
+    {
+    std::string baselineFile = files.GetFile(f);
+    if (baselineFile.compare(0, baselinePrefix.size(), baselinePrefix) != 0
+        || baselineFile.size() < 4
+        || baselineFile.compare(baselineFile.size() - 4, 4, ".vtk") != 0)
+      {
+      continue;
+      }
+    ++numberOfModels;
+    std::string testFile = testPrefix + baselineFile.substr(baselinePrefix.size());
+
+    vtkNew<vtkPolyDataReader> baselineReader;
+    baselineReader->SetFileName((directory + "/" + baselineFile).c_str());
+    baselineReader->Update();
+    vtkNew<vtkPolyDataReader> testReader;
+    testReader->SetFileName((directory + "/" + testFile).c_str());
+    testReader->Update();
+    vtkPolyData* baseline = baselineReader->GetOutput();
+    vtkPolyData* test = testReader->GetOutput();
+
+    if (test->GetNumberOfPoints() != baseline->GetNumberOfPoints()
+        || test->GetNumberOfCells() != baseline->GetNumberOfCells())
+      {
+      std::cerr << testFile << " has " << test->GetNumberOfPoints() << " points and "
+                << test->GetNumberOfCells() << " cells, " << baselineFile << " has "
+                << baseline->GetNumberOfPoints() << " points and "
+                << baseline->GetNumberOfCells() << " cells" << std::endl;
+      return EXIT_FAILURE;
+      }
+    double baselineBounds[6];
+    baseline->GetBounds(baselineBounds);
+    double testBounds[6];
+    test->GetBounds(testBounds);
+    for (int i = 0; i < 6; ++i)
+      {
+      if (std::fabs(testBounds[i] - baselineBounds[i]) > 1e-6)
+        {
+        std::cerr << testFile << " bound " << i << " is " << testBounds[i]
+                  << " instead of " << baselineBounds[i] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  if (numberOfModels != expectedNumberOfModels)
+    {
+    std::cerr << "Found " << numberOfModels << " models named " << baselinePrefix << "* in "
+              << directory << ", expected " << expectedNumberOfModels << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -26,10 +26,17 @@
 #include "itkFloodFilledImageFunctionConditionalIterator.h"
 #include "itkImageFileWriter.h"
 #include "itkPluginUtilities.h"
+#include "itkTimeProbe.h"
 #include <itksys/SystemTools.hxx>
 
+// SegmentationCore includes
+#include <vtkClosedSurfaceToBinaryLabelmapConversionRule.h>
+#include <vtkOrientedImageData.h>
+#include <vtkPolyDataToFractionalLabelmapFilter.h>
+
 // VTK includes
 #include <vtkDebugLeaks.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyDataPointSampler.h>
@@ -38,6 +45,7 @@
 #include <vtkVersion.h>
 
 typedef itk::Image<unsigned char, 3> LabelImageType;
+typedef itk::Image<float, 3>         FractionImageType;
 
 LabelImageType::Pointer BinaryErodeFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
 {
@@ -93,80 +101,64 @@ LabelImageType::Pointer BinaryClosingFilter3D( LabelImageType::Pointer & img, un
 }
 
 //
-// Description: A templated procedure to execute the algorithm
-template <class T>
-int DoIt( int argc, char * argv[])
+// Description: Set the geometry of an oriented image data to the one of an ITK image
+template <class TImage>
+void SetOrientedImageDataGeometry( vtkOrientedImageData* imageData, const TImage* image )
 {
-
-  PARSE_ARGS;
-  vtkDebugLeaks::SetExitError(true);
-
-  typedef    T InputPixelType;
-
-  typedef itk::Image<InputPixelType,  3> InputImageType;
-
-  typedef itk::ImageFileReader<InputImageType> ReaderType;
-  typedef itk::ImageFileWriter<LabelImageType> WriterType;
-
-  // Read the input volume
-  typename ReaderType::Pointer reader = ReaderType::New();
-  itk::PluginFilterWatcher watchReader(reader, "Read Input Volume",
-                                       CLPProcessInformation);
-  reader->SetFileName( InputVolume.c_str() );
-  reader->Update();
-
-  // output label map
-  LabelImageType::Pointer label = LabelImageType::New();
-  label->CopyInformation( reader->GetOutput() );
-  label->SetRegions( label->GetLargestPossibleRegion() );
-  label->Allocate();
-  label->FillBuffer( 0 );
-
-  // read the poly data
-  vtkSmartPointer<vtkPolyData> polyData;
-  vtkSmartPointer<vtkPolyDataReader> pdReader;
-  vtkSmartPointer<vtkXMLPolyDataReader> pdxReader;
-
-  // do we have vtk or vtp models?
-  std::string extension = itksys::SystemTools::LowerCase( itksys::SystemTools::GetFilenameLastExtension(surface) );
-  if( extension.empty() )
+  typename TImage::RegionType region = image->GetLargestPossibleRegion();
+  int extent[6];
+  double origin[3];
+  double spacing[3];
+  double directions[3][3];
+  for( int i = 0; i < 3; i++ )
     {
-    std::cerr << "Failed to find an extension for " << surface << std::endl;
-    return EXIT_FAILURE;
+    extent[2 * i] = region.GetIndex()[i];
+    extent[2 * i + 1] = region.GetIndex()[i] + static_cast<int>(region.GetSize()[i]) - 1;
+    origin[i] = image->GetOrigin()[i];
+    spacing[i] = image->GetSpacing()[i];
+    for( int j = 0; j < 3; j++ )
+      {
+      directions[i][j] = image->GetDirection()[i][j];
+      }
     }
+  imageData->SetExtent( extent );
+  imageData->SetOrigin( origin );
+  imageData->SetSpacing( spacing );
+  imageData->SetDirections( directions );
+}
 
-  if( extension == std::string(".vtk") )
-    {
-    pdReader = vtkSmartPointer<vtkPolyDataReader>::New();
-    pdReader->SetFileName(surface.c_str() );
-    pdReader->Update();
-    polyData = pdReader->GetOutput();
-    }
-  else if( extension == std::string(".vtp") )
-    {
-    pdxReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
-    pdxReader->SetFileName(surface.c_str() );
-    pdxReader->Update();
-    polyData = pdxReader->GetOutput();
-    }
-  if( polyData == NULL )
+//
+// Description: Exact voxelization of the closed surface: each slice of the label map
+// is intersected with the surface and the contours are filled scanline by scanline,
+// using the same code as the closed surface to binary labelmap segmentation conversion.
+bool ScanlineRasterization( LabelImageType::Pointer & label, vtkPolyData* polyData, unsigned char labelValue )
+{
+  vtkNew<vtkOrientedImageData> binaryLabelMap;
+  SetOrientedImageDataGeometry( binaryLabelMap.GetPointer(), label.GetPointer() );
+
+  vtkNew<vtkClosedSurfaceToBinaryLabelmapConversionRule> conversionRule;
+  conversionRule->SetUseOutputImageDataGeometry( true );
+  if( !conversionRule->Convert( polyData, binaryLabelMap.GetPointer() ) )
     {
-    std::cerr << "Failed to read surface " << surface << std::endl;
-    return EXIT_FAILURE;
+    return false;
     }
 
-  // LPS vs RAS
-
-  vtkPoints * allPoints = polyData->GetPoints();
-  for( int k = 0; k < allPoints->GetNumberOfPoints(); k++ )
+  const unsigned char* inside = static_cast<unsigned char*>( binaryLabelMap->GetScalarPointer() );
+  unsigned char*       voxel = label->GetBufferPointer();
+  const vtkIdType      numberOfVoxels = binaryLabelMap->GetNumberOfPoints();
+  for( vtkIdType k = 0; k < numberOfVoxels; k++ )
     {
-    double* point = polyData->GetPoint( k );
-    point[0] = -point[0];
-    point[1] = -point[1];
-    allPoints->SetPoint( k, point[0], point[1], point[2] );
+    voxel[k] = ( inside[k] ? labelValue : 0 );
     }
+  return true;
+}
 
-  // do it
+//
+// Description: Approximate voxelization of the surface by sampling points on the surface,
+// closing the resulting shell and flood filling it from the center of gravity of the surface
+void PointSamplerRasterization( LabelImageType::Pointer & label, vtkPolyData* polyData,
+                                double sampleDistance, unsigned char labelValue )
+{
   vtkNew<vtkPolyDataPointSampler> sampler;
 
   sampler->SetInputData( polyData );
@@ -245,6 +237,138 @@ int DoIt( int argc, char * argv[])
       label->SetPixel( i, finalLabel->GetPixel(i) );
       }
     }
+}
+
+//
+// Description: A templated procedure to execute the algorithm
+template <class T>
+int DoIt( int argc, char * argv[])
+{
+
+  PARSE_ARGS;
+  vtkDebugLeaks::SetExitError(true);
+
+  typedef    T InputPixelType;
+
+  typedef itk::Image<InputPixelType,  3> InputImageType;
+
+  typedef itk::ImageFileReader<InputImageType> ReaderType;
+  typedef itk::ImageFileWriter<LabelImageType> WriterType;
+
+  // Read the input volume
+  typename ReaderType::Pointer reader = ReaderType::New();
+  itk::PluginFilterWatcher watchReader(reader, "Read Input Volume",
+                                       CLPProcessInformation);
+  reader->SetFileName( InputVolume.c_str() );
+  reader->Update();
+
+  // output label map
+  LabelImageType::Pointer label = LabelImageType::New();
+  label->CopyInformation( reader->GetOutput() );
+  label->SetRegions( label->GetLargestPossibleRegion() );
+  label->Allocate();
+  label->FillBuffer( 0 );
+
+  // read the poly data
+  vtkSmartPointer<vtkPolyData> polyData;
+  vtkSmartPointer<vtkPolyDataReader> pdReader;
+  vtkSmartPointer<vtkXMLPolyDataReader> pdxReader;
+
+  // do we have vtk or vtp models?
+  std::string extension = itksys::SystemTools::LowerCase( itksys::SystemTools::GetFilenameLastExtension(surface) );
+  if( extension.empty() )
+    {
+    std::cerr << "Failed to find an extension for " << surface << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if( extension == std::string(".vtk") )
+    {
+    pdReader = vtkSmartPointer<vtkPolyDataReader>::New();
+    pdReader->SetFileName(surface.c_str() );
+    pdReader->Update();
+    polyData = pdReader->GetOutput();
+    }
+  else if( extension == std::string(".vtp") )
+    {
+    pdxReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    pdxReader->SetFileName(surface.c_str() );
+    pdxReader->Update();
+    polyData = pdxReader->GetOutput();
+    }
+  if( polyData == NULL )
+    {
+    std::cerr << "Failed to read surface " << surface << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // LPS vs RAS
+
+  vtkPoints * allPoints = polyData->GetPoints();
+  for( int k = 0; k < allPoints->GetNumberOfPoints(); k++ )
+    {
+    double* point = polyData->GetPoint( k );
+    point[0] = -point[0];
+    point[1] = -point[1];
+    allPoints->SetPoint( k, point[0], point[1], point[2] );
+    }
+
+  // do it
+  itk::TimeProbe rasterizationTime;
+  rasterizationTime.Start();
+  if( rasterizationMethod == "PointSampler" )
+    {
+    PointSamplerRasterization( label, polyData, sampleDistance, labelValue );
+    }
+  else if( !ScanlineRasterization( label, polyData, labelValue ) )
+    {
+    std::cerr << "Failed to rasterize surface " << surface << std::endl;
+    return EXIT_FAILURE;
+    }
+  rasterizationTime.Stop();
+  std::cout << rasterizationMethod << " rasterization time: " << rasterizationTime.GetTotal() << " s" << std::endl;
+
+  // partial volume of each voxel inside the surface
+  if( !FractionalVolume.empty() )
+    {
+    vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+    vtkNew<vtkOrientedImageData> geometryImageData;
+    SetOrientedImageDataGeometry( geometryImageData.GetPointer(), label.GetPointer() );
+    geometryImageData->GetImageToWorldMatrix( imageToWorldMatrix.GetPointer() );
+
+    vtkNew<vtkPolyDataToFractionalLabelmapFilter> fractionalLabelmapFilter;
+    fractionalLabelmapFilter->SetInputData( polyData );
+    fractionalLabelmapFilter->SetOutputImageToWorldMatrix( imageToWorldMatrix.GetPointer() );
+    fractionalLabelmapFilter->SetOutputWholeExtent( geometryImageData->GetExtent() );
+    fractionalLabelmapFilter->Update();
+    vtkOrientedImageData* fractionalLabelMap = fractionalLabelmapFilter->GetOutput();
+
+    FractionImageType::Pointer fraction = FractionImageType::New();
+    fraction->CopyInformation( label );
+    fraction->SetRegions( label->GetLargestPossibleRegion() );
+    fraction->Allocate();
+
+    // the filter samples each voxel with its default 6x6x6 offsets, each inside
+    // sample adds one step so that the sum spans FRACTIONAL_MIN to FRACTIONAL_MAX
+    const FRACTIONAL_DATA_TYPE* fractionalVoxel =
+      static_cast<FRACTIONAL_DATA_TYPE*>( fractionalLabelMap->GetScalarPointer() );
+    float*          fractionVoxel = fraction->GetBufferPointer();
+    const vtkIdType numberOfVoxels = fractionalLabelMap->GetNumberOfPoints();
+    for( vtkIdType k = 0; k < numberOfVoxels; k++ )
+      {
+      fractionVoxel[k] = static_cast<float>( fractionalVoxel[k] - FRACTIONAL_MIN ) / ( FRACTIONAL_MAX - FRACTIONAL_MIN );
+      }
+
+    typedef itk::ImageFileWriter<FractionImageType> FractionWriterType;
+    FractionWriterType::Pointer fractionWriter = FractionWriterType::New();
+    itk::PluginFilterWatcher watchFractionWriter(fractionWriter,
+                                                 "Write Fractional Volume",
+                                                 CLPProcessInformation);
+    fractionWriter->SetFileName( FractionalVolume.c_str() );
+    fractionWriter->SetInput( fraction );
+    fractionWriter->SetUseCompression(1);
+    fractionWriter->Update();
+    }
 
   typename WriterType::Pointer writer = WriterType::New();
   itk::PluginFilterWatcher watchWriter(writer,
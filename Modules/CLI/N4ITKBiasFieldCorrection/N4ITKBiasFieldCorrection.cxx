@@ -1,19 +1,25 @@
 #include "itkConstantPadImageFilter.h"
-#include "itkExtractImageFilter.h"
+#include "itkImageDuplicator.h"
 #include "itkImageFileWriter.h"
-#include "itkN4BiasFieldCorrectionImageFilter.h"
 #include "itkOtsuThresholdImageFilter.h"
 #include "itkShrinkImageFilter.h"
 
 #include "N4ITKBiasFieldCorrectionCLP.h"
+#include "N4ITKBiasFieldReconstruction.h"
 #include "itkPluginUtilities.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace
 {
 
-typedef float RealType;
-const int ImageDimension = 3;
-typedef itk::Image<RealType, ImageDimension> ImageType;
+typedef N4ITK::RealType      RealType;
+typedef N4ITK::ImageType     ImageType;
+typedef N4ITK::MaskImageType MaskImageType;
+typedef N4ITK::CorrecterType CorrecterType;
+typedef N4ITK::LatticeType   LatticeType;
+const int ImageDimension = N4ITK::ImageDimension;
 
 template <class TFilter>
 class CommandIterationUpdate : public itk::Command
@@ -60,6 +66,24 @@ int SaveIt(ImageType::Pointer img, const char* fname)
   return EXIT_SUCCESS;
 }
 
+// Divide an image by the exponential of a log bias field
+ImageType::Pointer CorrectImage( ImageType * image, ImageType * logBiasField, ImageType::Pointer & biasField )
+{
+  typedef itk::ExpImageFilter<ImageType, ImageType> ExpFilterType;
+  ExpFilterType::Pointer expFilter = ExpFilterType::New();
+  expFilter->SetInput( logBiasField );
+  expFilter->Update();
+  biasField = expFilter->GetOutput();
+
+  typedef itk::DivideImageFilter<ImageType, ImageType, ImageType> DividerType;
+  DividerType::Pointer divider = DividerType::New();
+  divider->SetInput1( image );
+  divider->SetInput2( biasField );
+  divider->Update();
+
+  return divider->GetOutput();
+}
+
 };
 
 int main(int argc, char* * argv)
@@ -67,12 +91,15 @@ int main(int argc, char* * argv)
 
   PARSE_ARGS;
 
+  if( numberOfThreads )
+    {
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads( numberOfThreads );
+    }
+
   ImageType::Pointer inputImage = NULL;
 
-  typedef itk::Image<unsigned char, ImageDimension> MaskImageType;
   MaskImageType::Pointer maskImage = NULL;
 
-  typedef    itk::N4BiasFieldCorrectionImageFilter<ImageType, MaskImageType, ImageType> CorrecterType;
   CorrecterType::Pointer correcter = CorrecterType::New();
 
   typedef itk::ImageFileReader<ImageType> ReaderType;
@@ -81,6 +108,7 @@ int main(int argc, char* * argv)
   reader->SetFileName( inputImageName.c_str() );
   reader->Update();
   inputImage = reader->GetOutput();
+  ImageType::Pointer originalInputImage = inputImage;
 
   /**
    * handle he mask image
@@ -165,11 +193,6 @@ int main(int argc, char* * argv)
    * he user wans o specify hings in erms of he spline disance.
    */
 
-  ImageType::IndexType inputImageIndex =
-    inputImage->GetLargestPossibleRegion().GetIndex();
-  ImageType::SizeType inputImageSize =
-    inputImage->GetLargestPossibleRegion().GetSize();
-
   ImageType::PointType newOrigin = inputImage->GetOrigin();
 
   if( bsplineOrder )
@@ -239,37 +262,6 @@ int main(int argc, char* * argv)
     correcter->SetNumberOfControlPoints( numberOfControlPoints );
     }
 
-  typedef itk::ShrinkImageFilter<ImageType, ImageType> ShrinkerType;
-  ShrinkerType::Pointer shrinker = ShrinkerType::New();
-  shrinker->SetInput( inputImage );
-  shrinker->SetShrinkFactors( 1 );
-
-  typedef itk::ShrinkImageFilter<MaskImageType, MaskImageType> MaskShrinkerType;
-  MaskShrinkerType::Pointer maskshrinker = MaskShrinkerType::New();
-  maskshrinker->SetInput( maskImage );
-  maskshrinker->SetShrinkFactors( 1 );
-
-  shrinker->SetShrinkFactors( shrinkFactor );
-  maskshrinker->SetShrinkFactors( shrinkFactor );
-  shrinker->Update();
-  maskshrinker->Update();
-
-  itk::TimeProbe timer;
-  timer.Start();
-
-  correcter->SetInput( shrinker->GetOutput() );
-  correcter->SetMaskImage( maskshrinker->GetOutput() );
-  if( weightImage )
-    {
-    typedef itk::ShrinkImageFilter<ImageType, ImageType> WeightShrinkerType;
-    WeightShrinkerType::Pointer weightshrinker = WeightShrinkerType::New();
-    weightshrinker->SetInput( weightImage );
-    weightshrinker->SetShrinkFactors( 1 );
-    weightshrinker->SetShrinkFactors( shrinkFactor );
-    weightshrinker->Update();
-    correcter->SetConfidenceImage( weightshrinker->GetOutput() );
-    }
-
   typedef CommandIterationUpdate<CorrecterType> CommandType;
   CommandType::Pointer observer = CommandType::New();
   correcter->AddObserver( itk::IterationEvent(), observer );
@@ -290,20 +282,119 @@ int main(int argc, char* * argv)
     correcter->SetNumberOfHistogramBins( nHistogramBins );
     }
 
-  try
+  /**
+   * multi-resolution schedule.  Each level fits the residual bias of the
+   * input corrected by the previous levels, so the log bias fields add up.
+   * The control point lattice of a level parameterizes the domain of the
+   * shrunk image it was estimated from: the shrinker moves the origin by
+   * ( factor - 1 ) / 2 voxels and the domain spans ( size / factor - 1 ) *
+   * factor voxels, so each lattice is evaluated over its own domain and the
+   * fields are summed.
+   */
+  std::vector<int> schedule( shrinkFactors.begin(), shrinkFactors.end() );
+  if( schedule.empty() )
     {
-    itk::PluginFilterWatcher watchN4(correcter, "N4 Bias field correction", CLPProcessInformation, 1.0 / 1.0, 0.0);
-    correcter->Update();
+    schedule.push_back( shrinkFactor );
     }
-  catch( itk::ExceptionObject & err )
+  for( size_t s = 0; s < schedule.size(); s++ )
     {
-    std::cerr << err << std::endl;
-    return EXIT_FAILURE;
+    if( schedule[s] < 1 )
+      {
+      std::cerr << "Shrink factors must be greater than 0." << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( s > 0 && schedule[s] >= schedule[s - 1] )
+      {
+      std::cerr << "Shrink factors must be decreasing." << std::endl;
+      return EXIT_FAILURE;
+      }
     }
-  catch( ... )
+
+  itk::TimeProbe timer;
+  timer.Start();
+
+  // The finer levels refine the bias field of the coarser ones, their
+  // number of iterations is scaled down by their shrink factor relative to
+  // the first level
+  const CorrecterType::VariableSizeArrayType maximumNumberOfIterations =
+    correcter->GetMaximumNumberOfIterations();
+
+  std::vector<LatticeType::Pointer> logBiasFieldLattices;
+  std::vector<ImageType::Pointer>   logBiasFieldDomains;
+  for( size_t s = 0; s < schedule.size(); s++ )
     {
-    std::cerr << "Unknown Exception caught." << std::endl;
-    return EXIT_FAILURE;
+    CorrecterType::VariableSizeArrayType levelNumberOfIterations( maximumNumberOfIterations.Size() );
+    for( unsigned int d = 0; d < maximumNumberOfIterations.Size(); d++ )
+      {
+      levelNumberOfIterations[d] = std::max( 1u, maximumNumberOfIterations[d] * schedule[s] / schedule[0] );
+      }
+    correcter->SetMaximumNumberOfIterations( levelNumberOfIterations );
+
+    typedef itk::ShrinkImageFilter<ImageType, ImageType> ShrinkerType;
+    ShrinkerType::Pointer shrinker = ShrinkerType::New();
+    shrinker->SetInput( inputImage );
+    shrinker->SetShrinkFactors( schedule[s] );
+    shrinker->Update();
+
+    typedef itk::ShrinkImageFilter<MaskImageType, MaskImageType> MaskShrinkerType;
+    MaskShrinkerType::Pointer maskshrinker = MaskShrinkerType::New();
+    maskshrinker->SetInput( maskImage );
+    maskshrinker->SetShrinkFactors( schedule[s] );
+    maskshrinker->Update();
+
+    ImageType::Pointer stageInput = shrinker->GetOutput();
+    if( !logBiasFieldLattices.empty() )
+      {
+      ImageType::Pointer stageLogBiasField = N4ITK::EvaluateLogBiasField(
+          logBiasFieldLattices, logBiasFieldDomains, correcter->GetSplineOrder(), stageInput );
+      ImageType::Pointer stageBiasField;
+      stageInput = CorrectImage( stageInput, stageLogBiasField, stageBiasField );
+      }
+
+    correcter->SetInput( stageInput );
+    correcter->SetMaskImage( maskshrinker->GetOutput() );
+    if( weightImage )
+      {
+      typedef itk::ShrinkImageFilter<ImageType, ImageType> WeightShrinkerType;
+      WeightShrinkerType::Pointer weightshrinker = WeightShrinkerType::New();
+      weightshrinker->SetInput( weightImage );
+      weightshrinker->SetShrinkFactors( schedule[s] );
+      weightshrinker->Update();
+      correcter->SetConfidenceImage( weightshrinker->GetOutput() );
+      }
+
+    std::cout << "Shrink factor: " << schedule[s] << ", maximum number of iterations: "
+              << levelNumberOfIterations << std::endl;
+    try
+      {
+      itk::PluginFilterWatcher watchN4(correcter, "N4 Bias field correction", CLPProcessInformation,
+                                       1.0 / schedule.size(), static_cast<double>( s ) / schedule.size() );
+      correcter->Update();
+      }
+    catch( itk::ExceptionObject & err )
+      {
+      std::cerr << err << std::endl;
+      return EXIT_FAILURE;
+      }
+    catch( ... )
+      {
+      std::cerr << "Unknown Exception caught." << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    typedef itk::ImageDuplicator<LatticeType> DuplicatorType;
+    DuplicatorType::Pointer duplicator = DuplicatorType::New();
+    duplicator->SetInputImage( correcter->GetLogBiasFieldControlPointLattice() );
+    duplicator->Update();
+    logBiasFieldLattices.push_back( duplicator->GetOutput() );
+    logBiasFieldDomains.push_back( shrinker->GetOutput() );
+    }
+
+  // A single level keeps its original reconstruction, with the lattice
+  // stretched over the full resolution domain, which the baselines rely on.
+  if( schedule.size() == 1 )
+    {
+    logBiasFieldDomains[0] = inputImage;
     }
 
   correcter->Print( std::cout, 3 );
@@ -314,100 +405,61 @@ int main(int argc, char* * argv)
   /**
    * ouput
    */
-  if( outputImageName != "" )
+  if( outputImageName != "" || outputBiasFieldName != "" || outputLogBiasFieldName != "" )
     {
     /**
-     * Reconsruct the bias field at full image resoluion.  Divide
-     * the original input image by the bias field to get the final
-     * corrected image.
+     * Reconsruct the bias field at full image resoluion, over the original
+     * (unpadded) input image only.  Divide the original input image by the
+     * bias field to get the final corrected image.
      */
-    typedef itk::BSplineControlPointImageFilter<
-      CorrecterType::BiasFieldControlPointLatticeType,
-      CorrecterType::ScalarImageType> BSplinerType;
-    BSplinerType::Pointer bspliner = BSplinerType::New();
-    bspliner->SetInput( correcter->GetLogBiasFieldControlPointLattice() );
-    bspliner->SetSplineOrder( correcter->GetSplineOrder() );
-    bspliner->SetSize( inputImage->GetLargestPossibleRegion().GetSize() );
-    bspliner->SetOrigin( newOrigin );
-    bspliner->SetDirection( inputImage->GetDirection() );
-    bspliner->SetSpacing( inputImage->GetSpacing() );
-    bspliner->Update();
-
-    ImageType::Pointer logField = ImageType::New();
-    logField->SetOrigin( inputImage->GetOrigin() );
-    logField->SetSpacing( inputImage->GetSpacing() );
-    logField->SetRegions( inputImage->GetLargestPossibleRegion() );
-    logField->SetDirection( inputImage->GetDirection() );
-    logField->Allocate();
-
-    itk::ImageRegionIterator<CorrecterType::ScalarImageType> IB(
-      bspliner->GetOutput(),
-      bspliner->GetOutput()->GetLargestPossibleRegion() );
-    itk::ImageRegionIterator<ImageType> IF( logField,
-                                            logField->GetLargestPossibleRegion() );
-    for( IB.GoToBegin(), IF.GoToBegin(); !IB.IsAtEnd(); ++IB, ++IF )
+    itk::TimeProbe reconstructionTimer;
+    reconstructionTimer.Start();
+
+    ImageType::Pointer logField = N4ITK::EvaluateLogBiasField(
+        logBiasFieldLattices, logBiasFieldDomains, correcter->GetSplineOrder(), originalInputImage );
+    ImageType::Pointer biasField;
+    ImageType::Pointer correctedImage = CorrectImage( originalInputImage, logField, biasField );
+
+    reconstructionTimer.Stop();
+    std::cout << "Bias field reconstruction time: " << reconstructionTimer.GetMean() << std::endl;
+
+    if( outputLogBiasFieldName != "" )
       {
-      IF.Set( IB.Get()[0] );
+      SaveIt( logField, outputLogBiasFieldName.c_str() );
       }
 
-    typedef itk::ExpImageFilter<ImageType, ImageType> ExpFilterType;
-    ExpFilterType::Pointer expFilter = ExpFilterType::New();
-    expFilter->SetInput( logField );
-    expFilter->Update();
-
-    typedef itk::DivideImageFilter<ImageType, ImageType, ImageType> DividerType;
-    DividerType::Pointer divider = DividerType::New();
-    divider->SetInput1( inputImage );
-    divider->SetInput2( expFilter->GetOutput() );
-    divider->Update();
-
-    ImageType::RegionType inputRegion;
-    inputRegion.SetIndex( inputImageIndex );
-    inputRegion.SetSize( inputImageSize );
-
-    typedef itk::ExtractImageFilter<ImageType, ImageType> CropperType;
-    CropperType::Pointer cropper = CropperType::New();
-    cropper->SetInput( divider->GetOutput() );
-    cropper->SetExtractionRegion( inputRegion );
-    cropper->SetDirectionCollapseToSubmatrix();
-    cropper->Update();
-
-    CropperType::Pointer biasFieldCropper = CropperType::New();
-    biasFieldCropper->SetInput( expFilter->GetOutput() );
-    biasFieldCropper->SetExtractionRegion( inputRegion );
-    biasFieldCropper->SetDirectionCollapseToSubmatrix();
-    biasFieldCropper->Update();
-
     if( outputBiasFieldName != "" )
       {
       typedef itk::ImageFileWriter<ImageType> WriterType;
       WriterType::Pointer writer = WriterType::New();
       writer->SetFileName( outputBiasFieldName.c_str() );
-      writer->SetInput( biasFieldCropper->GetOutput() );
+      writer->SetInput( biasField );
       writer->SetUseCompression(1);
       writer->Update();
       }
 
-    try
+    if( outputImageName != "" )
       {
+      try
+        {
 
-      itk::ImageIOBase::IOPixelType     pixelType;
-      itk::ImageIOBase::IOComponentType componentType;
+        itk::ImageIOBase::IOPixelType     pixelType;
+        itk::ImageIOBase::IOComponentType componentType;
 
-      itk::GetImageType(inputImageName, pixelType, componentType);
+        itk::GetImageType(inputImageName, pixelType, componentType);
 
-      // This filter handles all types on input, but only produces
-      // signed types
-      const char *fname = outputImageName.c_str();
+        // This filter handles all types on input, but only produces
+        // signed types
+        const char *fname = outputImageName.c_str();
 
-      return SaveIt(cropper->GetOutput(), fname);
-      }
-    catch( itk::ExceptionObject & e )
-      {
-      std::cerr << "Failed to save the data: " << e << std::endl;
-      return EXIT_FAILURE;
+        return SaveIt(correctedImage, fname);
+        }
+      catch( itk::ExceptionObject & e )
+        {
+        std::cerr << "Failed to save the data: " << e << std::endl;
+        return EXIT_FAILURE;
+        }
       }
-
     }
 
   return EXIT_SUCCESS;
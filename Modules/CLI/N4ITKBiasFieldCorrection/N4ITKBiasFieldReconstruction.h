@@ -0,0 +1,225 @@
+#ifndef N4ITKBiasFieldReconstruction_h
+#define N4ITKBiasFieldReconstruction_h
+
+#include "itkMultiThreader.h"
+#include "itkN4BiasFieldCorrectionImageFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Reconstruction of the log bias field estimated by
+// N4BiasFieldCorrectionImageFilter, shared by N4ITKBiasFieldCorrection and
+// its tests.
+namespace N4ITK
+{
+
+typedef float RealType;
+const int ImageDimension = 3;
+typedef itk::Image<RealType, ImageDimension>      ImageType;
+typedef itk::Image<unsigned char, ImageDimension> MaskImageType;
+typedef itk::N4BiasFieldCorrectionImageFilter<ImageType, MaskImageType, ImageType> CorrecterType;
+typedef CorrecterType::BiasFieldControlPointLatticeType LatticeType;
+
+// Centered uniform B-spline basis function of the given order, as
+// itk::BSplineKernelFunction
+inline double BSplineBasis( unsigned int order, double x )
+{
+  double value = 0.0;
+  double binomial = 1.0;
+  double factorial = 1.0;
+  for( unsigned int i = 2; i <= order; i++ )
+    {
+    factorial *= i;
+    }
+  for( unsigned int k = 0; k <= order + 1; k++ )
+    {
+    const double t = x + 0.5 * ( order + 1 ) - k;
+    if( t > 0.0 )
+      {
+      value += ( k % 2 ? -1.0 : 1.0 ) * binomial * std::pow( t, static_cast<int>( order ) );
+      }
+    binomial = binomial * ( order + 1 - k ) / ( k + 1 );
+    }
+  return value / factorial;
+}
+
+// First control point and weights of the order + 1 control points that
+// contribute to each voxel along an axis. The parameterization is the one of
+// itk::BSplineControlPointImageFilter: the domain of the spline spans the
+// domainSize voxels starting at domainStart. Voxel r of the evaluated region
+// is at the continuous index regionStart + r * regionStep of the domain;
+// voxels outside of the domain get the value of the closest domain boundary.
+struct BSplineAxisWeights
+  {
+  std::vector<itk::IndexValueType> FirstControlPoint;
+  std::vector<double>              Weights;
+  };
+
+inline void ComputeBSplineAxisWeights( unsigned int order, itk::SizeValueType numberOfControlPoints,
+                                       itk::IndexValueType domainStart, itk::SizeValueType domainSize,
+                                       double regionStart, double regionStep, itk::SizeValueType regionSize,
+                                       BSplineAxisWeights & axis )
+{
+  const double numberOfSpans = static_cast<double>( numberOfControlPoints - order );
+  const double epsilon = std::numeric_limits<RealType>::epsilon();
+  axis.FirstControlPoint.resize( regionSize );
+  axis.Weights.resize( regionSize * ( order + 1 ) );
+  for( itk::SizeValueType r = 0; r < regionSize; r++ )
+    {
+    double u = 0.0;
+    if( domainSize > 1 )
+      {
+      u = numberOfSpans * ( regionStart + r * regionStep - domainStart )
+        / static_cast<double>( domainSize - 1 );
+      }
+    u = std::max( 0.0, std::min( u, numberOfSpans - epsilon ) );
+    const itk::IndexValueType first = static_cast<itk::IndexValueType>( u );
+    axis.FirstControlPoint[r] = first;
+    for( unsigned int i = 0; i <= order; i++ )
+      {
+      axis.Weights[r * ( order + 1 ) + i] = BSplineBasis( order, u - ( first + i ) + 0.5 * ( order - 1.0 ) );
+      }
+    }
+}
+
+// Data shared by the threads evaluating the log bias field
+struct LogBiasFieldThreadStruct
+  {
+  const LatticeType * Lattice;
+  unsigned int        SplineOrder;
+  BSplineAxisWeights  Axes[ImageDimension];
+  ImageType *         LogBiasField;
+  bool                Accumulate;
+  };
+
+// Evaluate the log bias field on a slab of slices. The lattice is collapsed
+// along the slice axis once per slice, then along the rows once per row, so
+// that each voxel only costs order + 1 multiplications.
+inline ITK_THREAD_RETURN_TYPE EvaluateLogBiasFieldThread( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  LogBiasFieldThreadStruct * str = static_cast<LogBiasFieldThreadStruct *>( info->UserData );
+
+  const ImageType::SizeType   size = str->LogBiasField->GetBufferedRegion().GetSize();
+  const LatticeType::SizeType latticeSize = str->Lattice->GetBufferedRegion().GetSize();
+  const unsigned int          numberOfWeights = str->SplineOrder + 1;
+  const ::size_t              latticeSliceSize = latticeSize[0] * latticeSize[1];
+
+  const ::size_t beginSlice = size[2] * info->ThreadID / info->NumberOfThreads;
+  const ::size_t endSlice = size[2] * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  const LatticeType::PixelType * lattice = str->Lattice->GetBufferPointer();
+  std::vector<double>            plane( latticeSliceSize );
+  std::vector<double>            row( latticeSize[0] );
+  for( ::size_t z = beginSlice; z < endSlice; z++ )
+    {
+    std::fill( plane.begin(), plane.end(), 0.0 );
+    for( unsigned int i = 0; i < numberOfWeights; i++ )
+      {
+      const double                   weight = str->Axes[2].Weights[z * numberOfWeights + i];
+      const LatticeType::PixelType * latticeSlice =
+        lattice + ( str->Axes[2].FirstControlPoint[z] + i ) * latticeSliceSize;
+      for( ::size_t p = 0; p < latticeSliceSize; p++ )
+        {
+        plane[p] += weight * latticeSlice[p][0];
+        }
+      }
+    for( ::size_t y = 0; y < size[1]; y++ )
+      {
+      std::fill( row.begin(), row.end(), 0.0 );
+      for( unsigned int i = 0; i < numberOfWeights; i++ )
+        {
+        const double   weight = str->Axes[1].Weights[y * numberOfWeights + i];
+        const double * planeRow = &plane[( str->Axes[1].FirstControlPoint[y] + i ) * latticeSize[0]];
+        for( ::size_t x = 0; x < latticeSize[0]; x++ )
+          {
+          row[x] += weight * planeRow[x];
+          }
+        }
+      RealType * outputRow = str->LogBiasField->GetBufferPointer() + ( z * size[1] + y ) * size[0];
+      for( ::size_t x = 0; x < size[0]; x++ )
+        {
+        const double * weights = &str->Axes[0].Weights[x * numberOfWeights];
+        const double * controlPoints = &row[str->Axes[0].FirstControlPoint[x]];
+        double         value = 0.0;
+        for( unsigned int i = 0; i < numberOfWeights; i++ )
+          {
+          value += weights[i] * controlPoints[i];
+          }
+        outputRow[x] = static_cast<RealType>( str->Accumulate ? outputRow[x] + value : value );
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+// Evaluate the log bias field B-spline in the grid of the log bias field
+// image, in parallel. The spline domain is the largest possible region of
+// domainImage, which must have the same directions as the log bias field.
+// The field is added to the values of the image if accumulate is true.
+inline void EvaluateLogBiasField( const LatticeType * lattice, unsigned int splineOrder,
+                                  const ImageType * domainImage, ImageType * logBiasField, bool accumulate )
+{
+  const ImageType::RegionType & region = logBiasField->GetLargestPossibleRegion();
+  const ImageType::RegionType & domain = domainImage->GetLargestPossibleRegion();
+
+  ImageType::PointType regionOrigin;
+  logBiasField->TransformIndexToPhysicalPoint( region.GetIndex(), regionOrigin );
+  itk::ContinuousIndex<double, ImageDimension> regionStart;
+  domainImage->TransformPhysicalPointToContinuousIndex( regionOrigin, regionStart );
+
+  LogBiasFieldThreadStruct str;
+  str.Lattice = lattice;
+  str.SplineOrder = splineOrder;
+  str.LogBiasField = logBiasField;
+  str.Accumulate = accumulate;
+  for( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    // Snap to the voxels of the domain when the grids coincide, so that the
+    // field is exactly the one of BSplineControlPointImageFilter
+    double start = regionStart[d];
+    if( std::fabs( start - std::floor( start + 0.5 ) ) < 1e-4 )
+      {
+      start = std::floor( start + 0.5 );
+      }
+    ComputeBSplineAxisWeights( splineOrder, lattice->GetBufferedRegion().GetSize()[d],
+                               domain.GetIndex()[d], domain.GetSize()[d],
+                               start, logBiasField->GetSpacing()[d] / domainImage->GetSpacing()[d],
+                               region.GetSize()[d], str.Axes[d] );
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( std::max( 1, std::min( static_cast<int>( threader->GetNumberOfThreads() ),
+                                                       static_cast<int>( region.GetSize()[2] ) ) ) );
+  threader->SetSingleMethod( EvaluateLogBiasFieldThread, &str );
+  threader->SingleMethodExecute();
+}
+
+// Sum of the log bias fields of the levels of a multi-resolution schedule,
+// in the grid of a reference image. The lattice of each level is evaluated
+// over the domain of the image it was estimated from.
+inline ImageType::Pointer EvaluateLogBiasField( const std::vector<LatticeType::Pointer> & lattices,
+                                                const std::vector<ImageType::Pointer> & domainImages,
+                                                unsigned int splineOrder, const ImageType * referenceImage )
+{
+  ImageType::Pointer logBiasField = ImageType::New();
+  logBiasField->CopyInformation( referenceImage );
+  logBiasField->SetRegions( referenceImage->GetLargestPossibleRegion() );
+  logBiasField->Allocate();
+  if( lattices.empty() )
+    {
+    logBiasField->FillBuffer( 0.0 );
+    }
+  for( size_t level = 0; level < lattices.size(); level++ )
+    {
+    EvaluateLogBiasField( lattices[level], splineOrder, domainImages[level], logBiasField, level > 0 );
+    }
+  return logBiasField;
+}
+
+} // end namespace N4ITK
+
+#endif
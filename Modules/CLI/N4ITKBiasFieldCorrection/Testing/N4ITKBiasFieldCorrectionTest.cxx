@@ -7,8 +7,12 @@
 #endif
 
 extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char * []);
+int N4ITKBiasFieldReconstructionTest(int, char * []);
+int N4ITKBiasFieldResidualTest(int, char * []);
 
 void RegisterTests()
 {
   StringToTestFunctionMap["ModuleEntryPoint"] = ModuleEntryPoint;
+  StringToTestFunctionMap["N4ITKBiasFieldReconstructionTest"] = N4ITKBiasFieldReconstructionTest;
+  StringToTestFunctionMap["N4ITKBiasFieldResidualTest"] = N4ITKBiasFieldResidualTest;
 }
@@ -0,0 +1,172 @@
+#include "itkBSplineControlPointImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+#include "N4ITKBiasFieldReconstruction.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+typedef itk::BSplineControlPointImageFilter<N4ITK::LatticeType, N4ITK::CorrecterType::ScalarImageType> BSplinerType;
+
+// Largest difference between the log bias field and the B-spline of
+// BSplineControlPointImageFilter, at the voxels of the field that are on the
+// grid of the B-spline image
+double MaximumDifference( const N4ITK::ImageType * logBiasField, const BSplinerType::OutputImageType * bspline )
+{
+  double maximumDifference = 0.0;
+  itk::ImageRegionConstIterator<BSplinerType::OutputImageType> it( bspline, bspline->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+    {
+    BSplinerType::OutputImageType::PointType point;
+    bspline->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    N4ITK::ImageType::IndexType index;
+    logBiasField->TransformPhysicalPointToIndex( point, index );
+    maximumDifference = std::max( maximumDifference,
+                                  std::fabs( static_cast<double>( logBiasField->GetPixel( index ) ) - it.Get()[0] ) );
+    }
+  return maximumDifference;
+}
+
+}
+
+// Compare the threaded reconstruction of the log bias field with
+// BSplineControlPointImageFilter, which N4ITKBiasFieldCorrection used before,
+// and print the time of both on a volume of the size of he3volume.
+int N4ITKBiasFieldReconstructionTest( int argc, char * argv[] )
+{
+  const int numberOfRepeats = ( argc > 1 ? atoi( argv[1] ) : 1 );
+  const unsigned int splineOrder = 3;
+  const double tolerance = 1e-4;
+
+  N4ITK::ImageType::Pointer domain = N4ITK::ImageType::New();
+  N4ITK::ImageType::SizeType size;
+  size[0] = 128;
+  size[1] = 80;
+  size[2] = 31;
+  N4ITK::ImageType::SpacingType spacing;
+  spacing[0] = 3.28125;
+  spacing[1] = 3.28125;
+  spacing[2] = 10.0;
+  N4ITK::ImageType::PointType origin;
+  origin[0] = -210.0;
+  origin[1] = 131.25;
+  origin[2] = -150.0;
+  domain->SetRegions( size );
+  domain->SetSpacing( spacing );
+  domain->SetOrigin( origin );
+
+  N4ITK::LatticeType::Pointer lattice = N4ITK::LatticeType::New();
+  N4ITK::LatticeType::SizeType latticeSize;
+  latticeSize[0] = 8;
+  latticeSize[1] = 6;
+  latticeSize[2] = 5;
+  lattice->SetRegions( latticeSize );
+  lattice->Allocate();
+  N4ITK::LatticeType::PixelType * controlPoints = lattice->GetBufferPointer();
+  for( size_t i = 0; i < lattice->GetBufferedRegion().GetNumberOfPixels(); i++ )
+    {
+    controlPoints[i][0] = 0.3 * std::sin( 0.7 * i ) + 0.05 * ( i % 3 );
+    }
+
+  BSplinerType::Pointer bspliner = BSplinerType::New();
+  bspliner->SetInput( lattice );
+  bspliner->SetSplineOrder( splineOrder );
+  bspliner->SetSize( size );
+  bspliner->SetOrigin( origin );
+  bspliner->SetSpacing( spacing );
+  bspliner->SetDirection( domain->GetDirection() );
+  itk::TimeProbe bsplinerTimer;
+  for( int r = 0; r < numberOfRepeats; r++ )
+    {
+    bspliner->Modified();
+    bsplinerTimer.Start();
+    bspliner->Update();
+    bsplinerTimer.Stop();
+    }
+
+  N4ITK::ImageType::Pointer logBiasField = N4ITK::ImageType::New();
+  logBiasField->CopyInformation( domain );
+  logBiasField->SetRegions( size );
+  logBiasField->Allocate();
+
+  const int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  itk::TimeProbe singleThreadTimer;
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( 1 );
+  for( int r = 0; r < numberOfRepeats; r++ )
+    {
+    singleThreadTimer.Start();
+    N4ITK::EvaluateLogBiasField( lattice, splineOrder, domain, logBiasField, false );
+    singleThreadTimer.Stop();
+    }
+  const double singleThreadDifference = MaximumDifference( logBiasField, bspliner->GetOutput() );
+
+  itk::TimeProbe threadedTimer;
+  itk::MultiThreader::SetGlobalDefaultNumberOfThreads( numberOfThreads );
+  for( int r = 0; r < numberOfRepeats; r++ )
+    {
+    threadedTimer.Start();
+    N4ITK::EvaluateLogBiasField( lattice, splineOrder, domain, logBiasField, false );
+    threadedTimer.Stop();
+    }
+  const double threadedDifference = MaximumDifference( logBiasField, bspliner->GetOutput() );
+
+  std::cout << "BSplineControlPointImageFilter: " << bsplinerTimer.GetMean() << " s" << std::endl;
+  std::cout << "EvaluateLogBiasField, 1 thread: " << singleThreadTimer.GetMean() << " s" << std::endl;
+  std::cout << "EvaluateLogBiasField, " << numberOfThreads << " threads: "
+            << threadedTimer.GetMean() << " s" << std::endl;
+
+  if( singleThreadDifference > tolerance || threadedDifference > tolerance )
+    {
+    std::cerr << "The log bias field differs from BSplineControlPointImageFilter by "
+              << std::max( singleThreadDifference, threadedDifference ) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A finer grid with the same origin goes through the voxels of the domain
+  // every other voxel
+  N4ITK::ImageType::Pointer fineLogBiasField = N4ITK::ImageType::New();
+  N4ITK::ImageType::SizeType fineSize;
+  N4ITK::ImageType::SpacingType fineSpacing;
+  for( unsigned int d = 0; d < N4ITK::ImageDimension; d++ )
+    {
+    fineSize[d] = 2 * size[d] - 1;
+    fineSpacing[d] = 0.5 * spacing[d];
+    }
+  fineLogBiasField->SetRegions( fineSize );
+  fineLogBiasField->SetSpacing( fineSpacing );
+  fineLogBiasField->SetOrigin( origin );
+  fineLogBiasField->Allocate();
+  N4ITK::EvaluateLogBiasField( lattice, splineOrder, domain, fineLogBiasField, false );
+  const double fineDifference = MaximumDifference( fineLogBiasField, bspliner->GetOutput() );
+  if( fineDifference > tolerance )
+    {
+    std::cerr << "The log bias field on the finer grid differs from BSplineControlPointImageFilter by "
+              << fineDifference << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The fields of several levels add up
+  std::vector<N4ITK::LatticeType::Pointer> lattices( 2, lattice );
+  std::vector<N4ITK::ImageType::Pointer>   domains( 2, domain );
+  N4ITK::ImageType::Pointer                sum = N4ITK::EvaluateLogBiasField( lattices, domains, splineOrder, domain );
+  itk::ImageRegionConstIterator<N4ITK::ImageType> sumIt( sum, sum->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<N4ITK::ImageType> fieldIt( logBiasField, logBiasField->GetLargestPossibleRegion() );
+  for( ; !sumIt.IsAtEnd(); ++sumIt, ++fieldIt )
+    {
+    if( std::fabs( sumIt.Get() - 2.0 * fieldIt.Get() ) > tolerance )
+      {
+      std::cerr << "Voxel " << sumIt.GetIndex() << " of the sum of two levels is " << sumIt.Get()
+                << " instead of " << 2.0 * fieldIt.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+
+#include "N4ITKBiasFieldReconstruction.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+// Check that a log bias field is flat inside a mask. Estimated on an image
+// that was already corrected, it is the residual bias of the correction.
+int N4ITKBiasFieldResidualTest( int argc, char * argv[] )
+{
+  if( argc < 4 )
+    {
+    std::cerr << "Usage: " << argv[0] << " logBiasField mask tolerance" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double tolerance = atof( argv[3] );
+
+  typedef itk::ImageFileReader<N4ITK::ImageType>     ReaderType;
+  typedef itk::ImageFileReader<N4ITK::MaskImageType> MaskReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( argv[1] );
+  MaskReaderType::Pointer maskReader = MaskReaderType::New();
+  maskReader->SetFileName( argv[2] );
+  try
+    {
+    reader->Update();
+    maskReader->Update();
+    }
+  catch( itk::ExceptionObject & err )
+    {
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The log bias field is only defined up to a constant, its range is checked
+  double minimum = std::numeric_limits<double>::max();
+  double maximum = -std::numeric_limits<double>::max();
+  itk::ImageRegionConstIterator<N4ITK::ImageType> it( reader->GetOutput(),
+                                                      reader->GetOutput()->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<N4ITK::MaskImageType> maskIt( maskReader->GetOutput(),
+                                                              maskReader->GetOutput()->GetLargestPossibleRegion() );
+  for( ; !it.IsAtEnd(); ++it, ++maskIt )
+    {
+    if( maskIt.Get() )
+      {
+      minimum = std::min( minimum, static_cast<double>( it.Get() ) );
+      maximum = std::max( maximum, static_cast<double>( it.Get() ) );
+      }
+    }
+
+  std::cout << "Residual log bias field range: " << maximum - minimum << std::endl;
+  if( maximum < minimum || maximum - minimum > tolerance )
+    {
+    std::cerr << "The residual log bias field range is larger than " << tolerance << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -6,13 +6,18 @@
 
 // VTK includes
 #include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPointSet.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
-#include <vtkProbeFilter.h>
-#include <vtkTransform.h>
-#include <vtkTransformFilter.h>
+#include <vtkSmartPointer.h>
+#include <vtkTypeTraits.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkUnstructuredGrid.h>
 #include <vtkUnstructuredGridReader.h>
 #include <vtkUnstructuredGridWriter.h>
 #include <vtkXMLPolyDataReader.h>
@@ -22,16 +27,256 @@
 
 #include <vtksys/SystemTools.hxx>
 
-int main( int argc, char * argv[] )
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace
 {
 
-  PARSE_ARGS;
+//----------------------------------------------------------------------------
+// Trilinear interpolation stencil of every model point in a volume geometry.
+// It only depends on the points and on the volume geometry, so it is computed
+// once and shared by all the volumes that have the same geometry.
+struct PointSamplingMap
+{
+  int Dimensions[3];
+  vtkNew<vtkMatrix4x4> RASToIJK;
+
+  /// Index of the first of the 8 voxels around each point, -1 if the point is outside of the volume
+  std::vector<vtkIdType> FirstVoxel;
+  /// Offsets of the point from its first voxel along I, J and K, 3 per point
+  std::vector<double> Fractions;
+  /// Voxel index offsets of the 8 voxels of the stencil
+  vtkIdType VoxelOffsets[8];
+
+  bool HasGeometry(vtkImageData* volume, vtkMatrix4x4* rasToIJK)
+  {
+    int dimensions[3] = {0, 0, 0};
+    volume->GetDimensions(dimensions);
+    for (int i = 0; i < 3; ++i)
+      {
+      if (dimensions[i] != this->Dimensions[i])
+        {
+        return false;
+        }
+      }
+    for (int i = 0; i < 4; ++i)
+      {
+      for (int j = 0; j < 4; ++j)
+        {
+        if (rasToIJK->GetElement(i, j) != this->RASToIJK->GetElement(i, j))
+          {
+          return false;
+          }
+        }
+      }
+    return true;
+  }
+
+  void Compute(vtkPointSet* model, vtkImageData* volume, vtkMatrix4x4* rasToIJK)
+  {
+    volume->GetDimensions(this->Dimensions);
+    this->RASToIJK->DeepCopy(rasToIJK);
+
+    // Volumes with a single slice along an axis are sampled with a zero offset along it
+    vtkIdType strides[3] = {1, this->Dimensions[0], this->Dimensions[0] * this->Dimensions[1]};
+    vtkIdType increments[3] = {0, 0, 0};
+    for (int i = 0; i < 3; ++i)
+      {
+      increments[i] = (this->Dimensions[i] > 1 ? strides[i] : 0);
+      }
+    for (int corner = 0; corner < 8; ++corner)
+      {
+      this->VoxelOffsets[corner] = ((corner & 1) ? increments[0] : 0)
+        + ((corner & 2) ? increments[1] : 0)
+        + ((corner & 4) ? increments[2] : 0);
+      }
+
+    // Points outside of the volume by less than the tolerance of vtkProbeFilter
+    // (a thousandth of the squared diagonal of the volume) are moved onto its boundary
+    double spacing[3] = {1.0, 1.0, 1.0};
+    volume->GetSpacing(spacing);
+    double tolerance2 = 0.0;
+    for (int i = 0; i < 3; ++i)
+      {
+      double length = (this->Dimensions[i] - 1) * spacing[i];
+      tolerance2 += length * length;
+      }
+    tolerance2 = (tolerance2 > 0.0 ? tolerance2 / 1000.0 : 0.001);
+
+    vtkIdType numberOfPoints = model->GetNumberOfPoints();
+    this->FirstVoxel.resize(numberOfPoints);
+    this->Fractions.resize(3 * numberOfPoints);
+    for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+      {
+      double ras[4] = {0.0, 0.0, 0.0, 1.0};
+      model->GetPoint(pointId, ras);
+      double ijk[4] = {0.0, 0.0, 0.0, 1.0};
+      this->RASToIJK->MultiplyPoint(ras, ijk);
+
+      double distance2 = 0.0;
+      for (int i = 0; i < 3; ++i)
+        {
+        double boundedIndex = std::min(std::max(ijk[i], 0.0), static_cast<double>(this->Dimensions[i] - 1));
+        double distance = (ijk[i] - boundedIndex) * spacing[i];
+        distance2 += distance * distance;
+        ijk[i] = boundedIndex;
+        }
+      if (distance2 > tolerance2)
+        {
+        this->FirstVoxel[pointId] = -1;
+        continue;
+        }
+
+      vtkIdType firstVoxel = 0;
+      for (int i = 0; i < 3; ++i)
+        {
+        // Points on the last slice use the stencil of the previous slice
+        // so that all the voxels of the stencil are in the volume
+        int lastIndex = this->Dimensions[i] - 1;
+        int index = static_cast<int>(std::floor(ijk[i]));
+        if (index >= lastIndex && lastIndex > 0)
+          {
+          index = lastIndex - 1;
+          }
+        this->Fractions[3 * pointId + i] = (increments[i] ? ijk[i] - index : 0.0);
+        firstVoxel += index * strides[i];
+        }
+      this->FirstVoxel[pointId] = firstVoxel;
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+struct SampleThreadStruct
+{
+  PointSamplingMap* Map;
+  vtkDataArray* VolumeScalars;
+  vtkDataArray* Samples;
+};
+
+//----------------------------------------------------------------------------
+// Interpolated values are rounded and clamped for integer types like in
+// vtkDataArray::InterpolateTuple
+template <class T>
+T CastSample(double value)
+{
+  if (std::numeric_limits<T>::is_integer)
+    {
+    value = std::min(std::max(value, static_cast<double>(vtkTypeTraits<T>::Min())),
+                     static_cast<double>(vtkTypeTraits<T>::Max()));
+    return static_cast<T>(value >= 0.0 ? value + 0.5 : value - 0.5);
+    }
+  return static_cast<T>(value);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void SamplePoints(PointSamplingMap* map, const T* voxels, int numberOfComponents,
+                  T* samples, vtkIdType beginPointId, vtkIdType endPointId)
+{
+  for (vtkIdType pointId = beginPointId; pointId < endPointId; ++pointId)
+    {
+    T* sample = samples + pointId * numberOfComponents;
+    vtkIdType firstVoxel = map->FirstVoxel[pointId];
+    if (firstVoxel < 0)
+      {
+      for (int c = 0; c < numberOfComponents; ++c)
+        {
+        sample[c] = static_cast<T>(0);
+        }
+      continue;
+      }
+    const double* f = &map->Fractions[3 * pointId];
+    double weights[8];
+    for (int corner = 0; corner < 8; ++corner)
+      {
+      weights[corner] = ((corner & 1) ? f[0] : 1.0 - f[0])
+        * ((corner & 2) ? f[1] : 1.0 - f[1])
+        * ((corner & 4) ? f[2] : 1.0 - f[2]);
+      }
+    for (int c = 0; c < numberOfComponents; ++c)
+      {
+      double value = 0.0;
+      for (int corner = 0; corner < 8; ++corner)
+        {
+        value += weights[corner] * voxels[(firstVoxel + map->VoxelOffsets[corner]) * numberOfComponents + c];
+        }
+      sample[c] = CastSample<T>(value);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE SampleThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SampleThreadStruct* str = static_cast<SampleThreadStruct*>(info->UserData);
+
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(str->Map->FirstVoxel.size());
+  vtkIdType beginPointId = numberOfPoints * info->ThreadID / info->NumberOfThreads;
+  vtkIdType endPointId = numberOfPoints * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  void* voxels = str->VolumeScalars->GetVoidPointer(0);
+  int numberOfComponents = str->VolumeScalars->GetNumberOfComponents();
+  void* samples = str->Samples->GetVoidPointer(0);
+  switch (str->VolumeScalars->GetDataType())
+    {
+    vtkTemplateMacro(SamplePoints(str->Map, static_cast<VTK_TT*>(voxels), numberOfComponents,
+                                  static_cast<VTK_TT*>(samples), beginPointId, endPointId));
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Sample all the components of the volume at the model points with trilinear
+// interpolation, in parallel. The samples have the scalar type of the volume,
+// samples of points outside of the volume are 0.
+vtkSmartPointer<vtkDataArray> ProbeVolume(PointSamplingMap* map, vtkDataArray* volumeScalars)
+{
+  vtkSmartPointer<vtkDataArray> samples;
+  samples.TakeReference(vtkDataArray::CreateDataArray(volumeScalars->GetDataType()));
+  samples->SetNumberOfComponents(volumeScalars->GetNumberOfComponents());
+  samples->SetNumberOfTuples(static_cast<vtkIdType>(map->FirstVoxel.size()));
+
+  SampleThreadStruct str;
+  str.Map = map;
+  str.VolumeScalars = volumeScalars;
+  str.Samples = samples;
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetSingleMethod(SampleThreadFunction, &str);
+  threader->SingleMethodExecute();
+
+  return samples;
+}
+
+//----------------------------------------------------------------------------
+// Name that is not used by any array of the point data, the name itself or
+// the name followed by the first free number (e.g. volume_1)
+std::string UniqueArrayName(vtkPointData* pointData, const std::string& name)
+{
+  std::string uniqueName = name;
+  for (int suffix = 1; pointData->GetAbstractArray(uniqueName.c_str()); ++suffix)
+    {
+    std::stringstream ss;
+    ss << name << "_" << suffix;
+    uniqueName = ss.str();
+    }
+  return uniqueName;
+}
 
-  vtkNew<vtkNRRDReader> readerVol;
-  readerVol->SetFileName(InputVolume.c_str() );
-  readerVol->Update();
+} // end of anonymous namespace
 
-  vtkNew<vtkTransformFilter> transformer;
+int main( int argc, char * argv[] )
+{
+
+  PARSE_ARGS;
 
   vtkNew<vtkXMLPolyDataReader> readerXMLPD;
   readerXMLPD->SetFileName(InputModel.c_str());
@@ -43,27 +288,32 @@ int main( int argc, char * argv[] )
   readerVTKUG->SetFileName(InputModel.c_str());
 
   bool isPolyData = true; // polydata or unstructured grid
+  vtkSmartPointer<vtkPointSet> model;
 
   if (readerXMLPD->CanReadFile(InputModel.c_str()))
     {
     readerXMLPD->Update();
-    transformer->SetInputConnection(readerXMLPD->GetOutputPort());
+    model = vtkSmartPointer<vtkPolyData>::New();
+    model->ShallowCopy(readerXMLPD->GetOutput());
     }
   else if (readerVTKPD->IsFileValid("polydata"))
     {
     readerVTKPD->Update();
-    transformer->SetInputConnection(readerVTKPD->GetOutputPort());
+    model = vtkSmartPointer<vtkPolyData>::New();
+    model->ShallowCopy(readerVTKPD->GetOutput());
     }
   else if (readerXMLUG->CanReadFile(InputModel.c_str()))
     {
     readerXMLUG->Update();
-    transformer->SetInputConnection(readerXMLUG->GetOutputPort());
+    model = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    model->ShallowCopy(readerXMLUG->GetOutput());
     isPolyData = false;
     }
   else if (readerVTKUG->IsFileValid("unstructured_grid"))
     {
     readerVTKUG->Update();
-    transformer->SetInputConnection(readerVTKUG->GetOutputPort());
+    model = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    model->ShallowCopy(readerVTKUG->GetOutput());
     isPolyData = false;
     }
   else
@@ -72,41 +322,64 @@ int main( int argc, char * argv[] )
     return -1;
     }
 
-  // Set up matrices to put model points into ijk space of volume
-  // This assumes points are in RAS space of volume (i.e. RAS==world)
-  vtkNew<vtkMatrix4x4> ROI_A_RASToIJK;
-  ROI_A_RASToIJK->DeepCopy(readerVol->GetRasToIjkMatrix());
-
-  // the volume we're probing knows its spacing so take this out of the matrix
-  double sp[3] = { 1.0, 1.0, 1.0 };
-  readerVol->GetOutput()->GetSpacing(sp);
-  vtkNew<vtkTransform> trans;
-  trans->Identity();
-  trans->PreMultiply();
-  trans->SetMatrix(ROI_A_RASToIJK.GetPointer());
-  // Trans from IJK to RAS
-  trans->Inverse();
-  // Take into account spacing to compute Scaled IJK
-  trans->Scale(1 / sp[0], 1 / sp[1], 1 / sp[2]);
-  // now it's RAS to scaled IJK
-  trans->Inverse();
-
-  transformer->SetTransform(trans.GetPointer());
-  transformer->Update();
-
-  vtkNew<vtkProbeFilter> probe;
-  probe->SetSourceConnection(readerVol->GetOutputPort());
-  probe->SetInputConnection( transformer->GetOutputPort() );
-  probe->Update();
-
-  // Transform the model back into original space
-  vtkNew<vtkTransform> trans2;
-  trans2->DeepCopy(trans.GetPointer());
-  trans2->Inverse();
-  vtkNew<vtkTransformFilter> transformer2;
-  transformer2->SetTransform(trans2.GetPointer());
-  transformer2->SetInputConnection(probe->GetOutputPort());
-  transformer2->Update();
+  // The input volume is probed first, then the additional volumes. All the
+  // components of each volume (vector or multi-frame volumes) are sampled
+  // into one point data array.
+  std::vector<std::string> volumeFileNames;
+  volumeFileNames.push_back(InputVolume);
+  volumeFileNames.insert(volumeFileNames.end(), AdditionalVolumes.begin(), AdditionalVolumes.end());
+
+  // The model points are assumed to be in the RAS space of the volumes (i.e. RAS==world).
+  // The interpolation stencils of the points are only recomputed when the geometry changes.
+  PointSamplingMap samplingMap;
+  bool samplingMapComputed = false;
+  vtkSmartPointer<vtkDataArray> firstSamples;
+  for (size_t volumeIndex = 0; volumeIndex < volumeFileNames.size(); ++volumeIndex)
+    {
+    vtkNew<vtkNRRDReader> readerVol;
+    readerVol->SetFileName(volumeFileNames[volumeIndex].c_str());
+    readerVol->Update();
+    vtkImageData* volume = readerVol->GetOutput();
+    vtkDataArray* volumeScalars = (volume ? volume->GetPointData()->GetArray(0) : NULL);
+    if (!volumeScalars)
+      {
+      std::cerr << "Failed to read volume " << volumeFileNames[volumeIndex] << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if (!samplingMapComputed || !samplingMap.HasGeometry(volume, readerVol->GetRasToIjkMatrix()))
+      {
+      samplingMap.Compute(model, volume, readerVol->GetRasToIjkMatrix());
+      samplingMapComputed = true;
+      }
+
+    vtkSmartPointer<vtkDataArray> samples = ProbeVolume(&samplingMap, volumeScalars);
+    std::string volumeName = vtksys::SystemTools::GetFilenameWithoutExtension(volumeFileNames[volumeIndex]);
+    if (volumeIndex == 0)
+      {
+      // Same name as the array created by vtkProbeFilter
+      samples->SetName(UniqueArrayName(model->GetPointData(),
+        volumeScalars->GetName() ? volumeScalars->GetName() : volumeName).c_str());
+      firstSamples = samples;
+
+      // Mask of the points inside the input volume
+      vtkNew<vtkUnsignedCharArray> validPointMask;
+      validPointMask->SetName("vtkValidPointMask");
+      validPointMask->SetNumberOfTuples(model->GetNumberOfPoints());
+      for (vtkIdType pointId = 0; pointId < model->GetNumberOfPoints(); ++pointId)
+        {
+        validPointMask->SetValue(pointId, samplingMap.FirstVoxel[pointId] >= 0 ? 1 : 0);
+        }
+      model->GetPointData()->AddArray(validPointMask.GetPointer());
+      }
+    else
+      {
+      // Volumes with the same file name in different directories get different array names
+      samples->SetName(UniqueArrayName(model->GetPointData(), volumeName).c_str());
+      }
+    model->GetPointData()->AddArray(samples);
+    }
+  model->GetPointData()->SetActiveScalars(firstSamples->GetName());
 
   // Save the output
   std::string ext = vtksys::SystemTools::LowerCase(vtksys::SystemTools::GetFilenameLastExtension(OutputModel));
@@ -117,14 +390,14 @@ int main( int argc, char * argv[] )
       {
       vtkNew<vtkPolyDataWriter> dataWriter;
       dataWriter->SetFileName(OutputModel.c_str());
-      dataWriter->SetInputConnection(transformer2->GetOutputPort());
+      dataWriter->SetInputData(model);
       dataWriter->Write();
       }
     else
       {
       vtkNew<vtkXMLPolyDataWriter> xmlWriter;
       xmlWriter->SetFileName(OutputModel.c_str());
-      xmlWriter->SetInputConnection(transformer2->GetOutputPort());
+      xmlWriter->SetInputData(model);
       xmlWriter->Write();
       }
     }
@@ -134,14 +407,14 @@ int main( int argc, char * argv[] )
       {
       vtkNew<vtkUnstructuredGridWriter> dataWriter;
       dataWriter->SetFileName(OutputModel.c_str());
-      dataWriter->SetInputConnection(transformer2->GetOutputPort());
+      dataWriter->SetInputData(model);
       dataWriter->Write();
       }
     else
       {
       vtkNew<vtkXMLUnstructuredGridWriter> xmlWriter;
       xmlWriter->SetFileName(OutputModel.c_str());
-      xmlWriter->SetInputConnection(transformer2->GetOutputPort());
+      xmlWriter->SetInputData(model);
       xmlWriter->Write();
       }
     }
@@ -0,0 +1,186 @@
+
+// vtkTeem includes
+#include <vtkNRRDWriter.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkXMLPolyDataWriter.h>
+
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Oblique geometry of the input volume and of the vector volume
+void SetInputGeometry(vtkMatrix4x4* ijkToRAS)
+{
+  const double elements[16] = {
+    0.0, -1.0, 0.0, 10.0,
+    1.5, 0.0, 0.0, -20.0,
+    0.0, 0.0, 2.0, 5.0,
+    0.0, 0.0, 0.0, 1.0 };
+  ijkToRAS->DeepCopy(elements);
+}
+
+//----------------------------------------------------------------------------
+// Coarser geometry of the label volume, with another origin
+void SetLabelsGeometry(vtkMatrix4x4* ijkToRAS)
+{
+  const double elements[16] = {
+    -3.0, 0.0, 0.0, 30.0,
+    0.0, 2.5, 0.0, -22.0,
+    0.0, 0.0, 4.0, 3.0,
+    0.0, 0.0, 0.0, 1.0 };
+  ijkToRAS->DeepCopy(elements);
+}
+
+//----------------------------------------------------------------------------
+bool WriteVolume(vtkImageData* volume, vtkMatrix4x4* ijkToRAS, const std::string& fileName)
+{
+  vtkNew<vtkNRRDWriter> writer;
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(volume);
+  writer->SetIJKToRASMatrix(ijkToRAS);
+  writer->Write();
+  return !writer->GetWriteError();
+}
+
+//----------------------------------------------------------------------------
+// Indices along an axis of dimension: far outside, slightly outside (within
+// the vtkProbeFilter tolerance), on the boundary and inside of the volume
+void AxisIndices(int dimension, std::vector<double>& indices)
+{
+  indices.push_back(-3.2);
+  indices.push_back(-0.08);
+  for (double index = 0.0; index < dimension - 1; index += 1.37)
+    {
+    indices.push_back(index);
+    }
+  indices.push_back(dimension - 1);
+  indices.push_back(dimension - 1 + 0.08);
+  indices.push_back(dimension + 2.2);
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Generate the volumes and the model probed by the tests: a short volume,
+// a 3 component float volume with the same geometry, an unsigned char volume
+// with another geometry, and a model made of vertices in and around the
+// short volume.
+int GenerateProbeVolumeWithModelTestData(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << argv[0] << " <outputDirectory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string directory = argv[1];
+  vtksys::SystemTools::MakeDirectory((directory + "/Vector").c_str());
+  vtksys::SystemTools::MakeDirectory((directory + "/Labels").c_str());
+
+  const int dimensions[3] = {20, 24, 16};
+  vtkNew<vtkMatrix4x4> inputIJKToRAS;
+  SetInputGeometry(inputIJKToRAS.GetPointer());
+
+  vtkNew<vtkImageData> volume;
+  volume->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  vtkNew<vtkImageData> vectorVolume;
+  vectorVolume->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  vectorVolume->AllocateScalars(VTK_FLOAT, 3);
+  for (int k = 0; k < dimensions[2]; ++k)
+    {
+    for (int j = 0; j < dimensions[1]; ++j)
+      {
+      for (int i = 0; i < dimensions[0]; ++i)
+        {
+        short* voxel = static_cast<short*>(volume->GetScalarPointer(i, j, k));
+        *voxel = static_cast<short>(37 * i - 11 * j * j + 5 * k * k * k + ((i * j + k) % 7) * 100);
+        float* vector = static_cast<float*>(vectorVolume->GetScalarPointer(i, j, k));
+        vector[0] = 0.25f * i - 0.5f * j;
+        vector[1] = 0.01f * i * j * k;
+        vector[2] = static_cast<float>((i + 2 * j + 3 * k) % 5) - 2.5f;
+        }
+      }
+    }
+  if (!WriteVolume(volume.GetPointer(), inputIJKToRAS.GetPointer(), directory + "/volume.nrrd")
+      || !WriteVolume(vectorVolume.GetPointer(), inputIJKToRAS.GetPointer(), directory + "/Vector/volume.nrrd"))
+    {
+    std::cerr << "Failed to write the volumes in " << directory << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Label values are far apart so that the rounding of the samples is tested
+  const int labelsDimensions[3] = {9, 11, 10};
+  vtkNew<vtkMatrix4x4> labelsIJKToRAS;
+  SetLabelsGeometry(labelsIJKToRAS.GetPointer());
+  vtkNew<vtkImageData> labels;
+  labels->SetDimensions(labelsDimensions[0], labelsDimensions[1], labelsDimensions[2]);
+  labels->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = 0; k < labelsDimensions[2]; ++k)
+    {
+    for (int j = 0; j < labelsDimensions[1]; ++j)
+      {
+      for (int i = 0; i < labelsDimensions[0]; ++i)
+        {
+        unsigned char* voxel = static_cast<unsigned char*>(labels->GetScalarPointer(i, j, k));
+        *voxel = static_cast<unsigned char>(((i + j + k) % 4) * 85);
+        }
+      }
+    }
+  if (!WriteVolume(labels.GetPointer(), labelsIJKToRAS.GetPointer(), directory + "/Labels/volume.nrrd"))
+    {
+    std::cerr << "Failed to write the label volume in " << directory << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Model points are laid out on a grid in the IJK space of the input volume
+  std::vector<double> indices[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    AxisIndices(dimensions[axis], indices[axis]);
+    }
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> vertices;
+  for (size_t k = 0; k < indices[2].size(); ++k)
+    {
+    for (size_t j = 0; j < indices[1].size(); ++j)
+      {
+      for (size_t i = 0; i < indices[0].size(); ++i)
+        {
+        double ijk[4] = {indices[0][i], indices[1][j], indices[2][k], 1.0};
+        double ras[4] = {0.0, 0.0, 0.0, 1.0};
+        inputIJKToRAS->MultiplyPoint(ijk, ras);
+        vtkIdType pointId = points->InsertNextPoint(ras);
+        vertices->InsertNextCell(1, &pointId);
+        }
+      }
+    }
+  vtkNew<vtkPolyData> model;
+  model->SetPoints(points.GetPointer());
+  model->SetVerts(vertices.GetPointer());
+
+  vtkNew<vtkXMLPolyDataWriter> writer;
+  writer->SetFileName((directory + "/model.vtp").c_str());
+  writer->SetInputData(model.GetPointer());
+  if (!writer->Write())
+    {
+    std::cerr << "Failed to write the model in " << directory << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
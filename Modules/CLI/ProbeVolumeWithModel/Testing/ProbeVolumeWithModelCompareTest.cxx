@@ -0,0 +1,167 @@
+
+// vtkTeem includes
+#include <vtkNRRDReader.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkProbeFilter.h>
+#include <vtkTransform.h>
+#include <vtkTransformFilter.h>
+#include <vtkXMLPolyDataReader.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Probe the volume with the model the way ProbeVolumeWithModel did with
+// vtkProbeFilter: the model is moved into the scaled IJK space of the volume.
+void ProbeWithProbeFilter(vtkNRRDReader* readerVol, vtkPolyData* model, vtkProbeFilter* probe)
+{
+  double sp[3] = { 1.0, 1.0, 1.0 };
+  readerVol->GetOutput()->GetSpacing(sp);
+
+  vtkNew<vtkTransform> trans;
+  trans->Identity();
+  trans->PreMultiply();
+  trans->SetMatrix(readerVol->GetRasToIjkMatrix());
+  trans->Inverse();
+  trans->Scale(1 / sp[0], 1 / sp[1], 1 / sp[2]);
+  trans->Inverse();
+
+  vtkNew<vtkTransformFilter> transformer;
+  transformer->SetTransform(trans.GetPointer());
+  transformer->SetInputData(model);
+
+  probe->SetSourceConnection(readerVol->GetOutputPort());
+  probe->SetInputConnection(transformer->GetOutputPort());
+  probe->Update();
+}
+
+//----------------------------------------------------------------------------
+int CompareArrays(vtkDataArray* expected, vtkDataArray* actual, const std::string& name)
+{
+  if (!actual)
+    {
+    std::cerr << "Missing array " << name << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (actual->GetDataType() != expected->GetDataType()
+      || actual->GetNumberOfComponents() != expected->GetNumberOfComponents()
+      || actual->GetNumberOfTuples() != expected->GetNumberOfTuples())
+    {
+    std::cerr << "Array " << name << " is " << actual->GetDataTypeAsString()
+              << " with " << actual->GetNumberOfComponents() << " components and "
+              << actual->GetNumberOfTuples() << " tuples, expected "
+              << expected->GetDataTypeAsString()
+              << " with " << expected->GetNumberOfComponents() << " components and "
+              << expected->GetNumberOfTuples() << " tuples" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Integer samples may be rounded differently when the interpolated value
+  // is halfway between two integers, the weights are summed in another order
+  bool isInteger = (actual->GetDataType() != VTK_FLOAT && actual->GetDataType() != VTK_DOUBLE);
+  int numberOfDifferences = 0;
+  for (vtkIdType tupleId = 0; tupleId < actual->GetNumberOfTuples(); ++tupleId)
+    {
+    for (int c = 0; c < actual->GetNumberOfComponents(); ++c)
+      {
+      double expectedValue = expected->GetComponent(tupleId, c);
+      double actualValue = actual->GetComponent(tupleId, c);
+      double tolerance = (isInteger ? 1.0 : 1e-4 * (1.0 + std::fabs(expectedValue)));
+      if (std::fabs(actualValue - expectedValue) > tolerance)
+        {
+        if (++numberOfDifferences <= 10)
+          {
+          std::cerr << "Array " << name << ", point " << tupleId << ", component " << c
+                    << ": " << actualValue << " instead of " << expectedValue << std::endl;
+          }
+        }
+      }
+    }
+  if (numberOfDifferences > 0)
+    {
+    std::cerr << numberOfDifferences << " samples of " << name << " differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Compare the arrays of the output model with the samples of vtkProbeFilter
+// for each volume. The mask of the points inside the volume is compared for
+// the first volume.
+int ProbeVolumeWithModelCompareTest(int argc, char * argv[])
+{
+  if (argc < 5 || argc % 2 == 0)
+    {
+    std::cerr << argv[0] << " <inputModel> <outputModel> <volume> <arrayName> [<volume> <arrayName> ...]"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkXMLPolyDataReader> inputReader;
+  inputReader->SetFileName(argv[1]);
+  inputReader->Update();
+  vtkNew<vtkXMLPolyDataReader> outputReader;
+  outputReader->SetFileName(argv[2]);
+  outputReader->Update();
+  vtkPolyData* output = outputReader->GetOutput();
+  if (output->GetNumberOfPoints() != inputReader->GetOutput()->GetNumberOfPoints())
+    {
+    std::cerr << "Output model has " << output->GetNumberOfPoints() << " points instead of "
+              << inputReader->GetOutput()->GetNumberOfPoints() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for (int arg = 3; arg < argc; arg += 2)
+    {
+    vtkNew<vtkNRRDReader> readerVol;
+    readerVol->SetFileName(argv[arg]);
+    readerVol->Update();
+    vtkDataArray* volumeScalars = readerVol->GetOutput()->GetPointData()->GetArray(0);
+
+    vtkNew<vtkProbeFilter> probe;
+    ProbeWithProbeFilter(readerVol.GetPointer(), inputReader->GetOutput(), probe.GetPointer());
+    vtkPointData* expectedPointData = probe->GetOutput()->GetPointData();
+
+    if (CompareArrays(expectedPointData->GetArray(volumeScalars->GetName()),
+                      output->GetPointData()->GetArray(argv[arg + 1]), argv[arg + 1]) != EXIT_SUCCESS)
+      {
+      std::cerr << "Volume " << argv[arg] << " is not sampled like vtkProbeFilter" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    if (arg == 3)
+      {
+      vtkDataArray* expectedMask = expectedPointData->GetArray("vtkValidPointMask");
+      if (CompareArrays(expectedMask, output->GetPointData()->GetArray("vtkValidPointMask"),
+                        "vtkValidPointMask") != EXIT_SUCCESS)
+        {
+        return EXIT_FAILURE;
+        }
+      // The model must have points inside and outside of the volume
+      double range[2] = {0.0, 0.0};
+      expectedMask->GetRange(range);
+      if (range[0] != 0.0 || range[1] != 1.0)
+        {
+        std::cerr << "All the points are " << (range[0] ? "inside" : "outside") << " of the volume" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,13 @@
+#include "itkTestMain.h"
+
+void RegisterTests()
+{
+  REGISTER_TEST(ProbeVolumeWithModelTest);
+  REGISTER_TEST(ProbeVolumeWithModelCompareTest);
+  REGISTER_TEST(GenerateProbeVolumeWithModelTestData);
+}
+
+#undef main
+#define main ProbeVolumeWithModelTest
+
+#include "../ProbeVolumeWithModel.cxx"
@@ -27,6 +27,7 @@
 #include <itkVectorResampleImageFilter.h>
 #include <itkWindowedSincInterpolateImageFunction.h>
 #include <itkConstantBoundaryCondition.h>
+#include <itkMultiThreader.h>
 
 // ResampleScalarVectorDWIVolume includes
 #include "ResampleScalarVectorDWIVolumeCLP.h"
@@ -37,6 +38,8 @@
 #include "itkWarpTransform3D.h"
 
 // STD includes
+#include <algorithm>
+#include <cmath>
 
 // Use an anonymous namespace to keep class types and function names
 // from colliding when module is used as shared object module.  Every
@@ -74,6 +77,8 @@ struct parameters
   std::string imageCenter;
   std::string transformsOrder;
   bool notbulk;
+  bool cacheTransform;
+  int numberOfFieldDivisions;
   };
 
 // To check the image voxel type
@@ -1213,6 +1218,303 @@ SetInterpolator( const parameters & list )
   return interpol;
 }
 
+// Clamp an interpolated value to the range of the pixel type, as
+// itk::ResampleImageFilter does
+template <class PixelType>
+PixelType CastPixelWithBoundsChecking( double value )
+{
+  const double minimum = static_cast<double>( itk::NumericTraits<PixelType>::NonpositiveMin() );
+  const double maximum = static_cast<double>( itk::NumericTraits<PixelType>::max() );
+  if( value < minimum )
+    {
+    return itk::NumericTraits<PixelType>::NonpositiveMin();
+    }
+  if( value > maximum )
+    {
+    return itk::NumericTraits<PixelType>::max();
+    }
+  return static_cast<PixelType>( value );
+}
+
+// Data shared by the threads computing and using the transform field
+template <class PixelType>
+struct TransformFieldThreadStruct
+  {
+  typedef itk::Image<PixelType, 3>                         ImageType;
+  typedef itk::VectorImage<PixelType, 3>                   VectorImageType;
+  typedef itk::InterpolateImageFunction<ImageType, double> InterpolatorType;
+
+  const VectorImageType *              Input;
+  VectorImageType *                    Output;
+  const itk::Transform<double, 3, 3> * Transform;
+  // Slab of the output image being resampled
+  itk::ImageRegion<3> Region;
+  // Continuous index in the input image of each voxel of Region, and whether
+  // it is inside the input image
+  std::vector<itk::ContinuousIndex<double, 3> > * Field;
+  std::vector<unsigned char> *                    Inside;
+  // Interpolation of all the components at once (linear or nearest neighbor)
+  bool NearestNeighbor;
+  // Interpolation of a single component with an ITK interpolator
+  const InterpolatorType * Interpolator;
+  unsigned int             Component;
+  PixelType                DefaultPixelValue;
+  };
+
+// Range of voxels of the slab processed by a thread
+void GetThreadVoxelRange( ::size_t numberOfVoxels, const itk::MultiThreader::ThreadInfoStruct * info,
+                          ::size_t & begin, ::size_t & end )
+{
+  begin = numberOfVoxels * info->ThreadID / info->NumberOfThreads;
+  end = numberOfVoxels * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+}
+
+// Evaluate the transform once per output voxel
+template <class PixelType>
+ITK_THREAD_RETURN_TYPE ComputeTransformFieldThread( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  TransformFieldThreadStruct<PixelType> * str = static_cast<TransformFieldThreadStruct<PixelType> *>( info->UserData );
+  ::size_t begin;
+  ::size_t end;
+  GetThreadVoxelRange( str->Field->size(), info, begin, end );
+
+  // Same bounds as itk::InterpolateImageFunction::IsInsideBuffer()
+  const itk::ImageRegion<3> & inputRegion = str->Input->GetBufferedRegion();
+  double startContinuousIndex[3];
+  double endContinuousIndex[3];
+  for( int i = 0; i < 3; i++ )
+    {
+    startContinuousIndex[i] = inputRegion.GetIndex()[i] - 0.5;
+    endContinuousIndex[i] = inputRegion.GetIndex()[i] + inputRegion.GetSize()[i] - 0.5;
+    }
+
+  const itk::Index<3> & regionIndex = str->Region.GetIndex();
+  const itk::Size<3> &  regionSize = str->Region.GetSize();
+  itk::Index<3>         index;
+  itk::Point<double, 3> outputPoint;
+  itk::Point<double, 3> inputPoint;
+  for( ::size_t voxel = begin; voxel < end; voxel++ )
+    {
+    index[0] = regionIndex[0] + voxel % regionSize[0];
+    index[1] = regionIndex[1] + ( voxel / regionSize[0] ) % regionSize[1];
+    index[2] = regionIndex[2] + voxel / ( regionSize[0] * regionSize[1] );
+    str->Output->TransformIndexToPhysicalPoint( index, outputPoint );
+    inputPoint = str->Transform->TransformPoint( outputPoint );
+    itk::ContinuousIndex<double, 3> & continuousIndex = ( *str->Field )[voxel];
+    str->Input->TransformPhysicalPointToContinuousIndex( inputPoint, continuousIndex );
+    bool inside = true;
+    for( int i = 0; i < 3; i++ )
+      {
+      if( !( continuousIndex[i] >= startContinuousIndex[i] && continuousIndex[i] < endContinuousIndex[i] ) )
+        {
+        inside = false;
+        }
+      }
+    ( *str->Inside )[voxel] = inside;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+// Linear or nearest neighbor interpolation of all the components at once:
+// the neighbors and their weights are computed once per voxel
+template <class PixelType>
+ITK_THREAD_RETURN_TYPE InterpolateAllComponentsThread( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  TransformFieldThreadStruct<PixelType> * str = static_cast<TransformFieldThreadStruct<PixelType> *>( info->UserData );
+  ::size_t begin;
+  ::size_t end;
+  GetThreadVoxelRange( str->Field->size(), info, begin, end );
+
+  const unsigned int numberOfComponents = str->Input->GetNumberOfComponentsPerPixel();
+  const PixelType *  inputBuffer = str->Input->GetBufferPointer();
+  PixelType *        outputBuffer = str->Output->GetBufferPointer()
+    + str->Output->ComputeOffset( str->Region.GetIndex() ) * numberOfComponents;
+  const itk::ImageRegion<3> & inputRegion = str->Input->GetBufferedRegion();
+  const ::size_t              inputStride[3] =
+    { 1, inputRegion.GetSize()[0], inputRegion.GetSize()[0] * inputRegion.GetSize()[1] };
+
+  for( ::size_t voxel = begin; voxel < end; voxel++ )
+    {
+    PixelType * outputPixel = outputBuffer + voxel * numberOfComponents;
+    if( !( *str->Inside )[voxel] )
+      {
+      std::fill( outputPixel, outputPixel + numberOfComponents, str->DefaultPixelValue );
+      continue;
+      }
+    const itk::ContinuousIndex<double, 3> & continuousIndex = ( *str->Field )[voxel];
+    if( str->NearestNeighbor )
+      {
+      ::size_t inputOffset = 0;
+      for( int i = 0; i < 3; i++ )
+        {
+        // Same rounding as itk::NearestNeighborInterpolateImageFunction
+        long nearest = static_cast<long>( std::floor( continuousIndex[i] + 0.5 ) );
+        inputOffset += ( nearest - inputRegion.GetIndex()[i] ) * inputStride[i];
+        }
+      std::copy( inputBuffer + inputOffset * numberOfComponents,
+                 inputBuffer + ( inputOffset + 1 ) * numberOfComponents, outputPixel );
+      continue;
+      }
+    // Neighbors are clamped to the image, as in itk::LinearInterpolateImageFunction
+    ::size_t lowerOffset[3];
+    ::size_t upperOffset[3];
+    double   distance[3];
+    for( int i = 0; i < 3; i++ )
+      {
+      long lower = static_cast<long>( std::floor( continuousIndex[i] ) );
+      lower = std::max( lower, static_cast<long>( inputRegion.GetIndex()[i] ) );
+      distance[i] = std::max( 0.0, continuousIndex[i] - lower );
+      long upper = std::min( lower + 1,
+                             static_cast<long>( inputRegion.GetIndex()[i] + inputRegion.GetSize()[i] - 1 ) );
+      lowerOffset[i] = ( lower - inputRegion.GetIndex()[i] ) * inputStride[i];
+      upperOffset[i] = ( upper - inputRegion.GetIndex()[i] ) * inputStride[i];
+      }
+    ::size_t neighborOffset[8];
+    double   neighborWeight[8];
+    for( int neighbor = 0; neighbor < 8; neighbor++ )
+      {
+      neighborOffset[neighbor] = 0;
+      neighborWeight[neighbor] = 1.0;
+      for( int i = 0; i < 3; i++ )
+        {
+        const bool upper = ( neighbor >> i ) & 1;
+        neighborOffset[neighbor] += upper ? upperOffset[i] : lowerOffset[i];
+        neighborWeight[neighbor] *= upper ? distance[i] : 1.0 - distance[i];
+        }
+      neighborOffset[neighbor] *= numberOfComponents;
+      }
+    for( unsigned int component = 0; component < numberOfComponents; component++ )
+      {
+      double value = 0.0;
+      for( int neighbor = 0; neighbor < 8; neighbor++ )
+        {
+        value += neighborWeight[neighbor] * inputBuffer[neighborOffset[neighbor] + component];
+        }
+      outputPixel[component] = CastPixelWithBoundsChecking<PixelType>( value );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+// Interpolation of one component with an ITK interpolator
+template <class PixelType>
+ITK_THREAD_RETURN_TYPE InterpolateComponentThread( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info = static_cast<itk::MultiThreader::ThreadInfoStruct *>( arg );
+  TransformFieldThreadStruct<PixelType> * str = static_cast<TransformFieldThreadStruct<PixelType> *>( info->UserData );
+  ::size_t begin;
+  ::size_t end;
+  GetThreadVoxelRange( str->Field->size(), info, begin, end );
+
+  const unsigned int numberOfComponents = str->Input->GetNumberOfComponentsPerPixel();
+  PixelType *        outputBuffer = str->Output->GetBufferPointer()
+    + str->Output->ComputeOffset( str->Region.GetIndex() ) * numberOfComponents + str->Component;
+  for( ::size_t voxel = begin; voxel < end; voxel++ )
+    {
+    outputBuffer[voxel * numberOfComponents] = ( *str->Inside )[voxel]
+      ? CastPixelWithBoundsChecking<PixelType>(
+        static_cast<double>( str->Interpolator->EvaluateAtContinuousIndex( ( *str->Field )[voxel] ) ) )
+      : str->DefaultPixelValue;
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+// Resample all the components of a vector image with the same transform.
+// The transform is evaluated once per output voxel into a field of continuous
+// indices in the input image, the field is then used to interpolate every
+// component. The output is processed by slabs of slices
+// (list.numberOfFieldDivisions) so that the field only covers a part of it,
+// the input and output images are fully in memory.
+template <class PixelType>
+typename itk::VectorImage<PixelType, 3>::Pointer
+ResampleWithTransformField( const parameters & list,
+                            const typename itk::VectorImage<PixelType, 3>::Pointer & inputImage,
+                            const typename itk::ResampleImageFilter<itk::Image<PixelType, 3>,
+                                                                    itk::Image<PixelType, 3> >::Pointer & resample,
+                            const itk::Transform<double, 3, 3>::Pointer & transform )
+{
+  typedef itk::Image<PixelType, 3>                         ImageType;
+  typedef itk::VectorImage<PixelType, 3>                   VectorImageType;
+  typedef itk::InterpolateImageFunction<ImageType, double> InterpolatorType;
+  typename VectorImageType::Pointer outputImage = VectorImageType::New();
+  outputImage->SetRegions( resample->GetSize() );
+  outputImage->SetOrigin( resample->GetOutputOrigin() );
+  outputImage->SetSpacing( resample->GetOutputSpacing() );
+  outputImage->SetDirection( resample->GetOutputDirection() );
+  outputImage->SetVectorLength( inputImage->GetNumberOfComponentsPerPixel() );
+  outputImage->Allocate();
+
+  // Other interpolators are used component by component. Each component has
+  // its own interpolator so that its coefficients (e.g. BSpline) are only
+  // computed once for all the slabs.
+  const bool allComponentsAtOnce = !list.interpolationType.compare( "linear" )
+    || !list.interpolationType.compare( "nn" );
+  std::vector<typename InterpolatorType::Pointer> componentInterpolators;
+  if( !allComponentsAtOnce )
+    {
+    std::vector<typename ImageType::Pointer> componentImages;
+    SeparateImages<PixelType>( inputImage, componentImages );
+    for( unsigned int component = 0; component < componentImages.size(); component++ )
+      {
+      componentInterpolators.push_back( SetInterpolator<ImageType>( list ) );
+      componentInterpolators[component]->SetInputImage( componentImages[component] );
+      }
+    }
+
+  std::vector<itk::ContinuousIndex<double, 3> > field;
+  std::vector<unsigned char>                    inside;
+  TransformFieldThreadStruct<PixelType>         str;
+  str.Input = inputImage;
+  str.Output = outputImage;
+  str.Transform = transform;
+  str.Field = &field;
+  str.Inside = &inside;
+  str.NearestNeighbor = !list.interpolationType.compare( "nn" );
+  str.Interpolator = NULL;
+  str.Component = 0;
+  str.DefaultPixelValue = static_cast<PixelType>( list.defaultPixelValue );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  if( list.numberOfThread )
+    {
+    threader->SetNumberOfThreads( list.numberOfThread );
+    }
+
+  const itk::Size<3> size = resample->GetSize();
+  const long numberOfDivisions = std::max( 1L, std::min( static_cast<long>( list.numberOfFieldDivisions ),
+                                                         static_cast<long>( size[2] ) ) );
+  for( long division = 0; division < numberOfDivisions; division++ )
+    {
+    itk::Index<3> slabIndex = outputImage->GetLargestPossibleRegion().GetIndex();
+    itk::Size<3>  slabSize = size;
+    slabIndex[2] += size[2] * division / numberOfDivisions;
+    slabSize[2] = size[2] * ( division + 1 ) / numberOfDivisions - size[2] * division / numberOfDivisions;
+    str.Region = itk::ImageRegion<3>( slabIndex, slabSize );
+    field.resize( str.Region.GetNumberOfPixels() );
+    inside.resize( str.Region.GetNumberOfPixels() );
+
+    threader->SetSingleMethod( ComputeTransformFieldThread<PixelType>, &str );
+    threader->SingleMethodExecute();
+
+    if( allComponentsAtOnce )
+      {
+      threader->SetSingleMethod( InterpolateAllComponentsThread<PixelType>, &str );
+      threader->SingleMethodExecute();
+      continue;
+      }
+    for( unsigned int component = 0; component < componentInterpolators.size(); component++ )
+      {
+      str.Interpolator = componentInterpolators[component];
+      str.Component = component;
+      threader->SetSingleMethod( InterpolateComponentThread<PixelType>, &str );
+      threader->SingleMethodExecute();
+      }
+    }
+  return outputImage;
+}
+
 template <class PixelType>
 int Rotate( parameters & list )
 {
@@ -1221,7 +1523,8 @@ int Rotate( parameters & list )
   typedef itk::ResampleImageFilter<ImageType, ImageType>   ResampleType;
   typedef itk::Transform<double, 3, 3>                     TransformType;
   typedef itk::VectorImage<PixelType, 3>                   VectorImageType;
-  typename ImageType::Pointer image;
+  typename ImageType::Pointer              image;
+  typename VectorImageType::Pointer        inputImage;
   std::vector<typename ImageType::Pointer> vectorOfImage;
   itk::MetaDataDictionary                  dico;
   try
@@ -1237,8 +1540,19 @@ int Rotate( parameters & list )
       }
     // Save metadata dictionary
     dico = reader->GetOutput()->GetMetaDataDictionary();
-    // Separate the vector image into a vector of images
-    SeparateImages<PixelType>( reader->GetOutput(), vectorOfImage );
+    inputImage = reader->GetOutput();
+    if( list.cacheTransform )
+      {
+      // Only the geometry of the input image is needed to set up the transform
+      image = ImageType::New();
+      image->CopyInformation( inputImage );
+      }
+    else
+      {
+      // Separate the vector image into a vector of images
+      SeparateImages<PixelType>( inputImage, vectorOfImage );
+      image = vectorOfImage[0];
+      }
     }
   catch( itk::ExceptionObject exception )
     {
@@ -1250,29 +1564,37 @@ int Rotate( parameters & list )
   interpol = SetInterpolator<ImageType>( list );
   // Create resampler and initialize its output parameters
   typename ResampleType::Pointer resample = ResampleType::New();
-  SetOutputParameters<ImageType>( list, resample, vectorOfImage[0] );
+  SetOutputParameters<ImageType>( list, resample, image );
   TransformType::Pointer transform;
   // Load transforms and compute a merged transform
-  transform = SetAllTransform<ImageType>( list, resample, vectorOfImage[0] );
+  transform = SetAllTransform<ImageType>( list, resample, image );
   if( !transform )
     {
     return EXIT_FAILURE;
     }
-  resample->SetTransform( transform );
-  resample->SetInterpolator( interpol );
-  std::vector<typename ImageType::Pointer> vectorOutputImage;
-  // Resample all the images separately
-  for( ::size_t idx = 0; idx < vectorOfImage.size(); idx++ )
+  typename itk::VectorImage<PixelType, 3>::Pointer outputImage;
+  if( list.cacheTransform )
     {
-    resample->SetInput( vectorOfImage[idx] );
-    resample->Update();
-    vectorOutputImage.push_back( resample->GetOutput() );
-    vectorOutputImage[idx]->DisconnectPipeline();
+    // Evaluate the transform once for all the components
+    outputImage = ResampleWithTransformField<PixelType>( list, inputImage, resample, transform );
+    }
+  else
+    {
+    resample->SetTransform( transform );
+    resample->SetInterpolator( interpol );
+    std::vector<typename ImageType::Pointer> vectorOutputImage;
+    // Resample all the images separately
+    for( ::size_t idx = 0; idx < vectorOfImage.size(); idx++ )
+      {
+      resample->SetInput( vectorOfImage[idx] );
+      resample->Update();
+      vectorOutputImage.push_back( resample->GetOutput() );
+      vectorOutputImage[idx]->DisconnectPipeline();
+      }
+    outputImage = itk::VectorImage<PixelType, 3>::New();
+    AddImage<PixelType>( outputImage, vectorOutputImage );
+    vectorOutputImage.clear();
     }
-  typename itk::VectorImage<PixelType, 3>::Pointer outputImage;
-  outputImage = itk::VectorImage<PixelType, 3>::New();
-  AddImage<PixelType>( outputImage, vectorOutputImage );
-  vectorOutputImage.clear();
   // If necessary, transform gradient vectors with the loaded transformations
   int dwmriProblem = CheckDWMRI( dico, transform );
   if( list.space ) // && list.transformationFile.compare( "" ) )
@@ -1333,6 +1655,8 @@ int main( int argc, char * argv[] )
   list.imageCenter = imageCenter;
   list.transformsOrder = transformsOrder;
   list.notbulk = notbulk;
+  list.cacheTransform = cacheTransform;
+  list.numberOfFieldDivisions = numberOfFieldDivisions;
   // verify if all the vector parameters have the good length
   if( list.outputImageSpacing.size() != 3 || list.outputImageSize.size() != 3
       || ( list.outputImageOrigin.size() != 3
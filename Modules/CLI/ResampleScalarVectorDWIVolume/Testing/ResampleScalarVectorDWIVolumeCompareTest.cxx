@@ -0,0 +1,105 @@
+
+// ITK includes
+#include <itkImageFileReader.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkMetaDataObject.h>
+#include <itkVectorImage.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Compare two vector or DWI volumes component by component, with their DWMRI
+// attributes (b-value and gradients). The image comparison of itkTestMain
+// reads vector volumes as scalar volumes, it only compares a combination of
+// the first components.
+int ResampleScalarVectorDWIVolumeCompareTest(int argc, char * argv[])
+{
+  if( argc < 3 )
+    {
+    std::cerr << argv[0] << " <baselineVolume> <testVolume> [intensityTolerance]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const double intensityTolerance = ( argc > 3 ? atof( argv[3] ) : 0.0 );
+
+  typedef itk::VectorImage<float, 3>       ImageType;
+  typedef itk::ImageFileReader<ImageType> ReaderType;
+  ReaderType::Pointer baselineReader = ReaderType::New();
+  baselineReader->SetFileName( argv[1] );
+  ReaderType::Pointer testReader = ReaderType::New();
+  testReader->SetFileName( argv[2] );
+  try
+    {
+    baselineReader->Update();
+    testReader->Update();
+    }
+  catch( itk::ExceptionObject & excep )
+    {
+    std::cerr << "Failed to read the volumes: " << excep << std::endl;
+    return EXIT_FAILURE;
+    }
+  ImageType::Pointer baseline = baselineReader->GetOutput();
+  ImageType::Pointer test = testReader->GetOutput();
+
+  if( baseline->GetLargestPossibleRegion() != test->GetLargestPossibleRegion()
+      || baseline->GetNumberOfComponentsPerPixel() != test->GetNumberOfComponentsPerPixel() )
+    {
+    std::cerr << "Volume " << argv[2] << " has size " << test->GetLargestPossibleRegion().GetSize()
+              << " and " << test->GetNumberOfComponentsPerPixel() << " components, expected "
+              << baseline->GetLargestPossibleRegion().GetSize() << " and "
+              << baseline->GetNumberOfComponentsPerPixel() << " components" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  unsigned int numberOfComponents = baseline->GetNumberOfComponentsPerPixel();
+  unsigned int numberOfDifferences = 0;
+  itk::ImageRegionConstIterator<ImageType> baselineIt( baseline, baseline->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<ImageType> testIt( test, test->GetLargestPossibleRegion() );
+  for( ; !baselineIt.IsAtEnd(); ++baselineIt, ++testIt )
+    {
+    ImageType::PixelType baselinePixel = baselineIt.Get();
+    ImageType::PixelType testPixel = testIt.Get();
+    for( unsigned int c = 0; c < numberOfComponents; c++ )
+      {
+      if( std::fabs( testPixel[c] - baselinePixel[c] ) > intensityTolerance )
+        {
+        if( ++numberOfDifferences <= 10 )
+          {
+          std::cerr << "Voxel " << testIt.GetIndex() << ", component " << c << ": "
+                    << testPixel[c] << " instead of " << baselinePixel[c] << std::endl;
+          }
+        }
+      }
+    }
+  if( numberOfDifferences > 0 )
+    {
+    std::cerr << numberOfDifferences << " voxel components differ" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Gradients are transformed the same way whether the transform is cached or not
+  const itk::MetaDataDictionary & baselineDictionary = baseline->GetMetaDataDictionary();
+  const itk::MetaDataDictionary & testDictionary = test->GetMetaDataDictionary();
+  std::vector<std::string> keys = baselineDictionary.GetKeys();
+  for( std::vector<std::string>::const_iterator keyIt = keys.begin(); keyIt != keys.end(); ++keyIt )
+    {
+    if( keyIt->find( "DWMRI_" ) != 0 )
+      {
+      continue;
+      }
+    std::string baselineValue;
+    std::string testValue;
+    itk::ExposeMetaData<std::string>( baselineDictionary, *keyIt, baselineValue );
+    if( !itk::ExposeMetaData<std::string>( testDictionary, *keyIt, testValue )
+        || testValue != baselineValue )
+      {
+      std::cerr << *keyIt << " is \"" << testValue << "\" instead of \"" << baselineValue << "\"" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
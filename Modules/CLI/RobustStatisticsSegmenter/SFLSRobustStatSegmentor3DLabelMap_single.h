@@ -3,6 +3,9 @@
 
 #include "SFLSSegmentor3D.h"
 
+// itk
+#include "itkMultiThreader.h"
+
 #include <list>
 #include <vector>
 
@@ -69,6 +72,9 @@ public:
 
   void setIntensityHomogeneity(double h);
 
+  // the force on the zero level set is computed by that many threads
+  void setNumberOfThreads(long n);
+
 protected:
   /* data */
   TLabelImagePointer              m_inputLabelImage;
@@ -91,6 +97,8 @@ protected:
 
   double m_kernelWidthFactor; // kernel_width = empirical_std/m_kernelWidthFactor, Eric has it at 10.0
 
+  long m_numberOfThreads;
+
   /* fn */
   void initFeatureComputedImage();
 
@@ -101,6 +109,20 @@ protected:
 
   void getRobustStatistics(std::vector<double>& samples, std::vector<double>& robustStat);
 
+  // (1 - l)*s[k] + l*s[k + 1] where s is samples sorted, found by selection
+  double interpolatedOrderStatistic(std::vector<double>& samples, long k, double l);
+
+  // each thread computes the kappa and the data force of a contiguous part
+  // of the zero level set
+  struct ComputeForceThreadStruct
+  {
+    Self* segmentor;
+    const std::vector<typename CSFLSLayer::iterator>* zeroLayer;
+    double* kappa;
+    double* cvForce;
+  };
+  static ITK_THREAD_RETURN_TYPE computeForceThreaderCallback(void* arg);
+
   void inputLableImageToSeeds();
 
   void seedToMask();
@@ -30,6 +30,8 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
 
   m_kernelWidthFactor = 10.0;
 
+  m_numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
   m_inputImageIntensityMin = 0;
   m_inputImageIntensityMax = 0;
 
@@ -95,32 +97,23 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
       }
     }
 
-// #ifndef NDEBUG
-//     std::ofstream ff("/tmp/force.txt");
-// #endif
-  for( long i = 0; i < n; ++i )
-    {
-    typename CSFLSLayer::iterator itz = m_lzIterVct[i];
-
-    long ix = (*itz)[0];
-    long iy = (*itz)[1];
-    long iz = (*itz)[2];
-
-    TIndex idx = {{ix, iy, iz}};
-
-    kappaOnZeroLS[i] = this->computeKappa(ix, iy, iz);
+  /* A point of the zero level set is only once in m_lz, so the
+     threads compute and cache the features of different voxels. */
+  ComputeForceThreadStruct str;
+  str.segmentor = this;
+  str.zeroLayer = &m_lzIterVct;
+  str.kappa = kappaOnZeroLS;
+  str.cvForce = cvForce;
 
-    std::vector<double> f(m_numberOfFeature);
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( std::max(1L, std::min(m_numberOfThreads, n) ) );
+  threader->SetSingleMethod(computeForceThreaderCallback, &str);
+  threader->SingleMethodExecute();
 
-    computeFeatureAt(idx, f);
-
-    // double a = -kernelEvaluation(f);
-    double a = -kernelEvaluationUsingPDF(f);
-
-    fmax = fmax > fabs(a) ? fmax : fabs(a);
+  for( long i = 0; i < n; ++i )
+    {
+    fmax = fmax > fabs(cvForce[i]) ? fmax : fabs(cvForce[i]);
     kappaMax = kappaMax > fabs(kappaOnZeroLS[i]) ? kappaMax : fabs(kappaOnZeroLS[i]);
-
-    cvForce[i] = a;
     }
 
   // std::cout<<"fmax = "<<fmax<<std::endl;
@@ -137,6 +130,41 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
   delete[] cvForce;
 }
 
+/* ============================================================  */
+template <typename TPixel>
+ITK_THREAD_RETURN_TYPE
+CSFLSRobustStatSegmentor3DLabelMap<TPixel>
+::computeForceThreaderCallback(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  ComputeForceThreadStruct*             str = static_cast<ComputeForceThreadStruct*>(info->UserData);
+
+  long n = str->zeroLayer->size();
+  long begin = n * info->ThreadID / info->NumberOfThreads;
+  long end = n * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  std::vector<double> f(m_numberOfFeature);
+  for( long i = begin; i < end; ++i )
+    {
+    typename CSFLSLayer::iterator itz = (*str->zeroLayer)[i];
+
+    long ix = (*itz)[0];
+    long iy = (*itz)[1];
+    long iz = (*itz)[2];
+
+    TIndex idx = {{ix, iy, iz}};
+
+    str->kappa[i] = str->segmentor->computeKappa(ix, iy, iz);
+
+    str->segmentor->computeFeatureAt(idx, f);
+
+    // double a = -kernelEvaluation(f);
+    str->cvForce[i] = -str->segmentor->kernelEvaluationUsingPDF(f);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 /* ============================================================  */
 template <typename TPixel>
 void
@@ -269,6 +297,7 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
     {
     // compute the feature
     std::vector<double> neighborIntensities;
+    neighborIntensities.reserve( (2 * m_statNeighborX + 1) * (2 * m_statNeighborY + 1) * (2 * m_statNeighborZ + 1) );
 
     long ix = idx[0];
     long iy = idx[1];
@@ -422,11 +451,10 @@ void
 CSFLSRobustStatSegmentor3DLabelMap<TPixel>
 ::getRobustStatistics(std::vector<double>& samples, std::vector<double>& robustStat)
 {
-  /* note, sample is sorted, so the order is changed */
+  /* note, the order of samples is changed. The quantiles are found by
+     selection, there is no need to sort all the samples. */
   robustStat.resize(m_numberOfFeature);
 
-  std::sort(samples.begin(), samples.end() );
-
   double n = samples.size();
 
   double q1 = n / 4.0;
@@ -441,10 +469,10 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
   double q3_floor;
   double l3 = modf(q3, &q3_floor);
 
-  double median = (1 - l2) * samples[static_cast<long>(q2_floor)] + l2 * samples[static_cast<long>(q2_floor) + 1];
+  double median = interpolatedOrderStatistic(samples, static_cast<long>(q2_floor), l2);
 
-  double iqr = ( (1 - l3) * samples[static_cast<long>(q3_floor)] + l3 * samples[static_cast<long>(q3_floor) + 1] ) \
-    - ( (1 - l1) * samples[static_cast<long>(q1_floor)] + l1 * samples[static_cast<long>(q1_floor) + 1] );
+  double iqr = interpolatedOrderStatistic(samples, static_cast<long>(q3_floor), l3) \
+    - interpolatedOrderStatistic(samples, static_cast<long>(q1_floor), l1);
 
   robustStat[0] = median;
   robustStat[1] = iqr;
@@ -457,15 +485,34 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
     samplesDeMedian[i] = fabs(samples[i] - median);
     }
 
-  std::sort(samplesDeMedian.begin(), samplesDeMedian.end() );
-
-  double mad =
-    (1 - l2) * samplesDeMedian[static_cast<long>(q2_floor)] + l2 * samplesDeMedian[static_cast<long>(q2_floor) + 1];
+  double mad = interpolatedOrderStatistic(samplesDeMedian, static_cast<long>(q2_floor), l2);
   robustStat[2] = mad;
 
   return;
 }
 
+/* ============================================================ */
+template <typename TPixel>
+double
+CSFLSRobustStatSegmentor3DLabelMap<TPixel>
+::interpolatedOrderStatistic(std::vector<double>& samples, long k, double l)
+{
+  long n = samples.size();
+  k = std::min(k, n - 1);
+
+  std::nth_element(samples.begin(), samples.begin() + k, samples.end() );
+  double sk = samples[k];
+  if( l == 0 || k + 1 >= n )
+    {
+    return sk;
+    }
+
+  // after nth_element, the samples after k are not smaller than samples[k]
+  double sk1 = *std::min_element(samples.begin() + k + 1, samples.end() );
+
+  return (1 - l) * sk + l * sk1;
+}
+
 /* ============================================================ */
 template <typename TPixel>
 void
@@ -777,6 +824,17 @@ CSFLSRobustStatSegmentor3DLabelMap<TPixel>
   return;
 }
 
+/* ============================================================  */
+template <typename TPixel>
+void
+CSFLSRobustStatSegmentor3DLabelMap<TPixel>
+::setNumberOfThreads(long n)
+{
+  m_numberOfThreads = n < 1 ? 1 : n;
+
+  return;
+}
+
 /* ============================================================  */
 template <typename TPixel>
 void
@@ -0,0 +1,113 @@
+#include "SFLSRobustStatSegmentor3DLabelMap_single.h"
+
+// ITK includes
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+#include <itkTimeProbe.h>
+
+typedef short                                         PixelType;
+typedef CSFLSRobustStatSegmentor3DLabelMap<PixelType> SegmentorType;
+typedef SegmentorType::TImage                         ImageType;
+typedef SegmentorType::TLabelImage                    LabelImageType;
+typedef SegmentorType::LSImageType                    LevelSetImageType;
+
+// Sphere of radius r in the center of the image, with deterministic noise
+template <typename TImage>
+typename TImage::Pointer
+createSphereImage(long size, double r, typename TImage::PixelType inside, typename TImage::PixelType noise)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::RegionType region;
+  typename TImage::SizeType imageSize = {{size, size, size}};
+  region.SetSize(imageSize);
+  image->SetRegions(region);
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<TImage> it(image, region);
+  unsigned long seed = 1;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    typename TImage::IndexType idx = it.GetIndex();
+    double d2 = 0;
+    for( int i = 0; i < 3; ++i )
+      {
+      d2 += (idx[i] - size / 2.0) * (idx[i] - size / 2.0);
+      }
+    seed = seed * 1103515245 + 12345;
+    typename TImage::PixelType v = d2 <= r * r ? inside : 0;
+    if( noise > 0 )
+      {
+      v += static_cast<typename TImage::PixelType>( (seed >> 16) % noise);
+      }
+    it.Set(v);
+    }
+  return image;
+}
+
+LevelSetImageType::Pointer
+segment(ImageType::Pointer image, LabelImageType::Pointer label, long numberOfThreads, double& seconds)
+{
+  SegmentorType seg;
+  seg.setNumberOfThreads(numberOfThreads);
+  seg.setImage(image);
+  seg.setNumIter(10000);
+  seg.setMaxVolume(30.0); // mL, the sphere is about 33.5 mL
+  seg.setInputLabelImage(label);
+  seg.setMaxRunningTime(10000);
+  seg.setIntensityHomogeneity(0.1);
+  seg.setCurvatureWeight(0.2 / 1.5);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  seg.doSegmenation();
+  probe.Stop();
+  seconds = probe.GetTotal();
+
+  return seg.mp_phi;
+}
+
+int main(int argc, char* * argv)
+{
+  long size = argc > 1 ? atol(argv[1]) : 96;
+
+  ImageType::Pointer      image = createSphereImage<ImageType>(size, 20, 150, 30);
+  LabelImageType::Pointer label = createSphereImage<LabelImageType>(size, 5, 1, 0);
+
+  long numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  double                     singleThreadTime = 0;
+  LevelSetImageType::Pointer singleThreadPhi = segment(image, label, 1, singleThreadTime);
+  double                     multiThreadTime = 0;
+  LevelSetImageType::Pointer multiThreadPhi = segment(image, label, numberOfThreads, multiThreadTime);
+
+  std::cout << "Segmentation of a " << size << "^3 image" << std::endl;
+  std::cout << "  1 thread: " << singleThreadTime << " s" << std::endl;
+  std::cout << "  " << numberOfThreads << " threads: " << multiThreadTime << " s" << std::endl;
+
+  // the result must not depend on the number of threads
+  itk::ImageRegionConstIterator<LevelSetImageType> it1(singleThreadPhi, singleThreadPhi->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator<LevelSetImageType> it2(multiThreadPhi, multiThreadPhi->GetLargestPossibleRegion() );
+  long numberOfInsideVoxels = 0;
+  for( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      std::cerr << "Error: level set function differs at " << it1.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( it1.Get() <= 0 )
+      {
+      ++numberOfInsideVoxels;
+      }
+    }
+
+  // the seed must have grown
+  if( numberOfInsideVoxels <= 4 * 4 * 4 )
+    {
+    std::cerr << "Error: the segmentation did not grow, " << numberOfInsideVoxels << " voxels inside" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -24,6 +24,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QPixmap>
+#include <QProgressDialog>
 
 // CTK includes
 #include <ctkMessageBox.h>
@@ -31,6 +32,7 @@
 
 // QtCore includes
 #include "qMRMLUtils.h"
+#include "qSlicerArchiveThread.h"
 #include "qSlicerCoreApplication.h"
 #include "qSlicerSceneWriter.h"
 #include "vtkSlicerApplicationLogic.h"
@@ -255,10 +257,36 @@ bool qSlicerSceneWriter::writeToMRB(const qSlicerIO::IOProperties& properties)
     return false;
     }
 
+  // compress in a background thread, the user can follow the progress and
+  // cancel the save. The progress dialog is application modal and shown
+  // right away so that no other action can be triggered while waiting.
+  // The zip file is replaced only once compressed: canceling keeps an
+  // existing file.
   qDebug() << "zipping to " << fileInfo.absoluteFilePath();
-  if ( !applicationLogic->Zip(fileInfo.absoluteFilePath().toLatin1(),
-                              bundlePath.toLatin1()) )
+  qSlicerArchiveThread zipThread;
+  zipThread.setOperation(qSlicerArchiveThread::Zip);
+  zipThread.setArchiveFileName(fileInfo.absoluteFilePath());
+  zipThread.setDirectory(bundlePath);
+  QProgressDialog progressDialog(tr("Compressing %1...").arg(fileInfo.fileName()),
+                                 tr("Cancel"), 0, 100);
+  progressDialog.setWindowTitle(tr("Save scene as MRB"));
+  progressDialog.setWindowModality(Qt::ApplicationModal);
+  progressDialog.setValue(0);
+  progressDialog.show();
+  QObject::connect(&zipThread, SIGNAL(progressChanged(int)),
+                   &progressDialog, SLOT(setValue(int)), Qt::QueuedConnection);
+  QObject::connect(&progressDialog, SIGNAL(canceled()),
+                   &zipThread, SLOT(cancel()), Qt::DirectConnection);
+  bool zipped = zipThread.runAndWait(QEventLoop::AllEvents);
+  progressDialog.reset();
+  if (!zipped)
     {
+    ctk::removeDirRecursively(bundlePath);
+    if (zipThread.wasCanceled())
+      {
+      qDebug() << "saving" << fileInfo.absoluteFilePath() << "canceled";
+      return false;
+      }
     QMessageBox::critical(0, tr("Save scene as MRB"), tr("Could not compress bundle"));
     return false;
     }
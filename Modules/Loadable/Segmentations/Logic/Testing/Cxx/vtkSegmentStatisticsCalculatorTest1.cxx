@@ -0,0 +1,203 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkSegmentStatisticsCalculator.h"
+
+// SegmentationCore includes
+#include <vtkOrientedImageData.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+const int DIMENSIONS[3] = {40, 30, 20};
+const double PERCENTILES[7] = {0., 5., 25., 50., 75., 95., 100.};
+
+//----------------------------------------------------------------------------
+// Deterministic pseudo-random sequence, so that the test does not depend on
+// the standard library implementation
+unsigned int NextRandom(unsigned int& state)
+{
+  state = state * 1103515245u + 12345u;
+  return (state >> 8) & 0xffffff;
+}
+
+//----------------------------------------------------------------------------
+void InitializeImage(vtkOrientedImageData* image, int scalarType)
+{
+  image->SetDimensions(DIMENSIONS[0], DIMENSIONS[1], DIMENSIONS[2]);
+  image->SetSpacing(0.5, 1.0, 2.0);
+  image->SetOrigin(-10.0, 5.0, 3.0);
+  image->AllocateScalars(scalarType, 1);
+}
+
+//----------------------------------------------------------------------------
+// Segment 0: ellipsoid, segment 1: box, segment 2: empty
+void CreateSegments(vtkOrientedImageData* segments[3])
+{
+  for (int segmentIndex = 0; segmentIndex < 3; ++segmentIndex)
+    {
+    InitializeImage(segments[segmentIndex], VTK_UNSIGNED_CHAR);
+    unsigned char* labels = static_cast<unsigned char*>(segments[segmentIndex]->GetScalarPointer());
+    for (int k = 0; k < DIMENSIONS[2]; ++k)
+      {
+      for (int j = 0; j < DIMENSIONS[1]; ++j)
+        {
+        for (int i = 0; i < DIMENSIONS[0]; ++i, ++labels)
+          {
+          bool inside = false;
+          if (segmentIndex == 0)
+            {
+            double x = (i - 20) / 15.0;
+            double y = (j - 12) / 10.0;
+            double z = (k - 9) / 7.0;
+            inside = (x * x + y * y + z * z <= 1.0);
+            }
+          else if (segmentIndex == 1)
+            {
+            inside = (i >= 25 && i < 38 && j >= 2 && j < 28 && k >= 14 && k < 19);
+            }
+          *labels = inside ? 1 : 0;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void FillScalars(vtkOrientedImageData* image, double minimum, double range, bool integer)
+{
+  unsigned int state = 1;
+  T* scalars = static_cast<T*>(image->GetScalarPointer());
+  vtkIdType numberOfVoxels = image->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    double value = minimum + range * NextRandom(state) / double(0xffffff);
+    scalars[i] = static_cast<T>(integer ? floor(value) : value);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Reference statistics computed by sorting the values of all the voxels inside the segment
+int CheckSegmentStatistics(vtkSegmentStatisticsCalculator* calculator, int segmentIndex,
+  vtkOrientedImageData* segment, vtkOrientedImageData* scalarVolume)
+{
+  std::vector<double> values;
+  vtkIdType numberOfVoxels = scalarVolume->GetNumberOfPoints();
+  unsigned char* labels = static_cast<unsigned char*>(segment->GetScalarPointer());
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    if (labels[i] > 0)
+      {
+      values.push_back(scalarVolume->GetPointData()->GetScalars()->GetComponent(i, 0));
+      }
+    }
+  std::sort(values.begin(), values.end());
+
+  CHECK_INT(calculator->GetVoxelCount(segmentIndex), static_cast<int>(values.size()));
+  if (values.empty())
+    {
+    CHECK_DOUBLE(calculator->GetPercentileValue(segmentIndex, 0), 0.0);
+    return EXIT_SUCCESS;
+    }
+  double sum = 0.0;
+  for (size_t i = 0; i < values.size(); ++i)
+    {
+    sum += values[i];
+    }
+  CHECK_DOUBLE(calculator->GetMinimum(segmentIndex), values.front());
+  CHECK_DOUBLE(calculator->GetMaximum(segmentIndex), values.back());
+  CHECK_DOUBLE_TOLERANCE(calculator->GetMean(segmentIndex), sum / values.size(), 1e-6 * fabs(sum / values.size()) + 1e-9);
+
+  // Nearest-rank percentiles
+  for (int p = 0; p < 7; ++p)
+    {
+    vtkIdType rank = std::max(vtkIdType(1), static_cast<vtkIdType>(ceil(PERCENTILES[p] / 100.0 * values.size())));
+    CHECK_DOUBLE(calculator->GetPercentileValue(segmentIndex, p), values[rank - 1]);
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestPercentiles(int scalarType, double minimum, double range)
+{
+  vtkNew<vtkOrientedImageData> segment0;
+  vtkNew<vtkOrientedImageData> segment1;
+  vtkNew<vtkOrientedImageData> segment2;
+  vtkOrientedImageData* segments[3] = {segment0.GetPointer(), segment1.GetPointer(), segment2.GetPointer()};
+  CreateSegments(segments);
+
+  vtkNew<vtkOrientedImageData> scalarVolume;
+  InitializeImage(scalarVolume.GetPointer(), scalarType);
+  switch (scalarType)
+    {
+    vtkTemplateMacro(FillScalars<VTK_TT>(scalarVolume.GetPointer(), minimum, range,
+      scalarType != VTK_FLOAT && scalarType != VTK_DOUBLE));
+    }
+
+  // Results must not depend on how the work is split between threads
+  const int numberOfThreads[2] = {1, 4};
+  for (int t = 0; t < 2; ++t)
+    {
+    vtkNew<vtkSegmentStatisticsCalculator> calculator;
+    calculator->SetNumberOfThreads(numberOfThreads[t]);
+    calculator->SetScalarVolume(scalarVolume.GetPointer());
+    for (int segmentIndex = 0; segmentIndex < 3; ++segmentIndex)
+      {
+      CHECK_INT(calculator->AddSegment(segments[segmentIndex]), segmentIndex);
+      }
+    for (int p = 0; p < 7; ++p)
+      {
+      calculator->AddPercentile(PERCENTILES[p]);
+      }
+    CHECK_BOOL(calculator->Update(), true);
+    for (int segmentIndex = 0; segmentIndex < 3; ++segmentIndex)
+      {
+      CHECK_EXIT_SUCCESS(CheckSegmentStatistics(calculator.GetPointer(), segmentIndex,
+        segments[segmentIndex], scalarVolume.GetPointer()));
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculatorTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Integer scalars with a narrow range: histogram
+  CHECK_EXIT_SUCCESS(TestPercentiles(VTK_SHORT, -1000., 4000.));
+  CHECK_EXIT_SUCCESS(TestPercentiles(VTK_UNSIGNED_CHAR, 0., 255.));
+  // Integer scalars with a range wider than the histogram: sorted values
+  CHECK_EXIT_SUCCESS(TestPercentiles(VTK_INT, -5e6, 1e7));
+  // Floating point scalars: sorted values
+  CHECK_EXIT_SUCCESS(TestPercentiles(VTK_FLOAT, -1., 2.));
+  CHECK_EXIT_SUCCESS(TestPercentiles(VTK_DOUBLE, 1e3, 1e6));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,702 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkSegmentStatisticsCalculator.h"
+
+// SegmentationCore includes
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkAbstractTransform.h>
+#include <vtkGeneralTransform.h>
+#include <vtkMath.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Maximum number of voxels processed by a thread at once
+const vtkIdType MAXIMUM_NUMBER_OF_VOXELS_PER_WORK_ITEM = 1 << 20;
+// Maximum number of bins of the histogram used for computing percentiles
+// of integer scalars. Each thread fills its own histogram of each segment, so
+// the number of bins is capped (65536 covers 8 and 16 bit images). Values of
+// segments with a larger range are collected and partially sorted instead.
+const double MAXIMUM_NUMBER_OF_HISTOGRAM_BINS = 1 << 16;
+
+//----------------------------------------------------------------------------
+/// Statistics of the voxels of a segment visited by one thread
+struct SegmentAccumulator
+{
+  SegmentAccumulator()
+    : VoxelCount(0), Sum(0.0), SumOfSquares(0.0), Minimum(VTK_DOUBLE_MAX), Maximum(VTK_DOUBLE_MIN)
+    {}
+  vtkIdType VoxelCount;
+  double Sum;
+  double SumOfSquares;
+  double Minimum;
+  double Maximum;
+};
+
+//----------------------------------------------------------------------------
+/// Slab of the union of the effective extents of all the segments,
+/// processed by one thread for all the segments at once
+struct WorkItem
+{
+  int Extent[6];
+  /// Number of voxels of each segment in the slab, counted by the first pass
+  std::vector<vtkIdType> VoxelCounts;
+  /// Index of the first value of the slab in the collected values of each segment
+  std::vector<vtkIdType> ValueOffsets;
+};
+
+//----------------------------------------------------------------------------
+struct ThreadData
+{
+  vtkImageData* ScalarVolume;
+  /// Per segment, labelmap in the scalar volume geometry (NULL if the segment is empty)
+  /// and its effective extent
+  std::vector<vtkImageData*> Labelmaps;
+  std::vector<int> Extents;
+  std::vector<WorkItem>* WorkItems;
+  /// If false, count, sum, minimum and maximum are computed.
+  /// If true, histograms or values are collected for percentile computation.
+  bool CollectValues;
+  /// Per segment, first value of the histogram or NaN if values are collected
+  std::vector<double> HistogramOffsets;
+  std::vector<vtkIdType> HistogramSizes;
+
+  /// Per thread and segment
+  std::vector<std::vector<SegmentAccumulator> > Accumulators;
+  std::vector<std::vector<std::vector<vtkIdType> > > Histograms;
+  /// Per segment, values of all the work items, each one written at its offset
+  std::vector<std::vector<double> > Values;
+
+  vtkSimpleCriticalSection Lock;
+  size_t NextWorkItem;
+};
+
+//----------------------------------------------------------------------------
+template <class TLabel>
+void GetInsideMask(TLabel* labelRow, int length, char* mask)
+{
+  for (int i = 0; i < length; ++i)
+    {
+    mask[i] = (labelRow[i] > 0);
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class TScalar>
+void GetScalarRow(TScalar* scalarRow, int length, int numberOfComponents, double* values)
+{
+  for (int i = 0; i < length; ++i, scalarRow += numberOfComponents)
+    {
+    values[i] = static_cast<double>(*scalarRow);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Visit each row of the slab once: the scalars of the row are read once and
+// shared by all the segments that intersect the row.
+void ProcessWorkItem(ThreadData* data, int threadId, WorkItem& item)
+{
+  vtkImageData* scalarVolume = data->ScalarVolume;
+  const int* extent = item.Extent;
+  int rowLength = extent[1] - extent[0] + 1;
+  std::vector<char> mask(rowLength);
+  std::vector<double> scalars(scalarVolume ? rowLength : 0);
+  int numberOfComponents = scalarVolume ? scalarVolume->GetNumberOfScalarComponents() : 1;
+  int numberOfSegments = static_cast<int>(data->Labelmaps.size());
+  std::vector<SegmentAccumulator>& accumulators = data->Accumulators[threadId];
+  std::vector<std::vector<vtkIdType> >& histograms = data->Histograms[threadId];
+  std::vector<vtkIdType> valueIndices;
+  if (data->CollectValues)
+    {
+    valueIndices = item.ValueOffsets;
+    }
+  else
+    {
+    item.VoxelCounts.assign(numberOfSegments, 0);
+    }
+
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      bool scalarsRead = false;
+      for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+        {
+        vtkImageData* labelmap = data->Labelmaps[segmentIndex];
+        const int* segmentExtent = labelmap ? &data->Extents[6 * segmentIndex] : NULL;
+        if (!segmentExtent
+          || j < segmentExtent[2] || j > segmentExtent[3]
+          || k < segmentExtent[4] || k > segmentExtent[5])
+          {
+          continue;
+          }
+        int segmentRowLength = segmentExtent[1] - segmentExtent[0] + 1;
+        void* labelRow = labelmap->GetScalarPointer(segmentExtent[0], j, k);
+        switch (labelmap->GetScalarType())
+          {
+          vtkTemplateMacro(GetInsideMask(static_cast<VTK_TT*>(labelRow), segmentRowLength, &mask[0]));
+          default:
+            continue;
+          }
+        if (!scalarVolume)
+          {
+          // Only count voxels
+          vtkIdType count = 0;
+          for (int i = 0; i < segmentRowLength; ++i)
+            {
+            count += mask[i];
+            }
+          accumulators[segmentIndex].VoxelCount += count;
+          item.VoxelCounts[segmentIndex] += count;
+          continue;
+          }
+        if (!scalarsRead)
+          {
+          void* scalarRow = scalarVolume->GetScalarPointer(extent[0], j, k);
+          switch (scalarVolume->GetScalarType())
+            {
+            vtkTemplateMacro(GetScalarRow(static_cast<VTK_TT*>(scalarRow), rowLength, numberOfComponents, &scalars[0]));
+            default:
+              return;
+            }
+          scalarsRead = true;
+          }
+        const double* values = &scalars[segmentExtent[0] - extent[0]];
+        if (!data->CollectValues)
+          {
+          SegmentAccumulator& accumulator = accumulators[segmentIndex];
+          vtkIdType count = 0;
+          for (int i = 0; i < segmentRowLength; ++i)
+            {
+            if (!mask[i])
+              {
+              continue;
+              }
+            double value = values[i];
+            ++count;
+            accumulator.Sum += value;
+            accumulator.SumOfSquares += value * value;
+            accumulator.Minimum = std::min(accumulator.Minimum, value);
+            accumulator.Maximum = std::max(accumulator.Maximum, value);
+            }
+          accumulator.VoxelCount += count;
+          item.VoxelCounts[segmentIndex] += count;
+          }
+        else if (!vtkMath::IsNan(data->HistogramOffsets[segmentIndex]))
+          {
+          std::vector<vtkIdType>& histogram = histograms[segmentIndex];
+          if (histogram.empty())
+            {
+            histogram.assign(data->HistogramSizes[segmentIndex], 0);
+            }
+          double histogramOffset = data->HistogramOffsets[segmentIndex];
+          for (int i = 0; i < segmentRowLength; ++i)
+            {
+            if (mask[i])
+              {
+              ++histogram[static_cast<vtkIdType>(values[i] - histogramOffset)];
+              }
+            }
+          }
+        else
+          {
+          double* segmentValues = &data->Values[segmentIndex][0];
+          vtkIdType& valueIndex = valueIndices[segmentIndex];
+          for (int i = 0; i < segmentRowLength; ++i)
+            {
+            if (mask[i])
+              {
+              segmentValues[valueIndex++] = values[i];
+              }
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ThreadData* data = static_cast<ThreadData*>(info->UserData);
+  std::vector<WorkItem>& workItems = *data->WorkItems;
+  while (true)
+    {
+    data->Lock.Lock();
+    size_t workItemIndex = data->NextWorkItem++;
+    data->Lock.Unlock();
+    if (workItemIndex >= workItems.size())
+      {
+      break;
+      }
+    ProcessWorkItem(data, info->ThreadID, workItems[workItemIndex]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool IsIdentityTransform(vtkAbstractTransform* transform)
+{
+  if (transform == NULL)
+    {
+    return true;
+    }
+  vtkGeneralTransform* generalTransform = vtkGeneralTransform::SafeDownCast(transform);
+  return generalTransform && generalTransform->GetNumberOfConcatenatedTransforms() == 0;
+}
+
+//----------------------------------------------------------------------------
+// Nearest-rank percentile of a histogram
+double GetHistogramPercentile(const std::vector<vtkIdType>& histogram, double offset,
+                              vtkIdType count, double percentile)
+{
+  vtkIdType rank = std::max(vtkIdType(1), static_cast<vtkIdType>(ceil(percentile / 100.0 * count)));
+  vtkIdType cumulativeCount = 0;
+  for (size_t bin = 0; bin < histogram.size(); ++bin)
+    {
+    cumulativeCount += histogram[bin];
+    if (cumulativeCount >= rank)
+      {
+      return offset + bin;
+      }
+    }
+  return offset + histogram.size() - 1;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkSegmentStatisticsCalculator::vtkInternal
+{
+public:
+  struct SegmentStatistics
+  {
+    vtkIdType VoxelCount;
+    double VoxelVolume;
+    double Sum;
+    double SumOfSquares;
+    double Minimum;
+    double Maximum;
+    std::vector<double> PercentileValues;
+  };
+
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > Segments;
+  std::vector<double> Percentiles;
+  std::vector<SegmentStatistics> Statistics;
+
+  /// Return NULL if the index is out of range or statistics are not computed
+  SegmentStatistics* GetStatistics(int segmentIndex)
+    {
+    if (segmentIndex < 0 || segmentIndex >= static_cast<int>(this->Statistics.size()))
+      {
+      return NULL;
+      }
+    return &this->Statistics[segmentIndex];
+    }
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSegmentStatisticsCalculator);
+vtkCxxSetObjectMacro(vtkSegmentStatisticsCalculator, ScalarVolume, vtkOrientedImageData);
+vtkCxxSetObjectMacro(vtkSegmentStatisticsCalculator, SegmentToScalarVolumeTransform, vtkAbstractTransform);
+
+//----------------------------------------------------------------------------
+vtkSegmentStatisticsCalculator::vtkSegmentStatisticsCalculator()
+{
+  this->ScalarVolume = NULL;
+  this->SegmentToScalarVolumeTransform = NULL;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkSegmentStatisticsCalculator::~vtkSegmentStatisticsCalculator()
+{
+  this->SetScalarVolume(NULL);
+  this->SetSegmentToScalarVolumeTransform(NULL);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "ScalarVolume: " << this->ScalarVolume << "\n";
+  os << indent << "SegmentToScalarVolumeTransform: " << this->SegmentToScalarVolumeTransform << "\n";
+  os << indent << "NumberOfSegments: " << this->Internal->Segments.size() << "\n";
+  os << indent << "NumberOfPercentiles: " << this->Internal->Percentiles.size() << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::AddSegment(vtkOrientedImageData* labelmap)
+{
+  this->Internal->Segments.push_back(labelmap);
+  this->Internal->Statistics.clear();
+  this->Modified();
+  return static_cast<int>(this->Internal->Segments.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::RemoveAllSegments()
+{
+  this->Internal->Segments.clear();
+  this->Internal->Statistics.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::GetNumberOfSegments()
+{
+  return static_cast<int>(this->Internal->Segments.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::AddPercentile(double percentile)
+{
+  this->Internal->Percentiles.push_back(std::min(100.0, std::max(0.0, percentile)));
+  this->Internal->Statistics.clear();
+  this->Modified();
+  return static_cast<int>(this->Internal->Percentiles.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSegmentStatisticsCalculator::RemoveAllPercentiles()
+{
+  this->Internal->Percentiles.clear();
+  this->Internal->Statistics.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSegmentStatisticsCalculator::GetNumberOfPercentiles()
+{
+  return static_cast<int>(this->Internal->Percentiles.size());
+}
+
+//----------------------------------------------------------------------------
+bool vtkSegmentStatisticsCalculator::Update()
+{
+  int numberOfSegments = this->GetNumberOfSegments();
+  this->Internal->Statistics.clear();
+  this->Internal->Statistics.resize(numberOfSegments);
+
+  vtkOrientedImageData* scalarVolume = this->ScalarVolume;
+  if (scalarVolume && !scalarVolume->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Update: scalar volume has no scalars");
+    return false;
+    }
+  double scalarVolumeVoxelVolume = 0.0;
+  int scalarVolumeExtent[6] = {0, -1, 0, -1, 0, -1};
+  if (scalarVolume)
+    {
+    double* spacing = scalarVolume->GetSpacing();
+    scalarVolumeVoxelVolume = spacing[0] * spacing[1] * spacing[2];
+    scalarVolume->GetExtent(scalarVolumeExtent);
+    }
+  bool identityTransform = IsIdentityTransform(this->SegmentToScalarVolumeTransform);
+
+  // Bring segments to the scalar volume geometry and compute their
+  // effective extent
+  std::vector<vtkSmartPointer<vtkOrientedImageData> > labelmaps(numberOfSegments);
+  ThreadData data;
+  data.ScalarVolume = scalarVolume;
+  data.Labelmaps.assign(numberOfSegments, static_cast<vtkImageData*>(NULL));
+  data.Extents.assign(6 * numberOfSegments, 0);
+  int unionExtent[6] = {VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN};
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+    vtkInternal::SegmentStatistics& statistics = this->Internal->Statistics[segmentIndex];
+    statistics.VoxelCount = 0;
+    statistics.Sum = 0.0;
+    statistics.SumOfSquares = 0.0;
+    statistics.Minimum = VTK_DOUBLE_MAX;
+    statistics.Maximum = VTK_DOUBLE_MIN;
+    statistics.PercentileValues.assign(this->Internal->Percentiles.size(), 0.0);
+
+    vtkOrientedImageData* segmentLabelmap = this->Internal->Segments[segmentIndex];
+    if (!segmentLabelmap || !segmentLabelmap->GetPointData()->GetScalars())
+      {
+      continue;
+      }
+    labelmaps[segmentIndex] = segmentLabelmap;
+    if (scalarVolume)
+      {
+      statistics.VoxelVolume = scalarVolumeVoxelVolume;
+      if (!identityTransform
+        || !vtkOrientedImageDataResample::DoGeometriesMatch(segmentLabelmap, scalarVolume))
+        {
+        vtkSmartPointer<vtkOrientedImageData> resampledLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+          segmentLabelmap, scalarVolume, resampledLabelmap, false, false, this->SegmentToScalarVolumeTransform))
+          {
+          // empty segment
+          continue;
+          }
+        labelmaps[segmentIndex] = resampledLabelmap;
+        }
+      }
+    else
+      {
+      double* spacing = segmentLabelmap->GetSpacing();
+      statistics.VoxelVolume = spacing[0] * spacing[1] * spacing[2];
+      }
+
+    int* effectiveExtent = &data.Extents[6 * segmentIndex];
+    if (!vtkOrientedImageDataResample::CalculateEffectiveExtent(labelmaps[segmentIndex], effectiveExtent))
+      {
+      continue;
+      }
+    if (scalarVolume)
+      {
+      for (int i = 0; i < 3; ++i)
+        {
+        effectiveExtent[2*i] = std::max(effectiveExtent[2*i], scalarVolumeExtent[2*i]);
+        effectiveExtent[2*i+1] = std::min(effectiveExtent[2*i+1], scalarVolumeExtent[2*i+1]);
+        }
+      }
+    if (effectiveExtent[0] > effectiveExtent[1]
+      || effectiveExtent[2] > effectiveExtent[3]
+      || effectiveExtent[4] > effectiveExtent[5])
+      {
+      continue;
+      }
+    data.Labelmaps[segmentIndex] = labelmaps[segmentIndex];
+    for (int i = 0; i < 3; ++i)
+      {
+      unionExtent[2*i] = std::min(unionExtent[2*i], effectiveExtent[2*i]);
+      unionExtent[2*i+1] = std::max(unionExtent[2*i+1], effectiveExtent[2*i+1]);
+      }
+    }
+
+  // Split the union of the effective extents into slabs, each one
+  // processed for all the segments at once
+  std::vector<WorkItem> workItems;
+  if (unionExtent[0] <= unionExtent[1])
+    {
+    vtkIdType sliceSize = static_cast<vtkIdType>(unionExtent[1] - unionExtent[0] + 1)
+      * (unionExtent[3] - unionExtent[2] + 1);
+    int slicesPerWorkItem = static_cast<int>(std::max(vtkIdType(1), MAXIMUM_NUMBER_OF_VOXELS_PER_WORK_ITEM / sliceSize));
+    for (int k = unionExtent[4]; k <= unionExtent[5]; k += slicesPerWorkItem)
+      {
+      WorkItem item;
+      std::copy(unionExtent, unionExtent + 4, item.Extent);
+      item.Extent[4] = k;
+      item.Extent[5] = std::min(k + slicesPerWorkItem - 1, unionExtent[5]);
+      workItems.push_back(item);
+      }
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = std::min(this->NumberOfThreads, std::max(1, static_cast<int>(workItems.size())));
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ThreadedExecute, &data);
+
+  data.WorkItems = &workItems;
+  data.CollectValues = false;
+  data.NextWorkItem = 0;
+  data.Accumulators.assign(numberOfThreads, std::vector<SegmentAccumulator>(numberOfSegments));
+  data.Histograms.resize(numberOfThreads);
+  threader->SingleMethodExecute();
+
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+      {
+      const SegmentAccumulator& accumulator = data.Accumulators[thread][segmentIndex];
+      vtkInternal::SegmentStatistics& statistics = this->Internal->Statistics[segmentIndex];
+      statistics.VoxelCount += accumulator.VoxelCount;
+      statistics.Sum += accumulator.Sum;
+      statistics.SumOfSquares += accumulator.SumOfSquares;
+      statistics.Minimum = std::min(statistics.Minimum, accumulator.Minimum);
+      statistics.Maximum = std::max(statistics.Maximum, accumulator.Maximum);
+      }
+    }
+
+  if (!scalarVolume || this->Internal->Percentiles.empty())
+    {
+    return true;
+    }
+
+  // Second pass for percentiles: histogram of integer values between
+  // the minimum and the maximum, or all the values if the range is too large.
+  // Values are written directly at the position given by the voxel counts
+  // of the first pass.
+  bool integerScalars = (scalarVolume->GetScalarType() != VTK_FLOAT && scalarVolume->GetScalarType() != VTK_DOUBLE);
+  data.CollectValues = true;
+  data.NextWorkItem = 0;
+  data.HistogramOffsets.assign(numberOfSegments, vtkMath::Nan());
+  data.HistogramSizes.assign(numberOfSegments, 0);
+  data.Histograms.assign(numberOfThreads, std::vector<std::vector<vtkIdType> >(numberOfSegments));
+  data.Values.resize(numberOfSegments);
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+    vtkInternal::SegmentStatistics& statistics = this->Internal->Statistics[segmentIndex];
+    if (statistics.VoxelCount == 0)
+      {
+      data.Labelmaps[segmentIndex] = NULL;
+      continue;
+      }
+    // A histogram wider than the number of voxels is slower to scan than the values
+    if (integerScalars
+      && statistics.Maximum - statistics.Minimum < MAXIMUM_NUMBER_OF_HISTOGRAM_BINS
+      && statistics.Maximum - statistics.Minimum < static_cast<double>(statistics.VoxelCount))
+      {
+      data.HistogramOffsets[segmentIndex] = statistics.Minimum;
+      data.HistogramSizes[segmentIndex] = static_cast<vtkIdType>(statistics.Maximum - statistics.Minimum) + 1;
+      continue;
+      }
+    data.Values[segmentIndex].resize(statistics.VoxelCount);
+    vtkIdType offset = 0;
+    for (size_t i = 0; i < workItems.size(); ++i)
+      {
+      WorkItem& item = workItems[i];
+      item.ValueOffsets.resize(numberOfSegments, 0);
+      item.ValueOffsets[segmentIndex] = offset;
+      offset += item.VoxelCounts[segmentIndex];
+      }
+    }
+  threader->SingleMethodExecute();
+
+  for (int segmentIndex = 0; segmentIndex < numberOfSegments; ++segmentIndex)
+    {
+    vtkInternal::SegmentStatistics& statistics = this->Internal->Statistics[segmentIndex];
+    if (statistics.VoxelCount == 0)
+      {
+      continue;
+      }
+    // Sum the histograms of the threads into the first one
+    std::vector<vtkIdType> histogram;
+    if (!vtkMath::IsNan(data.HistogramOffsets[segmentIndex]))
+      {
+      for (int thread = 0; thread < numberOfThreads; ++thread)
+        {
+        std::vector<vtkIdType>& threadHistogram = data.Histograms[thread][segmentIndex];
+        if (histogram.empty())
+          {
+          histogram.swap(threadHistogram);
+          continue;
+          }
+        for (size_t bin = 0; bin < threadHistogram.size(); ++bin)
+          {
+          histogram[bin] += threadHistogram[bin];
+          }
+        }
+      }
+    std::vector<double>& segmentValues = data.Values[segmentIndex];
+    for (size_t p = 0; p < this->Internal->Percentiles.size(); ++p)
+      {
+      double percentile = this->Internal->Percentiles[p];
+      if (!histogram.empty())
+        {
+        statistics.PercentileValues[p] = GetHistogramPercentile(histogram,
+          data.HistogramOffsets[segmentIndex], statistics.VoxelCount, percentile);
+        }
+      else if (!segmentValues.empty())
+        {
+        vtkIdType rank = std::max(vtkIdType(1), static_cast<vtkIdType>(ceil(percentile / 100.0 * segmentValues.size())));
+        std::nth_element(segmentValues.begin(), segmentValues.begin() + (rank - 1), segmentValues.end());
+        statistics.PercentileValues[p] = segmentValues[rank - 1];
+        }
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSegmentStatisticsCalculator::GetVoxelCount(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  return statistics ? statistics->VoxelCount : 0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetVolumeMm3(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  return statistics ? statistics->VoxelCount * statistics->VoxelVolume : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMinimum(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  return (statistics && statistics->VoxelCount > 0 && this->ScalarVolume) ? statistics->Minimum : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMaximum(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  return (statistics && statistics->VoxelCount > 0 && this->ScalarVolume) ? statistics->Maximum : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetMean(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  if (!statistics || statistics->VoxelCount == 0 || !this->ScalarVolume)
+    {
+    return 0.0;
+    }
+  return statistics->Sum / statistics->VoxelCount;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetStandardDeviation(int segmentIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  if (!statistics || statistics->VoxelCount == 0 || !this->ScalarVolume)
+    {
+    return 0.0;
+    }
+  if (statistics->VoxelCount < 2)
+    {
+    return 0.0;
+    }
+  // Sample standard deviation, as computed by vtkImageAccumulate
+  double n = static_cast<double>(statistics->VoxelCount);
+  double variance = (statistics->SumOfSquares - statistics->Sum * statistics->Sum / n) / (n - 1.0);
+  return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSegmentStatisticsCalculator::GetPercentileValue(int segmentIndex, int percentileIndex)
+{
+  vtkInternal::SegmentStatistics* statistics = this->Internal->GetStatistics(segmentIndex);
+  if (!statistics || percentileIndex < 0
+    || percentileIndex >= static_cast<int>(statistics->PercentileValues.size()))
+    {
+    return 0.0;
+    }
+  return statistics->PercentileValues[percentileIndex];
+}
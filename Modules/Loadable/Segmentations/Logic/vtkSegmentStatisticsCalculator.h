@@ -0,0 +1,107 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSegmentStatisticsCalculator_h
+#define __vtkSegmentStatisticsCalculator_h
+
+// Segmentations includes
+#include "vtkSlicerSegmentationsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkAbstractTransform;
+class vtkOrientedImageData;
+
+/// \ingroup SlicerRt_QtModules_Segmentations
+/// \brief Compute statistics of many segments in one pass.
+///
+/// Computes voxel count, volume, and (if a scalar volume is set) minimum,
+/// maximum, mean, standard deviation and percentiles of the scalar values
+/// for each segment binary labelmap. A voxel is inside a segment if its
+/// labelmap value is greater than 0.
+///
+/// Segment labelmaps are resampled to the scalar volume geometry only if their
+/// geometry differs. The union of the effective extents of the segments is
+/// split into slabs that are processed in parallel: each row of scalars is read
+/// once for all the segments that intersect it, and only the effective extent
+/// of each segment is tested. Each thread accumulates the statistics and
+/// histograms of all the segments it visits.
+///
+/// If no scalar volume is set, voxels are counted in the geometry of each
+/// segment labelmap.
+class VTK_SLICER_SEGMENTATIONS_LOGIC_EXPORT vtkSegmentStatisticsCalculator : public vtkObject
+{
+public:
+  static vtkSegmentStatisticsCalculator *New();
+  vtkTypeMacro(vtkSegmentStatisticsCalculator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Scalar volume the intensity statistics are computed from (component 0)
+  void SetScalarVolume(vtkOrientedImageData* scalarVolume);
+  vtkGetObjectMacro(ScalarVolume, vtkOrientedImageData);
+
+  /// Transform from the segment labelmaps world coordinate system
+  /// to the scalar volume world coordinate system. NULL means identity.
+  void SetSegmentToScalarVolumeTransform(vtkAbstractTransform* transform);
+  vtkGetObjectMacro(SegmentToScalarVolumeTransform, vtkAbstractTransform);
+
+  /// Add a segment binary labelmap. Return the index of the segment.
+  int AddSegment(vtkOrientedImageData* labelmap);
+  void RemoveAllSegments();
+  int GetNumberOfSegments();
+
+  /// Add a percentile (between 0 and 100) to compute, for example 50 for the median.
+  /// Return the index of the percentile.
+  int AddPercentile(double percentile);
+  void RemoveAllPercentiles();
+  int GetNumberOfPercentiles();
+
+  /// Number of threads used for the computation.
+  /// Default is vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Compute statistics of all the segments.
+  /// Return false if statistics could not be computed.
+  bool Update();
+
+  /// Statistics of a segment, available after Update().
+  /// Intensity statistics are 0 if there is no scalar volume or the segment is empty.
+  vtkIdType GetVoxelCount(int segmentIndex);
+  double GetVolumeMm3(int segmentIndex);
+  double GetMinimum(int segmentIndex);
+  double GetMaximum(int segmentIndex);
+  double GetMean(int segmentIndex);
+  double GetStandardDeviation(int segmentIndex);
+  double GetPercentileValue(int segmentIndex, int percentileIndex);
+
+protected:
+  vtkSegmentStatisticsCalculator();
+  ~vtkSegmentStatisticsCalculator();
+
+  vtkOrientedImageData* ScalarVolume;
+  vtkAbstractTransform* SegmentToScalarVolumeTransform;
+  int NumberOfThreads;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkSegmentStatisticsCalculator(const vtkSegmentStatisticsCalculator&); // Not implemented.
+  void operator=(const vtkSegmentStatisticsCalculator&); // Not implemented.
+};
+
+#endif
@@ -0,0 +1,203 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QStandardItem>
+
+// SubjectHierarchy includes
+#include "qMRMLSubjectHierarchyModel.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+std::string itemName(const char* prefix, int index)
+{
+  std::stringstream ss;
+  ss << prefix << index;
+  return ss.str();
+}
+
+//-----------------------------------------------------------------------------
+// Patient (expanded) / studies (collapsed) / series
+vtkIdType createPatient(vtkMRMLSubjectHierarchyNode* shNode, int numberOfStudies, int numberOfSeries,
+                        std::vector<vtkIdType>& studyItemIDs)
+{
+  vtkIdType patientItemID = shNode->CreateSubjectItem(shNode->GetSceneItemID(), "Patient");
+  for (int study = 0; study < numberOfStudies; ++study)
+    {
+    vtkIdType studyItemID = shNode->CreateStudyItem(patientItemID, itemName("Study", study));
+    for (int series = 0; series < numberOfSeries; ++series)
+      {
+      shNode->CreateFolderItem(studyItemID, itemName("Series", series));
+      }
+    shNode->SetItemExpanded(studyItemID, false);
+    studyItemIDs.push_back(studyItemID);
+    }
+  return patientItemID;
+}
+
+//-----------------------------------------------------------------------------
+// Check that the model contains the same items in the same order as the subject hierarchy.
+// Unfetched children are fetched first.
+int checkBranch(qMRMLSubjectHierarchyModel* model, vtkIdType itemID)
+{
+  vtkMRMLSubjectHierarchyNode* shNode = model->subjectHierarchyNode();
+  QModelIndex index = model->indexFromSubjectHierarchyItem(itemID);
+  CHECK_BOOL(index.isValid(), true);
+  if (model->canFetchMore(index))
+    {
+    model->fetchMore(index);
+    index = model->indexFromSubjectHierarchyItem(itemID);
+    }
+  CHECK_BOOL(model->canFetchMore(index), false);
+
+  std::vector<vtkIdType> childItemIDs;
+  shNode->GetItemChildren(itemID, childItemIDs, false);
+  QStandardItem* item = model->itemFromIndex(index);
+  CHECK_NOT_NULL(item);
+  CHECK_INT(item->rowCount(), static_cast<int>(childItemIDs.size()));
+  for (int row = 0; row < static_cast<int>(childItemIDs.size()); ++row)
+    {
+    CHECK_INT(model->subjectHierarchyItemFromItem(item->child(row)), childItemIDs[row]);
+    CHECK_EXIT_SUCCESS(checkBranch(model, childItemIDs[row]));
+    }
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int testLazyPopulation()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  CHECK_NOT_NULL(shNode);
+  std::vector<vtkIdType> studyItemIDs;
+  vtkIdType patientItemID = createPatient(shNode, 3, 5, studyItemIDs);
+
+  qMRMLSubjectHierarchyModel model;
+  model.setMRMLScene(scene.GetPointer());
+
+  // Children of the expanded patient are inserted, children of the collapsed studies are not
+  QStandardItem* patientItem = model.itemFromSubjectHierarchyItem(patientItemID);
+  CHECK_NOT_NULL(patientItem);
+  CHECK_INT(patientItem->rowCount(), 3);
+  CHECK_BOOL(model.canFetchMore(patientItem->index()), false);
+  for (int study = 0; study < 3; ++study)
+    {
+    QModelIndex studyIndex = model.indexFromSubjectHierarchyItem(studyItemIDs[study]);
+    CHECK_BOOL(studyIndex.isValid(), true);
+    CHECK_INT(model.rowCount(studyIndex), 0);
+    CHECK_BOOL(model.hasChildren(studyIndex), true);
+    CHECK_BOOL(model.canFetchMore(studyIndex), true);
+    }
+
+  // Looking up an item below a collapsed item does not modify the model
+  std::vector<vtkIdType> seriesItemIDs;
+  shNode->GetItemChildren(studyItemIDs[0], seriesItemIDs, false);
+  CHECK_BOOL(model.indexFromSubjectHierarchyItem(seriesItemIDs[2]).isValid(), false);
+  CHECK_NULL(model.itemFromSubjectHierarchyItem(seriesItemIDs[2]));
+  QModelIndex firstStudyIndex = model.indexFromSubjectHierarchyItem(studyItemIDs[0]);
+  CHECK_INT(model.rowCount(firstStudyIndex), 0);
+  CHECK_BOOL(model.canFetchMore(firstStudyIndex), true);
+
+  // Fetching the ancestors of an item inserts the children of its collapsed ancestors
+  model.fetchSubjectHierarchyItemAncestors(seriesItemIDs[2]);
+  QModelIndex seriesIndex = model.indexFromSubjectHierarchyItem(seriesItemIDs[2]);
+  CHECK_BOOL(seriesIndex.isValid(), true);
+  CHECK_INT(seriesIndex.row(), 2);
+  firstStudyIndex = model.indexFromSubjectHierarchyItem(studyItemIDs[0]);
+  CHECK_INT(model.rowCount(firstStudyIndex), 5);
+  CHECK_BOOL(model.canFetchMore(firstStudyIndex), false);
+  CHECK_BOOL(model.canFetchMore(model.indexFromSubjectHierarchyItem(studyItemIDs[1])), true);
+
+  // Items added under a collapsed item are inserted when the item is fetched
+  vtkIdType addedSeriesItemID = shNode->CreateFolderItem(studyItemIDs[1], "Added series");
+  QModelIndex secondStudyIndex = model.indexFromSubjectHierarchyItem(studyItemIDs[1]);
+  CHECK_INT(model.rowCount(secondStudyIndex), 0);
+  model.fetchMore(secondStudyIndex);
+  CHECK_INT(model.rowCount(secondStudyIndex), 6);
+  CHECK_INT(model.indexFromSubjectHierarchyItem(addedSeriesItemID).row(), 5);
+
+  // Items moved out of a collapsed item are inserted at their new position
+  std::vector<vtkIdType> thirdStudySeriesItemIDs;
+  shNode->GetItemChildren(studyItemIDs[2], thirdStudySeriesItemIDs, false);
+  CHECK_BOOL(model.canFetchMore(model.indexFromSubjectHierarchyItem(studyItemIDs[2])), true);
+  shNode->SetItemParent(thirdStudySeriesItemIDs[0], studyItemIDs[0]);
+  QModelIndex movedSeriesIndex = model.indexFromSubjectHierarchyItem(thirdStudySeriesItemIDs[0]);
+  CHECK_BOOL(movedSeriesIndex.isValid(), true);
+  CHECK_INT(model.subjectHierarchyItemFromIndex(movedSeriesIndex.parent()), studyItemIDs[0]);
+  CHECK_INT(model.rowCount(model.indexFromSubjectHierarchyItem(studyItemIDs[0])), 6);
+
+  // Children of a removed collapsed item are moved to its parent
+  shNode->RemoveItem(studyItemIDs[2], false, false);
+  CHECK_EXIT_SUCCESS(checkBranch(&model, shNode->GetSceneItemID()));
+  CHECK_INT(patientItem->rowCount(), 2 + 4);
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+// Populating the model on scene import only creates the items that are visible
+int benchmarkPopulation()
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+  std::vector<vtkIdType> studyItemIDs;
+  const int numberOfStudies = 200;
+  const int numberOfSeries = 50;
+  createPatient(shNode, numberOfStudies, numberOfSeries, studyItemIDs);
+
+  qMRMLSubjectHierarchyModel model;
+  QElapsedTimer timer;
+  timer.start();
+  model.setMRMLScene(scene.GetPointer());
+  qint64 populateTime = timer.elapsed();
+
+  timer.restart();
+  CHECK_EXIT_SUCCESS(checkBranch(&model, shNode->GetSceneItemID()));
+  qint64 fetchAllTime = timer.elapsed();
+
+  std::cout << "Subject hierarchy items: " << shNode->GetNumberOfItems() << std::endl
+            << "Populate with collapsed studies: " << populateTime << " ms" << std::endl
+            << "Fetch and check all items: " << fetchAllTime << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int qMRMLSubjectHierarchyModelTest1(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  CHECK_EXIT_SUCCESS(testLazyPopulation());
+  CHECK_EXIT_SUCCESS(benchmarkPopulation());
+  return EXIT_SUCCESS;
+}
@@ -157,6 +157,96 @@ QStandardItem* qMRMLSubjectHierarchyModelPrivate::insertSubjectHierarchyItem(vtk
   return item;
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModelPrivate::createSubjectHierarchyBranch(vtkIdType itemID, QList<QStandardItem*>& rowItems,
+  QList<QPair<vtkIdType, QStandardItem*> >& branchItems)
+{
+  Q_Q(qMRMLSubjectHierarchyModel);
+  this->UnfetchedItems.remove(itemID);
+  for (int col=0; col<q->columnCount(); ++col)
+    {
+    QStandardItem* newItem = new QStandardItem();
+    q->updateItemFromSubjectHierarchyItem(newItem, itemID, col);
+    rowItems.append(newItem);
+    }
+  branchItems.append(qMakePair(itemID, rowItems[0]));
+
+  // Children are returned in the order of their position under the parent
+  std::vector<vtkIdType> childItemIDs;
+  this->SubjectHierarchyNode->GetItemChildren(itemID, childItemIDs, false);
+  if (childItemIDs.empty())
+    {
+    return;
+    }
+  if (!this->SubjectHierarchyNode->GetItemExpanded(itemID))
+    {
+    // Children of collapsed items are inserted when the item is expanded in a view
+    this->UnfetchedItems.insert(itemID);
+    return;
+    }
+  for (std::vector<vtkIdType>::iterator childIt=childItemIDs.begin(); childIt!=childItemIDs.end(); ++childIt)
+    {
+    QList<QStandardItem*> childRowItems;
+    this->createSubjectHierarchyBranch(*childIt, childRowItems, branchItems);
+    rowItems[0]->appendRow(childRowItems);
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModelPrivate::insertSubjectHierarchyChildren(vtkIdType parentItemID, QStandardItem* parentItem,
+  QList<QPair<vtkIdType, QStandardItem*> >& insertedItems)
+{
+  std::vector<vtkIdType> childItemIDs;
+  this->SubjectHierarchyNode->GetItemChildren(parentItemID, childItemIDs, false);
+  for (std::vector<vtkIdType>::iterator childIt=childItemIDs.begin(); childIt!=childItemIDs.end(); ++childIt)
+    {
+    // Skip the children that are already in the model (e.g. being moved under the collapsed parent)
+    QMap<vtkIdType,QPersistentModelIndex>::iterator rowCacheIt = this->RowCache.find(*childIt);
+    if (rowCacheIt != this->RowCache.end() && rowCacheIt.value().isValid()
+      && rowCacheIt.value().data(qMRMLSubjectHierarchyModel::SubjectHierarchyItemIDRole).toLongLong() == (*childIt))
+      {
+      continue;
+      }
+
+    QList<QStandardItem*> rowItems;
+    QList<QPair<vtkIdType, QStandardItem*> > branchItems;
+    this->createSubjectHierarchyBranch(*childIt, rowItems, branchItems);
+
+    // Insert invalid items in the cache to indicate that the items are in the model but their
+    // index is not known yet (see insertSubjectHierarchyItem)
+    for (QList<QPair<vtkIdType, QStandardItem*> >::iterator branchIt=branchItems.begin(); branchIt!=branchItems.end(); ++branchIt)
+      {
+      this->RowCache[branchIt->first] = QModelIndex();
+      }
+    parentItem->appendRow(rowItems);
+    for (QList<QPair<vtkIdType, QStandardItem*> >::iterator branchIt=branchItems.begin(); branchIt!=branchItems.end(); ++branchIt)
+      {
+      this->RowCache[branchIt->first] = branchIt->second->index();
+      }
+    insertedItems << branchItems;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSubjectHierarchyModelPrivate::isItemInUnfetchedBranch(vtkIdType itemID)const
+{
+  if (this->UnfetchedItems.isEmpty() || !this->SubjectHierarchyNode)
+    {
+    return false;
+    }
+  vtkIdType sceneItemID = this->SubjectHierarchyNode->GetSceneItemID();
+  for (vtkIdType ancestorItemID = this->SubjectHierarchyNode->GetItemParent(itemID);
+    ancestorItemID && ancestorItemID != sceneItemID;
+    ancestorItemID = this->SubjectHierarchyNode->GetItemParent(ancestorItemID))
+    {
+    if (this->UnfetchedItems.contains(ancestorItemID))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 // qMRMLSubjectHierarchyModel
 //------------------------------------------------------------------------------
@@ -344,7 +434,8 @@ QModelIndex qMRMLSubjectHierarchyModel::indexFromSubjectHierarchyItem(vtkIdType
   QMap<vtkIdType,QPersistentModelIndex>::iterator rowCacheIt = d->RowCache.find(itemID);
   if (rowCacheIt==d->RowCache.end())
     {
-    // Not found in cache, therefore it cannot be in the model
+    // Not found in cache, therefore it cannot be in the model. This is also the case for items
+    // below a collapsed item whose children have not been inserted yet (\sa fetchSubjectHierarchyItemAncestors)
     return itemIndex;
     }
   if (rowCacheIt.value().isValid())
@@ -635,17 +726,109 @@ bool qMRMLSubjectHierarchyModel::dropMimeData( const QMimeData *data, Qt::DropAc
   Q_UNUSED(column);
   // We want to do drag&drop only into the first item of a line (and not on a
   // random column.
+  QModelIndex parentIndex = parent.sibling(parent.row(), 0);
+  // Insert the existing children of a collapsed parent first so that the dropped items are not
+  // inserted twice when the parent is expanded
+  if (this->canFetchMore(parentIndex))
+    {
+    this->fetchMore(parentIndex);
+    }
   bool res = this->Superclass::dropMimeData(
-    data, action, row, 0, parent.sibling(parent.row(), 0));
+    data, action, row, 0, parentIndex);
   return res;
 }
 
+//------------------------------------------------------------------------------
+bool qMRMLSubjectHierarchyModel::hasChildren(const QModelIndex& parent)const
+{
+  if (this->canFetchMore(parent))
+    {
+    return true;
+    }
+  return this->Superclass::hasChildren(parent);
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLSubjectHierarchyModel::canFetchMore(const QModelIndex& parent)const
+{
+  Q_D(const qMRMLSubjectHierarchyModel);
+  if (d->UnfetchedItems.isEmpty() || !parent.isValid())
+    {
+    return false;
+    }
+  return d->UnfetchedItems.contains(this->subjectHierarchyItemFromIndex(parent));
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModel::fetchMore(const QModelIndex& parent)
+{
+  Q_D(qMRMLSubjectHierarchyModel);
+  if (!d->SubjectHierarchyNode || !parent.isValid())
+    {
+    return;
+    }
+  vtkIdType itemID = this->subjectHierarchyItemFromIndex(parent);
+  if (!d->UnfetchedItems.remove(itemID))
+    {
+    return;
+    }
+  QStandardItem* item = this->itemFromIndex(parent.sibling(parent.row(), 0));
+  if (!item)
+    {
+    return;
+    }
+
+  QList<QPair<vtkIdType, QStandardItem*> > insertedItems;
+  d->insertSubjectHierarchyChildren(itemID, item, insertedItems);
+
+  // Update expanded states of the inserted items
+  for (QList<QPair<vtkIdType, QStandardItem*> >::iterator itemIt=insertedItems.begin(); itemIt!=insertedItems.end(); ++itemIt)
+    {
+    QStandardItem* insertedItem = this->itemFromSubjectHierarchyItem(itemIt->first, this->nameColumn());
+    this->updateItemDataFromSubjectHierarchyItem(insertedItem, itemIt->first, this->nameColumn());
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSubjectHierarchyModel::fetchSubjectHierarchyItemAncestors(vtkIdType itemID)
+{
+  Q_D(qMRMLSubjectHierarchyModel);
+  if (!d->isItemInUnfetchedBranch(itemID))
+    {
+    return;
+    }
+  // Fetch from the top-level ancestor down, as the children of an ancestor are only in the model
+  // once the children of its own parent have been fetched
+  QList<vtkIdType> ancestorItemIDs;
+  vtkIdType sceneItemID = d->SubjectHierarchyNode->GetSceneItemID();
+  for (vtkIdType ancestorItemID = d->SubjectHierarchyNode->GetItemParent(itemID);
+    ancestorItemID && ancestorItemID != sceneItemID;
+    ancestorItemID = d->SubjectHierarchyNode->GetItemParent(ancestorItemID))
+    {
+    ancestorItemIDs.prepend(ancestorItemID);
+    }
+  foreach (vtkIdType ancestorItemID, ancestorItemIDs)
+    {
+    if (!d->UnfetchedItems.contains(ancestorItemID))
+      {
+      continue;
+      }
+    QModelIndex ancestorIndex = this->indexFromSubjectHierarchyItem(ancestorItemID);
+    if (!ancestorIndex.isValid())
+      {
+      return;
+      }
+    this->fetchMore(ancestorIndex);
+    }
+}
+
 //------------------------------------------------------------------------------
 void qMRMLSubjectHierarchyModel::updateFromSubjectHierarchy()
 {
   Q_D(qMRMLSubjectHierarchyModel);
 
   d->RowCache.clear();
+  d->UnfetchedItems.clear();
 
   // Enabled so it can be interacted with
   this->invisibleRootItem()->setFlags(Qt::ItemIsEnabled);
@@ -698,21 +881,17 @@ void qMRMLSubjectHierarchyModel::updateFromSubjectHierarchy()
   // Remove rows before populating
   this->subjectHierarchySceneItem()->removeRows(0, this->subjectHierarchySceneItem()->rowCount());
 
-  // Populate subject hierarchy with the items
-  std::vector<vtkIdType> allItemIDs;
-  d->SubjectHierarchyNode->GetItemChildren(d->SubjectHierarchyNode->GetSceneItemID(), allItemIDs, true);
-  for (std::vector<vtkIdType>::iterator itemIt=allItemIDs.begin(); itemIt!=allItemIDs.end(); ++itemIt)
-    {
-    vtkIdType itemID = (*itemIt);
-    int index = d->SubjectHierarchyNode->GetItemPositionUnderParent(itemID);
-    d->insertSubjectHierarchyItem(itemID, index);
-    }
+  // Populate subject hierarchy with the items. Each top-level branch is built outside of the
+  // model and inserted at once, so that views and proxy models are notified once per branch
+  // instead of once per item. Children of collapsed items are inserted on demand (see fetchMore).
+  QList<QPair<vtkIdType, QStandardItem*> > allItems;
+  d->insertSubjectHierarchyChildren(d->SubjectHierarchyNode->GetSceneItemID(), this->subjectHierarchySceneItem(), allItems);
 
   // Update expanded states (during inserting the update calls did not find valid indices, so
   // expand and collapse statuses were not set in the tree view)
-  for (std::vector<vtkIdType>::iterator itemIt=allItemIDs.begin(); itemIt!=allItemIDs.end(); ++itemIt)
+  for (QList<QPair<vtkIdType, QStandardItem*> >::iterator itemIt=allItems.begin(); itemIt!=allItems.end(); ++itemIt)
     {
-    vtkIdType itemID = (*itemIt);
+    vtkIdType itemID = itemIt->first;
     // Expanded states are handled with the name column
     QStandardItem* item = this->itemFromSubjectHierarchyItem(itemID, this->nameColumn());
     this->updateItemDataFromSubjectHierarchyItem(item, itemID, this->nameColumn());
@@ -755,6 +934,12 @@ QStandardItem* qMRMLSubjectHierarchyModel::insertSubjectHierarchyItem(vtkIdType
   parent->insertRow(row, items);
   d->RowCache[itemID] = items[0]->index();
 
+  // Children of an item moved out of a collapsed branch are inserted on demand
+  if (d->SubjectHierarchyNode && d->SubjectHierarchyNode->GetNumberOfItemChildren(itemID) > 0)
+    {
+    d->UnfetchedItems.insert(itemID);
+    }
+
   return items[0];
 }
 
@@ -829,6 +1014,8 @@ void qMRMLSubjectHierarchyModel::updateItemFromSubjectHierarchyItem(QStandardIte
   if (this->canBeAChild(shItemID))
     {
     QStandardItem* parentItem = item->parent();
+    // Insert the collapsed ancestors of the new parent so that the item can be moved under it
+    this->fetchSubjectHierarchyItemAncestors(shItemID);
     QStandardItem* newParentItem = this->itemFromSubjectHierarchyItem(this->parentSubjectHierarchyItem(shItemID));
     if (!newParentItem)
       {
@@ -837,6 +1024,11 @@ void qMRMLSubjectHierarchyModel::updateItemFromSubjectHierarchyItem(QStandardIte
     // If the item has no parent, then it means it hasn't been put into the hierarchy yet and it will do it automatically
     if (parentItem && parentItem != newParentItem)
       {
+      // Insert the other children of a collapsed new parent so that the item can be moved at its position
+      if (this->canFetchMore(newParentItem->index()))
+        {
+        this->fetchMore(newParentItem->index());
+        }
       int newIndex = this->subjectHierarchyItemIndex(shItemID);
       if (parentItem != newParentItem || newIndex != item->row())
         {
@@ -1145,7 +1337,14 @@ void qMRMLSubjectHierarchyModel::updateModelItems(vtkIdType itemID)
   if (!itemIndexes.count())
     {
     // Can happen while the item is added, the plugin handler sets the owner plugin, which triggers
-    // item modified before it can be inserted to the model
+    // item modified before it can be inserted to the model.
+    // It also happens when the item is moved out of a collapsed item whose children have not been
+    // inserted (there cannot be such items if all the children have been inserted).
+    if (!d->UnfetchedItems.isEmpty() && !d->isItemInUnfetchedBranch(itemID)
+      && d->SubjectHierarchyNode && d->SubjectHierarchyNode->GetItemParent(itemID))
+      {
+      this->insertSubjectHierarchyItem(itemID);
+      }
     return;
     }
 
@@ -1241,6 +1440,17 @@ void qMRMLSubjectHierarchyModel::onEvent(
 //------------------------------------------------------------------------------
 void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAdded(vtkIdType itemID)
 {
+  Q_D(qMRMLSubjectHierarchyModel);
+  if (d->MRMLScene && d->MRMLScene->IsBatchProcessing())
+    {
+    // The whole model is updated at the end of the batch processing
+    return;
+    }
+  if (d->isItemInUnfetchedBranch(itemID))
+    {
+    // The item is inserted with its siblings when its parent is expanded
+    return;
+    }
   this->insertSubjectHierarchyItem(itemID);
 }
 
@@ -1252,12 +1462,22 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAboutToBeRemoved(vtkIdTyp
     {
     return;
     }
+  if (d->isItemInUnfetchedBranch(itemID))
+    {
+    // The item has not been inserted in the model
+    return;
+    }
 
-  QModelIndexList itemIndexes = this->match(
-    this->subjectHierarchySceneIndex(), SubjectHierarchyItemIDRole, itemID, 1, Qt::MatchExactly | Qt::MatchRecursive );
-  if (itemIndexes.count() > 0)
+  QModelIndex itemIndex = this->indexFromSubjectHierarchyItem(itemID);
+  if (itemIndex.isValid() && this->canFetchMore(itemIndex))
     {
-    QStandardItem* item = this->itemFromIndex(itemIndexes[0].sibling(itemIndexes[0].row(),0));
+    // Insert the children so that they are reparented with the other orphans
+    this->fetchMore(itemIndex);
+    itemIndex = this->indexFromSubjectHierarchyItem(itemID);
+    }
+  if (itemIndex.isValid())
+    {
+    QStandardItem* item = this->itemFromIndex(itemIndex);
     // The children may be lost if not reparented, we ensure they got reparented.
     while (item->rowCount())
       {
@@ -1272,7 +1492,7 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemAboutToBeRemoved(vtkIdTyp
         d->Orphans.removeAll(orphans);
         }
       }
-    this->removeRow(itemIndexes[0].row(), itemIndexes[0].parent());
+    this->removeRow(itemIndex.row(), itemIndex.parent());
     }
 }
 
@@ -1296,6 +1516,7 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemRemoved(vtkIdType removed
       continue;
       }
     vtkIdType itemID = this->subjectHierarchyItemFromItem(orphan);
+    this->fetchSubjectHierarchyItemAncestors(itemID);
     int newIndex = this->subjectHierarchyItemIndex(itemID);
     QStandardItem* newParentItem = this->itemFromSubjectHierarchyItem(
       this->parentSubjectHierarchyItem(itemID) );
@@ -1319,7 +1540,7 @@ void qMRMLSubjectHierarchyModel::onSubjectHierarchyItemModified(vtkIdType itemID
 void qMRMLSubjectHierarchyModel::onMRMLSceneImported(vtkMRMLScene* scene)
 {
   Q_UNUSED(scene);
-  this->updateFromSubjectHierarchy();
+  // Import is a batch processing, the model is updated in onMRMLSceneEndBatchProcess
 }
 
 //------------------------------------------------------------------------------
@@ -105,6 +105,15 @@ public:
   virtual bool dropMimeData(const QMimeData *data, Qt::DropAction action,
                             int row, int column, const QModelIndex &parent);
 
+  /// Children of collapsed subject hierarchy items are only inserted in the model when they
+  /// are requested by a view (when expanding the item) or by \sa fetchSubjectHierarchyItemAncestors
+  virtual bool hasChildren(const QModelIndex& parent=QModelIndex())const;
+  virtual bool canFetchMore(const QModelIndex& parent)const;
+  virtual void fetchMore(const QModelIndex& parent);
+  /// Insert the children of the collapsed ancestors of the item that have not been inserted yet,
+  /// so that \sa indexFromSubjectHierarchyItem returns a valid index for the item
+  void fetchSubjectHierarchyItemAncestors(vtkIdType itemID);
+
   Q_INVOKABLE virtual void setMRMLScene(vtkMRMLScene* scene);
   Q_INVOKABLE vtkMRMLScene* mrmlScene()const;
 
@@ -119,6 +128,8 @@ public:
 
   vtkIdType subjectHierarchyItemFromIndex(const QModelIndex &index)const;
   vtkIdType subjectHierarchyItemFromItem(QStandardItem* item)const;
+  /// Invalid if the item is not in the model, such as below a collapsed item whose children
+  /// have not been fetched (\sa fetchSubjectHierarchyItemAncestors)
   QModelIndex indexFromSubjectHierarchyItem(vtkIdType itemID, int column=0)const;
   QStandardItem* itemFromSubjectHierarchyItem(vtkIdType itemID, int column=0)const;
 
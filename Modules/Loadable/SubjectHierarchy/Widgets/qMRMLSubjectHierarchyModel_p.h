@@ -38,6 +38,8 @@
 class QStandardItemModel;
 #include <QFlags>
 #include <QMap>
+#include <QPair>
+#include <QSet>
 
 // SubjectHierarchy includes
 #include "qSlicerSubjectHierarchyModuleWidgetsExport.h"
@@ -66,11 +68,27 @@ public:
   virtual ~qMRMLSubjectHierarchyModelPrivate();
   void init();
 
-  /// This method is called by qMRMLSubjectHierarchyModel::updateFromSubjectHierarchy() to speed up
-  /// the loading. By explicitly specifying the \a index, it skips item lookup within their parents
+  /// Insert a subject hierarchy item (and its parents if needed) in the model.
+  /// By explicitly specifying the \a index, it skips item lookup within their parents
   /// happening in qMRMLSubjectHierarchyModel::subjectHierarchyItemIndex(vtkIdType).
   virtual QStandardItem* insertSubjectHierarchyItem(vtkIdType itemID, int index);
 
+  /// Create the items of a subject hierarchy item and of its children without inserting them in the model.
+  /// Items of a row are appended to \a rowItems, items of the first column of all the branch are added to \a branchItems.
+  /// Populating a branch outside of the model avoids notifying the views and proxy models of each item insertion.
+  /// Children of collapsed items are not created, the item is added to \sa UnfetchedItems instead.
+  /// \sa qMRMLSubjectHierarchyModel::updateFromSubjectHierarchy()
+  void createSubjectHierarchyBranch(vtkIdType itemID, QList<QStandardItem*>& rowItems,
+    QList<QPair<vtkIdType, QStandardItem*> >& branchItems);
+
+  /// Insert the branches of the children of a subject hierarchy item under \a parentItem, one row insertion per child.
+  /// Items of the first column of the inserted branches are added to \a insertedItems.
+  void insertSubjectHierarchyChildren(vtkIdType parentItemID, QStandardItem* parentItem,
+    QList<QPair<vtkIdType, QStandardItem*> >& insertedItems);
+
+  /// Return true if an ancestor of the item has children that have not been inserted in the model yet
+  bool isItemInUnfetchedBranch(vtkIdType itemID)const;
+
   /// Convenience function to get name for subject hierarchy item
   QString subjectHierarchyItemName(vtkIdType itemID);
 
@@ -107,6 +125,10 @@ public:
   // not guaranteed to contain up-to-date information, should be just used as a search hint.
   // If the item cannot be found at the given index then we need to browse through all model items.
   mutable QMap<vtkIdType, QPersistentModelIndex> RowCache;
+
+  // Items in the model that have children in the subject hierarchy that are not in the model yet.
+  // Their children are inserted by \sa qMRMLSubjectHierarchyModel::fetchMore
+  mutable QSet<vtkIdType> UnfetchedItems;
 };
 
 #endif
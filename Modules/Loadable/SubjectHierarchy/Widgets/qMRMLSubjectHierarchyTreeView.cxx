@@ -380,6 +380,8 @@ void qMRMLSubjectHierarchyTreeView::setCurrentItem(vtkIdType itemID)
     return;
     }
 
+  // Insert the item in the model if it is under collapsed items whose children have not been inserted yet
+  d->Model->fetchSubjectHierarchyItemAncestors(itemID);
   QModelIndex itemIndex = d->SortFilterModel->indexFromSubjectHierarchyItem(itemID);
   this->selectionModel()->select(itemIndex, QItemSelectionModel::ClearAndSelect | QItemSelectionModel::Rows);
 }
@@ -422,6 +424,7 @@ void qMRMLSubjectHierarchyTreeView::setCurrentItems(QList<vtkIdType> items)
 
   foreach (long itemID, items)
     {
+    d->Model->fetchSubjectHierarchyItemAncestors(vtkIdType(itemID));
     QModelIndex itemIndex = d->SortFilterModel->indexFromSubjectHierarchyItem(vtkIdType(itemID));
     if (itemIndex.isValid())
       {
@@ -450,6 +453,7 @@ void qMRMLSubjectHierarchyTreeView::setCurrentItems(vtkIdList* items)
 
   for (int index=0; index<items->GetNumberOfIds(); ++index)
     {
+    d->Model->fetchSubjectHierarchyItemAncestors(items->GetId(index));
     QModelIndex itemIndex = d->SortFilterModel->indexFromSubjectHierarchyItem(items->GetId(index));
     if (itemIndex.isValid())
       {
@@ -545,6 +549,7 @@ void qMRMLSubjectHierarchyTreeView::setRootItem(vtkIdType rootItemID)
     }
   else
     {
+    sceneModel->fetchSubjectHierarchyItemAncestors(rootItemID);
     treeRootIndex = this->sortFilterProxyModel()->indexFromSubjectHierarchyItem(rootItemID);
     if (d->ShowRootItem)
       {
@@ -1017,6 +1022,7 @@ void qMRMLSubjectHierarchyTreeView::expandItem(vtkIdType itemID)
   Q_D(qMRMLSubjectHierarchyTreeView);
   if (itemID)
     {
+    d->Model->fetchSubjectHierarchyItemAncestors(itemID);
     QModelIndex itemIndex = d->SortFilterModel->indexFromSubjectHierarchyItem(itemID);
     if (itemIndex.isValid())
       {
@@ -0,0 +1,328 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Terminologies includes
+#include "vtkSlicerTerminologiesModuleLogic.h"
+#include "vtkSlicerTerminologyCategory.h"
+#include "vtkSlicerTerminologyType.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkTestingOutputWindow.h>
+
+// VTKSYS includes
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+
+typedef vtkSlicerTerminologiesModuleLogic::CodeIdentifier CodeIdentifier;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void WriteTestTerminology(const std::string& filePath, bool withExtraCategory)
+{
+  std::ofstream file(filePath.c_str());
+  file
+    << "{\n"
+    << "  \"SegmentationCategoryTypeContextName\": \"Test terminology\",\n"
+    << "  \"@schema\": \"https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/schemas/segment-context-schema.json#\",\n"
+    << "  \"SegmentationCodes\": {\n"
+    << "    \"Category\": [\n"
+    << "      { \"CodeMeaning\": \"Tissue\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D0050\",\n"
+    << "        \"Type\": [\n"
+    << "          { \"CodeMeaning\": \"Artery\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-41066\",\n"
+    << "            \"Modifier\": [\n"
+    << "              { \"CodeMeaning\": \"Left\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"G-A101\" },\n"
+    << "              { \"CodeMeaning\": \"Right\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"G-A100\" } ] },\n"
+    << "          { \"CodeMeaning\": \"Vein\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-48003\",\n"
+    << "            \"Modifier\": [] },\n"
+    << "          { \"CodeMeaning\": \"Nerve\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-A0100\" } ] },\n"
+    << "      { \"CodeMeaning\": \"Tissue duplicate\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D0050\",\n"
+    << "        \"Type\": [\n"
+    << "          { \"CodeMeaning\": \"Bone\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D016E\",\n"
+    << "            \"Modifier\": [] } ] },\n"
+    << "      { \"CodeMeaning\": \"Tissue DCM\", \"CodingSchemeDesignator\": \"DCM\", \"CodeValue\": \"T-D0050\",\n"
+    << "        \"Type\": [] },\n"
+    << "      { \"CodeMeaning\": \"Broken\", \"CodingSchemeDesignator\": \"SRT\" },\n";
+  if (withExtraCategory)
+    {
+    file
+      << "      { \"CodeMeaning\": \"Body substance\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D0080\",\n"
+      << "        \"Type\": [] },\n";
+    }
+  file
+    << "      { \"CodeMeaning\": \"Anatomical Structure\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-D000A\",\n"
+    << "        \"Type\": [] }\n"
+    << "    ]\n"
+    << "  }\n"
+    << "}\n";
+}
+
+//----------------------------------------------------------------------------
+void WriteTestAnatomicContext(const std::string& filePath)
+{
+  std::ofstream file(filePath.c_str());
+  file
+    << "{\n"
+    << "  \"AnatomicContextName\": \"Test anatomic context\",\n"
+    << "  \"@schema\": \"https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/schemas/anatomic-context-schema.json#\",\n"
+    << "  \"AnatomicCodes\": {\n"
+    << "    \"AnatomicRegion\": [\n"
+    << "      { \"CodeMeaning\": \"Kidney\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-71000\",\n"
+    << "        \"Modifier\": [\n"
+    << "          { \"CodeMeaning\": \"Left\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"G-A101\" },\n"
+    << "          { \"CodeMeaning\": \"Right\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"G-A100\" } ] },\n"
+    << "      { \"CodeMeaning\": \"Liver\", \"CodingSchemeDesignator\": \"SRT\", \"CodeValue\": \"T-62000\",\n"
+    << "        \"Modifier\": [] }\n"
+    << "    ]\n"
+    << "  }\n"
+    << "}\n";
+}
+
+//----------------------------------------------------------------------------
+int CountIndexCacheFiles(const std::string& indexCachePath)
+{
+  vtksys::Directory dir;
+  if (!dir.Load(indexCachePath.c_str()))
+    {
+    return 0;
+    }
+  int count = 0;
+  for (unsigned long fileIndex = 0; fileIndex < dir.GetNumberOfFiles(); ++fileIndex)
+    {
+    if (vtksys::SystemTools::GetFilenameLastExtension(dir.GetFile(fileIndex)) == ".index")
+      {
+      ++count;
+      }
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------------
+int CheckCodeLists(vtkSlicerTerminologiesModuleLogic* logic, const std::string& terminologyName,
+  const std::string& anatomicContextName, int expectedNumberOfCategories)
+{
+  std::vector<CodeIdentifier> codes;
+
+  // The category without code value is reported but not listed
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->FindCategoriesInTerminology(terminologyName, codes, ""), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(static_cast<int>(codes.size()), expectedNumberOfCategories);
+  CHECK_STD_STRING(codes[0].CodeMeaning, "Tissue");
+
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->FindCategoriesInTerminology(terminologyName, codes, "TIS"), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(static_cast<int>(codes.size()), 3);
+
+  // Types are listed from the first category with a matching code, not from its duplicate
+  CodeIdentifier tissueId("SRT", "T-D0050", "Tissue");
+  CHECK_BOOL(logic->GetTypesInTerminologyCategory(terminologyName, tissueId, codes), true);
+  CHECK_INT(static_cast<int>(codes.size()), 3);
+  CHECK_STD_STRING(codes[0].CodeMeaning, "Artery");
+  CHECK_STD_STRING(codes[1].CodeMeaning, "Vein");
+  CHECK_STD_STRING(codes[2].CodeMeaning, "Nerve");
+
+  CHECK_BOOL(logic->FindTypesInTerminologyCategory(terminologyName, tissueId, codes, "vei"), true);
+  CHECK_INT(static_cast<int>(codes.size()), 1);
+  CHECK_STD_STRING(codes[0].CodeValue, "T-48003");
+
+  CodeIdentifier arteryId("SRT", "T-41066", "Artery");
+  CHECK_BOOL(logic->GetTypeModifiersInTerminologyType(terminologyName, tissueId, arteryId, codes), true);
+  CHECK_INT(static_cast<int>(codes.size()), 2);
+  CHECK_STD_STRING(codes[1].CodeMeaning, "Right");
+
+  // Empty modifier array
+  CHECK_BOOL(logic->GetTypeModifiersInTerminologyType(terminologyName, tissueId, CodeIdentifier("SRT", "T-48003", "Vein"), codes), true);
+  CHECK_INT(static_cast<int>(codes.size()), 0);
+
+  // No modifier array
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetTypeModifiersInTerminologyType(terminologyName, tissueId, CodeIdentifier("SRT", "T-A0100", "Nerve"), codes), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  CHECK_BOOL(logic->FindRegionsInAnatomicContext(anatomicContextName, codes, "kid"), true);
+  CHECK_INT(static_cast<int>(codes.size()), 1);
+  CHECK_STD_STRING(codes[0].CodeValue, "T-71000");
+
+  CodeIdentifier kidneyId("SRT", "T-71000", "Kidney");
+  CHECK_BOOL(logic->GetRegionModifiersInAnatomicRegion(anatomicContextName, kidneyId, codes), true);
+  CHECK_INT(static_cast<int>(codes.size()), 2);
+  CHECK_STD_STRING(codes[0].CodeMeaning, "Left");
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int CheckCodeLookups(vtkSlicerTerminologiesModuleLogic* logic, const std::string& terminologyName,
+  const std::string& anatomicContextName)
+{
+  // Hit, resolved to the first of the categories with the same code
+  vtkNew<vtkSlicerTerminologyCategory> category;
+  CHECK_BOOL(logic->GetCategoryInTerminology(terminologyName, CodeIdentifier("SRT", "T-D0050", ""), category.GetPointer()), true);
+  CHECK_STRING(category->GetCodeMeaning(), "Tissue");
+
+  // Same code value in a different coding scheme is a different category
+  CHECK_BOOL(logic->GetCategoryInTerminology(terminologyName, CodeIdentifier("DCM", "T-D0050", ""), category.GetPointer()), true);
+  CHECK_STRING(category->GetCodeMeaning(), "Tissue DCM");
+
+  // Miss
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetCategoryInTerminology(terminologyName, CodeIdentifier("SRT", "T-XXXXX", "Missing"), category.GetPointer()), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  CodeIdentifier tissueId("SRT", "T-D0050", "Tissue");
+  vtkNew<vtkSlicerTerminologyType> type;
+  CHECK_BOOL(logic->GetTypeInTerminologyCategory(terminologyName, tissueId, CodeIdentifier("SRT", "T-41066", ""), type.GetPointer()), true);
+  CHECK_STRING(type->GetCodeMeaning(), "Artery");
+  CHECK_BOOL(type->GetHasModifiers(), true);
+
+  // The type of the duplicate category is not reachable through the shared category code
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetTypeInTerminologyCategory(terminologyName, tissueId, CodeIdentifier("SRT", "T-D016E", "Bone"), type.GetPointer()), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  vtkNew<vtkSlicerTerminologyType> modifier;
+  CHECK_BOOL(logic->GetTypeModifierInTerminologyType(terminologyName, tissueId, CodeIdentifier("SRT", "T-41066", ""),
+    CodeIdentifier("SRT", "G-A100", ""), modifier.GetPointer()), true);
+  CHECK_STRING(modifier->GetCodeMeaning(), "Right");
+
+  vtkNew<vtkSlicerTerminologyType> region;
+  CHECK_BOOL(logic->GetRegionInAnatomicContext(anatomicContextName, CodeIdentifier("SRT", "T-62000", ""), region.GetPointer()), true);
+  CHECK_STRING(region->GetCodeMeaning(), "Liver");
+
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetRegionInAnatomicContext(anatomicContextName, CodeIdentifier("SRT", "T-XXXXX", "Missing"), region.GetPointer()), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerTerminologiesModuleLogicTest1(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  std::string terminologyFilePath = tempDir + "/vtkSlicerTerminologiesModuleLogicTest1_Terminology.json";
+  std::string anatomicContextFilePath = tempDir + "/vtkSlicerTerminologiesModuleLogicTest1_AnatomicContext.json";
+  std::string indexCachePath = tempDir + "/vtkSlicerTerminologiesModuleLogicTest1_IndexCache";
+  vtksys::SystemTools::RemoveADirectory(indexCachePath.c_str());
+
+  WriteTestTerminology(terminologyFilePath, false);
+  WriteTestAnatomicContext(anatomicContextFilePath);
+
+  // Parse the files and write the index cache
+  {
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetIndexCachePath(indexCachePath.c_str());
+  CHECK_STD_STRING(logic->LoadTerminologyFromFile(terminologyFilePath), "Test terminology");
+  CHECK_STD_STRING(logic->LoadAnatomicContextFromFile(anatomicContextFilePath), "Test anatomic context");
+  CHECK_INT(CountIndexCacheFiles(indexCachePath), 2);
+
+  CHECK_EXIT_SUCCESS(CheckCodeLists(logic.GetPointer(), "Test terminology", "Test anatomic context", 4));
+  CHECK_EXIT_SUCCESS(CheckCodeLookups(logic.GetPointer(), "Test terminology", "Test anatomic context"));
+  }
+
+  // Load from the index cache. Lists are served from the cached index and objects are looked up
+  // after the file is parsed on demand.
+  {
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetIndexCachePath(indexCachePath.c_str());
+  CHECK_STD_STRING(logic->LoadTerminologyFromFile(terminologyFilePath), "Test terminology");
+  CHECK_BOOL(logic->LoadContextFromFile(anatomicContextFilePath), true);
+
+  CHECK_EXIT_SUCCESS(CheckCodeLists(logic.GetPointer(), "Test terminology", "Test anatomic context", 4));
+  CHECK_EXIT_SUCCESS(CheckCodeLookups(logic.GetPointer(), "Test terminology", "Test anatomic context"));
+  }
+
+  // The cached index is used without parsing the file: lists are still available after the file is moved away,
+  // while looking up an object needs the file
+  {
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetIndexCachePath(indexCachePath.c_str());
+  CHECK_STD_STRING(logic->LoadTerminologyFromFile(terminologyFilePath), "Test terminology");
+  std::string movedTerminologyFilePath = terminologyFilePath + ".moved";
+  CHECK_BOOL(vtksys::SystemTools::RenameFile(terminologyFilePath.c_str(), movedTerminologyFilePath.c_str()), true);
+
+  std::vector<CodeIdentifier> categories;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->FindCategoriesInTerminology("Test terminology", categories, ""), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(static_cast<int>(categories.size()), 4);
+
+  // Types with an empty modifier array or without modifier array are both indexed
+  CodeIdentifier tissueId("SRT", "T-D0050", "Tissue");
+  std::vector<CodeIdentifier> modifiers;
+  CHECK_BOOL(logic->GetTypeModifiersInTerminologyType("Test terminology", tissueId, CodeIdentifier("SRT", "T-48003", "Vein"), modifiers), true);
+  CHECK_INT(static_cast<int>(modifiers.size()), 0);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetTypeModifiersInTerminologyType("Test terminology", tissueId, CodeIdentifier("SRT", "T-A0100", "Nerve"), modifiers), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // None of the queries above parsed the file, it is parsed on the first object lookup
+  CHECK_BOOL(vtksys::SystemTools::RenameFile(movedTerminologyFilePath.c_str(), terminologyFilePath.c_str()), true);
+  vtkNew<vtkSlicerTerminologyCategory> category;
+  CHECK_BOOL(logic->GetCategoryInTerminology("Test terminology", CodeIdentifier("SRT", "T-D0050", ""), category.GetPointer()), true);
+  CHECK_STRING(category->GetCodeMeaning(), "Tissue");
+  }
+
+  // Looking up an object needs the file
+  {
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetIndexCachePath(indexCachePath.c_str());
+  CHECK_STD_STRING(logic->LoadTerminologyFromFile(terminologyFilePath), "Test terminology");
+  std::string movedTerminologyFilePath = terminologyFilePath + ".moved";
+  CHECK_BOOL(vtksys::SystemTools::RenameFile(terminologyFilePath.c_str(), movedTerminologyFilePath.c_str()), true);
+
+  vtkNew<vtkSlicerTerminologyCategory> category;
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(logic->GetCategoryInTerminology("Test terminology", CodeIdentifier("SRT", "T-D0050", ""), category.GetPointer()), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  CHECK_BOOL(vtksys::SystemTools::RenameFile(movedTerminologyFilePath.c_str(), terminologyFilePath.c_str()), true);
+  }
+
+  // Changing the file invalidates its cached index
+  WriteTestTerminology(terminologyFilePath, true);
+  {
+  vtkNew<vtkSlicerTerminologiesModuleLogic> logic;
+  logic->SetIndexCachePath(indexCachePath.c_str());
+  CHECK_STD_STRING(logic->LoadTerminologyFromFile(terminologyFilePath), "Test terminology");
+  CHECK_STD_STRING(logic->LoadAnatomicContextFromFile(anatomicContextFilePath), "Test anatomic context");
+  CHECK_EXIT_SUCCESS(CheckCodeLists(logic.GetPointer(), "Test terminology", "Test anatomic context", 5));
+  CHECK_EXIT_SUCCESS(CheckCodeLookups(logic.GetPointer(), "Test terminology", "Test anatomic context"));
+  }
+  CHECK_INT(CountIndexCacheFiles(indexCachePath), 2);
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -41,9 +41,14 @@
 #include <vtkVariant.h>
 #include <vtksys/SystemTools.hxx>
 #include <vtkDirectory.h>
+#include <vtkType.h>
 
 // STD includes
 #include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
 
 #include "rapidjson/document.h"     // rapidjson's DOM-style API
 #include "rapidjson/prettywriter.h" // for stringify JSON
@@ -54,6 +59,49 @@ static std::string ANATOMIC_CONTEXT_SCHEMA = "https://raw.githubusercontent.com/
 static std::string ANATOMIC_CONTEXT_SCHEMA_1 = "https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/schemas/anatomic-context-schema.json#";
 static std::string TERMINOLOGY_CONTEXT_SCHEMA = "https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/segment-context-schema.json#";
 static std::string TERMINOLOGY_CONTEXT_SCHEMA_1 = "https://raw.githubusercontent.com/qiicr/dcmqi/master/doc/schemas/segment-context-schema.json#";
+static std::string INDEX_CACHE_SIGNATURE = "SlicerTerminologyIndexCache";
+static const vtkTypeUInt32 INDEX_CACHE_VERSION = 2;
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+void WriteCacheValue(std::ostream& stream, vtkTypeInt64 value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+//---------------------------------------------------------------------------
+void WriteCacheString(std::ostream& stream, const std::string& value)
+{
+  WriteCacheValue(stream, static_cast<vtkTypeInt64>(value.size()));
+  stream.write(value.c_str(), value.size());
+}
+
+//---------------------------------------------------------------------------
+bool ReadCacheValue(std::istream& stream, vtkTypeInt64& value)
+{
+  stream.read(reinterpret_cast<char*>(&value), sizeof(value));
+  return stream.good();
+}
+
+//---------------------------------------------------------------------------
+bool ReadCacheString(std::istream& stream, std::string& value)
+{
+  vtkTypeInt64 size = 0;
+  if (!ReadCacheValue(stream, size) || size < 0 || size > (1 << 24))
+    {
+    return false;
+    }
+  value.resize(static_cast<size_t>(size));
+  if (size > 0)
+    {
+    stream.read(&value[0], size);
+    }
+  return stream.good();
+}
+
+}
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTerminologiesModuleLogic);
@@ -66,14 +114,89 @@ public:
   // on Linux and Mac), therefore we store a simple pointer and create/delete
   // the document object manually
   typedef std::map<std::string, rapidjson::Document* > TerminologyMap;
+
+  /// Lookup structure for the codes contained in a Json code array (categories, types, modifiers, regions).
+  /// Built when a context file is loaded and stored in the index cache, so that queries neither need to
+  /// walk the Json array nor, if the cache is up to date, parse the Json file.
+  struct CodeArrayIndex
+    {
+    CodeArrayIndex() : Missing(false) { }
+    /// True if the object has no such array (e.g. a type without Modifier member), so that
+    /// queries on it fail from the index without parsing the context
+    bool Missing;
+    /// Identifiers of the valid codes in the array, in array order
+    std::vector<CodeIdentifier> Codes;
+    /// Lowercase code meanings for case-insensitive search. Same order as \sa Codes
+    std::vector<std::string> LowerCaseCodeMeanings;
+    /// Index of the code object in the Json array. Key is created by \sa GetCodeIndexKey
+    std::map<std::string, rapidjson::SizeType> ArrayIndexByCode;
+    /// Code meanings of the objects in the array that are not valid codes, for error reporting
+    std::vector<std::string> InvalidCodeMeanings;
+    };
+  /// Indices of the code arrays of a context. Key is the path of the array, see \sa GetCodeArrayPath
+  typedef std::map<std::string, CodeArrayIndex> CodeArrayIndexMap;
+  /// Code array indices of the loaded contexts. Key is the context name
+  typedef std::map<std::string, CodeArrayIndexMap> ContextIndexMap;
+
   vtkInternal();
   ~vtkInternal();
 
   /// Utility function to get code in Json array
+  /// Note: Walks the array linearly. Use \sa GetCodeInIndexedArray for arrays of loaded contexts
   /// \param foundIndex Output parameter for index of found object in input array. -1 if not found
   /// \return Json object if found, otherwise null Json object
   rapidjson::Value& GetCodeInArray(CodeIdentifier codeId, rapidjson::Value& jsonArray, int &foundIndex);
 
+  /// Get code in a Json array of a loaded context using the index of the array
+  /// \return Json object if found, otherwise null Json object
+  rapidjson::Value& GetCodeInIndexedArray(CodeIdentifier codeId, rapidjson::Value& jsonArray, CodeArrayIndex& arrayIndex);
+
+  /// Get index of a code array of a loaded context if it has already been built
+  /// \return NULL if the array is not indexed
+  CodeArrayIndex* FindCodeArrayIndex(ContextIndexMap& contextIndices, const std::string& contextName, const std::string& arrayPath);
+  /// Get index of a Json code array of a loaded context. The index is built from the Json array if needed
+  CodeArrayIndex& GetCodeArrayIndex(ContextIndexMap& contextIndices, const std::string& contextName,
+    const std::string& arrayPath, rapidjson::Value& jsonArray);
+
+  /// Get key identifying a code in \sa CodeArrayIndex (coding scheme designator and code value)
+  static std::string GetCodeIndexKey(const std::string& codingSchemeDesignator, const std::string& codeValue)
+    {
+    return codingSchemeDesignator + "^" + codeValue;
+    }
+  /// Get path identifying a code array within a context. The top level (category or region) array has
+  /// an empty path, nested arrays are identified by the codes of their parent objects
+  static std::string GetCodeArrayPath(const CodeIdentifier& parentId)
+    {
+    return GetCodeIndexKey(parentId.CodingSchemeDesignator, parentId.CodeValue);
+    }
+  static std::string GetCodeArrayPath(const CodeIdentifier& grandParentId, const CodeIdentifier& parentId)
+    {
+    return GetCodeArrayPath(grandParentId) + "/" + GetCodeArrayPath(parentId);
+    }
+
+  /// Collect codes from a code array index whose code meaning contains the search string
+  /// \param search Lowercase search string. All codes are returned if empty
+  static void FindCodesInIndex(const CodeArrayIndex& arrayIndex, std::string search, std::vector<CodeIdentifier>& codes);
+
+  /// Index all the code arrays (categories, types and type modifiers) of a loaded terminology
+  void IndexTerminology(const std::string& terminologyName);
+  /// Index all the code arrays (regions and region modifiers) of a loaded anatomic context
+  void IndexAnatomicContext(const std::string& anatomicContextName);
+
+  /// Get the file in which the code array indices of a context file are cached
+  static std::string GetIndexCacheFilePath(const char* indexCachePath, const std::string& filePath);
+  /// Read the cached code array indices of a context file
+  /// \return False if there is no cache or it is out of date with respect to the context file
+  bool ReadIndexCache(const char* indexCachePath, const std::string& filePath,
+    bool& isTerminology, std::string& contextName, CodeArrayIndexMap& contextIndex);
+  /// Index the code arrays of a context loaded from a file and write them to the index cache
+  void WriteIndexCache(const char* indexCachePath, const std::string& filePath, bool isTerminology, const std::string& contextName);
+  /// Register a context from its cached index. The Json file is only parsed when a code object is accessed
+  void SetDeferredContext(bool isTerminology, const std::string& contextName, const std::string& filePath, CodeArrayIndexMap& contextIndex);
+  /// Parse the Json file of a context that was registered from the index cache
+  /// \return The parsed document, NULL on failure
+  rapidjson::Document* ParseDeferredContext(std::map<std::string, std::string>& deferredFiles, const std::string& contextName);
+
   /// Get root Json value for the terminology with given name
   rapidjson::Value& GetTerminologyRootByName(std::string terminologyName);
 
@@ -138,8 +261,19 @@ public:
   void GetJsonCodeFromIdentifier(rapidjson::Value& code, CodeIdentifier idenfifier, rapidjson::Document::AllocatorType& allocator);
 
   /// Utility function for safe (memory-leak-free) setting of a document pointer in map
-  static void SetDocumentInTerminologyMap(TerminologyMap& terminologyMap, const std::string& name, rapidjson::Document* doc)
+  /// Note: Clears the code array indices of the context as the stored arrays may have been changed or deleted
+  void SetDocumentInTerminologyMap(TerminologyMap& terminologyMap, const std::string& name, rapidjson::Document* doc)
     {
+    if (&terminologyMap == &this->LoadedTerminologies)
+      {
+      this->TerminologyIndices.erase(name);
+      this->DeferredTerminologyFiles.erase(name);
+      }
+    else
+      {
+      this->AnatomicContextIndices.erase(name);
+      this->DeferredAnatomicContextFiles.erase(name);
+      }
     if (terminologyMap.find(name) != terminologyMap.end())
       {
       if (doc == terminologyMap[name])
@@ -160,6 +294,17 @@ public:
 
   /// Loaded anatomical region contexts. Key is the context name, value is the root item.
   TerminologyMap LoadedAnatomicContexts;
+
+  /// Code array indices of the loaded terminologies
+  ContextIndexMap TerminologyIndices;
+  /// Code array indices of the loaded anatomic contexts
+  ContextIndexMap AnatomicContextIndices;
+
+  /// Json files of the terminologies registered from the index cache that have not been parsed yet.
+  /// Key is the context name, value is the file path. The document of these contexts is NULL in \sa LoadedTerminologies
+  std::map<std::string, std::string> DeferredTerminologyFiles;
+  /// Json files of the anatomic contexts registered from the index cache that have not been parsed yet
+  std::map<std::string, std::string> DeferredAnatomicContextFiles;
 };
 
 //---------------------------------------------------------------------------
@@ -217,10 +362,435 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInArray
   return JSON_EMPTY_VALUE;
 }
 
+//---------------------------------------------------------------------------
+vtkSlicerTerminologiesModuleLogic::vtkInternal::CodeArrayIndex*
+vtkSlicerTerminologiesModuleLogic::vtkInternal::FindCodeArrayIndex(
+  ContextIndexMap& contextIndices, const std::string& contextName, const std::string& arrayPath)
+{
+  ContextIndexMap::iterator contextIt = contextIndices.find(contextName);
+  if (contextIt == contextIndices.end())
+    {
+    return NULL;
+    }
+  CodeArrayIndexMap::iterator indexIt = contextIt->second.find(arrayPath);
+  if (indexIt == contextIt->second.end())
+    {
+    return NULL;
+    }
+  return &(indexIt->second);
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerTerminologiesModuleLogic::vtkInternal::CodeArrayIndex&
+vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeArrayIndex(
+  ContextIndexMap& contextIndices, const std::string& contextName, const std::string& arrayPath, rapidjson::Value& jsonArray)
+{
+  CodeArrayIndex* existingIndex = this->FindCodeArrayIndex(contextIndices, contextName, arrayPath);
+  if (existingIndex)
+    {
+    return *existingIndex;
+    }
+
+  CodeArrayIndex& arrayIndex = contextIndices[contextName][arrayPath];
+  if (!jsonArray.IsArray())
+    {
+    arrayIndex.Missing = true;
+    return arrayIndex;
+    }
+  arrayIndex.Codes.reserve(jsonArray.Size());
+  arrayIndex.LowerCaseCodeMeanings.reserve(jsonArray.Size());
+  for (rapidjson::SizeType index = 0; index < jsonArray.Size(); ++index)
+    {
+    rapidjson::Value& currentObject = jsonArray[index];
+    if (!currentObject.IsObject())
+      {
+      continue;
+      }
+    rapidjson::Value::MemberIterator codeMeaning = currentObject.FindMember("CodeMeaning");
+    rapidjson::Value::MemberIterator codingSchemeDesignator = currentObject.FindMember("CodingSchemeDesignator");
+    rapidjson::Value::MemberIterator codeValue = currentObject.FindMember("CodeValue");
+    bool validCodeMeaning = (codeMeaning != currentObject.MemberEnd() && codeMeaning->value.IsString());
+    if ( codingSchemeDesignator == currentObject.MemberEnd() || !codingSchemeDesignator->value.IsString()
+      || codeValue == currentObject.MemberEnd() || !codeValue->value.IsString() )
+      {
+      arrayIndex.InvalidCodeMeanings.push_back(validCodeMeaning ? codeMeaning->value.GetString() : "");
+      continue;
+      }
+    // Keep the first occurrence of a code, same as the linear search in GetCodeInArray
+    std::string key = GetCodeIndexKey(codingSchemeDesignator->value.GetString(), codeValue->value.GetString());
+    arrayIndex.ArrayIndexByCode.insert(std::make_pair(key, index));
+
+    if (!validCodeMeaning)
+      {
+      arrayIndex.InvalidCodeMeanings.push_back("");
+      continue;
+      }
+    std::string codeMeaningStr = codeMeaning->value.GetString();
+    std::string codeMeaningLowerCase(codeMeaningStr);
+    std::transform(codeMeaningLowerCase.begin(), codeMeaningLowerCase.end(), codeMeaningLowerCase.begin(), ::tolower);
+    arrayIndex.Codes.push_back(CodeIdentifier(
+      codingSchemeDesignator->value.GetString(), codeValue->value.GetString(), codeMeaningStr));
+    arrayIndex.LowerCaseCodeMeanings.push_back(codeMeaningLowerCase);
+    }
+
+  return arrayIndex;
+}
+
+//---------------------------------------------------------------------------
+rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCodeInIndexedArray(
+  CodeIdentifier codeId, rapidjson::Value& jsonArray, CodeArrayIndex& arrayIndex)
+{
+  if (!jsonArray.IsArray())
+    {
+    return JSON_EMPTY_VALUE;
+    }
+
+  std::map<std::string, rapidjson::SizeType>::iterator codeIt =
+    arrayIndex.ArrayIndexByCode.find(GetCodeIndexKey(codeId.CodingSchemeDesignator, codeId.CodeValue));
+  if (codeIt == arrayIndex.ArrayIndexByCode.end() || codeIt->second >= jsonArray.Size())
+    {
+    return JSON_EMPTY_VALUE;
+    }
+
+  return jsonArray[codeIt->second];
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::FindCodesInIndex(
+  const CodeArrayIndex& arrayIndex, std::string search, std::vector<CodeIdentifier>& codes)
+{
+  if (search.empty())
+    {
+    codes.insert(codes.end(), arrayIndex.Codes.begin(), arrayIndex.Codes.end());
+    return;
+    }
+  for (size_t index = 0; index < arrayIndex.Codes.size(); ++index)
+    {
+    if (arrayIndex.LowerCaseCodeMeanings[index].find(search) != std::string::npos)
+      {
+      codes.push_back(arrayIndex.Codes[index]);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::IndexTerminology(const std::string& terminologyName)
+{
+  rapidjson::Value& categoryArray = this->GetCategoryArrayInTerminology(terminologyName);
+  if (!categoryArray.IsArray())
+    {
+    return;
+    }
+  CodeArrayIndex& categoryIndex = this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, "", categoryArray);
+  std::map<std::string, rapidjson::SizeType>::iterator categoryIt;
+  for (categoryIt = categoryIndex.ArrayIndexByCode.begin(); categoryIt != categoryIndex.ArrayIndexByCode.end(); ++categoryIt)
+    {
+    rapidjson::Value& categoryObject = categoryArray[categoryIt->second];
+    // Objects without a type or modifier array are indexed too, as missing arrays
+    rapidjson::Value::MemberIterator typeArrayIt = categoryObject.FindMember("Type");
+    rapidjson::Value& typeArray = (typeArrayIt != categoryObject.MemberEnd() ? typeArrayIt->value : JSON_EMPTY_VALUE);
+    CodeArrayIndex& typeIndex = this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, categoryIt->first, typeArray);
+    std::map<std::string, rapidjson::SizeType>::iterator typeIt;
+    for (typeIt = typeIndex.ArrayIndexByCode.begin(); typeIt != typeIndex.ArrayIndexByCode.end(); ++typeIt)
+      {
+      rapidjson::Value& typeObject = typeArray[typeIt->second];
+      rapidjson::Value::MemberIterator modifierArrayIt = typeObject.FindMember("Modifier");
+      this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, categoryIt->first + "/" + typeIt->first,
+        modifierArrayIt != typeObject.MemberEnd() ? modifierArrayIt->value : JSON_EMPTY_VALUE);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::IndexAnatomicContext(const std::string& anatomicContextName)
+{
+  rapidjson::Value& regionArray = this->GetRegionArrayInAnatomicContext(anatomicContextName);
+  if (!regionArray.IsArray())
+    {
+    return;
+    }
+  CodeArrayIndex& regionIndex = this->GetCodeArrayIndex(this->AnatomicContextIndices, anatomicContextName, "", regionArray);
+  std::map<std::string, rapidjson::SizeType>::iterator regionIt;
+  for (regionIt = regionIndex.ArrayIndexByCode.begin(); regionIt != regionIndex.ArrayIndexByCode.end(); ++regionIt)
+    {
+    rapidjson::Value& regionObject = regionArray[regionIt->second];
+    rapidjson::Value::MemberIterator modifierArrayIt = regionObject.FindMember("Modifier");
+    this->GetCodeArrayIndex(this->AnatomicContextIndices, anatomicContextName, regionIt->first,
+      modifierArrayIt != regionObject.MemberEnd() ? modifierArrayIt->value : JSON_EMPTY_VALUE);
+    }
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerTerminologiesModuleLogic::vtkInternal::GetIndexCacheFilePath(const char* indexCachePath, const std::string& filePath)
+{
+  if (!indexCachePath || !indexCachePath[0])
+    {
+    return "";
+    }
+  // Files with the same name in different directories get different cache files
+  std::string fullPath = vtksys::SystemTools::CollapseFullPath(filePath);
+  vtkTypeUInt32 hash = 2166136261u;
+  for (std::string::const_iterator charIt = fullPath.begin(); charIt != fullPath.end(); ++charIt)
+    {
+    hash = (hash ^ static_cast<unsigned char>(*charIt)) * 16777619u;
+    }
+  std::stringstream cacheFilePath;
+  cacheFilePath << indexCachePath << "/" << vtksys::SystemTools::GetFilenameWithoutLastExtension(fullPath)
+    << "-" << std::hex << hash << ".index";
+  return cacheFilePath.str();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ReadIndexCache(const char* indexCachePath, const std::string& filePath,
+  bool& isTerminology, std::string& contextName, CodeArrayIndexMap& contextIndex)
+{
+  std::string cacheFilePath = GetIndexCacheFilePath(indexCachePath, filePath);
+  if (cacheFilePath.empty() || !vtksys::SystemTools::FileExists(cacheFilePath.c_str(), true))
+    {
+    return false;
+    }
+  std::ifstream stream(cacheFilePath.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    {
+    return false;
+    }
+
+  // The cache is only valid for the exact same version of the context file
+  std::string signature;
+  vtkTypeInt64 version = 0;
+  std::string cachedFilePath;
+  vtkTypeInt64 fileSize = 0;
+  vtkTypeInt64 fileTime = 0;
+  vtkTypeInt64 terminology = 0;
+  if ( !ReadCacheString(stream, signature) || signature != INDEX_CACHE_SIGNATURE
+    || !ReadCacheValue(stream, version) || version != INDEX_CACHE_VERSION
+    || !ReadCacheString(stream, cachedFilePath) || cachedFilePath != vtksys::SystemTools::CollapseFullPath(filePath)
+    || !ReadCacheValue(stream, fileSize) || fileSize != static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(filePath))
+    || !ReadCacheValue(stream, fileTime) || fileTime != static_cast<vtkTypeInt64>(vtksys::SystemTools::ModifiedTime(filePath))
+    || !ReadCacheValue(stream, terminology) || !ReadCacheString(stream, contextName) || contextName.empty() )
+    {
+    return false;
+    }
+  isTerminology = (terminology != 0);
+
+  contextIndex.clear();
+  vtkTypeInt64 numberOfArrays = 0;
+  if (!ReadCacheValue(stream, numberOfArrays))
+    {
+    return false;
+    }
+  for (vtkTypeInt64 arrayIndex = 0; arrayIndex < numberOfArrays; ++arrayIndex)
+    {
+    std::string arrayPath;
+    if (!ReadCacheString(stream, arrayPath))
+      {
+      return false;
+      }
+    CodeArrayIndex& codeArrayIndex = contextIndex[arrayPath];
+    vtkTypeInt64 missing = 0;
+    if (!ReadCacheValue(stream, missing))
+      {
+      return false;
+      }
+    codeArrayIndex.Missing = (missing != 0);
+
+    vtkTypeInt64 numberOfCodes = 0;
+    if (!ReadCacheValue(stream, numberOfCodes))
+      {
+      return false;
+      }
+    for (vtkTypeInt64 codeIndex = 0; codeIndex < numberOfCodes; ++codeIndex)
+      {
+      CodeIdentifier codeId;
+      if ( !ReadCacheString(stream, codeId.CodingSchemeDesignator) || !ReadCacheString(stream, codeId.CodeValue)
+        || !ReadCacheString(stream, codeId.CodeMeaning) )
+        {
+        return false;
+        }
+      std::string codeMeaningLowerCase(codeId.CodeMeaning);
+      std::transform(codeMeaningLowerCase.begin(), codeMeaningLowerCase.end(), codeMeaningLowerCase.begin(), ::tolower);
+      codeArrayIndex.Codes.push_back(codeId);
+      codeArrayIndex.LowerCaseCodeMeanings.push_back(codeMeaningLowerCase);
+      }
+
+    vtkTypeInt64 numberOfKeys = 0;
+    if (!ReadCacheValue(stream, numberOfKeys))
+      {
+      return false;
+      }
+    for (vtkTypeInt64 keyIndex = 0; keyIndex < numberOfKeys; ++keyIndex)
+      {
+      std::string key;
+      vtkTypeInt64 position = 0;
+      if (!ReadCacheString(stream, key) || !ReadCacheValue(stream, position))
+        {
+        return false;
+        }
+      codeArrayIndex.ArrayIndexByCode[key] = static_cast<rapidjson::SizeType>(position);
+      }
+
+    vtkTypeInt64 numberOfInvalidCodes = 0;
+    if (!ReadCacheValue(stream, numberOfInvalidCodes))
+      {
+      return false;
+      }
+    for (vtkTypeInt64 invalidIndex = 0; invalidIndex < numberOfInvalidCodes; ++invalidIndex)
+      {
+      std::string invalidCodeMeaning;
+      if (!ReadCacheString(stream, invalidCodeMeaning))
+        {
+        return false;
+        }
+      codeArrayIndex.InvalidCodeMeanings.push_back(invalidCodeMeaning);
+      }
+    }
+
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::WriteIndexCache(
+  const char* indexCachePath, const std::string& filePath, bool isTerminology, const std::string& contextName)
+{
+  if (isTerminology)
+    {
+    this->IndexTerminology(contextName);
+    }
+  else
+    {
+    this->IndexAnatomicContext(contextName);
+    }
+
+  std::string cacheFilePath = GetIndexCacheFilePath(indexCachePath, filePath);
+  if (cacheFilePath.empty())
+    {
+    return;
+    }
+  if (!vtksys::SystemTools::MakeDirectory(indexCachePath))
+    {
+    vtkGenericWarningMacro("WriteIndexCache: Failed to create terminology index cache directory " << indexCachePath);
+    return;
+    }
+
+  // Write to a temporary file first so that a concurrent reader never sees a partial cache
+  std::string temporaryCacheFilePath = cacheFilePath + ".tmp";
+  std::ofstream stream(temporaryCacheFilePath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!stream.is_open())
+    {
+    vtkGenericWarningMacro("WriteIndexCache: Failed to write terminology index cache file " << temporaryCacheFilePath);
+    return;
+    }
+  WriteCacheString(stream, INDEX_CACHE_SIGNATURE);
+  WriteCacheValue(stream, INDEX_CACHE_VERSION);
+  WriteCacheString(stream, vtksys::SystemTools::CollapseFullPath(filePath));
+  WriteCacheValue(stream, static_cast<vtkTypeInt64>(vtksys::SystemTools::FileLength(filePath)));
+  WriteCacheValue(stream, static_cast<vtkTypeInt64>(vtksys::SystemTools::ModifiedTime(filePath)));
+  WriteCacheValue(stream, isTerminology ? 1 : 0);
+  WriteCacheString(stream, contextName);
+
+  CodeArrayIndexMap& contextIndex = (isTerminology ? this->TerminologyIndices : this->AnatomicContextIndices)[contextName];
+  WriteCacheValue(stream, static_cast<vtkTypeInt64>(contextIndex.size()));
+  for (CodeArrayIndexMap::iterator indexIt = contextIndex.begin(); indexIt != contextIndex.end(); ++indexIt)
+    {
+    const CodeArrayIndex& codeArrayIndex = indexIt->second;
+    WriteCacheString(stream, indexIt->first);
+    WriteCacheValue(stream, codeArrayIndex.Missing ? 1 : 0);
+    WriteCacheValue(stream, static_cast<vtkTypeInt64>(codeArrayIndex.Codes.size()));
+    for (std::vector<CodeIdentifier>::const_iterator codeIt = codeArrayIndex.Codes.begin(); codeIt != codeArrayIndex.Codes.end(); ++codeIt)
+      {
+      WriteCacheString(stream, codeIt->CodingSchemeDesignator);
+      WriteCacheString(stream, codeIt->CodeValue);
+      WriteCacheString(stream, codeIt->CodeMeaning);
+      }
+    WriteCacheValue(stream, static_cast<vtkTypeInt64>(codeArrayIndex.ArrayIndexByCode.size()));
+    std::map<std::string, rapidjson::SizeType>::const_iterator keyIt;
+    for (keyIt = codeArrayIndex.ArrayIndexByCode.begin(); keyIt != codeArrayIndex.ArrayIndexByCode.end(); ++keyIt)
+      {
+      WriteCacheString(stream, keyIt->first);
+      WriteCacheValue(stream, static_cast<vtkTypeInt64>(keyIt->second));
+      }
+    WriteCacheValue(stream, static_cast<vtkTypeInt64>(codeArrayIndex.InvalidCodeMeanings.size()));
+    for (std::vector<std::string>::const_iterator invalidIt = codeArrayIndex.InvalidCodeMeanings.begin();
+      invalidIt != codeArrayIndex.InvalidCodeMeanings.end(); ++invalidIt)
+      {
+      WriteCacheString(stream, *invalidIt);
+      }
+    }
+  stream.close();
+  if (stream.fail() || !vtksys::SystemTools::RenameFile(temporaryCacheFilePath.c_str(), cacheFilePath.c_str()))
+    {
+    vtkGenericWarningMacro("WriteIndexCache: Failed to write terminology index cache file " << cacheFilePath);
+    vtksys::SystemTools::RemoveFile(temporaryCacheFilePath);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDeferredContext(
+  bool isTerminology, const std::string& contextName, const std::string& filePath, CodeArrayIndexMap& contextIndex)
+{
+  if (isTerminology)
+    {
+    this->SetDocumentInTerminologyMap(this->LoadedTerminologies, contextName, NULL);
+    this->TerminologyIndices[contextName].swap(contextIndex);
+    this->DeferredTerminologyFiles[contextName] = filePath;
+    }
+  else
+    {
+    this->SetDocumentInTerminologyMap(this->LoadedAnatomicContexts, contextName, NULL);
+    this->AnatomicContextIndices[contextName].swap(contextIndex);
+    this->DeferredAnatomicContextFiles[contextName] = filePath;
+    }
+}
+
+//---------------------------------------------------------------------------
+rapidjson::Document* vtkSlicerTerminologiesModuleLogic::vtkInternal::ParseDeferredContext(
+  std::map<std::string, std::string>& deferredFiles, const std::string& contextName)
+{
+  std::map<std::string, std::string>::iterator fileIt = deferredFiles.find(contextName);
+  if (fileIt == deferredFiles.end())
+    {
+    return NULL;
+    }
+  std::string filePath = fileIt->second;
+  deferredFiles.erase(fileIt);
+
+  // The file may have changed since the index was read, so the arrays are indexed again from the parsed document
+  if (&deferredFiles == &this->DeferredTerminologyFiles)
+    {
+    this->TerminologyIndices.erase(contextName);
+    }
+  else
+    {
+    this->AnatomicContextIndices.erase(contextName);
+    }
+
+  FILE *fp = fopen(filePath.c_str(), "r");
+  if (!fp)
+    {
+    vtkGenericWarningMacro("ParseDeferredContext: Failed to load context '" << contextName << "' from file " << filePath);
+    return NULL;
+    }
+  rapidjson::Document* doc = new rapidjson::Document;
+  char buffer[4096];
+  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
+  if (doc->ParseStream(fs).HasParseError())
+    {
+    vtkGenericWarningMacro("ParseDeferredContext: Failed to load context '" << contextName << "' from file " << filePath);
+    delete doc;
+    doc = NULL;
+    }
+  fclose(fp);
+  return doc;
+}
+
 //---------------------------------------------------------------------------
 rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTerminologyRootByName(std::string terminologyName)
 {
   TerminologyMap::iterator termIt = this->LoadedTerminologies.find(terminologyName);
+  if (termIt != this->LoadedTerminologies.end() && termIt->second == NULL)
+    {
+    termIt->second = this->ParseDeferredContext(this->DeferredTerminologyFiles, terminologyName);
+    }
   if (termIt != this->LoadedTerminologies.end() && termIt->second != NULL)
     {
     return *(termIt->second);
@@ -273,8 +843,8 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetCategoryInT
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(categoryId, categoryArray, index);
+  return this->GetCodeInIndexedArray(categoryId, categoryArray,
+    this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, "", categoryArray));
 }
 
 //---------------------------------------------------------------------------
@@ -372,8 +942,8 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeInTermi
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(typeId, typeArray, index);
+  return this->GetCodeInIndexedArray(typeId, typeArray,
+    this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, GetCodeArrayPath(categoryId), typeArray));
 }
 
 //---------------------------------------------------------------------------
@@ -500,14 +1070,18 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetTypeModifie
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(modifierId, typeModifierArray, index);
+  return this->GetCodeInIndexedArray(modifierId, typeModifierArray,
+    this->GetCodeArrayIndex(this->TerminologyIndices, terminologyName, GetCodeArrayPath(categoryId, typeId), typeModifierArray));
 }
 
 //---------------------------------------------------------------------------
 rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetAnatomicContextRootByName(std::string anatomicContextName)
 {
   TerminologyMap::iterator anIt = this->LoadedAnatomicContexts.find(anatomicContextName);
+  if (anIt != this->LoadedAnatomicContexts.end() && anIt->second == NULL)
+    {
+    anIt->second = this->ParseDeferredContext(this->DeferredAnatomicContextFiles, anatomicContextName);
+    }
   if (anIt != this->LoadedAnatomicContexts.end() && anIt->second != NULL)
     {
     return *(anIt->second);
@@ -560,8 +1134,8 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionInAna
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(regionId, regionArray, index);
+  return this->GetCodeInIndexedArray(regionId, regionArray,
+    this->GetCodeArrayIndex(this->AnatomicContextIndices, anatomicContextName, "", regionArray));
 }
 
 //---------------------------------------------------------------------------
@@ -612,8 +1186,8 @@ rapidjson::Value& vtkSlicerTerminologiesModuleLogic::vtkInternal::GetRegionModif
     return JSON_EMPTY_VALUE;
     }
 
-  int index = -1;
-  return this->GetCodeInArray(modifierId, regionModifierArray, index);
+  return this->GetCodeInIndexedArray(modifierId, regionModifierArray,
+    this->GetCodeArrayIndex(this->AnatomicContextIndices, anatomicContextName, GetCodeArrayPath(regionId), regionModifierArray));
 }
 
 //---------------------------------------------------------------------------
@@ -633,6 +1207,9 @@ bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ConvertSegmentationDescript
     return false;
     }
 
+  // The converted document may be a loaded context that is modified in place
+  this->TerminologyIndices.erase(contextName);
+
   rapidjson::Document::AllocatorType& allocator = convertedDoc.GetAllocator();
 
   // Use terminology with context name if exists
@@ -853,6 +1430,9 @@ bool vtkSlicerTerminologiesModuleLogic::vtkInternal::ConvertSegmentationDescript
     return false;
     }
 
+  // The converted document may be a loaded context that is modified in place
+  this->AnatomicContextIndices.erase(contextName);
+
   rapidjson::Document::AllocatorType& allocator = convertedDoc.GetAllocator();
 
   // Use terminology with context name if exists
@@ -995,6 +1575,7 @@ void vtkSlicerTerminologiesModuleLogic::vtkInternal::GetJsonCodeFromIdentifier(
 //----------------------------------------------------------------------------
 vtkSlicerTerminologiesModuleLogic::vtkSlicerTerminologiesModuleLogic()
   : UserContextsPath(NULL)
+  , IndexCachePath(NULL)
 {
   this->Internal = new vtkInternal();
 }
@@ -1006,6 +1587,7 @@ vtkSlicerTerminologiesModuleLogic::~vtkSlicerTerminologiesModuleLogic()
   this->Internal = NULL;
 
   this->SetUserContextsPath(NULL);
+  this->SetIndexCachePath(NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -1032,6 +1614,18 @@ void vtkSlicerTerminologiesModuleLogic::SetMRMLSceneInternal(vtkMRMLScene* newSc
 //---------------------------------------------------------------------------
 bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath)
 {
+  // Register the context from the index cache if it is up to date, the file is then parsed on demand
+  bool isTerminology = false;
+  std::string cachedContextName;
+  vtkInternal::CodeArrayIndexMap cachedIndex;
+  if (this->Internal->ReadIndexCache(this->IndexCachePath, filePath, isTerminology, cachedContextName, cachedIndex))
+    {
+    this->Internal->SetDeferredContext(isTerminology, cachedContextName, filePath, cachedIndex);
+    vtkDebugMacro("Context named '" << cachedContextName << "' successfully loaded from index cache of file " << filePath);
+    this->Modified();
+    return true;
+    }
+
   rapidjson::Document* jsonRoot = new rapidjson::Document;
 
   FILE *fp = fopen(filePath.c_str(), "r");
@@ -1062,16 +1656,18 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
     {
     // Store terminology
     std::string contextName = (*jsonRoot)["SegmentationCategoryTypeContextName"].GetString();
-    vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+    this->Internal->SetDocumentInTerminologyMap(
       this->Internal->LoadedTerminologies, contextName, jsonRoot);
+    this->Internal->WriteIndexCache(this->IndexCachePath, filePath, true, contextName);
     vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
     }
   else if (!schema.compare(ANATOMIC_CONTEXT_SCHEMA) || !schema.compare(ANATOMIC_CONTEXT_SCHEMA_1))
     {
     // Store anatomic context
     std::string contextName = (*jsonRoot)["AnatomicContextName"].GetString();
-    vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+    this->Internal->SetDocumentInTerminologyMap(
       this->Internal->LoadedAnatomicContexts, contextName, jsonRoot);
+    this->Internal->WriteIndexCache(this->IndexCachePath, filePath, false, contextName);
     vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
     }
   else
@@ -1089,6 +1685,19 @@ bool vtkSlicerTerminologiesModuleLogic::LoadContextFromFile(std::string filePath
 //---------------------------------------------------------------------------
 std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::string filePath)
 {
+  // Register the terminology from the index cache if it is up to date, the file is then parsed on demand
+  bool isTerminology = false;
+  std::string cachedContextName;
+  vtkInternal::CodeArrayIndexMap cachedIndex;
+  if ( this->Internal->ReadIndexCache(this->IndexCachePath, filePath, isTerminology, cachedContextName, cachedIndex)
+    && isTerminology )
+    {
+    this->Internal->SetDeferredContext(true, cachedContextName, filePath, cachedIndex);
+    vtkDebugMacro("Terminology named '" << cachedContextName << "' successfully loaded from index cache of file " << filePath);
+    this->Modified();
+    return cachedContextName;
+    }
+
   rapidjson::Document* terminologyRoot = new rapidjson::Document;
 
   FILE *fp = fopen(filePath.c_str(), "r");
@@ -1124,8 +1733,9 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromFile(std::stri
 
   // Store terminology
   std::string contextName = (*terminologyRoot)["SegmentationCategoryTypeContextName"].GetString();
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedTerminologies, contextName, terminologyRoot);
+  this->Internal->WriteIndexCache(this->IndexCachePath, filePath, true, contextName);
 
   vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
   fclose(fp);
@@ -1153,7 +1763,9 @@ bool vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromSegmentDescriptorFile
     return false;
     }
 
-  // Convert the loaded descriptor json file into terminology dictionary context json format
+  // Convert the loaded descriptor json file into terminology dictionary context json format.
+  // A terminology registered from the index cache is parsed first so that it is extended, not replaced
+  this->Internal->GetTerminologyRootByName(contextName);
   rapidjson::Document* convertedDoc = NULL;
   vtkInternal::TerminologyMap::iterator termIt = this->Internal->LoadedTerminologies.find(contextName);
   if (termIt != this->Internal->LoadedTerminologies.end() && termIt->second != NULL)
@@ -1174,7 +1786,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadTerminologyFromSegmentDescriptorFile
     }
 
   // Store terminology
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedTerminologies, contextName, convertedDoc );
 
   vtkDebugMacro("Terminology named '" << contextName << "' successfully loaded from file " << filePath);
@@ -1202,6 +1814,19 @@ void vtkSlicerTerminologiesModuleLogic::LoadDefaultTerminologies()
 //---------------------------------------------------------------------------
 std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::string filePath)
 {
+  // Register the anatomic context from the index cache if it is up to date, the file is then parsed on demand
+  bool isTerminology = true;
+  std::string cachedContextName;
+  vtkInternal::CodeArrayIndexMap cachedIndex;
+  if ( this->Internal->ReadIndexCache(this->IndexCachePath, filePath, isTerminology, cachedContextName, cachedIndex)
+    && !isTerminology )
+    {
+    this->Internal->SetDeferredContext(false, cachedContextName, filePath, cachedIndex);
+    vtkDebugMacro("Anatomic context named '" << cachedContextName << "' successfully loaded from index cache of file " << filePath);
+    this->Modified();
+    return cachedContextName;
+    }
+
   rapidjson::Document* anatomicContextRoot = new rapidjson::Document;
 
   FILE *fp = fopen(filePath.c_str(), "r");
@@ -1238,8 +1863,9 @@ std::string vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromFile(std::
 
   // Store anatomic context
   std::string contextName = (*anatomicContextRoot)["AnatomicContextName"].GetString();
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedAnatomicContexts, contextName, anatomicContextRoot);
+  this->Internal->WriteIndexCache(this->IndexCachePath, filePath, false, contextName);
 
   vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
   fclose(fp);
@@ -1267,7 +1893,9 @@ bool vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromSegmentDescriptor
     return false;
     }
 
-  // Convert the loaded descriptor json file into anatomic context json format
+  // Convert the loaded descriptor json file into anatomic context json format.
+  // An anatomic context registered from the index cache is parsed first so that it is extended, not replaced
+  this->Internal->GetAnatomicContextRootByName(contextName);
   rapidjson::Document* convertedDoc = NULL;
   vtkInternal::TerminologyMap::iterator anIt = this->Internal->LoadedAnatomicContexts.find(contextName);
   if (anIt != this->Internal->LoadedAnatomicContexts.end() && anIt->second != NULL)
@@ -1288,7 +1916,7 @@ bool vtkSlicerTerminologiesModuleLogic::LoadAnatomicContextFromSegmentDescriptor
     }
 
   // Store anatomic context
-  vtkSlicerTerminologiesModuleLogic::vtkInternal::SetDocumentInTerminologyMap(
+  this->Internal->SetDocumentInTerminologyMap(
     this->Internal->LoadedAnatomicContexts, contextName, convertedDoc );
 
   vtkDebugMacro("Anatomic context named '" << contextName << "' successfully loaded from file " << filePath);
@@ -1415,45 +2043,36 @@ bool vtkSlicerTerminologiesModuleLogic::FindCategoriesInTerminology(std::string
 {
   categories.clear();
 
-  rapidjson::Value& categoryArray = this->Internal->GetCategoryArrayInTerminology(terminologyName);
-  if (categoryArray.IsNull())
+  // Use the index of the category array, which does not require the terminology to be parsed if it was
+  // loaded from the index cache
+  vtkInternal::CodeArrayIndex* categoryIndex = this->Internal->FindCodeArrayIndex(
+    this->Internal->TerminologyIndices, terminologyName, "");
+  if (!categoryIndex)
+    {
+    rapidjson::Value& categoryArray = this->Internal->GetCategoryArrayInTerminology(terminologyName);
+    if (categoryArray.IsNull())
+      {
+      vtkErrorMacro("FindCategoriesInTerminology: Failed to find category array in terminology '" << terminologyName << "'");
+      return false;
+      }
+    categoryIndex = &this->Internal->GetCodeArrayIndex(this->Internal->TerminologyIndices, terminologyName, "", categoryArray);
+    }
+  if (categoryIndex->Missing)
     {
     vtkErrorMacro("FindCategoriesInTerminology: Failed to find category array in terminology '" << terminologyName << "'");
     return false;
     }
+  for (std::vector<std::string>::iterator invalidIt = categoryIndex->InvalidCodeMeanings.begin();
+    invalidIt != categoryIndex->InvalidCodeMeanings.end(); ++invalidIt)
+    {
+    vtkErrorMacro("FindCategoriesInTerminology: Invalid category '" << (*invalidIt) << "' in terminology '" << terminologyName << "'");
+    }
 
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse categories
-  rapidjson::SizeType index = 0;
-  while (index < categoryArray.Size())
-    {
-    rapidjson::Value& category = categoryArray[index];
-    if (category.IsObject())
-      {
-      rapidjson::Value& categoryName = category["CodeMeaning"];
-      rapidjson::Value& categoryCodingSchemeDesignator = category["CodingSchemeDesignator"];
-      rapidjson::Value& categoryCodeValue = category["CodeValue"];
-      if (categoryName.IsString() && categoryCodingSchemeDesignator.IsString() && categoryCodeValue.IsString())
-        {
-        // Add category to list if search string is empty or is contained by the current category name
-        std::string categoryNameStr = categoryName.GetString();
-        std::string categoryNameLowerCase(categoryNameStr);
-        std::transform(categoryNameLowerCase.begin(), categoryNameLowerCase.end(), categoryNameLowerCase.begin(), ::tolower);
-        if (search.empty() || categoryNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier categoryId(categoryCodingSchemeDesignator.GetString(), categoryCodeValue.GetString(), categoryNameStr);
-          categories.push_back(categoryId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindCategoriesInTerminology: Invalid category '" << categoryName.GetString() << "' in terminology '" << terminologyName << "'");
-        }
-      }
-    ++index;
-    }
+  // Collect categories containing the search string from the index of the category array
+  vtkInternal::FindCodesInIndex(*categoryIndex, search, categories);
 
   return true;
 }
@@ -1489,47 +2108,38 @@ bool vtkSlicerTerminologiesModuleLogic::FindTypesInTerminologyCategory(
 {
   types.clear();
 
-  rapidjson::Value& typeArray = this->Internal->GetTypeArrayInTerminologyCategory(terminologyName, categoryId);
-  if (typeArray.IsNull())
+  std::string typeArrayPath = vtkInternal::GetCodeArrayPath(categoryId);
+  vtkInternal::CodeArrayIndex* typeIndex = this->Internal->FindCodeArrayIndex(
+    this->Internal->TerminologyIndices, terminologyName, typeArrayPath);
+  if (!typeIndex)
+    {
+    rapidjson::Value& typeArray = this->Internal->GetTypeArrayInTerminologyCategory(terminologyName, categoryId);
+    if (typeArray.IsNull())
+      {
+      vtkErrorMacro("FindTypesInTerminologyCategory: Failed to find type array in category '"
+        << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
+      return false;
+      }
+    typeIndex = &this->Internal->GetCodeArrayIndex(this->Internal->TerminologyIndices, terminologyName, typeArrayPath, typeArray);
+    }
+  if (typeIndex->Missing)
     {
     vtkErrorMacro("FindTypesInTerminologyCategory: Failed to find type array in category '"
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
     return false;
     }
+  for (std::vector<std::string>::iterator invalidIt = typeIndex->InvalidCodeMeanings.begin();
+    invalidIt != typeIndex->InvalidCodeMeanings.end(); ++invalidIt)
+    {
+    vtkErrorMacro("FindTypesInTerminologyCategory: Invalid type '" << (*invalidIt) << "in category '"
+      << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
+    }
 
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse types
-  rapidjson::SizeType index = 0;
-  while (index < typeArray.Size())
-    {
-    rapidjson::Value& type = typeArray[index];
-    if (type.IsObject())
-      {
-      rapidjson::Value& typeName = type["CodeMeaning"];
-      rapidjson::Value& typeCodingSchemeDesignator = type["CodingSchemeDesignator"];
-      rapidjson::Value& typeCodeValue = type["CodeValue"];
-      if (typeName.IsString() && typeCodingSchemeDesignator.IsString() && typeCodeValue.IsString())
-        {
-        // Add type to list if search string is empty or is contained by the current type name
-        std::string typeNameStr = typeName.GetString();
-        std::string typeNameLowerCase(typeNameStr);
-        std::transform(typeNameLowerCase.begin(), typeNameLowerCase.end(), typeNameLowerCase.begin(), ::tolower);
-        if (search.empty() || typeNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier typeId(typeCodingSchemeDesignator.GetString(), typeCodeValue.GetString(), typeNameStr);
-          types.push_back(typeId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindTypesInTerminologyCategory: Invalid type '" << typeName.GetString() << "in category '"
-          << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
-        }
-      }
-    ++index;
-    }
+  // Collect types containing the search string from the index of the type array
+  vtkInternal::FindCodesInIndex(*typeIndex, search, types);
 
   return true;
 }
@@ -1561,8 +2171,22 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifiersInTerminologyType(
 {
   typeModifiers.clear();
 
-  rapidjson::Value& typeModifierArray = this->Internal->GetTypeModifierArrayInTerminologyType(terminologyName, categoryId, typeId);
-  if (typeModifierArray.IsNull())
+  std::string typeModifierArrayPath = vtkInternal::GetCodeArrayPath(categoryId, typeId);
+  vtkInternal::CodeArrayIndex* typeModifierIndex = this->Internal->FindCodeArrayIndex(
+    this->Internal->TerminologyIndices, terminologyName, typeModifierArrayPath);
+  if (!typeModifierIndex)
+    {
+    rapidjson::Value& typeModifierArray = this->Internal->GetTypeModifierArrayInTerminologyType(terminologyName, categoryId, typeId);
+    if (typeModifierArray.IsNull())
+      {
+      vtkErrorMacro("GetTypeModifiersInTerminologyType: Failed to find type modifier array member in type '" << typeId.CodeMeaning << "' in category "
+        << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
+      return false;
+      }
+    typeModifierIndex = &this->Internal->GetCodeArrayIndex(
+      this->Internal->TerminologyIndices, terminologyName, typeModifierArrayPath, typeModifierArray);
+    }
+  if (typeModifierIndex->Missing)
     {
     vtkErrorMacro("GetTypeModifiersInTerminologyType: Failed to find type modifier array member in type '" << typeId.CodeMeaning << "' in category "
       << categoryId.CodeMeaning << "' in terminology '" << terminologyName << "'");
@@ -1570,24 +2194,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetTypeModifiersInTerminologyType(
     }
 
   // Collect type modifiers
-  rapidjson::SizeType index = 0;
-  while (index < typeModifierArray.Size())
-    {
-    rapidjson::Value& typeModifier = typeModifierArray[index];
-    if (typeModifier.IsObject())
-      {
-      rapidjson::Value& typeModifierName = typeModifier["CodeMeaning"];
-      rapidjson::Value& typeModifierCodingSchemeDesignator = typeModifier["CodingSchemeDesignator"];
-      rapidjson::Value& typeModifierCodeValue = typeModifier["CodeValue"];
-      if (typeModifierName.IsString() && typeModifierCodingSchemeDesignator.IsString() && typeModifierCodeValue.IsString())
-        {
-        CodeIdentifier typeModifierId(typeModifierCodingSchemeDesignator.GetString(),
-          typeModifierCodeValue.GetString(), typeModifierName.GetString());
-        typeModifiers.push_back(typeModifierId);
-        }
-      }
-    ++index;
-    } // For each type modifier index
+  vtkInternal::FindCodesInIndex(*typeModifierIndex, "", typeModifiers);
 
   return true;
 }
@@ -1624,46 +2231,35 @@ bool vtkSlicerTerminologiesModuleLogic::FindRegionsInAnatomicContext(std::string
 {
   regions.clear();
 
-  rapidjson::Value& regionArray = this->Internal->GetRegionArrayInAnatomicContext(anatomicContextName);
-  if (regionArray.IsNull())
+  vtkInternal::CodeArrayIndex* regionIndex = this->Internal->FindCodeArrayIndex(
+    this->Internal->AnatomicContextIndices, anatomicContextName, "");
+  if (!regionIndex)
+    {
+    rapidjson::Value& regionArray = this->Internal->GetRegionArrayInAnatomicContext(anatomicContextName);
+    if (regionArray.IsNull())
+      {
+      vtkErrorMacro("FindRegionsInAnatomicContext: Failed to find region array member in anatomic context '" << anatomicContextName << "'");
+      return false;
+      }
+    regionIndex = &this->Internal->GetCodeArrayIndex(this->Internal->AnatomicContextIndices, anatomicContextName, "", regionArray);
+    }
+  if (regionIndex->Missing)
     {
     vtkErrorMacro("FindRegionsInAnatomicContext: Failed to find region array member in anatomic context '" << anatomicContextName << "'");
     return false;
     }
+  for (std::vector<std::string>::iterator invalidIt = regionIndex->InvalidCodeMeanings.begin();
+    invalidIt != regionIndex->InvalidCodeMeanings.end(); ++invalidIt)
+    {
+    vtkErrorMacro("FindRegionsInAnatomicContext: Invalid region '" << (*invalidIt)
+      << "' in anatomic context '" << anatomicContextName << "'");
+    }
 
   // Make lowercase for case-insensitive comparison
   std::transform(search.begin(), search.end(), search.begin(), ::tolower);
 
-  // Traverse regions
-  rapidjson::SizeType index = 0;
-  while (index<regionArray.Size())
-    {
-    rapidjson::Value& region = regionArray[index];
-    if (region.IsObject())
-      {
-      rapidjson::Value& regionName = region["CodeMeaning"];
-      rapidjson::Value& regionCodingSchemeDesignator = region["CodingSchemeDesignator"];
-      rapidjson::Value& regionCodeValue = region["CodeValue"];
-      if (regionName.IsString() && regionCodingSchemeDesignator.IsString() && regionCodeValue.IsString())
-        {
-        // Add region name to list if search string is empty or is contained by the current region name
-        std::string regionNameStr = regionName.GetString();
-        std::string regionNameLowerCase(regionNameStr);
-        std::transform(regionNameLowerCase.begin(), regionNameLowerCase.end(), regionNameLowerCase.begin(), ::tolower);
-        if (search.empty() || regionNameLowerCase.find(search) != std::string::npos)
-          {
-          CodeIdentifier regionId(regionCodingSchemeDesignator.GetString(), regionCodeValue.GetString(), regionNameStr);
-          regions.push_back(regionId);
-          }
-        }
-      else
-        {
-        vtkErrorMacro("FindRegionsInAnatomicContext: Invalid region '" << regionName.GetString()
-          << "' in anatomic context '" << anatomicContextName << "'");
-        }
-      }
-    ++index;
-    }
+  // Collect regions containing the search string from the index of the region array
+  vtkInternal::FindCodesInIndex(*regionIndex, search, regions);
 
   return true;
 }
@@ -1693,8 +2289,22 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifiersInAnatomicRegion(
 {
   regionModifiers.clear();
 
-  rapidjson::Value& regionModifierArray = this->Internal->GetRegionModifierArrayInRegion(anatomicContextName, regionId);
-  if (regionModifierArray.IsNull())
+  std::string regionModifierArrayPath = vtkInternal::GetCodeArrayPath(regionId);
+  vtkInternal::CodeArrayIndex* regionModifierIndex = this->Internal->FindCodeArrayIndex(
+    this->Internal->AnatomicContextIndices, anatomicContextName, regionModifierArrayPath);
+  if (!regionModifierIndex)
+    {
+    rapidjson::Value& regionModifierArray = this->Internal->GetRegionModifierArrayInRegion(anatomicContextName, regionId);
+    if (regionModifierArray.IsNull())
+      {
+      vtkErrorMacro("GetRegionModifiersInRegion: Failed to find Region Modifier array member in region '"
+        << regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
+      return false;
+      }
+    regionModifierIndex = &this->Internal->GetCodeArrayIndex(
+      this->Internal->AnatomicContextIndices, anatomicContextName, regionModifierArrayPath, regionModifierArray);
+    }
+  if (regionModifierIndex->Missing)
     {
     vtkErrorMacro("GetRegionModifiersInRegion: Failed to find Region Modifier array member in region '"
       << regionId.CodeMeaning << "' in anatomic context '" << anatomicContextName << "'");
@@ -1702,24 +2312,7 @@ bool vtkSlicerTerminologiesModuleLogic::GetRegionModifiersInAnatomicRegion(
     }
 
   // Collect region modifiers
-  rapidjson::SizeType index = 0;
-  while (index<regionModifierArray.Size())
-    {
-    rapidjson::Value& regionModifier = regionModifierArray[index];
-    if (regionModifier.IsObject())
-      {
-      rapidjson::Value& regionModifierName = regionModifier["CodeMeaning"];
-      rapidjson::Value& regionModifierCodingSchemeDesignator = regionModifier["CodingSchemeDesignator"];
-      rapidjson::Value& regionModifierCodeValue = regionModifier["CodeValue"];
-      if (regionModifierName.IsString() && regionModifierCodingSchemeDesignator.IsString() && regionModifierCodeValue.IsString())
-        {
-        CodeIdentifier regionModifierId(regionModifierCodingSchemeDesignator.GetString(),
-          regionModifierCodeValue.GetString(), regionModifierName.GetString());
-          regionModifiers.push_back(regionModifierId);
-        }
-      }
-    ++index;
-    } // For each region index
+  vtkInternal::FindCodesInIndex(*regionModifierIndex, "", regionModifiers);
 
   return true;
 }
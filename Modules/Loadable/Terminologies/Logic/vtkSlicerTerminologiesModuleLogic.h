@@ -203,6 +203,14 @@ public:
   vtkGetStringMacro(UserContextsPath);
   vtkSetStringMacro(UserContextsPath);
 
+  /// Directory in which the code indices of the loaded context files are cached.
+  /// A context file with an up-to-date index in the cache is only parsed when a code object is accessed,
+  /// category, type, region and modifier lists and searches are served from the index. Categories, types
+  /// and regions without a type or modifier array are indexed as such, so listing their missing array fails
+  /// without parsing the file. No caching if NULL.
+  vtkGetStringMacro(IndexCachePath);
+  vtkSetStringMacro(IndexCachePath);
+
 protected:
   vtkSlicerTerminologiesModuleLogic();
   virtual ~vtkSlicerTerminologiesModuleLogic();
@@ -219,6 +227,8 @@ protected:
 protected:
   /// The path from which the json files are automatically loaded on startup
   char* UserContextsPath;
+  /// The path in which the code indices of the loaded context files are cached
+  char* IndexCachePath;
 
 private:
   vtkSlicerTerminologiesModuleLogic(const vtkSlicerTerminologiesModuleLogic&); // Not implemented
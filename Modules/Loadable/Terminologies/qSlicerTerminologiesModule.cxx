@@ -137,6 +137,9 @@ vtkMRMLAbstractLogic* qSlicerTerminologiesModule::createLogic()
   // Setup logic
   vtkSlicerTerminologiesModuleLogic* logic = vtkSlicerTerminologiesModuleLogic::New();
   logic->SetUserContextsPath(settingsDirPath.toLatin1().constData());
+  // Cached code indices of the loaded context files, kept next to (not in) the user contexts folder
+  // so that they are not picked up as contexts
+  logic->SetIndexCachePath(settingsDir.absoluteFilePath("TerminologiesIndexCache").toLatin1().constData());
 
   return logic;
 }
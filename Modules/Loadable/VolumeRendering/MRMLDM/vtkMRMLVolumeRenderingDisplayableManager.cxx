@@ -21,6 +21,7 @@
 // Slicer includes
 #include "vtkImageGradientMagnitude.h"
 #include "vtkMRMLVolumeRenderingDisplayableManager.h"
+#include "vtkSlicerVolumeRenderingBrickPyramid.h"
 #include "vtkSlicerVolumeRenderingLogic.h"
 
 #include "vtkMRMLCPURayCastVolumeRenderingDisplayNode.h"
@@ -54,6 +55,7 @@
 #include "vtkObjectFactory.h"
 #include "vtkPlane.h"
 #include "vtkPlanes.h"
+#include "vtkPiecewiseFunction.h"
 #include "vtkPointData.h"
 #include "vtkPoints.h"
 #include "vtkRenderWindow.h"
@@ -79,8 +81,12 @@ int vtkMRMLVolumeRenderingDisplayableManager::DefaultGPUMemorySize = 256;
 vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManager()
 {
   this->MapperRaycast = NULL;
+  this->MapperRaycastInteractive = NULL;
   this->MapperGPURaycast3 = NULL;
   this->Volume = NULL;
+  this->Pyramid = vtkSlicerVolumeRenderingBrickPyramid::New();
+  this->InteractiveLevel = 0;
+  this->InteractiveRendering = false;
   //this->Histograms = vtkKWHistogramSet::New();
   //this->HistogramsFg = vtkKWHistogramSet::New();
   //this->VolumePropertyGPURaycast3 = NULL;
@@ -135,8 +141,14 @@ vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableMana
 
   //delete instances
   vtkSetMRMLNodeMacro(this->MapperRaycast, NULL);
+  vtkSetMRMLNodeMacro(this->MapperRaycastInteractive, NULL);
   vtkSetMRMLNodeMacro(this->MapperGPURaycast3, NULL);
   vtkSetMRMLNodeMacro(this->Volume, NULL);
+  if (this->Pyramid)
+    {
+    this->Pyramid->Delete();
+    this->Pyramid = NULL;
+    }
   /**
   if(this->Histograms != NULL)
   {
@@ -203,6 +215,13 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
                                       newMapperRaycast.GetPointer(),
                                       mapperEventsWithProgress.GetPointer());
 
+  // CPU mapper rendering a downsampled volume during interaction
+  vtkNew<vtkFixedPointVolumeRayCastMapper> newMapperRaycastInteractive;
+  vtkSetAndObserveMRMLNodeEventsMacro(this->MapperRaycastInteractive,
+                                      newMapperRaycastInteractive.GetPointer(),
+                                      mapperEvents.GetPointer());
+  this->InteractiveLevel = 0;
+
   // GPU raycast 3
   vtkNew<vtkGPUVolumeRayCastMapper> newMapperGPURaycast3;
   vtkSetAndObserveMRMLNodeEventsMacro(this->MapperGPURaycast3,
@@ -213,6 +232,11 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
   vtkNew<vtkVolume> newVolume;
   vtkSetMRMLNodeMacro(this->Volume, newVolume.GetPointer());
 
+  if (this->Pyramid)
+    {
+    this->Pyramid->SetInputConnection(NULL);
+    }
+
   /**
   if(this->Histograms != NULL)
   {
@@ -377,6 +401,7 @@ void vtkMRMLVolumeRenderingDisplayableManager
   vtkMRMLVolumeRenderingDisplayNode* vspNode)
 {
   this->UpdateClipping(mapper, vspNode);
+  this->UpdateEmptySpaceCropping(mapper, vspNode);
 }
 
 //---------------------------------------------------------------------------
@@ -518,6 +543,15 @@ void vtkMRMLVolumeRenderingDisplayableManager
     volumeMapper->SetInputConnection(
       index, volumeNode ? volumeNode->GetImageDataConnection() : 0);
     }
+  if (volumeMapper == this->MapperRaycast && index == 0)
+    {
+    this->Pyramid->SetInputConnection(
+      volumeNode ? volumeNode->GetImageDataConnection() : 0);
+    this->MapperRaycastInteractive->SetInputConnection(
+      this->Pyramid->GetLevelOutputPort(std::max(this->InteractiveLevel, 1)));
+    // Levels are computed by the interactive mapper when it first renders,
+    // volumes that are never interacted with don't pay for them.
+    }
 }
 
 /*
@@ -543,6 +577,12 @@ int vtkMRMLVolumeRenderingDisplayableManager
        this->UpdateMapper(vspNode))
     {
     volumeMapper = this->GetVolumeMapper(vspNode);
+    if (this->InteractiveRendering &&
+        this->InteractiveLevel > 0 &&
+        volumeMapper == this->MapperRaycast)
+      {
+      volumeMapper = this->MapperRaycastInteractive;
+      }
     volumeProperty = vspNode->GetVolumePropertyNode() ?
       vspNode->GetVolumePropertyNode()->GetVolumeProperty() : 0;
     }
@@ -568,6 +608,17 @@ bool vtkMRMLVolumeRenderingDisplayableManager::UpdateMapper(
     {
     this->UpdateCPURaycastMapper(vtkFixedPointVolumeRayCastMapper::SafeDownCast(volumeMapper),
                                  vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode));
+    if (this->InteractiveLevel > 0)
+      {
+      this->UpdateCPURaycastMapper(this->MapperRaycastInteractive,
+                                   vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode));
+      // Voxels of the coarse level are 2^level larger
+      const double levelScale = static_cast<double>(1 << this->InteractiveLevel);
+      this->MapperRaycastInteractive->SetSampleDistance(
+        levelScale * this->MapperRaycastInteractive->GetSampleDistance());
+      this->MapperRaycastInteractive->SetInteractiveSampleDistance(
+        levelScale * this->MapperRaycastInteractive->GetInteractiveSampleDistance());
+      }
     }
   else if (vspNode->IsA("vtkMRMLGPURayCastVolumeRenderingDisplayNode"))
     {
@@ -642,6 +693,106 @@ void vtkMRMLVolumeRenderingDisplayableManager::UpdateClipping(
   volumeMapper->SetClippingPlanes(planes.GetPointer());
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::UpdateEmptySpaceCropping(
+  vtkVolumeMapper* volumeMapper,
+  vtkMRMLVolumeRenderingDisplayNode* vspNode)
+{
+  // The bricks describe the input of the CPU mappers only, other mappers
+  // are never cropped.
+  if (!volumeMapper ||
+      (volumeMapper != this->MapperRaycast && volumeMapper != this->MapperRaycastInteractive))
+    {
+    return;
+    }
+  vtkMRMLCPURayCastVolumeRenderingDisplayNode* cpuNode =
+    vtkMRMLCPURayCastVolumeRenderingDisplayNode::SafeDownCast(vspNode);
+  vtkMRMLVolumeNode* volumeNode = cpuNode ? cpuNode->GetVolumeNode() : 0;
+  vtkVolumeProperty* volumeProperty = (cpuNode && cpuNode->GetVolumePropertyNode()) ?
+    cpuNode->GetVolumePropertyNode()->GetVolumeProperty() : 0;
+  double visibleRange[2] = {0., 0.};
+  int visibleExtent[6] = {0, -1, 0, -1, 0, -1};
+  // MIP and MinIP must see all the voxels.
+  bool crop = volumeProperty != 0
+    && volumeNode != 0
+    && this->Pyramid->GetInputConnection() == volumeNode->GetImageDataConnection()
+    && cpuNode->GetRaycastTechnique() == vtkMRMLCPURayCastVolumeRenderingDisplayNode::Composite
+    && vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(
+         volumeProperty->GetScalarOpacity(0), visibleRange)
+    && this->Pyramid->GetVisibleExtent(visibleRange, visibleExtent);
+
+  vtkImageData* imageData = volumeNode ? volumeNode->GetImageData() : 0;
+  if (crop && imageData)
+    {
+    int wholeExtent[6];
+    imageData->GetExtent(wholeExtent);
+    crop = !std::equal(visibleExtent, visibleExtent + 6, wholeExtent);
+    }
+  if (!crop)
+    {
+    volumeMapper->CroppingOff();
+    return;
+    }
+
+  // Image data of volume nodes has unit spacing and zero origin: the cropping
+  // planes (in data coordinates) are the IJK voxel boundaries, and they stay
+  // valid for the downsampled levels of the pyramid.
+  double planes[6];
+  for (int i = 0; i < 6; i += 2)
+    {
+    planes[i] = visibleExtent[i] - 0.5;
+    planes[i + 1] = visibleExtent[i + 1] + 0.5;
+    }
+  volumeMapper->SetCroppingRegionPlanes(planes);
+  volumeMapper->SetCroppingRegionFlagsToSubVolume();
+  volumeMapper->CroppingOn();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::UpdateInteractiveLevel(
+  vtkMRMLVolumeRenderingDisplayNode* vspNode)
+{
+  int level = this->InteractiveLevel;
+  const double framerate = vspNode ? this->GetFramerate(vspNode) : 0.;
+  if (framerate <= 0. ||
+      this->GetVolumeMapper(vspNode) != this->MapperRaycast)
+    {
+    // Maximum quality or GPU rendering: no downsampling.
+    level = 0;
+    }
+  else
+    {
+    const double targetTime = 1. / framerate;
+    double lastTime = level == 0 ?
+      this->MapperRaycast->GetTimeToDraw() :
+      this->MapperRaycastInteractive->GetTimeToDraw();
+    if (lastTime > 0.)
+      {
+      // Each level divides the number of voxels by 8, but the number of
+      // rays is unchanged: assume rendering time is halved.
+      while (lastTime > targetTime && level < this->Pyramid->GetMaximumLevel())
+        {
+        lastTime /= 2.;
+        ++level;
+        }
+      if (level > 0 && lastTime * 2. < 0.8 * targetTime)
+        {
+        --level;
+        }
+      }
+    }
+  if (level == this->InteractiveLevel)
+    {
+    return;
+    }
+  this->InteractiveLevel = level;
+  if (level > 0)
+    {
+    this->MapperRaycastInteractive->SetInputConnection(
+      this->Pyramid->GetLevelOutputPort(level));
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeRenderingDisplayableManager::TransformModified(vtkMRMLVolumeRenderingDisplayNode* vspNode)
 {
@@ -1006,9 +1157,12 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorStyleEvent(int eventi
     {
     case vtkCommand::EndInteractionEvent:
       //this->SetExpectedFPS(0.0001);
+      this->InteractiveRendering = false;
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       break;
     case vtkCommand::StartInteractionEvent:
+      this->InteractiveRendering = true;
+      this->UpdateInteractiveLevel(this->DisplayedNode);
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       //this->SetExpectedFPS(
       //  this->DisplayedNode ? this->DisplayedNode->GetExpectedFPS() : 15);
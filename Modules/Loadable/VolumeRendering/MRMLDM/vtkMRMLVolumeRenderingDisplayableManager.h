@@ -30,6 +30,7 @@ class vtkMRMLGPURayCastVolumeRenderingDisplayNode;
 class vtkMRMLVolumeNode;
 class vtkMRMLVolumeRenderingDisplayNode;
 class vtkMRMLVolumeRenderingScenarioNode;
+class vtkSlicerVolumeRenderingBrickPyramid;
 class vtkSlicerVolumeRenderingLogic;
 class vtkVolumeProperty;
 
@@ -102,6 +103,15 @@ public:
   void UpdateDesiredUpdateRate(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   void UpdateClipping(vtkVolumeMapper* mapper, vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
+  /// Restrict the mapper to the bounding box of the bricks that contain
+  /// visible (non fully transparent) voxels. Only composite rendering of
+  /// single component volumes by the CPU ray cast mappers is cropped.
+  void UpdateEmptySpaceCropping(vtkVolumeMapper* mapper, vtkMRMLVolumeRenderingDisplayNode* vspNode);
+
+  /// Choose the resolution level used during interaction from the time
+  /// spent rendering the previous frame and the expected framerate.
+  void UpdateInteractiveLevel(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+
   //void CreateVolumePropertyGPURaycast3(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   //void UpdateVolumePropertyGPURaycast3(vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
@@ -168,6 +178,24 @@ protected:
   // The software accelerated software mapper
   vtkFixedPointVolumeRayCastMapper *MapperRaycast;
 
+  // Description:
+  // The software mapper used during interaction, rendering a
+  // downsampled level of the volume
+  vtkFixedPointVolumeRayCastMapper *MapperRaycastInteractive;
+
+  // Description:
+  // Downsampled levels and brick ranges of the displayed volume
+  vtkSlicerVolumeRenderingBrickPyramid *Pyramid;
+
+  // Description:
+  // Level of the pyramid rendered during interaction (0 is full resolution)
+  int InteractiveLevel;
+
+  // Description:
+  // True between StartInteractionEvent and EndInteractionEvent of the
+  // interactor style.
+  bool InteractiveRendering;
+
   // Description:
   // The gpu ray cast mapper.
   vtkGPUVolumeRayCastMapper *MapperGPURaycast3;
@@ -0,0 +1,364 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRendering includes
+#include "vtkSlicerVolumeRenderingBrickPyramid.h"
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkImageShrink3D.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+const int MAXIMUM_NUMBER_OF_LEVELS = 8;
+
+//----------------------------------------------------------------------------
+template <class T>
+void ComputeBrickRanges(vtkImageData* image, T* scalars, int brickSize,
+                        const int brickDimensions[3],
+                        std::vector<double>& minima, std::vector<double>& maxima)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    int brickK = (k - extent[4]) / brickSize;
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      int brickJ = (j - extent[2]) / brickSize;
+      T* row = scalars + (k - extent[4]) * increments[2] + (j - extent[2]) * increments[1];
+      vtkIdType brickRowIndex = (static_cast<vtkIdType>(brickK) * brickDimensions[1] + brickJ) * brickDimensions[0];
+      int rowLength = extent[1] - extent[0] + 1;
+      for (int i = 0; i < rowLength; i += brickSize)
+        {
+        int runLength = std::min(brickSize, rowLength - i);
+        T* voxel = row + i * numberOfComponents;
+        T runMin = *voxel;
+        T runMax = *voxel;
+        for (int n = 1; n < runLength; ++n)
+          {
+          voxel += numberOfComponents;
+          runMin = std::min(runMin, *voxel);
+          runMax = std::max(runMax, *voxel);
+          }
+        vtkIdType brickIndex = brickRowIndex + i / brickSize;
+        minima[brickIndex] = std::min(minima[brickIndex], static_cast<double>(runMin));
+        maxima[brickIndex] = std::max(maxima[brickIndex], static_cast<double>(runMax));
+        }
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkCenteredImageShrink3D : public vtkImageShrink3D
+{
+public:
+  static vtkCenteredImageShrink3D* New();
+  vtkTypeMacro(vtkCenteredImageShrink3D, vtkImageShrink3D);
+
+protected:
+  vtkCenteredImageShrink3D() {};
+  ~vtkCenteredImageShrink3D() {};
+
+  // vtkImageShrink3D keeps the origin of the input: move it to the center of
+  // the input voxels averaged into the first output voxel so that the output
+  // covers the same physical region as the input.
+  int RequestInformation(vtkInformation* request,
+                         vtkInformationVector** inputVector,
+                         vtkInformationVector* outputVector) VTK_OVERRIDE
+    {
+    if (!this->Superclass::RequestInformation(request, inputVector, outputVector))
+      {
+      return 0;
+      }
+    vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+    vtkInformation* outInfo = outputVector->GetInformationObject(0);
+    double inSpacing[3] = {1., 1., 1.};
+    double origin[3] = {0., 0., 0.};
+    inInfo->Get(vtkDataObject::SPACING(), inSpacing);
+    inInfo->Get(vtkDataObject::ORIGIN(), origin);
+    for (int i = 0; i < 3; ++i)
+      {
+      double offset = this->Shift[i];
+      if (this->Mean || this->Median || this->Minimum || this->Maximum)
+        {
+        offset += 0.5 * (this->ShrinkFactors[i] - 1);
+        }
+      origin[i] += offset * inSpacing[i];
+      }
+    outInfo->Set(vtkDataObject::ORIGIN(), origin, 3);
+    return 1;
+    }
+};
+
+vtkStandardNewMacro(vtkCenteredImageShrink3D);
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVolumeRenderingBrickPyramid);
+
+//----------------------------------------------------------------------------
+vtkSlicerVolumeRenderingBrickPyramid::vtkSlicerVolumeRenderingBrickPyramid()
+{
+  this->BrickSize = 32;
+  this->MaximumLevel = 3;
+  for (int i = 0; i < 3; ++i)
+    {
+    this->BrickDimensions[i] = 0;
+    this->BrickedExtent[2*i] = 0;
+    this->BrickedExtent[2*i+1] = -1;
+    }
+  this->BrickedImage = NULL;
+
+  for (int level = 0; level < MAXIMUM_NUMBER_OF_LEVELS; ++level)
+    {
+    vtkSmartPointer<vtkImageShrink3D> shrink = vtkSmartPointer<vtkCenteredImageShrink3D>::New();
+    shrink->SetShrinkFactors(2, 2, 2);
+    shrink->AveragingOn();
+    if (level > 0)
+      {
+      shrink->SetInputConnection(this->Levels[level - 1]->GetOutputPort());
+      }
+    this->Levels.push_back(shrink);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVolumeRenderingBrickPyramid::~vtkSlicerVolumeRenderingBrickPyramid()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeRenderingBrickPyramid::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "MaximumLevel: " << this->MaximumLevel << "\n";
+  os << indent << "BrickDimensions: " << this->BrickDimensions[0] << " "
+     << this->BrickDimensions[1] << " " << this->BrickDimensions[2] << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeRenderingBrickPyramid::SetInputConnection(vtkAlgorithmOutput* input)
+{
+  if (input == this->GetInputConnection())
+    {
+    return;
+    }
+  this->Levels[0]->SetInputConnection(input);
+  this->BrickedImage = NULL;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkSlicerVolumeRenderingBrickPyramid::GetInputConnection()
+{
+  return this->Levels[0]->GetNumberOfInputConnections(0) > 0 ?
+    this->Levels[0]->GetInputConnection(0, 0) : NULL;
+}
+
+//----------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkSlicerVolumeRenderingBrickPyramid::GetLevelOutputPort(int level)
+{
+  level = std::min(level, this->MaximumLevel);
+  if (level <= 0)
+    {
+    return this->GetInputConnection();
+    }
+  return this->Levels[level - 1]->GetOutputPort();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeRenderingBrickPyramid::UpdateLevels()
+{
+  if (!this->GetInputConnection())
+    {
+    return;
+    }
+  // Each level is the input of the next one
+  this->Levels[this->MaximumLevel - 1]->Update();
+  this->UpdateBricks();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerVolumeRenderingBrickPyramid::UpdateBricks()
+{
+  vtkAlgorithmOutput* input = this->GetInputConnection();
+  vtkImageData* image = input ? vtkImageData::SafeDownCast(
+    input->GetProducer()->GetOutputDataObject(input->GetIndex())) : NULL;
+  if (!image || !image->GetPointData()->GetScalars()
+    || image->GetNumberOfScalarComponents() != 1)
+    {
+    this->BrickedImage = NULL;
+    return NULL;
+    }
+  if (image == this->BrickedImage
+    && image->GetMTime() <= this->BricksTime.GetMTime()
+    && image->GetPointData()->GetScalars()->GetMTime() <= this->BricksTime.GetMTime())
+    {
+    return image;
+    }
+
+  image->GetExtent(this->BrickedExtent);
+  vtkIdType numberOfBricks = 1;
+  for (int i = 0; i < 3; ++i)
+    {
+    int size = this->BrickedExtent[2*i+1] - this->BrickedExtent[2*i] + 1;
+    this->BrickDimensions[i] = size > 0 ? (size - 1) / this->BrickSize + 1 : 0;
+    numberOfBricks *= this->BrickDimensions[i];
+    }
+  this->BrickMinima.assign(numberOfBricks, VTK_DOUBLE_MAX);
+  this->BrickMaxima.assign(numberOfBricks, VTK_DOUBLE_MIN);
+
+  if (numberOfBricks > 0)
+    {
+    void* scalars = image->GetScalarPointer();
+    switch (image->GetScalarType())
+      {
+      vtkTemplateMacro(ComputeBrickRanges(image, static_cast<VTK_TT*>(scalars),
+        this->BrickSize, this->BrickDimensions, this->BrickMinima, this->BrickMaxima));
+      default:
+        vtkErrorMacro("UpdateBricks: unsupported scalar type " << image->GetScalarTypeAsString());
+        this->BrickedImage = NULL;
+        return NULL;
+      }
+    }
+
+  this->BrickedImage = image;
+  this->BricksTime.Modified();
+  return image;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVolumeRenderingBrickPyramid::GetVisibleExtent(const double scalarRange[2], int extent[6])
+{
+  if (!this->UpdateBricks())
+    {
+    return false;
+    }
+
+  int brickExtent[6] = {VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN};
+  vtkIdType brickIndex = 0;
+  for (int k = 0; k < this->BrickDimensions[2]; ++k)
+    {
+    for (int j = 0; j < this->BrickDimensions[1]; ++j)
+      {
+      for (int i = 0; i < this->BrickDimensions[0]; ++i, ++brickIndex)
+        {
+        if (this->BrickMaxima[brickIndex] < scalarRange[0]
+          || this->BrickMinima[brickIndex] > scalarRange[1])
+          {
+          // fully transparent brick
+          continue;
+          }
+        brickExtent[0] = std::min(brickExtent[0], i);
+        brickExtent[1] = std::max(brickExtent[1], i);
+        brickExtent[2] = std::min(brickExtent[2], j);
+        brickExtent[3] = std::max(brickExtent[3], j);
+        brickExtent[4] = std::min(brickExtent[4], k);
+        brickExtent[5] = std::max(brickExtent[5], k);
+        }
+      }
+    }
+
+  if (brickExtent[0] > brickExtent[1])
+    {
+    // no visible brick
+    for (int i = 0; i < 3; ++i)
+      {
+      extent[2*i] = this->BrickedExtent[2*i];
+      extent[2*i+1] = this->BrickedExtent[2*i] - 1;
+      }
+    return false;
+    }
+
+  for (int i = 0; i < 3; ++i)
+    {
+    extent[2*i] = this->BrickedExtent[2*i] + brickExtent[2*i] * this->BrickSize;
+    extent[2*i+1] = std::min(this->BrickedExtent[2*i] + (brickExtent[2*i+1] + 1) * this->BrickSize - 1,
+                             this->BrickedExtent[2*i+1]);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(vtkPiecewiseFunction* scalarOpacity, double scalarRange[2])
+{
+  scalarRange[0] = VTK_DOUBLE_MAX;
+  scalarRange[1] = VTK_DOUBLE_MIN;
+  int numberOfNodes = scalarOpacity ? scalarOpacity->GetSize() : 0;
+  if (numberOfNodes == 0)
+    {
+    return false;
+    }
+
+  double node[4] = {0., 0., 0., 0.};
+  double previousNode[4] = {0., 0., 0., 0.};
+  for (int n = 0; n < numberOfNodes; ++n)
+    {
+    scalarOpacity->GetNodeValue(n, node);
+    if (node[1] > 0.)
+      {
+      scalarRange[0] = std::min(scalarRange[0], node[0]);
+      scalarRange[1] = std::max(scalarRange[1], node[0]);
+      // the segment from the previous node is partially visible
+      if (n > 0)
+        {
+        scalarRange[0] = std::min(scalarRange[0], previousNode[0]);
+        }
+      }
+    else if (n > 0 && previousNode[1] > 0.)
+      {
+      scalarRange[1] = std::max(scalarRange[1], node[0]);
+      }
+    std::copy(node, node + 4, previousNode);
+    }
+  if (scalarRange[0] > scalarRange[1])
+    {
+    return false;
+    }
+
+  // Values outside of the function range use the opacity of the first/last nodes
+  if (scalarOpacity->GetClamping())
+    {
+    scalarOpacity->GetNodeValue(0, node);
+    if (node[1] > 0.)
+      {
+      scalarRange[0] = VTK_DOUBLE_MIN;
+      }
+    scalarOpacity->GetNodeValue(numberOfNodes - 1, node);
+    if (node[1] > 0.)
+      {
+      scalarRange[1] = VTK_DOUBLE_MAX;
+      }
+    }
+  return true;
+}
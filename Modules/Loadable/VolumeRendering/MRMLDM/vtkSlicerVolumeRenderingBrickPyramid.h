@@ -0,0 +1,115 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkSlicerVolumeRenderingBrickPyramid_h
+#define __vtkSlicerVolumeRenderingBrickPyramid_h
+
+// VolumeRendering includes
+#include "vtkSlicerVolumeRenderingModuleMRMLDisplayableManagerExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+class vtkAlgorithmOutput;
+class vtkImageData;
+class vtkImageShrink3D;
+class vtkPiecewiseFunction;
+
+// STD includes
+#include <vector>
+
+/// \ingroup Slicer_QtModules_VolumeRendering
+/// \brief Multi-resolution representation of a volume used for adaptive volume rendering.
+///
+/// The pyramid provides downsampled levels of the input image: level n has
+/// 2^n times fewer voxels along each axis than the input (level 0). Levels are
+/// computed by UpdateLevels() or when their output port is updated by a mapper.
+/// Each voxel of level n is located at the center of the 2^n input voxels it
+/// averages (the origin is shifted by (2^n-1)/2 input voxels), so all levels
+/// cover the same region in the coordinate system of the input and a single
+/// volume actor matrix applies to all of them.
+///
+/// The input (if it has a single component) is also split into bricks whose scalar range is computed once per
+/// input modification. This allows quickly finding the region of the volume that
+/// is not fully transparent for a given scalar opacity transfer function.
+class VTK_SLICER_VOLUMERENDERING_MODULE_MRMLDISPLAYABLEMANAGER_EXPORT vtkSlicerVolumeRenderingBrickPyramid
+  : public vtkObject
+{
+public:
+  static vtkSlicerVolumeRenderingBrickPyramid *New();
+  vtkTypeMacro(vtkSlicerVolumeRenderingBrickPyramid, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Full resolution image (level 0)
+  void SetInputConnection(vtkAlgorithmOutput* input);
+  vtkAlgorithmOutput* GetInputConnection();
+
+  /// Number of voxels along each axis of a brick. Default is 32.
+  vtkSetClampMacro(BrickSize, int, 4, 512);
+  vtkGetMacro(BrickSize, int);
+
+  /// Coarsest available level. Default is 3 (8x fewer voxels along each axis).
+  vtkSetClampMacro(MaximumLevel, int, 1, 8);
+  vtkGetMacro(MaximumLevel, int);
+
+  /// Return the output port of the requested level.
+  /// Level 0 returns the input connection.
+  vtkAlgorithmOutput* GetLevelOutputPort(int level);
+
+  /// Compute the levels up to MaximumLevel and the brick ranges of the input
+  /// so that they are ready when they are first rendered.
+  void UpdateLevels();
+
+  /// Compute the smallest voxel extent of the input that contains all the bricks
+  /// having at least one voxel in the scalar range.
+  /// Return false if the input is not available (extent is not set) or if no
+  /// brick is visible (extent is set to an empty extent).
+  bool GetVisibleExtent(const double scalarRange[2], int extent[6]);
+
+  /// Compute the range of scalar values that are not fully transparent
+  /// according to the opacity transfer function.
+  /// Return false if all values are transparent.
+  static bool GetVisibleScalarRange(vtkPiecewiseFunction* scalarOpacity, double scalarRange[2]);
+
+protected:
+  vtkSlicerVolumeRenderingBrickPyramid();
+  ~vtkSlicerVolumeRenderingBrickPyramid();
+
+  /// Recompute the brick scalar ranges if the input image has been modified.
+  /// Return the input image or NULL if it is not available.
+  vtkImageData* UpdateBricks();
+
+  int BrickSize;
+  int MaximumLevel;
+
+  /// Filters computing levels 1 to 8, each one shrinking the previous level
+  /// and centering its voxels on the voxels they average.
+  /// The first filter holds the input connection.
+  std::vector<vtkSmartPointer<vtkImageShrink3D> > Levels;
+
+  int BrickDimensions[3];
+  int BrickedExtent[6];
+  std::vector<double> BrickMinima;
+  std::vector<double> BrickMaxima;
+  vtkTimeStamp BricksTime;
+  vtkImageData* BrickedImage;
+
+private:
+  vtkSlicerVolumeRenderingBrickPyramid(const vtkSlicerVolumeRenderingBrickPyramid&); // Not implemented.
+  void operator=(const vtkSlicerVolumeRenderingBrickPyramid&); // Not implemented.
+};
+
+#endif
@@ -0,0 +1,245 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRendering includes
+#include <vtkMRMLCPURayCastVolumeRenderingDisplayNode.h>
+#include <vtkMRMLGPURayCastVolumeRenderingDisplayNode.h>
+#include <vtkMRMLVolumePropertyNode.h>
+#include <vtkMRMLVolumeRenderingDisplayableManager.h>
+#include <vtkSlicerVolumeRenderingBrickPyramid.h>
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkTrivialProducer.h>
+#include <vtkVolumeMapper.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Zero volume with a small bright blob in the middle brick along I
+void CreateBlobImage(vtkImageData* imageData)
+{
+  imageData->SetDimensions(70, 64, 40);
+  imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxels = static_cast<unsigned char*>(imageData->GetScalarPointer());
+  std::fill(voxels, voxels + imageData->GetNumberOfPoints(), 0);
+  for (int k = 33; k <= 35; ++k)
+    {
+    for (int j = 5; j <= 10; ++j)
+      {
+      for (int i = 40; i <= 45; ++i)
+        {
+        *static_cast<unsigned char*>(imageData->GetScalarPointer(i, j, k)) = 200;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int TestPyramid()
+{
+  vtkNew<vtkImageData> imageData;
+  CreateBlobImage(imageData.GetPointer());
+  vtkNew<vtkTrivialProducer> producer;
+  producer->SetOutput(imageData.GetPointer());
+
+  vtkNew<vtkSlicerVolumeRenderingBrickPyramid> pyramid;
+  int extent[6] = {0, -1, 0, -1, 0, -1};
+  const double visibleRange[2] = {100., 255.};
+  CHECK_BOOL(pyramid->GetVisibleExtent(visibleRange, extent), false);
+
+  pyramid->SetInputConnection(producer->GetOutputPort());
+  CHECK_POINTER(pyramid->GetLevelOutputPort(0), producer->GetOutputPort());
+
+  // Levels are not computed until they are requested
+  for (int level = 1; level <= pyramid->GetMaximumLevel(); ++level)
+    {
+    vtkAlgorithmOutput* levelPort = pyramid->GetLevelOutputPort(level);
+    vtkImageData* levelImage = vtkImageData::SafeDownCast(
+      levelPort->GetProducer()->GetOutputDataObject(levelPort->GetIndex()));
+    CHECK_NOT_NULL(levelImage);
+    CHECK_INT(levelImage->GetNumberOfPoints(), 0);
+    }
+
+  pyramid->UpdateLevels();
+  const int expectedDimensions[3][2] = { {32, 20}, {16, 10}, {8, 5} };
+  for (int level = 1; level <= pyramid->GetMaximumLevel(); ++level)
+    {
+    vtkAlgorithmOutput* levelPort = pyramid->GetLevelOutputPort(level);
+    vtkImageData* levelImage = vtkImageData::SafeDownCast(
+      levelPort->GetProducer()->GetOutputDataObject(levelPort->GetIndex()));
+    CHECK_NOT_NULL(levelImage);
+    CHECK_INT(levelImage->GetDimensions()[1], expectedDimensions[level - 1][0]);
+    CHECK_INT(levelImage->GetDimensions()[2], expectedDimensions[level - 1][1]);
+    }
+
+  // Voxels of the coarsest level are centered on the voxels they average:
+  // along J and K, where the dimensions are multiples of 8, the voxel
+  // boundaries of the level are the ones of the input.
+  vtkAlgorithmOutput* coarsePort = pyramid->GetLevelOutputPort(3);
+  vtkImageData* coarseImage = vtkImageData::SafeDownCast(
+    coarsePort->GetProducer()->GetOutputDataObject(coarsePort->GetIndex()));
+  CHECK_DOUBLE(coarseImage->GetSpacing()[0], 8.);
+  CHECK_DOUBLE(coarseImage->GetOrigin()[0], 3.5);
+  double bounds[6];
+  double coarseBounds[6];
+  imageData->GetBounds(bounds);
+  coarseImage->GetBounds(coarseBounds);
+  for (int axis = 1; axis < 3; ++axis)
+    {
+    CHECK_DOUBLE(coarseBounds[2 * axis] - 0.5 * coarseImage->GetSpacing()[axis],
+                 bounds[2 * axis] - 0.5 * imageData->GetSpacing()[axis]);
+    CHECK_DOUBLE(coarseBounds[2 * axis + 1] + 0.5 * coarseImage->GetSpacing()[axis],
+                 bounds[2 * axis + 1] + 0.5 * imageData->GetSpacing()[axis]);
+    }
+  // The first 64 of the 70 voxels along I are averaged
+  CHECK_DOUBLE(coarseBounds[0] - 0.5 * coarseImage->GetSpacing()[0], -0.5);
+  CHECK_DOUBLE(coarseBounds[1] + 0.5 * coarseImage->GetSpacing()[0], 63.5);
+
+  // Only the brick containing the blob is visible
+  CHECK_BOOL(pyramid->GetVisibleExtent(visibleRange, extent), true);
+  const int expectedExtent[6] = {32, 63, 0, 31, 32, 39};
+  for (int i = 0; i < 6; ++i)
+    {
+    CHECK_INT(extent[i], expectedExtent[i]);
+    }
+
+  const double emptyRange[2] = {250., 255.};
+  CHECK_BOOL(pyramid->GetVisibleExtent(emptyRange, extent), false);
+
+  // Bricks are recomputed when the input is modified
+  *static_cast<unsigned char*>(imageData->GetScalarPointer(2, 2, 2)) = 200;
+  imageData->Modified();
+  CHECK_BOOL(pyramid->GetVisibleExtent(visibleRange, extent), true);
+  CHECK_INT(extent[0], 0);
+  CHECK_INT(extent[1], 63);
+  CHECK_INT(extent[4], 0);
+  CHECK_INT(extent[5], 39);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestVisibleScalarRange()
+{
+  vtkNew<vtkPiecewiseFunction> opacity;
+  double range[2] = {0., 0.};
+  CHECK_BOOL(vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(opacity.GetPointer(), range), false);
+
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(100., 0.);
+  opacity->AddPoint(150., 0.5);
+  opacity->AddPoint(180., 0.);
+  opacity->AddPoint(255., 0.);
+  CHECK_BOOL(vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(opacity.GetPointer(), range), true);
+  CHECK_DOUBLE(range[0], 100.);
+  CHECK_DOUBLE(range[1], 180.);
+
+  // The last node is visible and values above it use its opacity
+  opacity->AddPoint(255., 1.);
+  opacity->ClampingOn();
+  CHECK_BOOL(vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(opacity.GetPointer(), range), true);
+  CHECK_DOUBLE(range[0], 100.);
+  CHECK_DOUBLE(range[1], VTK_DOUBLE_MAX);
+
+  opacity->RemoveAllPoints();
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(255., 0.);
+  CHECK_BOOL(vtkSlicerVolumeRenderingBrickPyramid::GetVisibleScalarRange(opacity.GetPointer(), range), false);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestEmptySpaceCropping()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkImageData> imageData;
+  CreateBlobImage(imageData.GetPointer());
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+
+  vtkNew<vtkMRMLVolumePropertyNode> volumePropertyNode;
+  vtkNew<vtkPiecewiseFunction> opacity;
+  opacity->AddPoint(0., 0.);
+  opacity->AddPoint(100., 0.);
+  opacity->AddPoint(255., 1.);
+  volumePropertyNode->SetScalarOpacity(opacity.GetPointer());
+  scene->AddNode(volumePropertyNode.GetPointer());
+
+  vtkNew<vtkMRMLCPURayCastVolumeRenderingDisplayNode> cpuDisplayNode;
+  scene->AddNode(cpuDisplayNode.GetPointer());
+  cpuDisplayNode->SetAndObserveVolumeNodeID(volumeNode->GetID());
+  cpuDisplayNode->SetAndObserveVolumePropertyNodeID(volumePropertyNode->GetID());
+
+  vtkNew<vtkMRMLGPURayCastVolumeRenderingDisplayNode> gpuDisplayNode;
+  scene->AddNode(gpuDisplayNode.GetPointer());
+  gpuDisplayNode->SetAndObserveVolumeNodeID(volumeNode->GetID());
+  gpuDisplayNode->SetAndObserveVolumePropertyNodeID(volumePropertyNode->GetID());
+
+  vtkNew<vtkMRMLVolumeRenderingDisplayableManager> displayableManager;
+
+  // The CPU mapper is cropped to the visible bricks
+  displayableManager->SetupMapperFromVolumeNode(cpuDisplayNode.GetPointer());
+  vtkVolumeMapper* cpuMapper = displayableManager->GetVolumeMapper(cpuDisplayNode.GetPointer());
+  CHECK_NOT_NULL(cpuMapper);
+  displayableManager->UpdateEmptySpaceCropping(cpuMapper, cpuDisplayNode.GetPointer());
+  CHECK_INT(cpuMapper->GetCropping(), 1);
+  const double expectedPlanes[6] = {31.5, 63.5, -0.5, 31.5, 31.5, 39.5};
+  for (int i = 0; i < 6; ++i)
+    {
+    CHECK_DOUBLE(cpuMapper->GetCroppingRegionPlanes()[i], expectedPlanes[i]);
+    }
+
+  // Maximum intensity projection needs all the voxels
+  cpuDisplayNode->SetRaycastTechnique(vtkMRMLVolumeRenderingDisplayNode::MaximumIntensityProjection);
+  displayableManager->UpdateEmptySpaceCropping(cpuMapper, cpuDisplayNode.GetPointer());
+  CHECK_INT(cpuMapper->GetCropping(), 0);
+
+  // The GPU mapper is not fed by the pyramid and is never cropped
+  vtkVolumeMapper* gpuMapper = displayableManager->GetVolumeMapper(gpuDisplayNode.GetPointer());
+  CHECK_NOT_NULL(gpuMapper);
+  CHECK_POINTER_DIFFERENT(gpuMapper, cpuMapper);
+  displayableManager->UpdateEmptySpaceCropping(gpuMapper, gpuDisplayNode.GetPointer());
+  CHECK_INT(gpuMapper->GetCropping(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerVolumeRenderingBrickPyramidTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  CHECK_EXIT_SUCCESS(TestPyramid());
+  CHECK_EXIT_SUCCESS(TestVisibleScalarRange());
+  CHECK_EXIT_SUCCESS(TestEmptySpaceCropping());
+  return EXIT_SUCCESS;
+}
@@ -69,6 +69,12 @@ class DICOMPlugin(object):
   """ Base class for DICOM plugins
   """
 
+  # qSlicerDICOMHeaderScanner that contains the tag values of the examined
+  # files, read all at once by the DICOM browser before calling the plugins.
+  # Plugins should use fileValue and fileHasTag while examining files, so that
+  # the files are not opened and the database is not queried for each tag.
+  headerScanner = None
+
   def __init__(self):
     # displayed for the user as the plugin handling the load
     self.loadType = "Generic DICOM"
@@ -85,6 +91,20 @@ class DICOMPlugin(object):
     self.tags['seriesDescription'] = "0008,103E"
     self.tags['seriesNumber'] = "0020,0011"
 
+  def fileValue(self,filePath,tag):
+    """Get value of a tag of a file, using the values read by the
+    header scanner if available"""
+    if DICOMPlugin.headerScanner:
+      return DICOMPlugin.headerScanner.fileValue(filePath,tag)
+    return slicer.dicomDatabase.fileValue(filePath,tag)
+
+  def fileHasTag(self,filePath,tag):
+    """Determine whether a file contains a tag. Unlike fileValue
+    it does not require reading long values such as pixel data"""
+    if DICOMPlugin.headerScanner:
+      return DICOMPlugin.headerScanner.fileHasTag(filePath,tag)
+    return slicer.dicomDatabase.fileValue(filePath,tag) != ''
+
   def hashFiles(self,files):
     """Create a hash key for a list of files"""
     try:
@@ -152,8 +172,8 @@ class DICOMPlugin(object):
     instanceFilePaths = slicer.dicomDatabase.filesForSeries(seriesUID)
     if len(instanceFilePaths) == 0:
       return "Unnamed Series"
-    seriesDescription = slicer.dicomDatabase.fileValue(instanceFilePaths[0],self.tags['seriesDescription'])
-    seriesNumber = slicer.dicomDatabase.fileValue(instanceFilePaths[0],self.tags['seriesNumber'])
+    seriesDescription = self.fileValue(instanceFilePaths[0],self.tags['seriesDescription'])
+    seriesNumber = self.fileValue(instanceFilePaths[0],self.tags['seriesNumber'])
     name = seriesDescription
     if seriesDescription == "":
       name = "Unnamed Series"
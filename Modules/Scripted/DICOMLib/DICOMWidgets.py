@@ -1,4 +1,4 @@
-import os, copy
+import os, copy, time
 import qt
 import vtk
 import logging
@@ -706,6 +706,10 @@ class DICOMDetailsBase(VTKObservationMixin, SizePositionSettingsMixin):
 
     plugins = self.pluginSelector.selectedPlugins()
 
+    # Read the tags used by the plugins from all the files at once using multiple threads,
+    # so that plugins do not need to open the files or query the database one tag at a time
+    self.scanHeaders(fileLists)
+
     progress = slicer.util.createProgressDialog(parent=self, value=0, maximum=len(plugins))
 
     for step, pluginClass in enumerate(plugins):
@@ -733,9 +737,34 @@ class DICOMDetailsBase(VTKObservationMixin, SizePositionSettingsMixin):
         print "DICOM Plugin failed: %s" % str(e)
 
     progress.close()
+    # Scanned values are only needed while the plugins examine the files,
+    # do not keep the headers of all the selected files in memory
+    DICOMLib.DICOMPlugin.headerScanner = None
+    if hasattr(self, 'headerScanner'):
+      self.headerScanner.clear()
 
     return loadablesByPlugin, loadEnabled
 
+  def scanHeaders(self, fileLists):
+    """Read the precached tags of all files in the file lists and
+    make them available to the plugins"""
+    if not hasattr(slicer, 'qSlicerDICOMHeaderScanner'):
+      return
+    if not hasattr(self, 'headerScanner'):
+      self.headerScanner = slicer.qSlicerDICOMHeaderScanner()
+      self.headerScannerTags = None
+    tags = list(slicer.dicomDatabase.tagsToPrecache)
+    if self.headerScannerTags != tags:
+      # Setting tags removes the values scanned previously
+      self.headerScanner.tags = tags
+      self.headerScannerTags = tags
+    self.headerScanner.setDatabase(slicer.dicomDatabase)
+    files = [filePath for fileList in fileLists for filePath in fileList]
+    startTime = time.time()
+    numberOfScannedFiles = self.headerScanner.scanFiles(files)
+    logging.debug('Scanned headers of %d files in %.2f seconds' % (numberOfScannedFiles, time.time() - startTime))
+    DICOMLib.DICOMPlugin.headerScanner = self.headerScanner
+
   def isFileListInCheckedLoadables(self, fileList):
     for plugin in self.loadablesByPlugin:
       for loadable in self.loadablesByPlugin[plugin]:
@@ -0,0 +1,384 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DICOMLib includes
+#include "qSlicerDICOMHeaderScanner.h"
+
+// CTK includes
+#include <ctkDICOMDatabase.h>
+#include <ctkPimpl.h>
+
+// Qt includes
+#include <QDebug>
+#include <QHash>
+#include <QRunnable>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+
+//-----------------------------------------------------------------------------
+class qSlicerDICOMHeaderScannerPrivate
+{
+public:
+  qSlicerDICOMHeaderScannerPrivate();
+  virtual ~qSlicerDICOMHeaderScannerPrivate();
+
+  enum TagState
+    {
+    TagMissing = 0,
+    TagValueRead,
+    TagValueNotRead
+    };
+
+  /// Tag values read from one file
+  struct FileHeader
+    {
+    FileHeader() : Valid(false) { }
+    bool Valid;
+    QString SOPInstanceUID;
+    /// Values and states in the order of \sa Tags
+    QVector<QString> Values;
+    QVector<char> States;
+    };
+
+  /// Index of a tag in \sa Tags, -1 if not scanned
+  int tagIndex(const QString& tag)const;
+
+  /// Tags to read, in lowercase
+  QStringList Tags;
+  QHash<QString, int> TagIndices;
+  QVector<DcmTagKey> TagKeys;
+
+  int NumberOfThreads;
+  int MaximumValueLength;
+  ctkDICOMDatabase* Database;
+
+  /// Scanned files
+  QHash<QString, FileHeader> FileHeaders;
+};
+
+//-----------------------------------------------------------------------------
+/// Read the headers of a range of files. Each task writes a distinct range of the results.
+class qSlicerDICOMHeaderScanTask : public QRunnable
+{
+public:
+  qSlicerDICOMHeaderScanTask(const QStringList* files, int firstFileIndex, int lastFileIndex,
+    const QVector<DcmTagKey>& tagKeys, int maximumValueLength, qSlicerDICOMHeaderScannerPrivate::FileHeader* headers)
+    : Files(files)
+    , FirstFileIndex(firstFileIndex)
+    , LastFileIndex(lastFileIndex)
+    , TagKeys(tagKeys)
+    , MaximumValueLength(maximumValueLength)
+    , Headers(headers)
+  {
+  }
+
+  virtual void run()
+  {
+    for (int fileIndex = this->FirstFileIndex; fileIndex < this->LastFileIndex; ++fileIndex)
+      {
+      this->readHeader(this->Files->at(fileIndex), this->Headers[fileIndex]);
+      }
+  }
+
+protected:
+  void readHeader(const QString& fileName, qSlicerDICOMHeaderScannerPrivate::FileHeader& header)
+  {
+    // Elements longer than the maximum value length (such as pixel data) are not loaded into memory
+    DcmFileFormat fileFormat;
+    OFCondition status = fileFormat.loadFile(fileName.toLocal8Bit().constData(),
+      EXS_Unknown, EGL_noChange, static_cast<Uint32>(this->MaximumValueLength));
+    if (status.bad())
+      {
+      return;
+      }
+    DcmDataset* dataset = fileFormat.getDataset();
+    if (!dataset)
+      {
+      return;
+      }
+
+    OFString sopInstanceUID;
+    if (dataset->findAndGetOFString(DCM_SOPInstanceUID, sopInstanceUID).good())
+      {
+      header.SOPInstanceUID = QString(sopInstanceUID.c_str());
+      }
+
+    int numberOfTags = this->TagKeys.size();
+    header.Values.resize(numberOfTags);
+    header.States.fill(qSlicerDICOMHeaderScannerPrivate::TagMissing, numberOfTags);
+    for (int tagIndex = 0; tagIndex < numberOfTags; ++tagIndex)
+      {
+      DcmElement* element = NULL;
+      if (dataset->findAndGetElement(this->TagKeys[tagIndex], element).bad() || !element)
+        {
+        continue;
+        }
+      if (!element->isLeaf() || element->getLength() > static_cast<Uint32>(this->MaximumValueLength))
+        {
+        header.States[tagIndex] = qSlicerDICOMHeaderScannerPrivate::TagValueNotRead;
+        continue;
+        }
+      OFString value;
+      if (element->getOFStringArray(value).good())
+        {
+        header.Values[tagIndex] = QString(value.c_str());
+        }
+      header.States[tagIndex] = qSlicerDICOMHeaderScannerPrivate::TagValueRead;
+      }
+    header.Valid = true;
+  }
+
+  const QStringList* Files;
+  int FirstFileIndex;
+  int LastFileIndex;
+  QVector<DcmTagKey> TagKeys;
+  int MaximumValueLength;
+  qSlicerDICOMHeaderScannerPrivate::FileHeader* Headers;
+};
+
+//-----------------------------------------------------------------------------
+// qSlicerDICOMHeaderScannerPrivate methods
+
+//-----------------------------------------------------------------------------
+qSlicerDICOMHeaderScannerPrivate::qSlicerDICOMHeaderScannerPrivate()
+{
+  this->NumberOfThreads = qMax(1, QThread::idealThreadCount());
+  this->MaximumValueLength = 1024;
+  this->Database = 0;
+}
+
+//-----------------------------------------------------------------------------
+qSlicerDICOMHeaderScannerPrivate::~qSlicerDICOMHeaderScannerPrivate()
+{
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerDICOMHeaderScannerPrivate::tagIndex(const QString& tag)const
+{
+  return this->TagIndices.value(tag.toLower(), -1);
+}
+
+//-----------------------------------------------------------------------------
+// qSlicerDICOMHeaderScanner methods
+
+//-----------------------------------------------------------------------------
+qSlicerDICOMHeaderScanner::qSlicerDICOMHeaderScanner(QObject* parentObject)
+  : Superclass(parentObject)
+  , d_ptr(new qSlicerDICOMHeaderScannerPrivate)
+{
+}
+
+//-----------------------------------------------------------------------------
+qSlicerDICOMHeaderScanner::~qSlicerDICOMHeaderScanner()
+{
+}
+
+//-----------------------------------------------------------------------------
+CTK_GET_CPP(qSlicerDICOMHeaderScanner, QStringList, tags, Tags)
+CTK_GET_CPP(qSlicerDICOMHeaderScanner, int, numberOfThreads, NumberOfThreads)
+CTK_GET_CPP(qSlicerDICOMHeaderScanner, int, maximumValueLength, MaximumValueLength)
+CTK_GET_CPP(qSlicerDICOMHeaderScanner, ctkDICOMDatabase*, database, Database)
+CTK_SET_CPP(qSlicerDICOMHeaderScanner, ctkDICOMDatabase*, setDatabase, Database)
+
+//-----------------------------------------------------------------------------
+void qSlicerDICOMHeaderScanner::setTags(const QStringList& newTags)
+{
+  Q_D(qSlicerDICOMHeaderScanner);
+  d->Tags.clear();
+  d->TagIndices.clear();
+  d->TagKeys.clear();
+  d->FileHeaders.clear();
+  foreach (const QString& tag, newTags)
+    {
+    QString normalizedTag = tag.toLower();
+    if (d->TagIndices.contains(normalizedTag))
+      {
+      continue;
+      }
+    QStringList groupAndElement = normalizedTag.split(',');
+    bool groupValid = false;
+    bool elementValid = false;
+    unsigned short group = 0;
+    unsigned short element = 0;
+    if (groupAndElement.size() == 2)
+      {
+      group = groupAndElement[0].trimmed().toUShort(&groupValid, 16);
+      element = groupAndElement[1].trimmed().toUShort(&elementValid, 16);
+      }
+    if (!groupValid || !elementValid)
+      {
+      qWarning() << Q_FUNC_INFO << ": Invalid DICOM tag " << tag;
+      continue;
+      }
+    d->TagIndices[normalizedTag] = d->Tags.size();
+    d->Tags << normalizedTag;
+    d->TagKeys << DcmTagKey(group, element);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDICOMHeaderScanner::setNumberOfThreads(int newNumberOfThreads)
+{
+  Q_D(qSlicerDICOMHeaderScanner);
+  d->NumberOfThreads = qMax(1, newNumberOfThreads);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDICOMHeaderScanner::setMaximumValueLength(int newMaximumValueLength)
+{
+  Q_D(qSlicerDICOMHeaderScanner);
+  if (d->MaximumValueLength == newMaximumValueLength)
+    {
+    return;
+    }
+  d->MaximumValueLength = qMax(0, newMaximumValueLength);
+  // Values were read with a different limit
+  d->FileHeaders.clear();
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerDICOMHeaderScanner::scanFiles(const QStringList& files)
+{
+  Q_D(qSlicerDICOMHeaderScanner);
+
+  // Collect files that have not been scanned yet
+  QStringList filesToScan;
+  QSet<QString> filesToScanSet;
+  foreach (const QString& fileName, files)
+    {
+    if (d->FileHeaders.contains(fileName) || filesToScanSet.contains(fileName))
+      {
+      continue;
+      }
+    filesToScan << fileName;
+    filesToScanSet.insert(fileName);
+    }
+  if (filesToScan.isEmpty())
+    {
+    return 0;
+    }
+
+  // Read headers. Split the files into more batches than threads so that
+  // threads that finish early (e.g. on smaller files) get more work.
+  QVector<qSlicerDICOMHeaderScannerPrivate::FileHeader> headers(filesToScan.size());
+  qSlicerDICOMHeaderScannerPrivate::FileHeader* headersData = headers.data();
+  QThreadPool threadPool;
+  threadPool.setMaxThreadCount(d->NumberOfThreads);
+  int numberOfBatches = qMin(filesToScan.size(), d->NumberOfThreads * 4);
+  for (int batchIndex = 0; batchIndex < numberOfBatches; ++batchIndex)
+    {
+    int firstFileIndex = static_cast<int>(static_cast<qint64>(filesToScan.size()) * batchIndex / numberOfBatches);
+    int lastFileIndex = static_cast<int>(static_cast<qint64>(filesToScan.size()) * (batchIndex + 1) / numberOfBatches);
+    threadPool.start(new qSlicerDICOMHeaderScanTask(&filesToScan, firstFileIndex, lastFileIndex,
+      d->TagKeys, d->MaximumValueLength, headersData));
+    }
+  threadPool.waitForDone();
+
+  // Store the results. The database is only accessed from this thread.
+  int numberOfScannedFiles = 0;
+  bool storeInDatabase = (d->Database && d->Database->isOpen());
+  QStringList cachedSOPInstanceUIDs;
+  QStringList cachedTags;
+  QStringList cachedValues;
+  for (int fileIndex = 0; fileIndex < filesToScan.size(); ++fileIndex)
+    {
+    const qSlicerDICOMHeaderScannerPrivate::FileHeader& header = headers[fileIndex];
+    if (!header.Valid)
+      {
+      qWarning() << Q_FUNC_INFO << ": Failed to read DICOM header from file " << filesToScan[fileIndex];
+      continue;
+      }
+    d->FileHeaders.insert(filesToScan[fileIndex], header);
+    ++numberOfScannedFiles;
+
+    if (!storeInDatabase || header.SOPInstanceUID.isEmpty())
+      {
+      continue;
+      }
+    for (int tagIndex = 0; tagIndex < d->Tags.size(); ++tagIndex)
+      {
+      if (header.States[tagIndex] == qSlicerDICOMHeaderScannerPrivate::TagValueRead
+        && !header.Values[tagIndex].isEmpty())
+        {
+        cachedSOPInstanceUIDs << header.SOPInstanceUID;
+        cachedTags << d->Tags[tagIndex];
+        cachedValues << header.Values[tagIndex];
+        }
+      }
+    }
+  if (!cachedSOPInstanceUIDs.isEmpty())
+    {
+    // Store all values in one transaction
+    d->Database->cacheTags(cachedSOPInstanceUIDs, cachedTags, cachedValues);
+    }
+
+  return numberOfScannedFiles;
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerDICOMHeaderScanner::isFileScanned(const QString& fileName)const
+{
+  Q_D(const qSlicerDICOMHeaderScanner);
+  return d->FileHeaders.contains(fileName);
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerDICOMHeaderScanner::fileValue(const QString& fileName, const QString& tag)const
+{
+  Q_D(const qSlicerDICOMHeaderScanner);
+  int tagIndex = d->tagIndex(tag);
+  QHash<QString, qSlicerDICOMHeaderScannerPrivate::FileHeader>::const_iterator headerIt = d->FileHeaders.constFind(fileName);
+  if (tagIndex >= 0 && headerIt != d->FileHeaders.constEnd())
+    {
+    if (headerIt->States[tagIndex] == qSlicerDICOMHeaderScannerPrivate::TagValueRead)
+      {
+      return headerIt->Values[tagIndex];
+      }
+    if (headerIt->States[tagIndex] == qSlicerDICOMHeaderScannerPrivate::TagMissing)
+      {
+      return QString();
+      }
+    }
+  // Value was not read
+  return (d->Database ? d->Database->fileValue(fileName, tag) : QString());
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerDICOMHeaderScanner::fileHasTag(const QString& fileName, const QString& tag)const
+{
+  Q_D(const qSlicerDICOMHeaderScanner);
+  int tagIndex = d->tagIndex(tag);
+  QHash<QString, qSlicerDICOMHeaderScannerPrivate::FileHeader>::const_iterator headerIt = d->FileHeaders.constFind(fileName);
+  if (tagIndex >= 0 && headerIt != d->FileHeaders.constEnd())
+    {
+    return (headerIt->States[tagIndex] != qSlicerDICOMHeaderScannerPrivate::TagMissing);
+    }
+  return !this->fileValue(fileName, tag).isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerDICOMHeaderScanner::clear()
+{
+  Q_D(qSlicerDICOMHeaderScanner);
+  d->FileHeaders.clear();
+}
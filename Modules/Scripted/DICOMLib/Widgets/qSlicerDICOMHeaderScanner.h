@@ -0,0 +1,97 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qSlicerDICOMHeaderScanner_h
+#define __qSlicerDICOMHeaderScanner_h
+
+// Qt includes
+#include <QObject>
+#include <QStringList>
+
+// DICOMLib includes
+#include "qSlicerDICOMLibModuleWidgetsExport.h"
+
+class qSlicerDICOMHeaderScannerPrivate;
+class ctkDICOMDatabase;
+
+/// Read a set of DICOM tags from many files at once.
+///
+/// The headers of the files are read by a pool of threads, each file only once
+/// and without loading the pixel data. The values are kept in memory so that
+/// DICOM plugins can query them while examining the files without opening the
+/// files again, and they are also stored in the tag cache of the DICOM database
+/// (if set) so that later queries of the database do not need to open the files.
+///
+/// Values of sequences and of elements longer than \sa maximumValueLength
+/// (for example pixel data) are not read, only their presence is recorded
+/// (see \sa fileHasTag). Querying their value is forwarded to the database.
+class Q_SLICER_MODULE_DICOMLIB_WIDGETS_EXPORT qSlicerDICOMHeaderScanner : public QObject
+{
+  Q_OBJECT
+
+  /// Tags to read from each file, in the "gggg,eeee" hexadecimal format
+  /// used by ctkDICOMDatabase (for example "0020,000e")
+  Q_PROPERTY(QStringList tags READ tags WRITE setTags)
+  /// Number of threads reading the files. Default is the ideal thread count of the system
+  Q_PROPERTY(int numberOfThreads READ numberOfThreads WRITE setNumberOfThreads)
+  /// Values longer than this number of bytes are not read. Default is 1024
+  Q_PROPERTY(int maximumValueLength READ maximumValueLength WRITE setMaximumValueLength)
+
+public:
+  typedef QObject Superclass;
+  qSlicerDICOMHeaderScanner(QObject *parent = 0);
+  virtual ~qSlicerDICOMHeaderScanner();
+
+  QStringList tags()const;
+  /// Set tags to read. Removes previously scanned values
+  void setTags(const QStringList& newTags);
+
+  int numberOfThreads()const;
+  void setNumberOfThreads(int newNumberOfThreads);
+
+  int maximumValueLength()const;
+  void setMaximumValueLength(int newMaximumValueLength);
+
+  /// Database to store the read values in, and to forward queries of tags that
+  /// were not read to. The scanner does not take ownership of the database
+  Q_INVOKABLE void setDatabase(ctkDICOMDatabase* database);
+  Q_INVOKABLE ctkDICOMDatabase* database()const;
+
+  /// Read the tags from the files that have not been scanned yet
+  /// \return Number of files successfully scanned by this call
+  Q_INVOKABLE int scanFiles(const QStringList& files);
+
+  /// Determine whether a file has been successfully scanned
+  Q_INVOKABLE bool isFileScanned(const QString& fileName)const;
+
+  /// Get value of a tag of a file. If the file was not scanned or the value
+  /// was not read then the value is queried from the database
+  Q_INVOKABLE QString fileValue(const QString& fileName, const QString& tag)const;
+
+  /// Determine whether a file contains a tag, even if its value was not read
+  Q_INVOKABLE bool fileHasTag(const QString& fileName, const QString& tag)const;
+
+  /// Remove all scanned values
+  Q_INVOKABLE void clear();
+
+protected:
+  QScopedPointer<qSlicerDICOMHeaderScannerPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qSlicerDICOMHeaderScanner);
+  Q_DISABLE_COPY(qSlicerDICOMHeaderScanner);
+};
+
+#endif
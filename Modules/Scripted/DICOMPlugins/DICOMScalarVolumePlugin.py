@@ -114,7 +114,7 @@ class DICOMScalarVolumePluginClass(DICOMPlugin):
     files parameter.
     """
 
-    seriesUID = slicer.dicomDatabase.fileValue(files[0],self.tags['seriesUID'])
+    seriesUID = self.fileValue(files[0],self.tags['seriesUID'])
     seriesName = self.defaultSeriesNodeName(seriesUID)
 
     # default loadable includes all files for series
@@ -149,16 +149,16 @@ class DICOMScalarVolumePluginClass(DICOMPlugin):
     for file in loadable.files:
 
       # save position and orientation
-      positions[file] = slicer.dicomDatabase.fileValue(file,self.tags['position'])
+      positions[file] = self.fileValue(file,self.tags['position'])
       if positions[file] == "":
         positions[file] = None
-      orientations[file] = slicer.dicomDatabase.fileValue(file,self.tags['orientation'])
+      orientations[file] = self.fileValue(file,self.tags['orientation'])
       if orientations[file] == "":
         orientations[file] = None
 
       # check for subseries values
       for tag in subseriesTags:
-        value = slicer.dicomDatabase.fileValue(file,self.tags[tag])
+        value = self.fileValue(file,self.tags[tag])
         value = value.replace(",","_") # remove commas so it can be used as an index
         if not subseriesValues.has_key(tag):
           subseriesValues[tag] = []
@@ -193,7 +193,7 @@ class DICOMScalarVolumePluginClass(DICOMPlugin):
     for loadable in loadables:
       newFiles = []
       for file in loadable.files:
-        if slicer.dicomDatabase.fileValue(file,self.tags['pixelData'])!='':
+        if self.fileHasTag(file,self.tags['pixelData']):
           newFiles.append(file)
       if len(newFiles) > 0:
         loadable.files = newFiles
@@ -221,14 +221,14 @@ class DICOMScalarVolumePluginClass(DICOMPlugin):
       # series and calculate the scan direction (assumed to be perpendicular
       # to the acquisition plane)
       #
-      value = slicer.dicomDatabase.fileValue(loadable.files[0], self.tags['numberOfFrames'])
+      value = self.fileValue(loadable.files[0], self.tags['numberOfFrames'])
       if value != "":
         loadable.warning += "Multi-frame image. If slice orientation or spacing is non-uniform then the image may be displayed incorrectly. Use with caution.  "
 
       validGeometry = True
       ref = {}
       for tag in [self.tags['position'], self.tags['orientation']]:
-        value = slicer.dicomDatabase.fileValue(loadable.files[0], tag)
+        value = self.fileValue(loadable.files[0], tag)
         if not value or value == "":
           loadable.warning += "Reference image in series does not contain geometry information.  Please use caution.  "
           validGeometry = False
@@ -368,14 +368,18 @@ class UndoRedo(object):
   class checkPoint(object):
     """Internal class to store one checkpoint
     step consisting of the stashed data
-    and the volumeNode it corresponds to
+    and the volumeNode it corresponds to.
+    The parts of the volume that did not change since the
+    previous checkPoint are shared with it.
     """
-    def __init__(self,volumeNode):
+    def __init__(self,volumeNode,previousCheckPoint=None):
       self.volumeNode = volumeNode
       self.stashImage = vtk.vtkImageData()
       self.stash = slicer.vtkImageStash()
       self.stashImage.DeepCopy( volumeNode.GetImageData() )
       self.stash.SetStashImage( self.stashImage )
+      if previousCheckPoint and previousCheckPoint.volumeNode == volumeNode:
+        self.stash.SetPreviousStash( previousCheckPoint.stash )
       self.stash.ThreadedStash()
 
     def restore(self):
@@ -424,7 +428,8 @@ class UndoRedo(object):
     """
     if not self.enabled or not volumeNode or not volumeNode.GetImageData():
       return
-    checkPointList.append( self.checkPoint(volumeNode) )
+    previousCheckPoint = checkPointList[-1] if checkPointList else None
+    checkPointList.append( self.checkPoint(volumeNode,previousCheckPoint) )
     self.stateChangedCallback()
     if len(checkPointList) >= self.undoSize:
       return( checkPointList[1:] )
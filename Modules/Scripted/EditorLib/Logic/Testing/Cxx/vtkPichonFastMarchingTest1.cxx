@@ -0,0 +1,193 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+// EditorLib includes
+#include "vtkPichonFastMarching.h"
+
+// MRML includes
+#include <vtkMRMLCoreTestingMacros.h>
+
+// vtkTeem includes
+#include <vtkNRRDReader.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// The filter reads the output of the previous execution and updates it in place
+// (the Editor copies it back into the label map). Newly allocated outputs are not
+// initialized, so the tester restores the labels kept by the test before executing
+// to make the outputs reproducible.
+
+//---------------------------------------------------------------------------
+class vtkPichonFastMarchingTester : public vtkPichonFastMarching
+{
+public:
+  static vtkPichonFastMarchingTester *New();
+  vtkTypeMacro(vtkPichonFastMarchingTester, vtkPichonFastMarching);
+  vtkImageData* Labels;
+protected:
+  vtkPichonFastMarchingTester() : Labels(0) {}
+  void ExecuteDataWithInformation(vtkDataObject* output, vtkInformation* outInfo) VTK_OVERRIDE
+    {
+    vtkImageData* outData = this->AllocateOutputData(output, outInfo);
+    outData->GetPointData()->GetScalars()->DeepCopy(this->Labels->GetPointData()->GetScalars());
+    this->Superclass::ExecuteDataWithInformation(output, outInfo);
+    }
+};
+vtkStandardNewMacro(vtkPichonFastMarchingTester);
+
+namespace
+{
+
+const int DIMENSION = 40;
+const int LABEL = 5;
+
+//---------------------------------------------------------------------------
+// Bright sphere on a dark background, both with deterministic noise so that
+// the arrival times of many nodes are close
+void createInput(vtkImageData* input)
+{
+  input->SetDimensions(DIMENSION, DIMENSION, DIMENSION);
+  input->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(input->GetScalarPointer());
+  unsigned int seed = 1;
+  for (int k = 0; k < DIMENSION; ++k)
+    {
+    for (int j = 0; j < DIMENSION; ++j)
+      {
+      for (int i = 0; i < DIMENSION; ++i)
+        {
+        seed = seed * 1103515245 + 12345;
+        int distance2 = (i - 20) * (i - 20) + (j - 18) * (j - 18) + (k - 21) * (k - 21);
+        *voxels++ = static_cast<short>((distance2 < 100 ? 200 : 50) + (seed >> 16) % 41 - 20);
+        }
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void createLabels(vtkImageData* labels)
+{
+  labels->SetDimensions(DIMENSION, DIMENSION, DIMENSION);
+  labels->AllocateScalars(VTK_SHORT, 1);
+  memset(labels->GetScalarPointer(), 0, DIMENSION * DIMENSION * DIMENSION * sizeof(short));
+}
+
+//---------------------------------------------------------------------------
+// Same sequence of calls as the FastMarching effect, the label map is saved
+// after each call to show(). Each evolution ends with part of the points
+// hidden, the next evolution restarts from the shown points.
+void segment(vtkImageData* input, std::vector<vtkSmartPointer<vtkImageData> >& results)
+{
+  vtkNew<vtkImageData> labels;
+  createLabels(labels.GetPointer());
+
+  vtkNew<vtkPichonFastMarchingTester> fastMarching;
+  fastMarching->Labels = labels.GetPointer();
+  fastMarching->init(DIMENSION, DIMENSION, DIMENSION, 300, 1, 1, 1);
+  fastMarching->SetInputData(input);
+  // initialize the nodes
+  fastMarching->Update();
+
+  fastMarching->setActiveLabel(LABEL);
+  fastMarching->addSeedIJK(20, 18, 21);
+  fastMarching->addSeedIJK(22, 18, 21);
+
+  const int numberOfPoints[2] = { 2000, 3000 };
+  const float showRatios[3] = { 1.f, 0.25f, 0.5f };
+  for (int evolution = 0; evolution < 2; ++evolution)
+    {
+    fastMarching->setNPointsEvolution(numberOfPoints[evolution]);
+    fastMarching->Modified();
+    fastMarching->Update();
+    for (int show = 0; show < 3; ++show)
+      {
+      fastMarching->show(showRatios[show]);
+      labels->DeepCopy(fastMarching->GetOutput());
+      vtkSmartPointer<vtkImageData> result = vtkSmartPointer<vtkImageData>::New();
+      result->DeepCopy(labels.GetPointer());
+      results.push_back(result);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+int countLabel(vtkImageData* labels)
+{
+  const short* voxels = static_cast<short*>(labels->GetScalarPointer());
+  int count = 0;
+  for (int i = 0; i < DIMENSION * DIMENSION * DIMENSION; ++i)
+    {
+    count += (voxels[i] == LABEL);
+    }
+  return count;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+// Check that the segmentation is the same as the baseline, computed by the
+// implementation before the minheap and the nodes initialization were optimized.
+// Bit i of a baseline voxel is set if the voxel is labeled in the i-th result.
+int vtkPichonFastMarchingTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkPichonFastMarchingTest1 /path/to/baseline.nrrd" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkNRRDReader> reader;
+  reader->SetFileName(argv[1]);
+  reader->Update();
+  vtkImageData* baseline = reader->GetOutput();
+  CHECK_INT(baseline->GetScalarType(), VTK_UNSIGNED_CHAR);
+  CHECK_INT(baseline->GetNumberOfPoints(), DIMENSION * DIMENSION * DIMENSION);
+  const unsigned char* baselineVoxels = static_cast<unsigned char*>(baseline->GetScalarPointer());
+
+  vtkNew<vtkImageData> input;
+  createInput(input.GetPointer());
+
+  std::vector<vtkSmartPointer<vtkImageData> > results;
+  segment(input.GetPointer(), results);
+
+  CHECK_INT(static_cast<int>(results.size()), 6);
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    int count = countLabel(results[i]);
+    std::cout << "Result " << i << ": " << count << " labeled voxels" << std::endl;
+    CHECK_BOOL(count > 0, true);
+    const short* voxels = static_cast<short*>(results[i]->GetScalarPointer());
+    for (int v = 0; v < DIMENSION * DIMENSION * DIMENSION; ++v)
+      {
+      const short expected = ((baselineVoxels[v] >> i) & 1) ? LABEL : 0;
+      if (voxels[v] != expected)
+        {
+        std::cerr << "Line " << __LINE__ << ": result " << i << " differs from the baseline at voxel " << v
+                  << ": " << voxels[v] << " instead of " << expected << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  CHECK_BOOL(countLabel(results[1]) < countLabel(results[2]), true);
+  CHECK_BOOL(countLabel(results[2]) < countLabel(results[0]), true);
+  CHECK_BOOL(countLabel(results[3]) > countLabel(results[2]), true);
+
+  return EXIT_SUCCESS;
+}
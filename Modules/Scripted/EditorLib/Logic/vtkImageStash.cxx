@@ -14,22 +14,220 @@
 =========================================================================*/
 #include "vtkImageStash.h"
 
+#include "vtkNew.h"
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
+#include "vtkSmartPointer.h"
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 vtkStandardNewMacro(vtkImageStash);
 
+//----------------------------------------------------------------------------
+class vtkImageStash::vtkInternal
+{
+public:
+  enum CodecType
+    {
+    RunLength,
+    ZLib
+    };
+
+  struct Chunk
+    {
+    vtkSmartPointer<vtkUnsignedCharArray> Data;
+    CodecType Codec;
+    /// size of the uncompressed chunk in bytes
+    vtkIdType Size;
+    /// only computed if there is a previous stash to compare with
+    vtkTypeUInt64 Hash;
+    bool Hashed;
+    bool Reused;
+    bool Succeeded;
+    };
+
+  /// decompress the chunk into data, that has the size of the uncompressed chunk
+  static bool DecodeChunk(const Chunk& chunk, unsigned char* data, int elementSize,
+                          vtkZLibDataCompressor* compressor);
+
+  std::vector<Chunk> Chunks;
+  /// size in bytes of all the chunks but the last one
+  vtkIdType ChunkBytes;
+
+  /// state shared by the threads while stashing or unstashing
+  vtkImageStash* Self;
+  unsigned char* Scalars;
+  vtkIdType ScalarSize;
+  int ElementSize;
+  vtkInternal* Previous;
+  /// the previous stash is released by GetStashing() once ThreadedStash is done
+  bool ReleasePreviousStash;
+};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 HashBytes(const unsigned char* data, vtkIdType size)
+{
+  // MurmurHash64A: each word is mixed before being combined and the result
+  // goes through a final avalanche, so that every bit of the data affects
+  // all the bits of the hash
+  const vtkTypeUInt64 m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  vtkTypeUInt64 hash = 0x8445d61a4e774912ULL ^ (static_cast<vtkTypeUInt64>(size) * m);
+  vtkIdType i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+    vtkTypeUInt64 word;
+    memcpy(&word, data + i, 8);
+    word *= m;
+    word ^= word >> r;
+    word *= m;
+    hash ^= word;
+    hash *= m;
+    }
+  if (i < size)
+    {
+    vtkTypeUInt64 word = 0;
+    memcpy(&word, data + i, static_cast<size_t>(size - i));
+    hash ^= word;
+    hash *= m;
+    }
+  hash ^= hash >> r;
+  hash *= m;
+  hash ^= hash >> r;
+  return hash;
+}
+
+//----------------------------------------------------------------------------
+// Encode the values as (count, value) records. Return false if the encoded
+// data would be larger than maxEncodedSize.
+template <class T>
+bool RunLengthEncode(const T* values, vtkIdType numberOfValues,
+                     vtkIdType maxEncodedSize, std::vector<unsigned char>& encoded)
+{
+  const vtkIdType recordSize = sizeof(vtkTypeUInt32) + sizeof(T);
+  encoded.clear();
+  vtkIdType i = 0;
+  while (i < numberOfValues)
+    {
+    const T value = values[i];
+    vtkIdType end = i + 1;
+    while (end < numberOfValues && values[end] == value && end - i < VTK_TYPE_UINT32_MAX)
+      {
+      ++end;
+      }
+    const vtkIdType position = static_cast<vtkIdType>(encoded.size());
+    if (position + recordSize > maxEncodedSize)
+      {
+      return false;
+      }
+    const vtkTypeUInt32 count = static_cast<vtkTypeUInt32>(end - i);
+    encoded.resize(position + recordSize);
+    memcpy(&encoded[position], &count, sizeof(count));
+    memcpy(&encoded[position + sizeof(count)], &value, sizeof(T));
+    i = end;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+bool RunLengthDecode(const unsigned char* encoded, vtkIdType encodedSize,
+                     T* values, vtkIdType numberOfValues)
+{
+  const vtkIdType recordSize = sizeof(vtkTypeUInt32) + sizeof(T);
+  vtkIdType i = 0;
+  for (vtkIdType position = 0; position + recordSize <= encodedSize; position += recordSize)
+    {
+    vtkTypeUInt32 count;
+    T value;
+    memcpy(&count, encoded + position, sizeof(count));
+    memcpy(&value, encoded + position + sizeof(count), sizeof(T));
+    if (i + count > numberOfValues)
+      {
+      return false;
+      }
+    std::fill(values + i, values + i + count, value);
+    i += count;
+    }
+  return i == numberOfValues;
+}
+
+//----------------------------------------------------------------------------
+bool RunLengthEncodeChunk(const unsigned char* data, vtkIdType size, int elementSize,
+                          vtkIdType maxEncodedSize, std::vector<unsigned char>& encoded)
+{
+  switch (elementSize)
+    {
+    case 1:
+      return RunLengthEncode(reinterpret_cast<const vtkTypeUInt8*>(data), size, maxEncodedSize, encoded);
+    case 2:
+      return RunLengthEncode(reinterpret_cast<const vtkTypeUInt16*>(data), size / 2, maxEncodedSize, encoded);
+    case 4:
+      return RunLengthEncode(reinterpret_cast<const vtkTypeUInt32*>(data), size / 4, maxEncodedSize, encoded);
+    case 8:
+      return RunLengthEncode(reinterpret_cast<const vtkTypeUInt64*>(data), size / 8, maxEncodedSize, encoded);
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool RunLengthDecodeChunk(const unsigned char* encoded, vtkIdType encodedSize,
+                          unsigned char* data, vtkIdType size, int elementSize)
+{
+  switch (elementSize)
+    {
+    case 1:
+      return RunLengthDecode(encoded, encodedSize, reinterpret_cast<vtkTypeUInt8*>(data), size);
+    case 2:
+      return RunLengthDecode(encoded, encodedSize, reinterpret_cast<vtkTypeUInt16*>(data), size / 2);
+    case 4:
+      return RunLengthDecode(encoded, encodedSize, reinterpret_cast<vtkTypeUInt32*>(data), size / 4);
+    case 8:
+      return RunLengthDecode(encoded, encodedSize, reinterpret_cast<vtkTypeUInt64*>(data), size / 8);
+    default:
+      return false;
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+bool vtkImageStash::vtkInternal::DecodeChunk(const Chunk& chunk, unsigned char* data, int elementSize,
+                                             vtkZLibDataCompressor* compressor)
+{
+  vtkIdType stashedSize = chunk.Data->GetNumberOfTuples();
+  unsigned char *stash_p = chunk.Data->GetPointer(0);
+  if (chunk.Codec == RunLength)
+    {
+    return RunLengthDecodeChunk(stash_p, stashedSize, data, chunk.Size, elementSize);
+    }
+  return compressor->Uncompress(stash_p, stashedSize, data, chunk.Size) == static_cast<size_t>(chunk.Size);
+}
+
 //----------------------------------------------------------------------------
 vtkImageStash::vtkImageStash()
 {
   this->StashImage = NULL;
-  this->StashedScalars = NULL;
+  this->PreviousStash = NULL;
   this->MultiThreader = vtkMultiThreader::New();
   this->Compressor = vtkZLibDataCompressor::New();
   this->CompressionLevel = 1; // corresponds to Z_BEST_SPEED
   this->Stashing = 0;
   this->StashingThreadID = 0;
   this->StashingSucceeded = 0;
+  this->ChunkSize = 1024 * 1024;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->NumberOfReusedChunks = 0;
+  this->Internal = new vtkInternal;
+  this->Internal->ChunkBytes = 0;
+  this->Internal->ReleasePreviousStash = false;
 }
 
 //----------------------------------------------------------------------------
@@ -44,9 +242,9 @@ vtkImageStash::~vtkImageStash()
     {
     this->StashImage->Delete();
     }
-  if (this->StashedScalars)
+  if (this->PreviousStash)
     {
-    this->StashedScalars->Delete();
+    this->PreviousStash->Delete();
     }
   if (this->MultiThreader)
     {
@@ -56,6 +254,7 @@ vtkImageStash::~vtkImageStash()
     {
     this->Compressor->Delete();
     }
+  delete this->Internal;
 }
 
 //----------------------------------------------------------------------------
@@ -77,14 +276,113 @@ void vtkImageStash::ThreadedStash()
                                         static_cast<void *>(this));
 }
 
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageStash::StashChunksThreadFunction(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkInternal *internal = static_cast<vtkInternal*>(info->UserData);
+  vtkImageStash *self = internal->Self;
+
+  // the compressor keeps the compressed buffer, each thread needs its own
+  vtkSmartPointer<vtkZLibDataCompressor> compressor =
+    vtkSmartPointer<vtkZLibDataCompressor>::Take(self->Compressor->NewInstance());
+  compressor->SetCompressionLevel(self->CompressionLevel);
+
+  std::vector<unsigned char> encoded;
+  const int numberOfChunks = static_cast<int>(internal->Chunks.size());
+  for (int c = info->ThreadID; c < numberOfChunks; c += info->NumberOfThreads)
+    {
+    vtkInternal::Chunk& chunk = internal->Chunks[c];
+    const vtkIdType offset = c * internal->ChunkBytes;
+    const unsigned char *data = internal->Scalars + offset;
+    chunk.Size = std::min(internal->ChunkBytes, internal->ScalarSize - offset);
+    chunk.Hash = 0;
+    chunk.Hashed = false;
+    chunk.Reused = false;
+    chunk.Succeeded = false;
+
+    vtkInternal* previous = internal->Previous;
+    if (previous)
+      {
+      chunk.Hash = HashBytes(data, chunk.Size);
+      chunk.Hashed = true;
+      if (c < static_cast<int>(previous->Chunks.size()))
+        {
+        const vtkInternal::Chunk& previousChunk = previous->Chunks[c];
+        if (previousChunk.Succeeded && previousChunk.Hashed
+            && previousChunk.Size == chunk.Size && previousChunk.Hash == chunk.Hash)
+          {
+          // unchanged since the previous stash, share the compressed data
+          chunk.Data = previousChunk.Data;
+          chunk.Codec = previousChunk.Codec;
+          chunk.Reused = true;
+          chunk.Succeeded = true;
+          continue;
+          }
+        }
+      }
+
+    // label maps are mostly long runs of the same value, run-length encoding
+    // is faster than zlib for them. Give up on it as soon as it does not
+    // compress well.
+    if (RunLengthEncodeChunk(data, chunk.Size, internal->ElementSize, chunk.Size / 4, encoded))
+      {
+      chunk.Data = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      chunk.Data->SetNumberOfTuples(static_cast<vtkIdType>(encoded.size()));
+      if (!encoded.empty())
+        {
+        memcpy(chunk.Data->GetPointer(0), &encoded[0], encoded.size());
+        }
+      chunk.Codec = vtkInternal::RunLength;
+      chunk.Succeeded = true;
+      continue;
+      }
+
+    // returns a new buffer that has to be deleted
+    chunk.Data.TakeReference(compressor->Compress(data, chunk.Size));
+    if (chunk.Data)
+      {
+      // The compressor allocates space that has the size of an uncompressed chunk
+      // and even if it uses less memory the buffer size is not reduced.
+      // Call squeeze on the buffer to reclaim the unused memory space
+      chunk.Data->Squeeze();
+      chunk.Codec = vtkInternal::ZLib;
+      chunk.Succeeded = true;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageStash::UnstashChunksThreadFunction(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkInternal *internal = static_cast<vtkInternal*>(info->UserData);
+  vtkImageStash *self = internal->Self;
+
+  vtkSmartPointer<vtkZLibDataCompressor> compressor =
+    vtkSmartPointer<vtkZLibDataCompressor>::Take(self->Compressor->NewInstance());
+
+  const int numberOfChunks = static_cast<int>(internal->Chunks.size());
+  for (int c = info->ThreadID; c < numberOfChunks; c += info->NumberOfThreads)
+    {
+    vtkInternal::Chunk& chunk = internal->Chunks[c];
+    unsigned char *data = internal->Scalars + c * internal->ChunkBytes;
+    chunk.Succeeded = vtkInternal::DecodeChunk(chunk, data, internal->ElementSize, compressor);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
 
 //----------------------------------------------------------------------------
 void vtkImageStash::Stash()
 {
   //
   // put a compressed version of the scalars into the compressed
-  // buffer, and then set the scalar size to zero
+  // chunks, and then set the scalar size to zero
   //
+  this->Internal->Chunks.clear();
+  this->NumberOfReusedChunks = 0;
+
   if (!this->GetStashImage())
     {
     vtkErrorWithObjectMacro (this, "Cannot stash - no image data");
@@ -104,18 +402,53 @@ void vtkImageStash::Stash()
   vtkIdType scalarSize = size * numPrims;
 
   unsigned char *p = static_cast<unsigned char *>(scalars->WriteVoidPointer(0, numPrims));
-  this->GetCompressor()->SetCompressionLevel(this->GetCompressionLevel());
-  vtkUnsignedCharArray* compressedBuffer=this->GetCompressor()->Compress(p, scalarSize); // returns a new buffer that has to be deleted
-  // The compressor allocates space that has the size of an uncompressed volume
-  // and even if it uses less memory the buffer size is not reduced.
-  // Call squeeze on the buffer to reclaim the unused memory space
-  // (typically reduces memory consumption from hundreds of megabytes to under a megabyte)
-  if (compressedBuffer)
-    {
-    compressedBuffer->Squeeze();
-    this->SetStashedScalars(compressedBuffer);
-    compressedBuffer->Delete();
 
+  // chunks contain whole values so that they can be run-length encoded
+  this->Internal->ChunkBytes = std::max(size, this->ChunkSize - this->ChunkSize % size);
+  this->Internal->Chunks.resize(
+    static_cast<size_t>((scalarSize + this->Internal->ChunkBytes - 1) / this->Internal->ChunkBytes));
+  this->Internal->Self = this;
+  this->Internal->Scalars = p;
+  this->Internal->ScalarSize = scalarSize;
+  this->Internal->ElementSize = static_cast<int>(size);
+  this->Internal->Previous = 0;
+  if (this->PreviousStash && !this->PreviousStash->Stashing
+      && this->PreviousStash->GetStashingSucceeded()
+      && this->PreviousStash->Internal->ChunkBytes == this->Internal->ChunkBytes
+      && this->PreviousStash->Internal->ElementSize == this->Internal->ElementSize)
+    {
+    this->Internal->Previous = this->PreviousStash->Internal;
+    }
+
+  const int numberOfChunks = static_cast<int>(this->Internal->Chunks.size());
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::max(1, std::min(this->NumberOfThreads, numberOfChunks)));
+  threader->SetSingleMethod(vtkImageStash::StashChunksThreadFunction, this->Internal);
+  threader->SingleMethodExecute();
+
+  // the previous stash is not needed anymore, do not keep the whole
+  // history of stashes alive. In the stashing thread, it is released by
+  // GetStashing() in the calling thread instead: releasing it invokes
+  // ModifiedEvent and may delete it.
+  this->Internal->Previous = 0;
+  if (this->Stashing)
+    {
+    this->Internal->ReleasePreviousStash = true;
+    }
+  else
+    {
+    this->SetPreviousStash(0);
+    }
+
+  bool succeeded = true;
+  for (int c = 0; c < numberOfChunks; ++c)
+    {
+    succeeded = succeeded && this->Internal->Chunks[c].Succeeded;
+    this->NumberOfReusedChunks += this->Internal->Chunks[c].Reused ? 1 : 0;
+    }
+
+  if (succeeded)
+    {
     // this will realloc a zero sized buffer
     scalars->SetNumberOfTuples(0);
     scalars->Squeeze();
@@ -124,11 +457,23 @@ void vtkImageStash::Stash()
   else
     {
     // couldn't really compress
-    this->SetStashedScalars(0);
+    this->Internal->Chunks.clear();
+    this->NumberOfReusedChunks = 0;
     this->SetStashingSucceeded(0);
     }
 }
 
+//----------------------------------------------------------------------------
+int vtkImageStash::GetStashing()
+{
+  if (!this->Stashing && this->Internal->ReleasePreviousStash)
+    {
+    this->Internal->ReleasePreviousStash = false;
+    this->SetPreviousStash(0);
+    }
+  return this->Stashing;
+}
+
 //----------------------------------------------------------------------------
 void vtkImageStash::Unstash()
 {
@@ -155,7 +500,7 @@ void vtkImageStash::Unstash()
     return;
     }
 
-  if (!this->StashedScalars)
+  if (!this->StashingSucceeded)
     {
     vtkErrorMacro ("Cannot unstash - nothing in the stash");
     return;
@@ -165,18 +510,50 @@ void vtkImageStash::Unstash()
   //   - the number of components and the datatype are unchanged from before
   //     so we know the right size for the output buffer
   vtkIdType numPrims = this->GetNumberOfTuples() * scalars->GetNumberOfComponents();
-  vtkIdType size = vtkDataArray::GetDataTypeSize(scalars->GetDataType());
-  vtkIdType scalarSize = size * numPrims;
 
   // setting the number of tuples reallocates the right amount of data
   // so we can uncompress directly into the buffer
   scalars->SetNumberOfTuples(this->GetNumberOfTuples());
-  vtkIdType stashedSize = this->StashedScalars->GetNumberOfTuples();
   unsigned char *scalar_p =
       static_cast<unsigned char *>(scalars->WriteVoidPointer(0, numPrims));
-  unsigned char *stash_p =
-      static_cast<unsigned char *>(this->StashedScalars->WriteVoidPointer(0, stashedSize));
-  this->GetCompressor()->Uncompress(stash_p, stashedSize, scalar_p, scalarSize);
+
+  this->Internal->Self = this;
+  this->Internal->Scalars = scalar_p;
+
+  const int numberOfChunks = static_cast<int>(this->Internal->Chunks.size());
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::max(1, std::min(this->NumberOfThreads, numberOfChunks)));
+  threader->SetSingleMethod(vtkImageStash::UnstashChunksThreadFunction, this->Internal);
+  threader->SingleMethodExecute();
+
+  for (int c = 0; c < numberOfChunks; ++c)
+    {
+    if (!this->Internal->Chunks[c].Succeeded)
+      {
+      vtkErrorMacro ("Unstash: failed to decompress chunk " << c);
+      return;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageStash::GetStashedSize()
+{
+  vtkIdType stashedSize = 0;
+  for (size_t c = 0; c < this->Internal->Chunks.size(); ++c)
+    {
+    if (this->Internal->Chunks[c].Data)
+      {
+      stashedSize += this->Internal->Chunks[c].Data->GetNumberOfTuples();
+      }
+    }
+  return stashedSize;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageStash::GetNumberOfStashedChunks()
+{
+  return static_cast<int>(this->Internal->Chunks.size());
 }
 
 //----------------------------------------------------------------------------
@@ -185,11 +562,13 @@ void vtkImageStash::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "StashImage: " << this->GetStashImage() << "\n";
-  os << indent << "Stashing: " << this->GetStashing() << "\n";
-  os << indent << "Stashed Scalars: " << this->GetStashedScalars() << "\n";
-  if ( this->GetStashedScalars()) this->GetStashedScalars()->PrintSelf(os,indent.GetNextIndent());
+  os << indent << "Stashing: " << this->Stashing << "\n";
+  os << indent << "ChunkSize: " << this->ChunkSize << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "Stashed Chunks: " << this->GetNumberOfStashedChunks() << "\n";
+  os << indent << "Reused Chunks: " << this->NumberOfReusedChunks << "\n";
+  os << indent << "Stashed Size: " << this->GetStashedSize() << "\n";
   os << indent << "CompressionLevel: " << this->GetCompressionLevel() << "\n";
   os << indent << "Compressor: \n";
   this->GetCompressor()->PrintSelf(os,indent.GetNextIndent());
 }
-
@@ -14,6 +14,13 @@
 =========================================================================*/
 ///  vtkImageStash -
 ///  Store an image data in a compressed form to save memory
+///
+///  The scalars are split in chunks of ChunkSize bytes that are compressed
+///  and decompressed in parallel. Chunks that are well run-length encoded
+///  (e.g. label maps) use run-length encoding, the others use the zlib
+///  Compressor. If a PreviousStash is set, the chunks that did not change
+///  since the previous stash are shared with it instead of being compressed
+///  again.
 
 #ifndef __vtkImageStash_h
 #define __vtkImageStash_h
@@ -44,10 +51,34 @@ public:
   vtkGetObjectMacro(StashImage, vtkImageData);
 
   ///
-  /// The stashed scalars:
-  /// this is the zlib compressed image scalar data
-  vtkSetObjectMacro(StashedScalars, vtkUnsignedCharArray);
-  vtkGetObjectMacro(StashedScalars, vtkUnsignedCharArray);
+  /// Stash of the previous version of the same image, its unchanged
+  /// chunks are reused. It is released once Stash is done, or by
+  /// GetStashing() once ThreadedStash is done.
+  /// The chunks are hashed only when a previous stash is set, so the
+  /// first stash of a series does not share its chunks with the next one.
+  vtkSetObjectMacro(PreviousStash, vtkImageStash);
+  vtkGetObjectMacro(PreviousStash, vtkImageStash);
+
+  ///
+  /// Size in bytes of the chunks the scalars are split into
+  vtkSetClampMacro(ChunkSize, vtkIdType, 1024, VTK_ID_MAX);
+  vtkGetMacro(ChunkSize, vtkIdType);
+
+  ///
+  /// Number of threads compressing or decompressing the chunks
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  ///
+  /// Total size in bytes of the stashed chunks, including the ones
+  /// shared with the previous stash
+  vtkIdType GetStashedSize();
+
+  ///
+  /// Number of chunks of the last call to Stash, and how many of them
+  /// were reused from the previous stash
+  int GetNumberOfStashedChunks();
+  vtkGetMacro(NumberOfReusedChunks, int);
 
   // Description:
   // To keep track of original number of tuples in scalar data
@@ -84,7 +115,7 @@ public:
   // Description:
   // Check if compression thread is finished
   vtkSetMacro(Stashing, int);
-  vtkGetMacro(Stashing, int);
+  int GetStashing();
 
   // Description:
   // 1 if the last call to Stash worked correctly, 0 otherwise
@@ -95,14 +126,23 @@ protected:
   vtkImageStash();
   ~vtkImageStash();
 
+  static VTK_THREAD_RETURN_TYPE StashChunksThreadFunction(void *arg);
+  static VTK_THREAD_RETURN_TYPE UnstashChunksThreadFunction(void *arg);
+
   vtkImageData *StashImage;
-  vtkUnsignedCharArray *StashedScalars;
+  vtkImageStash *PreviousStash;
   vtkMultiThreader *MultiThreader;
   vtkIdType NumberOfTuples;
   vtkZLibDataCompressor *Compressor;
   int CompressionLevel;
   int Stashing;
   int StashingSucceeded;
+  vtkIdType ChunkSize;
+  int NumberOfThreads;
+  int NumberOfReusedChunks;
+
+  class vtkInternal;
+  vtkInternal* Internal;
 
 private:
   int StashingThreadID;
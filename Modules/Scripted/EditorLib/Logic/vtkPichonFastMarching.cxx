@@ -17,6 +17,7 @@
 #include <vtkInformation.h>
 #include <vtkDataArray.h>
 #include <vtkMath.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
@@ -24,15 +25,6 @@
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 
-// used to compute the median
-int compareInt(const void *a, const void *b)
-{
-  return  (*(int*)a) - (*(int*)b);
-}
-
-///////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////
-
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkPichonFastMarching);
 
@@ -142,7 +134,14 @@ inline void vtkPichonFastMarching::getMedianInhomo( int index, int &med, int &in
   for(int k=0;k<=26;k++)
       tmpNeighborhood[k] = (int)indata[index + arrayShiftNeighbor[k]];
 
-  qsort( (void*)tmpNeighborhood, 27, sizeof(int), &compareInt );
+  // only 3 order statistics are needed, select them instead of sorting
+  // the neighborhood. After a selection, the values above the selected
+  // one are the larger ones, so the next selection only looks at them
+  int *first = tmpNeighborhood;
+  int *last = tmpNeighborhood + 27;
+  std::nth_element( first, first + 5, last );
+  std::nth_element( first + 6, first + 13, last );
+  std::nth_element( first + 14, first + 21, last );
 
   inh = inhomo[ index ] = (tmpNeighborhood[21] - tmpNeighborhood[5]);
   med = median[ index ] = tmpNeighborhood[13];
@@ -159,13 +158,74 @@ inline void vtkPichonFastMarching::getMedianInhomo( int index, int &med, int &in
     tmpNeighborhood[p++] = (int)indata[k];
     }
 
-    qsort( (void*)tmpNeighborhood, 125, sizeof(int), &compareInt );
+    std::nth_element( tmpNeighborhood, tmpNeighborhood + 20, tmpNeighborhood + 125 );
+    std::nth_element( tmpNeighborhood + 21, tmpNeighborhood + 63, tmpNeighborhood + 125 );
+    std::nth_element( tmpNeighborhood + 64, tmpNeighborhood + 105, tmpNeighborhood + 125 );
 
     inh = inhomo[ index ] = (tmpNeighborhood[105] - tmpNeighborhood[20]);
     med = median[ index ] = tmpNeighborhood[63];
   */
 }
 
+void vtkPichonFastMarching::initializeNodes( int kBegin, int kEnd, bool updateProgress )
+{
+  int index=kBegin*dimXY;
+  int lastPercentageProgressBarUpdated=-1;
+
+  for(int k=kBegin;k<kEnd;k++)
+    {
+    if( updateProgress )
+      {
+      int currentPercentage = GRANULARITY_PROGRESS*(k-kBegin) / (kEnd-kBegin);
+
+      if( currentPercentage > lastPercentageProgressBarUpdated )
+        {
+        lastPercentageProgressBarUpdated = currentPercentage;
+        this->UpdateProgress(float(currentPercentage)/float(GRANULARITY_PROGRESS));
+        }
+      }
+
+    for(int j=0;j<dimY;j++)
+      for(int i=0;i<dimX;i++)
+        {
+        node[index].T=(float)INF;
+
+        if(outdata[index]==0)
+          node[index].status=fmsFAR;
+        else
+          node[index].status=fmsDONE;
+
+        inhomo[index]=-1; // meaning inhomo and median have not been computed there
+
+        if( (i<BAND_OUT) || (j<BAND_OUT) ||  (k<BAND_OUT) ||
+          (i>=(dimX-BAND_OUT)) || (j>=(dimY-BAND_OUT)) || (k>=(dimZ-BAND_OUT)) )
+          {
+          node[index].status=fmsOUT;
+
+          // we should never have to look at these values anyway !
+          inhomo[ index ] = depth;
+          median[ index ] = 0;
+          }
+
+        index++;
+        }
+    }
+}
+
+VTK_THREAD_RETURN_TYPE vtkPichonFastMarching::initializeNodesThreadFunction( void *arg )
+{
+  vtkMultiThreader::ThreadInfo *info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkPichonFastMarching *self = static_cast<vtkPichonFastMarching*>(info->UserData);
+
+  int kBegin = self->dimZ * info->ThreadID / info->NumberOfThreads;
+  int kEnd = self->dimZ * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  // thread 0 runs in the calling thread, it is safe to invoke events there
+  self->initializeNodes( kBegin, kEnd, info->ThreadID == 0 );
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 void vtkPichonFastMarching::initNewExpansion( void )
 {
   if(somethingReallyWrong)
@@ -267,46 +327,13 @@ void vtkPichonFastMarchingExecute(vtkPichonFastMarching *self,
     {
     self->initialized = true;
 
-    int index=0;
-    int lastPercentageProgressBarUpdated=-1;
-
-
-    for(k=0;k<self->dimZ;k++)
-      for(int j=0;j<self->dimY;j++)
-        for(int i=0;i<self->dimX;i++)
-          {
-
-          self->node[index].T=(float)INF;
-
-          if(self->outdata[index]==0)
-            self->node[index].status=fmsFAR;
-          else
-            self->node[index].status=fmsDONE;
-
-          self->inhomo[index]=-1; // meaning inhomo and median have not been computed there
-
-          if( (i<BAND_OUT) || (j<BAND_OUT) ||  (k<BAND_OUT) ||
-            (i>=(self->dimX-BAND_OUT)) || (j>=(self->dimY-BAND_OUT)) || (k>=(self->dimZ-BAND_OUT)) )
-            {
-
-            // update progress bar
-            int currentPercentage = GRANULARITY_PROGRESS*index / self->dimXYZ;
-
-            if( currentPercentage > lastPercentageProgressBarUpdated )
-              {
-              lastPercentageProgressBarUpdated = currentPercentage;
-              self->UpdateProgress(float(currentPercentage)/float(GRANULARITY_PROGRESS));
-              }
-
-            self->node[index].status=fmsOUT;
-
-            // we should never have to look at these values anyway !
-            self->inhomo[ index ] = self->depth;
-            self->median[ index ] = 0;
-            }
-
-          index++;
-          }
+    // the slices are initialized in parallel, the calling thread
+    // initializes the first ones and updates the progress
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(
+      std::max(1, std::min(threader->GetNumberOfThreads(), self->dimZ)) );
+    threader->SetSingleMethod( vtkPichonFastMarching::initializeNodesThreadFunction, self );
+    threader->SingleMethodExecute();
 
     return;
     }
@@ -555,6 +582,7 @@ void vtkPichonFastMarching::insert(const FMleaf leaf) {
 
   // insert element at the back
   tree.push_back( leaf );
+  tree.back().T = node[ leaf.nodeIndex ].T;
   node[ leaf.nodeIndex ].leafIndex=(int)(tree.size()-1);
 
   // trickle the element up until everything
@@ -598,92 +626,72 @@ bool vtkPichonFastMarching::minHeapIsSorted( void )
 void vtkPichonFastMarching::downTree(int index) {
   /*
    * This routine sweeps downward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is smaller than that of the parent. Note that this only
-   * guarantees the heap property if the value at the
-   * starting index is greater than all its parents.
+   * moving up the children that have a smaller value than
+   * the leaf. Note that this only guarantees the heap property
+   * if the value at the starting index is greater than all its parents.
+   *
+   * The leaf is only written once at its final place, and the
+   * values are compared without looking up the nodes.
    */
+  FMleaf leaf = tree[index];
+  leaf.T = node[ leaf.nodeIndex ].T;
+
+  int size = (int)tree.size();
   int LeftChild = 2 * index + 1;
-  int RightChild = 2 * index + 2;
 
-  while (LeftChild < (int)tree.size())
+  while (LeftChild < size)
     {
-      /*
-       * Terminate the process when the current leaf has no
-       * children. If no swap occurs at a higher leaf, this
-       * condition is forced.
-       */
-
       /*
        * Find the child with the smallest value. The node has at least
        * one child, and so has at least a left child.
        */
       int MinChild = LeftChild;
+      int RightChild = LeftChild + 1;
 
-      /*
-       * If the node has a right child, and if the right child
-       * has smaller crossing time than the left child, then the
-       * right child is the MinChild.
-       */
-      if (RightChild < (int)tree.size()) {
-
-    if (node[tree[LeftChild].nodeIndex].T>
-        node[tree[RightChild].nodeIndex].T)
-      MinChild = RightChild;
-      }
+      if ( (RightChild < size) && (tree[LeftChild].T > tree[RightChild].T) )
+    MinChild = RightChild;
 
       /*
-       * If the MinChild has smaller T than the current leaf,
-       * swap them, and move the current leaf to the MinChild.
+       * If the MinChild has smaller T than the leaf,
+       * move it up, and move the leaf down to the MinChild.
        */
-      if (node[tree[MinChild].nodeIndex].T<
-      node[tree[index].nodeIndex].T)
+      if (tree[MinChild].T < leaf.T)
     {
-      FMleaf tmp=tree[index];
-      tree[index]=tree[MinChild];
-      tree[MinChild]=tmp;
-
-      // make sure pointers remain correct
-      node[ tree[MinChild].nodeIndex ].leafIndex = MinChild;
+      tree[index] = tree[MinChild];
       node[ tree[index].nodeIndex ].leafIndex = index;
 
       index = MinChild;
-
       LeftChild = 2 * index + 1;
-      RightChild =  LeftChild + 1;
     }
       else
     /*
-     * If the current leaf has a lower value than its
+     * If the leaf has a lower value than its
      * MinChild, the job is done, force a stop.
      */
     break;
     }
+
+  tree[index] = leaf;
+  node[ leaf.nodeIndex ].leafIndex = index;
 }
 
 void vtkPichonFastMarching::upTree(int index) {
   /*
    * This routine sweeps upward from leaf 'index',
-   * swapping child and parent if the value of the child
-   * is less than that of the parent. Note that this only
-   * guarantees the heap property if the value at the
-   * starting leaf is less than all its children.
+   * moving down the parents that have a larger value than
+   * the leaf. Note that this only guarantees the heap property
+   * if the value at the starting leaf is less than all its children.
    */
+  FMleaf leaf = tree[index];
+  leaf.T = node[ leaf.nodeIndex ].T;
+
   while( index>0 )
     {
       int upIndex = (int) (index-1)/2;
 
-      if( node[tree[index].nodeIndex].T <
-      node[tree[upIndex].nodeIndex].T )
+      if( leaf.T < tree[upIndex].T )
     {
-      // then swap the 2 nodes
-
-      FMleaf tmp=tree[index];
-      tree[index]=tree[upIndex];
-      tree[upIndex]=tmp;
-
-      // make sure pointers remain correct
-      node[ tree[upIndex].nodeIndex ].leafIndex = upIndex;
+      tree[index] = tree[upIndex];
       node[ tree[index].nodeIndex ].leafIndex = index;
 
       index = upIndex;
@@ -693,6 +701,9 @@ void vtkPichonFastMarching::upTree(int index) {
     // force stop
     break;
     }
+
+  tree[index] = leaf;
+  node[ leaf.nodeIndex ].leafIndex = index;
 }
 
 FMleaf vtkPichonFastMarching::removeSmallest( void ) {
@@ -704,15 +715,12 @@ FMleaf vtkPichonFastMarching::removeSmallest( void ) {
    * Now move the bottom, rightmost, leaf to the root.
    */
   tree[0]=tree[ tree.size()-1 ];
-
-  // make sure pointers remain correct
-  node[ tree[0].nodeIndex ].leafIndex = 0;
-
   tree.pop_back();
 
   // trickle the element down until everything
   // is sorted again
-  downTree( 0 );
+  if( !tree.empty() )
+    downTree( 0 );
 
   return f;
 }
@@ -15,6 +15,7 @@
 // VTK includes
 #include <vtkImageData.h>
 #include <vtkImageAlgorithm.h>
+#include <vtkMultiThreader.h>
 #include <vtkVersion.h>
 
 // STD includes
@@ -48,8 +49,11 @@ struct FMnode {
   int leafIndex;
 };
 
+/// T is a copy of node[nodeIndex].T so that the minheap can be sorted
+/// without looking up the nodes
 struct FMleaf {
   int nodeIndex;
+  float T;
 };
 
 /// these typedef are for tclwrapper...
@@ -206,6 +210,10 @@ private:
 
   void getMedianInhomo(int index, int &median, int &inhomo );
 
+  /// initialize the nodes of the slices [kBegin, kEnd[ before the first evolution
+  void initializeNodes(int kBegin, int kEnd, bool updateProgress);
+  static VTK_THREAD_RETURN_TYPE initializeNodesThreadFunction(void *arg);
+
   int shiftNeighbor(int n);
   double distanceNeighbor(int n);
   float computeT(int index );
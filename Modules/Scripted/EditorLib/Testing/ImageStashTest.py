@@ -0,0 +1,105 @@
+import unittest
+import vtk
+import slicer
+
+class ImageStash(unittest.TestCase):
+  def setUp(self):
+    pass
+
+  def createLabelMap(self, dimension=128):
+    """Label map with a box of label 1 and a few scattered labels"""
+    imageData = vtk.vtkImageData()
+    imageData.SetDimensions(dimension, dimension, dimension)
+    imageData.AllocateScalars(vtk.VTK_SHORT, 1)
+    scalars = imageData.GetPointData().GetScalars()
+    scalars.Fill(0)
+    for k in range(dimension // 4, dimension // 2):
+      for j in range(dimension // 4, dimension // 2):
+        for i in range(dimension // 4, dimension // 2):
+          imageData.SetScalarComponentFromDouble(i, j, k, 0, 1)
+    for index in range(0, dimension * dimension * dimension, 4099):
+      scalars.SetTuple1(index, index % 7)
+    return imageData
+
+  def stashAndUnstash(self, stash, imageData):
+    reference = vtk.vtkImageData()
+    reference.DeepCopy(imageData)
+    stashImage = vtk.vtkImageData()
+    stashImage.DeepCopy(imageData)
+    stash.SetStashImage(stashImage)
+    stash.ThreadedStash()
+    while stash.GetStashing():
+      pass
+    self.assertEqual(stash.GetStashingSucceeded(), 1)
+    self.assertEqual(stashImage.GetPointData().GetScalars().GetNumberOfTuples(), 0)
+    stash.Unstash()
+    self.assertEqual(stashImage.GetPointData().GetScalars().GetNumberOfTuples(), reference.GetNumberOfPoints())
+    difference = vtk.vtkImageMathematics()
+    difference.SetOperationToSubtract()
+    difference.SetInput1Data(stashImage)
+    difference.SetInput2Data(reference)
+    difference.Update()
+    self.assertEqual(difference.GetOutput().GetScalarRange(), (0.0, 0.0))
+
+  def runTest(self):
+    self.test_ImageStash()
+
+  def test_ImageStash(self):
+    labelMap = self.createLabelMap()
+
+    # label map: run-length encoded chunks
+    stash = slicer.vtkImageStash()
+    stash.SetChunkSize(64 * 1024)
+    self.stashAndUnstash(stash, labelMap)
+    self.assertEqual(stash.GetNumberOfStashedChunks(), 64)
+    self.assertEqual(stash.GetNumberOfReusedChunks(), 0)
+    self.assertTrue(stash.GetStashedSize() < 2 * labelMap.GetNumberOfPoints() / 10)
+
+    # the first stash has no previous stash, its chunks are not hashed and
+    # cannot be reused
+    hashedStash = slicer.vtkImageStash()
+    hashedStash.SetChunkSize(64 * 1024)
+    hashedStash.SetPreviousStash(stash)
+    self.stashAndUnstash(hashedStash, labelMap)
+    self.assertEqual(hashedStash.GetNumberOfReusedChunks(), 0)
+    self.assertEqual(hashedStash.GetPreviousStash(), None)
+
+    # edit a few slices, only their chunks are stashed again
+    labelMap.SetScalarComponentFromDouble(10, 10, 10, 0, 3)
+    labelMap.SetScalarComponentFromDouble(100, 100, 100, 0, 3)
+    nextStash = slicer.vtkImageStash()
+    nextStash.SetChunkSize(64 * 1024)
+    nextStash.SetPreviousStash(hashedStash)
+    self.stashAndUnstash(nextStash, labelMap)
+    self.assertEqual(nextStash.GetNumberOfStashedChunks(), 64)
+    self.assertEqual(nextStash.GetNumberOfReusedChunks(), 62)
+    self.assertEqual(nextStash.GetPreviousStash(), None)
+
+    # flipping the sign bit of two values changes the hash of their chunk,
+    # it is stashed again
+    signFlipped = vtk.vtkImageData()
+    signFlipped.DeepCopy(labelMap)
+    scalars = signFlipped.GetPointData().GetScalars()
+    for index in (3, 7):
+      scalars.SetTuple1(index, scalars.GetTuple1(index) - 32768)
+    signFlippedStash = slicer.vtkImageStash()
+    signFlippedStash.SetChunkSize(64 * 1024)
+    signFlippedStash.SetPreviousStash(nextStash)
+    self.stashAndUnstash(signFlippedStash, signFlipped)
+    self.assertEqual(signFlippedStash.GetNumberOfReusedChunks(), 63)
+
+    # noise: zlib compressed chunks
+    noise = vtk.vtkImageNoiseSource()
+    noise.SetWholeExtent(0, 63, 0, 63, 0, 63)
+    noise.SetMinimum(-1000)
+    noise.SetMaximum(1000)
+    cast = vtk.vtkImageCast()
+    cast.SetInputConnection(noise.GetOutputPort())
+    cast.SetOutputScalarTypeToShort()
+    cast.Update()
+    self.stashAndUnstash(slicer.vtkImageStash(), cast.GetOutput())
+
+    # single thread
+    stash = slicer.vtkImageStash()
+    stash.SetNumberOfThreads(1)
+    self.stashAndUnstash(stash, labelMap)
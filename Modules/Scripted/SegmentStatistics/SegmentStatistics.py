@@ -414,10 +414,21 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
     if visibleSegmentIds.GetNumberOfValues() == 0:
       logging.debug("computeStatistics will not return any results: there are no visible segments")
 
+    segmentIDs = [visibleSegmentIds.GetValue(segmentIndex) for segmentIndex in range(visibleSegmentIds.GetNumberOfValues())]
+
+    # let plugins compute measurements of all segments at once
+    enabledPlugins = [plugin for plugin in self.plugins
+      if self.getParameterNode().GetParameter(plugin.__class__.__name__+'.enabled')=='True']
+    for plugin in enabledPlugins:
+      plugin.beginComputeStatistics(segmentIDs)
+
     # update statistics for all segment IDs
-    for segmentIndex in range(visibleSegmentIds.GetNumberOfValues()):
-      segmentID = visibleSegmentIds.GetValue(segmentIndex)
-      self.updateStatisticsForSegment(segmentID)
+    try:
+      for segmentID in segmentIDs:
+        self.updateStatisticsForSegment(segmentID)
+    finally:
+      for plugin in enabledPlugins:
+        plugin.endComputeStatistics()
 
   def updateStatisticsForSegment(self, segmentID):
     """
@@ -11,14 +11,30 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     self.keys = ["voxel_count", "volume_mm3", "volume_cm3"]
     self.defaultKeys = self.keys # calculate all measurements by default
     #... developer may add extra options to configure other parameters
+    self.cachedStatistics = {}
+
+  def beginComputeStatistics(self, segmentIDs):
+    self.cachedStatistics = self.computeStatisticsForSegments(segmentIDs)
+
+  def endComputeStatistics(self):
+    self.cachedStatistics = {}
 
   def computeStatistics(self, segmentID):
+    if segmentID in self.cachedStatistics:
+      return self.cachedStatistics[segmentID]
+    stats = self.computeStatisticsForSegments([segmentID])
+    return stats[segmentID] if segmentID in stats else {}
+
+  def computeStatisticsForSegments(self, segmentIDs):
+    """Compute measurements of all the given segments at once.
+    Return a dictionary mapping segment IDs to dictionaries of measurements.
+    """
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
 
-    if len(requestedKeys)==0:
+    if len(requestedKeys)==0 or len(segmentIDs)==0:
       return {}
 
     containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
@@ -26,43 +42,28 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     if not containsLabelmapRepresentation:
       return {}
 
-    segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+    # Without scalar volume, voxels are counted in the geometry of each segment labelmap
+    calculator = slicer.vtkSegmentStatisticsCalculator()
     segBinaryLabelName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
-    segmentLabelmap = segment.GetRepresentation(segBinaryLabelName)
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(thresh.GetOutput())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
+    for segmentID in segmentIDs:
+      segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+      calculator.AddSegment(segment.GetRepresentation(segBinaryLabelName) if segment else None)
+    if not calculator.Update():
+      return {}
 
     # Add data to statistics list
-    cubicMMPerVoxel = reduce(lambda x,y: x*y, segmentLabelmap.GetSpacing())
     ccPerCubicMM = 0.001
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-    return stats
+    statistics = {}
+    for segmentIndex, segmentID in enumerate(segmentIDs):
+      stats = {}
+      if "voxel_count" in requestedKeys:
+        stats["voxel_count"] = calculator.GetVoxelCount(segmentIndex)
+      if "volume_mm3" in requestedKeys:
+        stats["volume_mm3"] = calculator.GetVolumeMm3(segmentIndex)
+      if "volume_cm3" in requestedKeys:
+        stats["volume_cm3"] = calculator.GetVolumeMm3(segmentIndex) * ccPerCubicMM
+      statistics[segmentID] = stats
+    return statistics
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key"""
@@ -8,18 +8,34 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
   def __init__(self):
     super(ScalarVolumeSegmentStatisticsPlugin,self).__init__()
     self.name = "Scalar Volume"
-    self.keys = ["voxel_count", "volume_mm3", "volume_cm3", "min", "max", "mean", "stdev"]
-    self.defaultKeys = self.keys # calculate all measurements by default
+    self.keys = ["voxel_count", "volume_mm3", "volume_cm3", "min", "max", "mean", "stdev", "median"]
+    self.defaultKeys = ["voxel_count", "volume_mm3", "volume_cm3", "min", "max", "mean", "stdev"]
     #... developer may add extra options to configure other parameters
+    self.cachedStatistics = {}
+
+  def beginComputeStatistics(self, segmentIDs):
+    self.cachedStatistics = self.computeStatisticsForSegments(segmentIDs)
+
+  def endComputeStatistics(self):
+    self.cachedStatistics = {}
 
   def computeStatistics(self, segmentID):
+    if segmentID in self.cachedStatistics:
+      return self.cachedStatistics[segmentID]
+    stats = self.computeStatisticsForSegments([segmentID])
+    return stats[segmentID] if segmentID in stats else {}
+
+  def computeStatisticsForSegments(self, segmentIDs):
+    """Compute measurements of all the given segments in one pass over the scalar volume.
+    Return a dictionary mapping segment IDs to dictionaries of measurements.
+    """
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
     grayscaleNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("ScalarVolume"))
 
-    if len(requestedKeys)==0:
+    if len(requestedKeys)==0 or len(segmentIDs)==0:
       return {}
 
     containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
@@ -30,73 +46,59 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     if grayscaleNode is None or grayscaleNode.GetImageData() is None:
       return {}
 
-    # Get geometry of grayscale volume node as oriented image data
-    # reference geometry in reference node coordinate system
-    referenceGeometry_Reference = vtkSegmentationCore.vtkOrientedImageData()
-    referenceGeometry_Reference.SetExtent(grayscaleNode.GetImageData().GetExtent())
+    # Get grayscale volume node as oriented image data
+    # (image data in reference node coordinate system)
+    grayscaleImage_Reference = vtkSegmentationCore.vtkOrientedImageData()
+    grayscaleImage_Reference.ShallowCopy(grayscaleNode.GetImageData())
     ijkToRasMatrix = vtk.vtkMatrix4x4()
     grayscaleNode.GetIJKToRASMatrix(ijkToRasMatrix)
-    referenceGeometry_Reference.SetGeometryFromImageToWorldMatrix(ijkToRasMatrix)
+    grayscaleImage_Reference.SetGeometryFromImageToWorldMatrix(ijkToRasMatrix)
 
     # Get transform between grayscale volume and segmentation
     segmentationToReferenceGeometryTransform = vtk.vtkGeneralTransform()
     slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(),
       grayscaleNode.GetParentTransformNode(), segmentationToReferenceGeometryTransform)
 
-    cubicMMPerVoxel = reduce(lambda x,y: x*y, referenceGeometry_Reference.GetSpacing())
-    ccPerCubicMM = 0.001
-
-    segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+    # Segments are resampled to the grayscale volume geometry (nearest neighbor interpolation)
+    # and all segments are processed at once
+    calculator = slicer.vtkSegmentStatisticsCalculator()
+    calculator.SetScalarVolume(grayscaleImage_Reference)
+    calculator.SetSegmentToScalarVolumeTransform(segmentationToReferenceGeometryTransform)
     segBinaryLabelName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
-    segmentLabelmap = segment.GetRepresentation(segBinaryLabelName)
-
-    segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
-    vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-      segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
-      False, # nearest neighbor interpolation
-      False, # no padding
-      segmentationToReferenceGeometryTransform)
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap_Reference)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(grayscaleNode.GetImageData())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
+    for segmentID in segmentIDs:
+      segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+      calculator.AddSegment(segment.GetRepresentation(segBinaryLabelName) if segment else None)
+    if "median" in requestedKeys:
+      calculator.AddPercentile(50.0)
+    if not calculator.Update():
+      return {}
+
+    ccPerCubicMM = 0.001
 
     # create statistics list
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-    if stat.GetVoxelCount()>0:
-      if "min" in requestedKeys:
-        stats["min"] = stat.GetMin()[0]
-      if "max" in requestedKeys:
-        stats["max"] = stat.GetMax()[0]
-      if "mean" in requestedKeys:
-        stats["mean"] = stat.GetMean()[0]
-      if "stdev" in requestedKeys:
-        stats["stdev"] = stat.GetStandardDeviation()[0]
-    return stats
+    statistics = {}
+    for segmentIndex, segmentID in enumerate(segmentIDs):
+      voxelCount = calculator.GetVoxelCount(segmentIndex)
+      stats = {}
+      if "voxel_count" in requestedKeys:
+        stats["voxel_count"] = voxelCount
+      if "volume_mm3" in requestedKeys:
+        stats["volume_mm3"] = calculator.GetVolumeMm3(segmentIndex)
+      if "volume_cm3" in requestedKeys:
+        stats["volume_cm3"] = calculator.GetVolumeMm3(segmentIndex) * ccPerCubicMM
+      if voxelCount>0:
+        if "min" in requestedKeys:
+          stats["min"] = calculator.GetMinimum(segmentIndex)
+        if "max" in requestedKeys:
+          stats["max"] = calculator.GetMaximum(segmentIndex)
+        if "mean" in requestedKeys:
+          stats["mean"] = calculator.GetMean(segmentIndex)
+        if "stdev" in requestedKeys:
+          stats["stdev"] = calculator.GetStandardDeviation(segmentIndex)
+        if "median" in requestedKeys:
+          stats["median"] = calculator.GetPercentileValue(segmentIndex, 0)
+      statistics[segmentID] = stats
+    return statistics
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key""" 
@@ -161,4 +163,11 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
                                    unitsDicomCode=scalarVolumeUnits.GetAsString(),
                                    derivationDicomCode=self.createCodedEntry('R-10047','SRT','Standard Deviation', True))
 
+    info["median"] = \
+      self.createMeasurementInfo(name="Median", description="Median scalar value",
+                                   units=scalarVolumeUnits.GetCodeMeaning(),
+                                   quantityDicomCode=scalarVolumeQuantity.GetAsString(),
+                                   unitsDicomCode=scalarVolumeUnits.GetAsString(),
+                                   derivationDicomCode=self.createCodedEntry('R-00319','SRT','Median', True))
+
     return info[key] if key in info else None
@@ -55,6 +55,16 @@ class SegmentStatisticsPluginBase(object):
     """
     pass
 
+  def beginComputeStatistics(self, segmentIDs):
+    """Called before computeStatistics is called for each of the given segments.
+    Plugins that can compute measurements of many segments at once should do it here.
+    """
+    pass
+
+  def endComputeStatistics(self):
+    """Called after computeStatistics was called for all segments passed to beginComputeStatistics"""
+    pass
+
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key.
     Utilize createMeasurementInfo() to create the dictionary containing the measurement information.
@@ -0,0 +1,947 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Headless benchmarks of the MRML, slice logic and segmentation hot paths.
+//
+// All the data is generated synthetically and nothing is rendered, so the
+// benchmarks run without display or downloaded data. Timings and memory usage
+// are written as JSON (--output) and optionally compared with the JSON output
+// of a previous run (--baseline).
+
+// MRMLLogic includes
+#include <vtkMRMLSliceLogic.h>
+
+// MRML includes
+#include <vtkEventBroker.h>
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLLinearTransformNode.h>
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSceneViewNode.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceNode.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+#include <vtkMRMLTableNode.h>
+#include <vtkMRMLTableSQLiteStorageNode.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// SegmentationCore includes
+#include <vtkBinaryLabelmapToClosedSurfaceConversionRule.h>
+#include <vtkClosedSurfaceToBinaryLabelmapConversionRule.h>
+#include <vtkOrientedImageData.h>
+#include <vtkOrientedImageDataResample.h>
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
+#include <vtkSegmentationConverterFactory.h>
+
+// ITK includes
+#include <itkFactoryRegistration.h>
+
+// VTK includes
+#include <vtkAlgorithm.h>
+#include <vtkAlgorithmOutput.h>
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTable.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemInformation.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// RapidJSON includes
+#include <rapidjson/document.h>
+#include <rapidjson/filereadstream.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct BenchmarkResult
+{
+  std::string Name;
+  int Repeats;
+  double MeanSeconds;
+  double MinSeconds;
+  double MaxSeconds;
+  /// Process memory growth during the benchmark in KiB
+  long long MemoryDeltaKiB;
+};
+
+//----------------------------------------------------------------------------
+/// Accumulates the timings of the repeated executions of a benchmark.
+/// Only the code between Start() and Stop() is measured, setup code is not.
+class BenchmarkTimer
+{
+public:
+  BenchmarkTimer(const std::string& name)
+    : Name(name)
+    , MemoryAtStartKiB(-1)
+    {
+    }
+
+  void Start()
+    {
+    if (this->MemoryAtStartKiB < 0)
+      {
+      this->MemoryAtStartKiB = this->SystemInformation.GetProcMemoryUsed();
+      }
+    this->Timer->StartTimer();
+    }
+
+  void Stop()
+    {
+    this->Timer->StopTimer();
+    this->Timings.push_back(this->Timer->GetElapsedTime());
+    }
+
+  BenchmarkResult GetResult()
+    {
+    BenchmarkResult result;
+    result.Name = this->Name;
+    result.Repeats = static_cast<int>(this->Timings.size());
+    result.MeanSeconds = 0.;
+    result.MinSeconds = 0.;
+    result.MaxSeconds = 0.;
+    if (!this->Timings.empty())
+      {
+      for (size_t i = 0; i < this->Timings.size(); ++i)
+        {
+        result.MeanSeconds += this->Timings[i];
+        }
+      result.MeanSeconds /= this->Timings.size();
+      result.MinSeconds = *std::min_element(this->Timings.begin(), this->Timings.end());
+      result.MaxSeconds = *std::max_element(this->Timings.begin(), this->Timings.end());
+      }
+    result.MemoryDeltaKiB = this->SystemInformation.GetProcMemoryUsed() - this->MemoryAtStartKiB;
+    return result;
+    }
+
+protected:
+  std::string Name;
+  std::vector<double> Timings;
+  long long MemoryAtStartKiB;
+  vtkNew<vtkTimerLog> Timer;
+  vtksys::SystemInformation SystemInformation;
+};
+
+//----------------------------------------------------------------------------
+struct BenchmarkContext
+{
+  int Repeats;
+  std::string TemporaryDirectory;
+  std::vector<BenchmarkResult> Results;
+};
+
+//----------------------------------------------------------------------------
+void createImage(vtkImageData* image, int dimension, int scalarType)
+{
+  image->SetDimensions(dimension, dimension, dimension);
+  image->AllocateScalars(scalarType, 1);
+  const double center = dimension / 2.;
+  for (int k = 0; k < dimension; ++k)
+    {
+    for (int j = 0; j < dimension; ++j)
+      {
+      for (int i = 0; i < dimension; ++i)
+        {
+        // Concentric shells, so that the data is neither constant nor random
+        double radius = sqrt((i - center) * (i - center)
+                           + (j - center) * (j - center)
+                           + (k - center) * (k - center));
+        image->SetScalarComponentFromDouble(i, j, k, 0, static_cast<int>(radius) % 16);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLScalarVolumeNode* addVolumeNode(vtkMRMLScene* scene, const char* name, int dimension, int scalarType)
+{
+  vtkNew<vtkImageData> image;
+  createImage(image.GetPointer(), dimension, scalarType);
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetName(name);
+  volumeNode->SetAndObserveImageData(image.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->SetAutoWindowLevel(false);
+  displayNode->SetWindowLevel(16., 8.);
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+  scene->AddNode(displayNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  return volumeNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkScene(BenchmarkContext& context)
+{
+  const int numberOfNodes = 1000;
+
+  vtkNew<vtkMRMLScene> scene;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkNew<vtkMRMLLinearTransformNode> transformNode;
+    scene->AddNode(transformNode.GetPointer());
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    scene->AddNode(volumeNode.GetPointer());
+    volumeNode->SetAndObserveTransformNodeID(transformNode->GetID());
+    }
+
+  BenchmarkTimer saveTimer("SceneSaveToXMLString");
+  std::string sceneXML;
+  scene->SetSaveToXMLString(1);
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    saveTimer.Start();
+    scene->Commit();
+    saveTimer.Stop();
+    }
+  sceneXML = scene->GetSceneXMLString();
+  context.Results.push_back(saveTimer.GetResult());
+
+  BenchmarkTimer importTimer("SceneImportFromXMLString");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkMRMLScene> importedScene;
+    importedScene->SetLoadFromXMLString(1);
+    importedScene->SetSceneXMLString(sceneXML);
+    importTimer.Start();
+    importedScene->Import();
+    importTimer.Stop();
+    if (importedScene->GetNumberOfNodesByClass("vtkMRMLLinearTransformNode") != numberOfNodes)
+      {
+      std::cerr << "benchmarkScene: imported scene is incomplete" << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(importTimer.GetResult());
+
+  BenchmarkTimer clearTimer("SceneClear");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkMRMLScene> importedScene;
+    importedScene->SetLoadFromXMLString(1);
+    importedScene->SetSceneXMLString(sceneXML);
+    importedScene->Import();
+    clearTimer.Start();
+    importedScene->Clear(1);
+    clearTimer.Stop();
+    }
+  context.Results.push_back(clearTimer.GetResult());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkSliceLogic(BenchmarkContext& context)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLSliceNode::AddDefaultSliceOrientationPresets(scene.GetPointer());
+
+  vtkMRMLScalarVolumeNode* backgroundNode = addVolumeNode(scene.GetPointer(), "Background", 256, VTK_SHORT);
+  vtkMRMLScalarVolumeNode* foregroundNode = addVolumeNode(scene.GetPointer(), "Foreground", 256, VTK_SHORT);
+
+  vtkNew<vtkMRMLSliceLogic> sliceLogic;
+  sliceLogic->SetName("Red");
+  sliceLogic->SetMRMLScene(scene.GetPointer());
+  vtkMRMLSliceNode* sliceNode = sliceLogic->GetSliceNode();
+  vtkMRMLSliceCompositeNode* sliceCompositeNode = sliceLogic->GetSliceCompositeNode();
+  if (!sliceNode || !sliceCompositeNode)
+    {
+    std::cerr << "benchmarkSliceLogic: slice logic is not initialized" << std::endl;
+    return false;
+    }
+  sliceNode->SetDimensions(1024, 1024, 1);
+  sliceNode->SetFieldOfView(256., 256., 1.);
+  sliceCompositeNode->SetBackgroundVolumeID(backgroundNode->GetID());
+  sliceCompositeNode->SetForegroundVolumeID(foregroundNode->GetID());
+  sliceCompositeNode->SetForegroundOpacity(0.5);
+
+  BenchmarkTimer resliceTimer("SliceLogicResliceBlend");
+  for (int i = 0; i < context.Repeats * 10; ++i)
+    {
+    sliceLogic->SetSliceOffset(-100. + (i % 200));
+    resliceTimer.Start();
+    sliceLogic->UpdatePipeline();
+    sliceLogic->GetImageDataConnection()->GetProducer()->Update();
+    resliceTimer.Stop();
+    }
+  context.Results.push_back(resliceTimer.GetResult());
+
+  // Dragging window/level remaps the slice without reslicing it
+  vtkMRMLScalarVolumeDisplayNode* backgroundDisplayNode = backgroundNode->GetScalarVolumeDisplayNode();
+  BenchmarkTimer windowLevelTimer("SliceLogicWindowLevel");
+  for (int i = 0; i < context.Repeats * 10; ++i)
+    {
+    backgroundDisplayNode->SetWindowLevel(8. + (i % 16), 4. + (i % 8));
+    windowLevelTimer.Start();
+    sliceLogic->UpdatePipeline();
+    sliceLogic->GetImageDataConnection()->GetProducer()->Update();
+    windowLevelTimer.Stop();
+    }
+  context.Results.push_back(windowLevelTimer.GetResult());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkSegmentationConversion(BenchmarkContext& context)
+{
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New() );
+  vtkSegmentationConverterFactory::GetInstance()->RegisterConverterRule(
+    vtkSmartPointer<vtkClosedSurfaceToBinaryLabelmapConversionRule>::New() );
+
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetCenter(0, 0, 0);
+  sphere->SetRadius(50);
+  sphere->SetThetaResolution(200);
+  sphere->SetPhiResolution(200);
+  sphere->Update();
+
+  const std::string closedSurfaceName = vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName();
+  const std::string labelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+
+  BenchmarkTimer toLabelmapTimer("SegmentationClosedSurfaceToBinaryLabelmap");
+  BenchmarkTimer toSurfaceTimer("SegmentationBinaryLabelmapToClosedSurface");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(closedSurfaceName, sphere->GetOutput());
+    vtkNew<vtkSegmentation> segmentation;
+    segmentation->SetMasterRepresentationName(closedSurfaceName);
+    segmentation->AddSegment(segment.GetPointer());
+
+    toLabelmapTimer.Start();
+    bool success = segmentation->CreateRepresentation(labelmapName);
+    toLabelmapTimer.Stop();
+    if (!success)
+      {
+      std::cerr << "benchmarkSegmentationConversion: conversion to binary labelmap failed" << std::endl;
+      return false;
+      }
+
+    // Convert back from the labelmap
+    segmentation->SetMasterRepresentationName(labelmapName);
+    segment->RemoveRepresentation(closedSurfaceName);
+    toSurfaceTimer.Start();
+    success = segmentation->CreateRepresentation(closedSurfaceName);
+    toSurfaceTimer.Stop();
+    if (!success)
+      {
+      std::cerr << "benchmarkSegmentationConversion: conversion to closed surface failed" << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(toLabelmapTimer.GetResult());
+  context.Results.push_back(toSurfaceTimer.GetResult());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkOrientedImageMerge(BenchmarkContext& context)
+{
+  vtkNew<vtkOrientedImageData> image1;
+  createImage(image1.GetPointer(), 256, VTK_UNSIGNED_CHAR);
+  vtkNew<vtkOrientedImageData> image2;
+  image2->SetExtent(64, 319, 64, 319, 64, 319);
+  image2->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  image2->GetPointData()->GetScalars()->Fill(1);
+
+  BenchmarkTimer mergeTimer("OrientedImageDataResampleMergeImage");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkOrientedImageData> merged;
+    mergeTimer.Start();
+    bool success = vtkOrientedImageDataResample::MergeImage(image1.GetPointer(), image2.GetPointer(),
+      merged.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+    mergeTimer.Stop();
+    if (!success)
+      {
+      std::cerr << "benchmarkOrientedImageMerge: merge failed" << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(mergeTimer.GetResult());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void countEventCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                        void* clientData, void* vtkNotUsed(callData))
+{
+  ++(*reinterpret_cast<int*>(clientData));
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkEventBroker(BenchmarkContext& context)
+{
+  const int numberOfSubjects = 1000;
+  const int numberOfObserversPerSubject = 10;
+  const int numberOfEventsPerSubject = 100;
+
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  int eventCount = 0;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(countEventCallback);
+  callback->SetClientData(&eventCount);
+
+  std::vector<vtkSmartPointer<vtkMRMLLinearTransformNode> > subjects;
+  std::vector<vtkSmartPointer<vtkMRMLLinearTransformNode> > observers;
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects.push_back(vtkSmartPointer<vtkMRMLLinearTransformNode>::New());
+    for (int j = 0; j < numberOfObserversPerSubject; ++j)
+      {
+      observers.push_back(vtkSmartPointer<vtkMRMLLinearTransformNode>::New());
+      broker->AddObservation(subjects.back(), vtkCommand::ModifiedEvent,
+        observers.back(), callback.GetPointer());
+      }
+    }
+
+  BenchmarkTimer dispatchTimer("EventBrokerDispatch");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    eventCount = 0;
+    dispatchTimer.Start();
+    for (int event = 0; event < numberOfEventsPerSubject; ++event)
+      {
+      for (int subject = 0; subject < numberOfSubjects; ++subject)
+        {
+        subjects[subject]->InvokeEvent(vtkCommand::ModifiedEvent);
+        }
+      }
+    dispatchTimer.Stop();
+    if (eventCount != numberOfSubjects * numberOfObserversPerSubject * numberOfEventsPerSubject)
+      {
+      std::cerr << "benchmarkEventBroker: unexpected number of dispatched events: " << eventCount << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(dispatchTimer.GetResult());
+
+  for (size_t i = 0; i < subjects.size(); ++i)
+    {
+    broker->RemoveObservations(subjects[i].GetPointer());
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkVolumeStorage(BenchmarkContext& context)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkMRMLScalarVolumeNode* volumeNode = addVolumeNode(scene.GetPointer(), "Volume", 256, VTK_SHORT);
+
+  std::string fileName = context.TemporaryDirectory + "/SlicerPerformanceBenchmarksVolume.nrrd";
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> storageNode;
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetUseCompression(0);
+  scene->AddNode(storageNode.GetPointer());
+
+  BenchmarkTimer writeTimer("VolumeArchetypeStorageNodeWriteNrrd");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    writeTimer.Start();
+    int success = storageNode->WriteData(volumeNode);
+    writeTimer.Stop();
+    if (!success)
+      {
+      std::cerr << "benchmarkVolumeStorage: failed to write " << fileName << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(writeTimer.GetResult());
+
+  BenchmarkTimer readTimer("VolumeArchetypeStorageNodeReadNrrd");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkMRMLScalarVolumeNode> readVolumeNode;
+    scene->AddNode(readVolumeNode.GetPointer());
+    readTimer.Start();
+    int success = storageNode->ReadData(readVolumeNode.GetPointer());
+    readTimer.Stop();
+    scene->RemoveNode(readVolumeNode.GetPointer());
+    if (!success)
+      {
+      std::cerr << "benchmarkVolumeStorage: failed to read " << fileName << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(readTimer.GetResult());
+
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkTableStorage(BenchmarkContext& context)
+{
+  const vtkIdType numberOfRows = 100000;
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLTableNode> tableNode;
+  scene->AddNode(tableNode.GetPointer());
+  vtkTable* table = tableNode->GetTable();
+  vtkNew<vtkIntArray> labelArray;
+  labelArray->SetName("Label");
+  labelArray->SetNumberOfValues(numberOfRows);
+  table->AddColumn(labelArray.GetPointer());
+  const char* measurementNames[] = {"Volume", "Mean", "StandardDeviation"};
+  for (int c = 0; c < 3; ++c)
+    {
+    vtkNew<vtkDoubleArray> measurementArray;
+    measurementArray->SetName(measurementNames[c]);
+    measurementArray->SetNumberOfValues(numberOfRows);
+    for (vtkIdType i = 0; i < numberOfRows; ++i)
+      {
+      measurementArray->SetValue(i, (c + 1) * 0.5 * i);
+      }
+    table->AddColumn(measurementArray.GetPointer());
+    }
+  for (vtkIdType i = 0; i < numberOfRows; ++i)
+    {
+    labelArray->SetValue(i, static_cast<int>(i % 256));
+    }
+
+  std::string fileName = context.TemporaryDirectory + "/SlicerPerformanceBenchmarksTable.sqlite3";
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  vtkNew<vtkMRMLTableSQLiteStorageNode> storageNode;
+  storageNode->SetFileName(fileName.c_str());
+  storageNode->SetTableName("Measurements");
+  scene->AddNode(storageNode.GetPointer());
+
+  BenchmarkTimer writeTimer("TableSQLiteStorageNodeWrite100kRows");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    writeTimer.Start();
+    int success = storageNode->WriteData(tableNode.GetPointer());
+    writeTimer.Stop();
+    if (!success)
+      {
+      std::cerr << "benchmarkTableStorage: failed to write " << fileName << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(writeTimer.GetResult());
+
+  BenchmarkTimer readTimer("TableSQLiteStorageNodeRead100kRows");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkMRMLTableNode> readTableNode;
+    scene->AddNode(readTableNode.GetPointer());
+    readTimer.Start();
+    int success = storageNode->ReadData(readTableNode.GetPointer());
+    readTimer.Stop();
+    success = success && readTableNode->GetNumberOfRows() == numberOfRows;
+    scene->RemoveNode(readTableNode.GetPointer());
+    if (!success)
+      {
+      std::cerr << "benchmarkTableStorage: failed to read " << fileName << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(readTimer.GetResult());
+
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkSceneView(BenchmarkContext& context)
+{
+  const int numberOfVolumes = 500;
+  vtkNew<vtkMRMLScene> scene;
+  std::vector<vtkMRMLScalarVolumeDisplayNode*> displayNodes;
+  for (int i = 0; i < numberOfVolumes; ++i)
+    {
+    vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+    scene->AddNode(displayNode.GetPointer());
+    displayNodes.push_back(displayNode.GetPointer());
+    vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+    scene->AddNode(volumeNode.GetPointer());
+    volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+    }
+
+  // Memory delta of this timer is the memory used by all the scene views
+  BenchmarkTimer storeTimer("SceneViewStore");
+  std::vector<vtkSmartPointer<vtkMRMLSceneViewNode> > sceneViewNodes;
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    vtkNew<vtkMRMLSceneViewNode> sceneViewNode;
+    scene->AddNode(sceneViewNode.GetPointer());
+    sceneViewNodes.push_back(sceneViewNode.GetPointer());
+    storeTimer.Start();
+    sceneViewNode->StoreScene();
+    storeTimer.Stop();
+    }
+  context.Results.push_back(storeTimer.GetResult());
+
+  vtkMRMLSceneViewNode* sceneViewNode = sceneViewNodes[0];
+  BenchmarkTimer updateTimer("SceneViewUpdateOneModifiedNode");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    displayNodes[i % numberOfVolumes]->SetWindowLevel(100. + i, 50.);
+    updateTimer.Start();
+    sceneViewNode->StoreScene();
+    updateTimer.Stop();
+    }
+  context.Results.push_back(updateTimer.GetResult());
+
+  BenchmarkTimer restoreTimer("SceneViewRestoreOneModifiedNode");
+  for (int i = 0; i < context.Repeats; ++i)
+    {
+    displayNodes[i % numberOfVolumes]->SetWindowLevel(200. + i, 50.);
+    restoreTimer.Start();
+    sceneViewNode->RestoreScene();
+    restoreTimer.Stop();
+    if (displayNodes[i % numberOfVolumes]->GetWindow() == 200. + i)
+      {
+      std::cerr << "benchmarkSceneView: scene view is not restored" << std::endl;
+      return false;
+      }
+    }
+  context.Results.push_back(restoreTimer.GetResult());
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool benchmarkSubjectHierarchy(BenchmarkContext& context)
+{
+  // Lookup time is measured at increasing hierarchy sizes to show how it scales
+  const int numberOfStudies = 20;
+  const int hierarchySizes[] = { 500, 2000, 8000 };
+  for (int sizeIndex = 0; sizeIndex < 3; ++sizeIndex)
+    {
+    const int numberOfItems = hierarchySizes[sizeIndex];
+    vtkNew<vtkMRMLScene> scene;
+    vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene.GetPointer());
+    if (!shNode)
+      {
+      std::cerr << "benchmarkSubjectHierarchy: failed to create subject hierarchy node" << std::endl;
+      return false;
+      }
+
+    std::ostringstream suffix;
+    suffix << numberOfItems;
+
+    BenchmarkTimer createTimer("SubjectHierarchyCreate" + suffix.str());
+    createTimer.Start();
+    vtkIdType subjectItemID = shNode->CreateSubjectItem(shNode->GetSceneItemID(), "Subject");
+    std::vector<vtkIdType> studyItemIDs;
+    for (int i = 0; i < numberOfStudies; ++i)
+      {
+      studyItemIDs.push_back(shNode->CreateStudyItem(subjectItemID, "Study"));
+      }
+    std::vector<vtkMRMLNode*> dataNodes;
+    std::vector<std::string> instanceUIDs;
+    for (int i = 0; i < numberOfItems; ++i)
+      {
+      vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+      scene->AddNode(volumeNode.GetPointer());
+      vtkIdType itemID = shNode->CreateItem(studyItemIDs[i % numberOfStudies], volumeNode.GetPointer());
+      std::ostringstream uid;
+      uid << "1.2.840.113619." << i;
+      shNode->SetItemUID(itemID, "DICOM", uid.str());
+      dataNodes.push_back(volumeNode.GetPointer());
+      instanceUIDs.push_back(uid.str());
+      }
+    createTimer.Stop();
+    context.Results.push_back(createTimer.GetResult());
+
+    const int numberOfLookups = 1000;
+    BenchmarkTimer dataNodeTimer("SubjectHierarchyItemByDataNode" + suffix.str());
+    BenchmarkTimer uidTimer("SubjectHierarchyItemByUID" + suffix.str());
+    BenchmarkTimer childrenTimer("SubjectHierarchyItemChildren" + suffix.str());
+    for (int i = 0; i < context.Repeats; ++i)
+      {
+      dataNodeTimer.Start();
+      for (int lookup = 0; lookup < numberOfLookups; ++lookup)
+        {
+        int index = (lookup * 7919 + i) % numberOfItems;
+        if (shNode->GetItemByDataNode(dataNodes[index]) == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+          {
+          std::cerr << "benchmarkSubjectHierarchy: item is not found by data node" << std::endl;
+          return false;
+          }
+        }
+      dataNodeTimer.Stop();
+
+      uidTimer.Start();
+      for (int lookup = 0; lookup < numberOfLookups; ++lookup)
+        {
+        int index = (lookup * 7919 + i) % numberOfItems;
+        if (shNode->GetItemByUID("DICOM", instanceUIDs[index].c_str()) == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+          {
+          std::cerr << "benchmarkSubjectHierarchy: item is not found by UID" << std::endl;
+          return false;
+          }
+        }
+      uidTimer.Stop();
+
+      childrenTimer.Start();
+      std::vector<vtkIdType> childIDs;
+      shNode->GetItemChildren(shNode->GetSceneItemID(), childIDs, true);
+      childrenTimer.Stop();
+      if (childIDs.size() != static_cast<size_t>(numberOfItems + numberOfStudies + 1))
+        {
+        std::cerr << "benchmarkSubjectHierarchy: unexpected number of children " << childIDs.size() << std::endl;
+        return false;
+        }
+      }
+    context.Results.push_back(dataNodeTimer.GetResult());
+    context.Results.push_back(uidTimer.GetResult());
+    context.Results.push_back(childrenTimer.GetResult());
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool writeResults(const std::vector<BenchmarkResult>& results, const std::string& fileName)
+{
+  std::ofstream output(fileName.c_str());
+  if (!output.is_open())
+    {
+    std::cerr << "Failed to write results to " << fileName << std::endl;
+    return false;
+    }
+  output << "{\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    const BenchmarkResult& result = results[i];
+    output << "    {\n"
+           << "      \"name\": \"" << result.Name << "\",\n"
+           << "      \"repeats\": " << result.Repeats << ",\n"
+           << "      \"mean_seconds\": " << result.MeanSeconds << ",\n"
+           << "      \"min_seconds\": " << result.MinSeconds << ",\n"
+           << "      \"max_seconds\": " << result.MaxSeconds << ",\n"
+           << "      \"memory_delta_kib\": " << result.MemoryDeltaKiB << "\n"
+           << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+  output << "  ]\n}\n";
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool readBaseline(const std::string& fileName, std::map<std::string, double>& baselineMeanSeconds)
+{
+  FILE* fp = fopen(fileName.c_str(), "r");
+  if (!fp)
+    {
+    std::cerr << "Failed to open baseline " << fileName << std::endl;
+    return false;
+    }
+  rapidjson::Document baseline;
+  char buffer[4096];
+  rapidjson::FileReadStream fs(fp, buffer, sizeof(buffer));
+  bool parseError = baseline.ParseStream(fs).HasParseError();
+  fclose(fp);
+  if (parseError || !baseline.IsObject() || !baseline.HasMember("results") || !baseline["results"].IsArray())
+    {
+    std::cerr << "Invalid baseline " << fileName << std::endl;
+    return false;
+    }
+  rapidjson::Value& results = baseline["results"];
+  for (rapidjson::SizeType i = 0; i < results.Size(); ++i)
+    {
+    rapidjson::Value& result = results[i];
+    if (result.IsObject() && result.HasMember("name") && result["name"].IsString()
+      && result.HasMember("mean_seconds") && result["mean_seconds"].IsNumber())
+      {
+      baselineMeanSeconds[result["name"].GetString()] = result["mean_seconds"].GetDouble();
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// \return Number of benchmarks slower than the baseline by more than tolerance
+int compareWithBaseline(const std::vector<BenchmarkResult>& results,
+                        const std::map<std::string, double>& baselineMeanSeconds, double tolerance)
+{
+  int numberOfRegressions = 0;
+  for (size_t i = 0; i < results.size(); ++i)
+    {
+    std::map<std::string, double>::const_iterator baselineIt = baselineMeanSeconds.find(results[i].Name);
+    if (baselineIt == baselineMeanSeconds.end() || baselineIt->second <= 0.)
+      {
+      std::cout << results[i].Name << ": no baseline" << std::endl;
+      continue;
+      }
+    double ratio = results[i].MeanSeconds / baselineIt->second;
+    bool regression = ratio > tolerance;
+    std::cout << results[i].Name << ": " << ratio << "x baseline"
+              << (regression ? " - REGRESSION" : "") << std::endl;
+    if (regression)
+      {
+      ++numberOfRegressions;
+      }
+    }
+  return numberOfRegressions;
+}
+
+//----------------------------------------------------------------------------
+void printUsage(const char* executable)
+{
+  std::cerr << "Usage: " << executable << " [options]\n"
+            << "  --output <file.json>             Write results to file\n"
+            << "  --baseline <file.json>           Compare results with the output of a previous run\n"
+            << "  --tolerance <ratio>              Slow-down ratio reported as regression (default: 1.5)\n"
+            << "  --fail-on-regression             Return failure if a regression is detected\n"
+            << "  --repeats <count>                Number of repetitions of each benchmark (default: 5)\n"
+            << "  --temporary-directory <dir>      Directory for the storage benchmarks (default: .)\n"
+            << "  --benchmark <name>               Only run the given benchmark (can be repeated)\n"
+            << std::endl;
+}
+
+typedef bool (*BenchmarkFunction)(BenchmarkContext&);
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  itk::itkFactoryRegistration();
+
+  std::string outputFileName;
+  std::string baselineFileName;
+  double tolerance = 1.5;
+  bool failOnRegression = false;
+  std::vector<std::string> selectedBenchmarks;
+
+  BenchmarkContext context;
+  context.Repeats = 5;
+  context.TemporaryDirectory = ".";
+
+  for (int i = 1; i < argc; ++i)
+    {
+    std::string arg = argv[i];
+    bool hasValue = (i + 1 < argc);
+    if (arg == "--output" && hasValue)
+      {
+      outputFileName = argv[++i];
+      }
+    else if (arg == "--baseline" && hasValue)
+      {
+      baselineFileName = argv[++i];
+      }
+    else if (arg == "--tolerance" && hasValue)
+      {
+      tolerance = atof(argv[++i]);
+      }
+    else if (arg == "--fail-on-regression")
+      {
+      failOnRegression = true;
+      }
+    else if (arg == "--repeats" && hasValue)
+      {
+      context.Repeats = std::max(1, atoi(argv[++i]));
+      }
+    else if (arg == "--temporary-directory" && hasValue)
+      {
+      context.TemporaryDirectory = argv[++i];
+      }
+    else if (arg == "--benchmark" && hasValue)
+      {
+      selectedBenchmarks.push_back(argv[++i]);
+      }
+    else
+      {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::vector<std::pair<std::string, BenchmarkFunction> > benchmarks;
+  benchmarks.push_back(std::make_pair(std::string("Scene"), &benchmarkScene));
+  benchmarks.push_back(std::make_pair(std::string("SliceLogic"), &benchmarkSliceLogic));
+  benchmarks.push_back(std::make_pair(std::string("SegmentationConversion"), &benchmarkSegmentationConversion));
+  benchmarks.push_back(std::make_pair(std::string("OrientedImageMerge"), &benchmarkOrientedImageMerge));
+  benchmarks.push_back(std::make_pair(std::string("EventBroker"), &benchmarkEventBroker));
+  benchmarks.push_back(std::make_pair(std::string("VolumeStorage"), &benchmarkVolumeStorage));
+  benchmarks.push_back(std::make_pair(std::string("TableStorage"), &benchmarkTableStorage));
+  benchmarks.push_back(std::make_pair(std::string("SceneView"), &benchmarkSceneView));
+  benchmarks.push_back(std::make_pair(std::string("SubjectHierarchy"), &benchmarkSubjectHierarchy));
+
+  bool success = true;
+  for (size_t i = 0; i < benchmarks.size(); ++i)
+    {
+    if (!selectedBenchmarks.empty() && std::find(selectedBenchmarks.begin(),
+      selectedBenchmarks.end(), benchmarks[i].first) == selectedBenchmarks.end())
+      {
+      continue;
+      }
+    std::cout << "Running " << benchmarks[i].first << std::endl;
+    if (!(*benchmarks[i].second)(context))
+      {
+      std::cerr << "Benchmark " << benchmarks[i].first << " failed" << std::endl;
+      success = false;
+      }
+    }
+
+  for (size_t i = 0; i < context.Results.size(); ++i)
+    {
+    const BenchmarkResult& result = context.Results[i];
+    std::cout << result.Name << ": mean " << result.MeanSeconds << "s, min " << result.MinSeconds
+              << "s, max " << result.MaxSeconds << "s, memory " << result.MemoryDeltaKiB << " KiB" << std::endl;
+    }
+
+  if (!outputFileName.empty() && !writeResults(context.Results, outputFileName))
+    {
+    success = false;
+    }
+
+  if (!baselineFileName.empty())
+    {
+    std::map<std::string, double> baselineMeanSeconds;
+    if (!readBaseline(baselineFileName, baselineMeanSeconds))
+      {
+      return EXIT_FAILURE;
+      }
+    int numberOfRegressions = compareWithBaseline(context.Results, baselineMeanSeconds, tolerance);
+    if (numberOfRegressions > 0 && failOnRegression)
+      {
+      std::cerr << numberOfRegressions << " benchmark(s) regressed" << std::endl;
+      success = false;
+      }
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}